@@ -2,44 +2,332 @@
 
 
 #include "Structures.h"
+#include "ChunkedCompression.h"
+#include "Hash.h"
 
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <span>
+#include <cstring>
 
 
 namespace AssetsCreator::Asset {
 	namespace fs = std::filesystem;
 
+	// Read only istream over bytes owned elsewhere, e.g. a mapped pak entry.
+	class MemoryStream : private std::streambuf, public std::istream {
+	public:
+		MemoryStream(const uint8_t* data, uint64_t size) : std::istream(this) {
+			char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+			setg(begin, begin, begin + size);
+		}
+
+	private:
+		std::streambuf::pos_type seekoff(std::streambuf::off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) override {
+			char* base = direction == std::ios_base::beg ? eback() : direction == std::ios_base::cur ? gptr() : egptr();
+			if (base + offset < eback() || base + offset > egptr()) return std::streambuf::pos_type(std::streambuf::off_type(-1));
+			setg(eback(), base + offset, egptr());
+			return std::streambuf::pos_type(gptr() - eback());
+		}
+		std::streambuf::pos_type seekpos(std::streambuf::pos_type position, std::ios_base::openmode which) override {
+			return seekoff(std::streambuf::off_type(position), std::ios_base::beg, which);
+		}
+	};
+
 	class AssetReader {
 	public:
-		static std::unique_ptr<File::MeshAsset> ReadMeshHeaders(const fs::path& path) {
+		// verify also hashes the tables and every stored section and compares them with the header checksums;
+		// without verifySections only the tables are hashed, for readers that hash the sections as they load them.
+		static std::unique_ptr<File::MeshAsset> ReadMeshHeaders(const fs::path& path, bool verify = false, bool verifySections = true) {
 			if (!fs::exists(path) || !fs::is_regular_file(path)) {
 				throw std::runtime_error("[AssetWriter] Non existing file " + path.string());
 			}
-
-			auto meshAsset = std::make_unique<File::MeshAsset>();
 			std::ifstream file(path, std::ios::binary);
+			return ReadMeshHeaders(file, path.string(), verify, verifySections);
+		}
 
+		// From the asset start, e.g. a MemoryStream over a pak entry; name is only used in errors.
+		// Version and file size are always checked, so stale or truncated assets fail here instead of on the GPU.
+		static std::unique_ptr<File::MeshAsset> ReadMeshHeaders(std::istream& file, const std::string& name, bool verify = false, bool verifySections = true) {
+			auto meshAsset = std::make_unique<File::MeshAsset>();
 			file.read(reinterpret_cast<char*>(&meshAsset->header), sizeof(meshAsset->header));
 
 			if (meshAsset->header.magic != File::ASSET_MAGIC || meshAsset->header.fileType != File::ASSET_MESH) {
-				throw std::runtime_error("[AssetWriter] Not a mesh " + path.string());
+				throw std::runtime_error("[AssetWriter] Not a mesh " + name);
 			}
+			CheckVersion(meshAsset->header.version, File::MeshHeader{}.version, name);
 
 			meshAsset->attributeBuffers.resize(meshAsset->header.attributeBufferCount);
 			meshAsset->indexBuffers.resize(meshAsset->header.indexBufferCount);
 			meshAsset->skinnedBuffers.resize(meshAsset->header.skinnedBufferCount);
 			meshAsset->submeshes.resize(meshAsset->header.submeshCount);
+			meshAsset->meshlets.resize(meshAsset->header.meshletCount);
+			meshAsset->lods.resize(meshAsset->header.lodCount);
+			meshAsset->chunks.resize(meshAsset->header.chunkCount);
+			meshAsset->materials.resize(meshAsset->header.materialCount);
+			meshAsset->textureReferences.resize(meshAsset->header.textureReferenceCount);
+			meshAsset->draws.resize(meshAsset->header.submeshCount);
 
-			file.read(reinterpret_cast<char*>(meshAsset->attributeBuffers.data()), meshAsset->attributeBuffers.size() * sizeof(File::AttributeBufferEntry));
-			file.read(reinterpret_cast<char*>(meshAsset->indexBuffers.data()), meshAsset->indexBuffers.size() * sizeof(File::IndexBufferEntry));
-			file.read(reinterpret_cast<char*>(meshAsset->skinnedBuffers.data()), meshAsset->skinnedBuffers.size() * sizeof(File::SkinnedBufferEntry));
-			file.read(reinterpret_cast<char*>(meshAsset->submeshes.data()), meshAsset->submeshes.size() * sizeof(File::SubmeshEntry));
-
+			Hash::XXH64State tableChecksum;
+			ReadTable(file, meshAsset->attributeBuffers, tableChecksum);
+			ReadTable(file, meshAsset->indexBuffers, tableChecksum);
+			ReadTable(file, meshAsset->skinnedBuffers, tableChecksum);
+			ReadTable(file, meshAsset->submeshes, tableChecksum);
+			ReadTable(file, meshAsset->meshlets, tableChecksum);
+			ReadTable(file, meshAsset->lods, tableChecksum);
+			ReadTable(file, meshAsset->chunks, tableChecksum);
+			ReadTable(file, meshAsset->materials, tableChecksum);
+			ReadTable(file, meshAsset->textureReferences, tableChecksum);
+			ReadTable(file, meshAsset->draws, tableChecksum);
+			if (!file) {
+				throw std::runtime_error("[AssetReader] Truncated mesh header in " + name);
+			}
 
+			auto& header = meshAsset->header;
+			uint64_t end = header.skinnedDataOffset + header.skinnedCompressedSizeInBytes;
+			if (header.bvhNodeCount) end = header.bvhDataOffset + GetBvhSize(header);
+			CheckSize(file, end, name);
+			if (verify) {
+				CheckChecksum(tableChecksum.digest(), header.tableChecksum, "tables", name);
+				if (verifySections) VerifyMeshSections(file, *meshAsset, name);
+			}
 			return meshAsset;
 		}
+
+		// Streams the stored sections, and the BVH, through XXH64; the stream must hold the whole asset.
+		static void VerifyMeshSections(std::istream& file, const File::MeshAsset& meshAsset, const std::string& name) {
+			auto& header = meshAsset.header;
+			VerifyRange(file, header.attributeDataOffset, header.attributeCompressedSizeInBytes, header.attributeChecksum, "attribute section", name);
+			VerifyRange(file, header.indexDataOffset, header.indexCompressedSizeInBytes, header.indexChecksum, "index section", name);
+			VerifyRange(file, header.skinnedDataOffset, header.skinnedCompressedSizeInBytes, header.skinnedChecksum, "skinned section", name);
+			VerifyRange(file, header.bvhDataOffset, GetBvhSize(header), header.bvhChecksum, "BVH", name);
+		}
+
+		// The optional BVH section, empty when the mesh was cooked without one; always checked against bvhChecksum.
+		static File::MeshBvh ReadBvh(const fs::path& path, const File::MeshAsset& meshAsset) {
+			std::ifstream file(path, std::ios::binary);
+			return ReadBvh(file, meshAsset, path.string());
+		}
+
+		static File::MeshBvh ReadBvh(std::istream& file, const File::MeshAsset& meshAsset, const std::string& name) {
+			File::MeshBvh bvh;
+			auto& header = meshAsset.header;
+			if (!header.bvhNodeCount) return bvh;
+
+			bvh.nodes.resize(header.bvhNodeCount);
+			bvh.triangles.resize(header.bvhTriangleCount);
+			file.seekg(header.bvhDataOffset);
+			Hash::XXH64State checksum;
+			ReadTable(file, bvh.nodes, checksum);
+			ReadTable(file, bvh.triangles, checksum);
+			if (!file) {
+				throw std::runtime_error("[AssetReader] Truncated BVH in " + name);
+			}
+			CheckChecksum(checksum.digest(), header.bvhChecksum, "BVH", name);
+			return bvh;
+		}
+
+		// Where the data of a submesh cooked into the content store lives.
+		static fs::path GetPayloadPath(const fs::path& meshPath, const File::MeshAsset& meshAsset, const File::SubmeshEntry& submesh) {
+			return (meshPath.parent_path() / meshAsset.header.contentDirectory / (File::PayloadId(submesh.payloadHash) + ".mesh.asset")).lexically_normal();
+		}
+
+		static std::unique_ptr<File::TextureAsset> ReadTextureHeaders(const fs::path& path, bool verify = false) {
+			if (!fs::exists(path) || !fs::is_regular_file(path)) {
+				throw std::runtime_error("[AssetReader] Non existing file " + path.string());
+			}
+			std::ifstream file(path, std::ios::binary);
+			return ReadTextureHeaders(file, path.string(), verify);
+		}
+
+		static std::unique_ptr<File::TextureAsset> ReadTextureHeaders(std::istream& file, const std::string& name, bool verify = false) {
+			auto textureAsset = std::make_unique<File::TextureAsset>();
+			file.read(reinterpret_cast<char*>(&textureAsset->header), sizeof(textureAsset->header));
+
+			if (textureAsset->header.magic != File::ASSET_MAGIC || textureAsset->header.fileType != File::ASSET_TEXTURE) {
+				throw std::runtime_error("[AssetReader] Not a texture " + name);
+			}
+			CheckVersion(textureAsset->header.version, File::TextureHeader{}.version, name);
+
+			textureAsset->mips.resize(textureAsset->header.mipCount);
+			Hash::XXH64State tableChecksum;
+			ReadTable(file, textureAsset->mips, tableChecksum);
+			if (!file) {
+				throw std::runtime_error("[AssetReader] Truncated texture header in " + name);
+			}
+
+			auto& header = textureAsset->header;
+			CheckSize(file, header.dataOffset + header.sizeInBytes, name);
+			if (verify) {
+				CheckChecksum(tableChecksum.digest(), header.tableChecksum, "mip table", name);
+				VerifyRange(file, header.dataOffset, header.sizeInBytes, header.dataChecksum, "mip data", name);
+			}
+			return textureAsset;
+		}
+
+		static std::unique_ptr<File::SceneAsset> ReadScene(const fs::path& path, bool verify = false) {
+			if (!fs::exists(path) || !fs::is_regular_file(path)) {
+				throw std::runtime_error("[AssetReader] Non existing file " + path.string());
+			}
+			std::ifstream file(path, std::ios::binary);
+			return ReadScene(file, path.string(), verify);
+		}
+
+		static std::unique_ptr<File::SceneAsset> ReadScene(std::istream& file, const std::string& name, bool verify = false) {
+			auto sceneAsset = std::make_unique<File::SceneAsset>();
+			file.read(reinterpret_cast<char*>(&sceneAsset->header), sizeof(sceneAsset->header));
+
+			if (sceneAsset->header.magic != File::ASSET_MAGIC || sceneAsset->header.fileType != File::ASSET_SCENE) {
+				throw std::runtime_error("[AssetReader] Not a scene " + name);
+			}
+			CheckVersion(sceneAsset->header.version, File::SceneHeader{}.version, name);
+
+			sceneAsset->nodes.resize(sceneAsset->header.nodeCount);
+			sceneAsset->meshes.resize(sceneAsset->header.meshCount);
+			sceneAsset->instances.resize(sceneAsset->header.instanceCount);
+			Hash::XXH64State tableChecksum;
+			ReadTable(file, sceneAsset->nodes, tableChecksum);
+			ReadTable(file, sceneAsset->meshes, tableChecksum);
+			ReadTable(file, sceneAsset->instances, tableChecksum);
+			if (!file) {
+				throw std::runtime_error("[AssetReader] Truncated scene in " + name);
+			}
+			if (verify) {
+				CheckChecksum(tableChecksum.digest(), sceneAsset->header.tableChecksum, "tables", name);
+			}
+			return sceneAsset;
+		}
+
+		// Checks the header and TOC bounds of a pak loaded or mapped at data and returns its entries.
+		static std::span<const File::PakEntry> ReadPakToc(const uint8_t* data, uint64_t size, const std::string& name) {
+			File::PakHeader header;
+			if (size < sizeof(header)) {
+				throw std::runtime_error("[AssetReader] Not a pak " + name);
+			}
+			std::memcpy(&header, data, sizeof(header));
+			if (header.magic != File::ASSET_MAGIC || header.fileType != File::ASSET_PAK) {
+				throw std::runtime_error("[AssetReader] Not a pak " + name);
+			}
+			if (header.tocOffset + static_cast<uint64_t>(header.entryCount) * sizeof(File::PakEntry) > size) {
+				throw std::runtime_error("[AssetReader] Truncated pak TOC in " + name);
+			}
+			std::span<const File::PakEntry> entries(reinterpret_cast<const File::PakEntry*>(data + header.tocOffset), header.entryCount);
+			for (auto& entry : entries) {
+				if (entry.offset + entry.sizeInBytes > size) {
+					throw std::runtime_error("[AssetReader] Truncated pak entry " + std::string(entry.id) + " in " + name);
+				}
+			}
+			return entries;
+		}
+
+		// Binary search of the sorted TOC, nullptr when the pak has no such asset.
+		static const File::PakEntry* FindPakEntry(std::span<const File::PakEntry> entries, const std::string& id) {
+			auto itt = std::lower_bound(entries.begin(), entries.end(), id, [](const File::PakEntry& entry, const std::string& value) {
+				return std::strncmp(entry.id, value.c_str(), sizeof(entry.id)) < 0;
+				});
+			if (itt == entries.end() || std::strncmp(itt->id, id.c_str(), sizeof(itt->id)) != 0) return nullptr;
+			return &*itt;
+		}
+
+		// Reads one data section and decompresses it on the CPU, chunks in parallel when a pool is given.
+		// The result has the 64kb aligned section size; buffer entries index it with fileOffset - <section>DataOffset.
+		// verify checks the stored bytes against the section checksum before they are decompressed.
+		static std::vector<uint8_t> ReadSection(const fs::path& path, const File::MeshAsset& meshAsset, File::Section section, ThreadPool* pool = nullptr,
+			bool verify = false) {
+			auto& header = meshAsset.header;
+			uint64_t fileOffset = 0, storedSize = 0, size = 0, checksum = 0;
+			switch (section) {
+			case File::Section::ATTRIBUTE:
+				fileOffset = header.attributeDataOffset;
+				storedSize = header.attributeCompressedSizeInBytes;
+				size = header.attributeSizeInBytes;
+				checksum = header.attributeChecksum;
+				break;
+			case File::Section::INDEX:
+				fileOffset = header.indexDataOffset;
+				storedSize = header.indexCompressedSizeInBytes;
+				size = header.indexSizeInBytes;
+				checksum = header.indexChecksum;
+				break;
+			case File::Section::SKINNED:
+				fileOffset = header.skinnedDataOffset;
+				storedSize = header.skinnedCompressedSizeInBytes;
+				size = header.skinnedSizeInBytes;
+				checksum = header.skinnedChecksum;
+				break;
+			}
+
+			std::ifstream file(path, std::ios::binary);
+			std::vector<uint8_t> stored(storedSize);
+			file.seekg(fileOffset);
+			file.read(reinterpret_cast<char*>(stored.data()), stored.size());
+			if (!file) {
+				throw std::runtime_error("[AssetReader] Truncated section in " + path.string());
+			}
+			if (verify) {
+				CheckChecksum(Hash::XXH64(stored.data(), stored.size()), checksum, "section", path.string());
+			}
+			if (header.compression == File::CompressionFormat::NONE) return stored;
+
+			// chunks cover the unaligned payload; the 64kb tail stays zero
+			std::vector<uint8_t> data(size, 0);
+			ChunkedCompression::Decompress(stored.data(), fileOffset, meshAsset.chunks, section, data.data(), pool);
+			return data;
+		}
+
+		static void CheckChecksum(uint64_t checksum, uint64_t expected, const char* what, const std::string& name) {
+			if (checksum != expected) {
+				throw std::runtime_error(std::string("[AssetReader] Checksum mismatch in ") + what + " of " + name);
+			}
+		}
+
+	private:
+		static constexpr size_t VERIFY_BLOCK_SIZE = 1 << 20;
+
+		template<typename T>
+		static void ReadTable(std::istream& file, std::vector<T>& table, Hash::XXH64State& checksum) {
+			file.read(reinterpret_cast<char*>(table.data()), table.size() * sizeof(T));
+			checksum.update(table.data(), table.size() * sizeof(T));
+		}
+
+		static uint64_t GetBvhSize(const File::MeshHeader& header) {
+			return header.bvhNodeCount * sizeof(File::BvhNodeEntry) + header.bvhTriangleCount * sizeof(File::BvhTriangleEntry);
+		}
+
+		static void CheckVersion(uint32_t version, uint32_t expected, const std::string& name) {
+			if (version != expected) {
+				throw std::runtime_error("[AssetReader] " + name + " is version " + std::to_string(version) + ", expected "
+					+ std::to_string(expected) + "; recook it");
+			}
+		}
+
+		// The header promises data up to end; the stream position is kept.
+		static void CheckSize(std::istream& file, uint64_t end, const std::string& name) {
+			auto position = file.tellg();
+			file.seekg(0, std::ios::end);
+			auto size = static_cast<uint64_t>(file.tellg());
+			file.seekg(position);
+			if (size < end) {
+				throw std::runtime_error("[AssetReader] Truncated " + name + ": " + std::to_string(size) + " of " + std::to_string(end) + " bytes");
+			}
+		}
+
+		static void VerifyRange(std::istream& file, uint64_t offset, uint64_t size, uint64_t expected, const char* what, const std::string& name) {
+			Hash::XXH64State checksum;
+			std::vector<char> block(std::min<uint64_t>(size, VERIFY_BLOCK_SIZE));
+			file.seekg(offset);
+			for (uint64_t remaining = size; remaining; ) {
+				auto count = std::min<uint64_t>(remaining, block.size());
+				file.read(block.data(), count);
+				if (!file) {
+					throw std::runtime_error(std::string("[AssetReader] Truncated ") + what + " in " + name);
+				}
+				checksum.update(block.data(), count);
+				remaining -= count;
+			}
+			CheckChecksum(checksum.digest(), expected, what, name);
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <syncstream>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+
+#include "AssetReader.h"
+#include "ThreadPool.h"
+
+namespace AssetsCreator::Asset {
+	namespace fs = std::filesystem;
+
+	// Checks every cooked asset under a directory against its header: version, size, and the XXH64 of every table and
+	// section. Files, and the entries of a pak, are checked in parallel; the checks read each byte once.
+	class AssetValidator {
+	public:
+		struct Result {
+			uint32_t checked = 0;
+			uint32_t failed = 0;
+			uint64_t bytes = 0;
+		};
+
+		static Result ValidateTree(const fs::path& root, ThreadPool& pool) {
+			auto start = std::chrono::steady_clock::now();
+			std::vector<fs::path> files;
+			if (fs::is_regular_file(root)) {
+				files.push_back(root);
+			}
+			else {
+				for (auto& entry : fs::recursive_directory_iterator(root)) {
+					if (entry.is_regular_file() && IsAsset(entry.path())) files.push_back(entry.path());
+				}
+			}
+
+			std::atomic<uint32_t> checked{ 0 }, failed{ 0 };
+			std::atomic<uint64_t> bytes{ 0 };
+			pool.parallelFor(files.size(), [&](size_t i) {
+				auto& path = files[i];
+				try {
+					if (path.extension() == ".pak") {
+						ValidatePak(path, pool, checked, failed);
+					}
+					else {
+						ValidateFile(path);
+						checked++;
+					}
+					bytes += fs::file_size(path);
+				}
+				catch (const std::exception& e) {
+					checked++;
+					failed++;
+					std::osyncstream(std::cout) << "[AssetValidator] FAILED " << e.what() << "\n";
+				}
+				});
+
+			Result result{ checked.load(), failed.load(), bytes.load() };
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::osyncstream(std::cout) << "[AssetValidator] " << result.checked << " asset(s), " << result.failed << " failed, "
+				<< result.bytes / (1024 * 1024) << " MB in " << seconds << "s\n";
+			return result;
+		}
+
+		// Throws with the file and the failing part.
+		static void ValidateFile(const fs::path& path) {
+			std::ifstream file(path, std::ios::binary);
+			if (!file) {
+				throw std::runtime_error("[AssetValidator] Can't open " + path.string());
+			}
+			if (EndsWith(path.filename().string(), ".mesh.asset")) {
+				ValidatePayloads(*AssetReader::ReadMeshHeaders(file, path.string(), true), path);
+			}
+			else {
+				ValidateStream(file, path.filename().string(), path.string());
+			}
+		}
+
+	private:
+		static bool IsAsset(const fs::path& path) {
+			auto filename = path.filename().string();
+			return EndsWith(filename, ".mesh.asset") || EndsWith(filename, ".texture.asset") || EndsWith(filename, ".scene.asset")
+				|| path.extension() == ".pak";
+		}
+
+		static bool EndsWith(const std::string& value, const std::string& suffix) {
+			return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+		}
+
+		// id decides the asset type: a file name, or a pak entry id.
+		static void ValidateStream(std::istream& stream, const std::string& id, const std::string& name) {
+			if (EndsWith(id, ".mesh.asset")) AssetReader::ReadMeshHeaders(stream, name, true);
+			else if (EndsWith(id, ".texture.asset")) AssetReader::ReadTextureHeaders(stream, name, true);
+			else if (EndsWith(id, ".scene.asset")) AssetReader::ReadScene(stream, name, true);
+			else throw std::runtime_error("[AssetValidator] Unknown asset type " + name);
+		}
+
+		// Content store payloads live next to the tree, a mesh is only usable when they exist.
+		static void ValidatePayloads(const File::MeshAsset& meshAsset, const fs::path& path) {
+			for (auto& submesh : meshAsset.submeshes) {
+				if (!submesh.payloadHash) continue;
+				auto payloadPath = AssetReader::GetPayloadPath(path, meshAsset, submesh);
+				if (!fs::exists(payloadPath)) {
+					throw std::runtime_error("[AssetValidator] " + path.string() + " references missing payload " + payloadPath.string());
+				}
+			}
+		}
+
+		// Only the header and TOC are read up front, every entry is then read into memory and checked on its own.
+		static void ValidatePak(const fs::path& path, ThreadPool& pool, std::atomic<uint32_t>& checked, std::atomic<uint32_t>& failed) {
+			std::ifstream file(path, std::ios::binary);
+			File::PakHeader header = {};
+			file.read(reinterpret_cast<char*>(&header), sizeof(header));
+			if (!file) {
+				throw std::runtime_error("[AssetValidator] Not a pak " + path.string());
+			}
+			std::vector<uint8_t> toc(header.tocOffset + static_cast<uint64_t>(header.entryCount) * sizeof(File::PakEntry));
+			file.seekg(0);
+			file.read(reinterpret_cast<char*>(toc.data()), toc.size());
+			if (!file) {
+				throw std::runtime_error("[AssetValidator] Truncated pak TOC in " + path.string());
+			}
+			// ReadPakToc only touches the header and TOC, the file size bounds the entries
+			auto entries = AssetReader::ReadPakToc(toc.data(), fs::file_size(path), path.string());
+
+			pool.parallelFor(entries.size(), [&](size_t i) {
+				auto& entry = entries[i];
+				auto name = path.string() + ":" + entry.id;
+				try {
+					std::ifstream pak(path, std::ios::binary);
+					std::vector<uint8_t> data(entry.sizeInBytes);
+					pak.seekg(entry.offset);
+					pak.read(reinterpret_cast<char*>(data.data()), data.size());
+					if (!pak) {
+						throw std::runtime_error("[AssetValidator] Truncated " + name);
+					}
+					MemoryStream stream(data.data(), data.size());
+					ValidateStream(stream, entry.id, name);
+				}
+				catch (const std::exception& e) {
+					failed++;
+					std::osyncstream(std::cout) << "[AssetValidator] FAILED " << e.what() << "\n";
+				}
+				checked++;
+				});
+		}
+	};
+}
@@ -2,18 +2,23 @@
 
 
 #include "Structures.h"
+#include "ChunkedCompression.h"
+#include "BvhBuilder.h"
+#include "Hash.h"
 
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <syncstream>
 #include <algorithm>
+#include <unordered_map>
 
 
 inline uint64_t Align(uint64_t size, uint64_t alignment) {
 	return (size + alignment - 1) & ~(alignment - 1);
 }
 
-void CopyStringToChar50(const std::string& input, char(&output)[50]) {
+inline void CopyStringToChar50(const std::string& input, char(&output)[50]) {
 	std::fill(std::begin(output), std::end(output), 0); // Ensure null-termination
 	std::copy_n(input.c_str(), std::min<std::size_t>(input.size(), sizeof(output) - 1), output);
 }
@@ -21,166 +26,701 @@ void CopyStringToChar50(const std::string& input, char(&output)[50]) {
 namespace AssetsCreator::Asset {
 	namespace fs = std::filesystem;
 
-	class AssetWriter {
+	// Writes one .mesh.asset submesh by submesh, so a caller only has to keep the submesh it is adding in memory.
+	// Cooking decides the payload sizes, so payloads go to one spill file per section (compressed as they arrive) while the
+	// entries stay in memory; finish() lays out the tables from the entries alone and streams the spill files into the asset.
+	class StreamingAssetWriter {
 	public:
-		static void Write(const AssetsCreator::Asset::Mesh& mesh) {
-			static fs::path dir = fs::current_path() / "assets";
+		static constexpr uint64_t INDEX_BUFFER_ALIGNMENT = 4;
+		static constexpr size_t IO_BUFFER_SIZE = 1 << 20;
+
+		StreamingAssetWriter(std::string id, const fs::path& dir,
+			File::CompressionFormat compression = File::CompressionFormat::NONE, ThreadPool* pool = nullptr)
+			: m_id(std::move(id)), m_compression(compression) {
 			if (!fs::exists(dir)) {
 				fs::create_directories(dir);
 			}
-			
-			fs::path filename = dir / (mesh.id + ".mesh.asset");
-			std::ofstream file(filename, std::ios::binary);
+			m_filename = dir / (m_id + ".mesh.asset");
+			m_sections[0] = std::make_unique<SectionStream>(SpillPath(0), File::Section::ATTRIBUTE, compression, pool);
+			m_sections[1] = std::make_unique<SectionStream>(SpillPath(1), File::Section::INDEX, compression, pool);
+			m_sections[2] = std::make_unique<SectionStream>(SpillPath(2), File::Section::SKINNED, compression, pool);
+		}
+
+		~StreamingAssetWriter() {
+			removeSpillFiles();
+		}
+
+		StreamingAssetWriter(const StreamingAssetWriter&) = delete;
+		StreamingAssetWriter& operator=(const StreamingAssetWriter&) = delete;
+
+		// Source materials the submeshes' materialIndex refers to; only the ones a submesh uses end up in the table.
+		void setMaterials(const std::vector<Material>& materials) {
+			m_sourceMaterials = materials;
+			m_materialRemap.assign(materials.size(), NO_MATERIAL);
+		}
+
+		// Relative path from the output directory to the content store that addSubmeshReference payloads live in.
+		void setContentDirectory(const std::string& contentDirectory) {
+			if (contentDirectory.size() >= sizeof(File::MeshHeader::contentDirectory)) {
+				throw std::runtime_error("[AssetWriter] Content directory path too long: " + contentDirectory);
+			}
+			m_contentDirectory = contentDirectory;
+		}
+
+		// Content store payloads leave the BVH to the meshes referencing them.
+		void setBvh(bool enabled) {
+			m_bvhEnabled = enabled;
+		}
+
+		// Submesh whose cooked data is a content store payload: only bounds, topology and material are written here.
+		void addSubmeshReference(const SubMesh& submesh, uint64_t payloadHash) {
+			File::SubmeshEntry submeshEntry = {};
+			CopyStringToChar50(submesh.id, submeshEntry.id);
+			submeshEntry.attributeBufferIndex = static_cast<uint32_t>(m_attributeBuffers.size());
+			submeshEntry.indexBufferIndex = ~0u;
+			submeshEntry.skinnedBufferIndex = static_cast<uint32_t>(m_skinnedBuffers.size());
+			submeshEntry.meshletIndex = static_cast<uint32_t>(m_meshlets.size());
+			submeshEntry.lodIndex = static_cast<uint32_t>(m_lods.size());
+			submeshEntry.topology = submesh.topology;
+			submeshEntry.materialID = addMaterial(submesh.materialIndex);
+			std::copy_n(submesh.aabbMin, 3, submeshEntry.aabbMin);
+			std::copy_n(submesh.aabbMax, 3, submeshEntry.aabbMax);
+			submeshEntry.payloadHash = payloadHash;
+			if (m_bvhEnabled) BvhBuilder::AddTriangles(m_bvhTriangles, submesh, static_cast<uint32_t>(m_submeshes.size()));
+			m_submeshes.push_back(submeshEntry);
+			m_draws.push_back(MakeDraw(submesh, false));
+			m_payloadHashes.push_back(payloadHash);
+		}
+
+		const std::vector<uint64_t>& getPayloadHashes() const { return m_payloadHashes; }
+
+		void addSubmesh(const SubMesh& submesh) {
+			auto& attributeSection = *m_sections[0];
+			auto& indexSection = *m_sections[1];
+			auto& skinnedSection = *m_sections[2];
+
+			File::SubmeshEntry submeshEntry = {};
+			File::DrawEntry draw = MakeDraw(submesh, true);
+			CopyStringToChar50(submesh.id, submeshEntry.id);
+			submeshEntry.attributeBufferIndex = static_cast<uint32_t>(m_attributeBuffers.size());
+			submeshEntry.indexBufferIndex = static_cast<uint32_t>(m_indexBuffers.size());
+			submeshEntry.skinnedBufferIndex = static_cast<uint32_t>(m_skinnedBuffers.size());
+			submeshEntry.topology = submesh.topology;
+			submeshEntry.materialID = addMaterial(submesh.materialIndex);
+			std::copy_n(submesh.aabbMin, 3, submeshEntry.aabbMin);
+			std::copy_n(submesh.aabbMax, 3, submeshEntry.aabbMax);
+
+			submeshEntry.meshletIndex = static_cast<uint32_t>(m_meshlets.size());
+			submeshEntry.meshletCount = static_cast<uint32_t>(submesh.meshlets.size());
+			for (auto& meshlet : submesh.meshlets) {
+				File::MeshletEntry meshletEntry = {};
+				meshletEntry.firstIndex = meshlet.firstIndex;
+				meshletEntry.indexCount = meshlet.indexCount;
+				meshletEntry.vertexCount = meshlet.vertexCount;
+				std::copy_n(meshlet.center, 3, meshletEntry.center);
+				meshletEntry.radius = meshlet.radius;
+				std::copy_n(meshlet.coneApex, 3, meshletEntry.coneApex);
+				std::copy_n(meshlet.coneAxis, 3, meshletEntry.coneAxis);
+				meshletEntry.coneCutoff = meshlet.coneCutoff;
+				m_meshlets.push_back(meshletEntry);
+			}
+
+			submeshEntry.lodIndex = static_cast<uint32_t>(m_lods.size());
+			submeshEntry.lodCount = static_cast<uint32_t>(submesh.lods.size());
+			for (auto& lod : submesh.lods) {
+				m_lods.push_back({ lod.firstIndex, lod.indexCount, lod.error });
+			}
+
+			// fileOffset holds the offset inside the section until finish() knows where the section starts
+			for (auto& [attributeType, attribute] : submesh.attributes) {
+				if (attributeType == AttributeType::JOINT || attributeType == AttributeType::WEIGHT) {
+					submeshEntry.skinnedBufferCount++;
+
+					File::SkinnedBufferEntry skinnedBufferEntry = {};
+					skinnedBufferEntry.format = attribute->format;
+					skinnedBufferEntry.sizeInBytes = attribute->data.size();
+					skinnedBufferEntry.type = attribute->type;
+					skinnedBufferEntry.typeIndex = attribute->semanticIndex;
+					skinnedBufferEntry.vertexCount = static_cast<uint32_t>(attribute->data.size()) / attribute->strideInBytes;
+					skinnedBufferEntry.fileOffset = skinnedSection.size();
+					AddDrawStream(draw, attribute->type, attribute->semanticIndex, attribute->format,
+						{ skinnedBufferEntry.fileOffset, static_cast<uint32_t>(attribute->data.size()), attribute->strideInBytes }, false);
+					skinnedSection.write(attribute->data.data(), attribute->data.size());
+					m_skinnedBuffers.push_back(skinnedBufferEntry);
+				}
+				else {
+					submeshEntry.attributeBufferCount++;
+
+					File::AttributeBufferEntry attributeBufferEntry = {};
+					attributeBufferEntry.format = attribute->format;
+					attributeBufferEntry.sizeInBytes = attribute->data.size();
+					attributeBufferEntry.type = attribute->type;
+					attributeBufferEntry.typeIndex = attribute->semanticIndex;
+					attributeBufferEntry.vertexCount = static_cast<uint32_t>(attribute->data.size()) / attribute->strideInBytes;
+					attributeBufferEntry.strideInBytes = attribute->strideInBytes;
+					attributeBufferEntry.fileOffset = attributeSection.size();
+					AddDrawStream(draw, attribute->type, attribute->semanticIndex, attribute->format,
+						{ attributeBufferEntry.fileOffset, static_cast<uint32_t>(attribute->data.size()), attribute->strideInBytes }, false);
+					attributeSection.write(attribute->data.data(), attribute->data.size());
+					m_attributeBuffers.push_back(attributeBufferEntry);
+				}
+			}
+
+			if (submesh.interleaved) {
+				auto& stream = *submesh.interleaved;
+				uint64_t fileOffset = attributeSection.size();
+				attributeSection.write(stream.data.data(), stream.data.size());
+				for (auto& element : stream.elements) {
+					submeshEntry.attributeBufferCount++;
+
+					File::AttributeBufferEntry attributeBufferEntry = {};
+					attributeBufferEntry.format = element.format;
+					attributeBufferEntry.sizeInBytes = stream.data.size();
+					attributeBufferEntry.type = element.type;
+					attributeBufferEntry.typeIndex = element.semanticIndex;
+					attributeBufferEntry.vertexCount = static_cast<uint32_t>(stream.data.size() / stream.strideInBytes);
+					attributeBufferEntry.strideInBytes = stream.strideInBytes;
+					attributeBufferEntry.elementOffset = element.offset;
+					attributeBufferEntry.fileOffset = fileOffset;
+					m_attributeBuffers.push_back(attributeBufferEntry);
+					AddDrawStream(draw, element.type, element.semanticIndex, element.format,
+						{ fileOffset, static_cast<uint32_t>(stream.data.size()), stream.strideInBytes }, true);
+				}
+			}
+
+			File::IndexBufferEntry indexBufferEntry = {};
+			indexBufferEntry.format = submesh.indices.format;
+			indexBufferEntry.indexCount = static_cast<uint32_t>(submesh.indices.data.size()) / submesh.indices.strideInBytes;
+			indexBufferEntry.sizeInBytes = submesh.indices.data.size();
+			indexBufferEntry.fileOffset = indexSection.size();
+			draw.indexOffset = indexBufferEntry.fileOffset;
+			indexSection.write(submesh.indices.data.data(), submesh.indices.data.size());
+			// 16 bit payloads can end on a 2 byte boundary; keep every index buffer 4 byte aligned for the 32 bit ones that follow.
+			indexSection.align(INDEX_BUFFER_ALIGNMENT);
+			m_indexBuffers.push_back(indexBufferEntry);
+
+			if (m_bvhEnabled) BvhBuilder::AddTriangles(m_bvhTriangles, submesh, static_cast<uint32_t>(m_submeshes.size()));
+			m_submeshes.push_back(submeshEntry);
+			m_draws.push_back(draw);
+		}
+
+		fs::path finish() {
+			for (auto& section : m_sections) section->close();
+			auto& attributeSection = *m_sections[0];
+			auto& indexSection = *m_sections[1];
+			auto& skinnedSection = *m_sections[2];
 
 			File::MeshHeader header = {};
-			CopyStringToChar50(mesh.id, header.id);
-			header.submeshCount = static_cast<uint32_t>(mesh.submeshes.size());
+			CopyStringToChar50(m_id, header.id);
+			header.submeshCount = static_cast<uint32_t>(m_submeshes.size());
+			header.attributeBufferCount = static_cast<uint32_t>(m_attributeBuffers.size());
+			header.indexBufferCount = static_cast<uint32_t>(m_indexBuffers.size());
+			header.skinnedBufferCount = static_cast<uint32_t>(m_skinnedBuffers.size());
+			header.meshletCount = static_cast<uint32_t>(m_meshlets.size());
+			header.lodCount = static_cast<uint32_t>(m_lods.size());
+			header.materialCount = static_cast<uint32_t>(m_materials.size());
+			header.textureReferenceCount = static_cast<uint32_t>(m_textureReferences.size());
+			CopyStringToChar50(m_contentDirectory, header.contentDirectory);
+			header.attributeSizeInBytes = Align(attributeSection.size(), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+			header.indexSizeInBytes = Align(indexSection.size(), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+			header.skinnedSizeInBytes = Align(skinnedSection.size(), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
 
-			std::vector<File::AttributeBufferEntry> vAttributeBufferEntry;
-			std::vector<std::vector<uint8_t>> vAttributeBufferEntryData;
+			// Compressed sections drop the 64kb padding, it only matters for the GPU allocation.
+			header.compression = m_compression;
+			if (m_compression != File::CompressionFormat::NONE) {
+				header.chunkSize = ChunkedCompression::CHUNK_SIZE;
+			}
+			header.chunkCount = static_cast<uint32_t>(attributeSection.chunks().size() + indexSection.chunks().size() + skinnedSection.chunks().size());
+			header.attributeCompressedSizeInBytes = attributeSection.storedSize();
+			header.indexCompressedSizeInBytes = indexSection.storedSize();
+			header.skinnedCompressedSizeInBytes = skinnedSection.storedSize();
+
+			header.attributeDataOffset = sizeof(File::MeshHeader)
+				+ sizeof(File::AttributeBufferEntry) * m_attributeBuffers.size()
+				+ sizeof(File::IndexBufferEntry) * m_indexBuffers.size()
+				+ sizeof(File::SkinnedBufferEntry) * m_skinnedBuffers.size()
+				+ sizeof(File::SubmeshEntry) * m_submeshes.size()
+				+ sizeof(File::MeshletEntry) * m_meshlets.size()
+				+ sizeof(File::LodEntry) * m_lods.size()
+				+ sizeof(File::ChunkEntry) * header.chunkCount
+				+ sizeof(File::MaterialEntry) * m_materials.size()
+				+ sizeof(File::TextureReferenceEntry) * m_textureReferences.size()
+				+ sizeof(File::DrawEntry) * m_draws.size();
 
-			std::vector<File::IndexBufferEntry> vIndexBufferEntry;
-			std::vector<std::vector<uint8_t>> vIndexBufferEntryData;
+			header.indexDataOffset = header.attributeDataOffset + header.attributeCompressedSizeInBytes;
+			header.skinnedDataOffset = header.indexDataOffset + header.indexCompressedSizeInBytes;
 
-			std::vector<File::SkinnedBufferEntry> vSkinnedBufferEntry;
-			std::vector<std::vector<uint8_t>> vSkinnedBufferEntryData;
+			auto bvh = BvhBuilder::Build(std::move(m_bvhTriangles));
+			header.bvhNodeCount = static_cast<uint32_t>(bvh.nodes.size());
+			header.bvhTriangleCount = static_cast<uint32_t>(bvh.triangles.size());
+			header.bvhDataOffset = bvh.nodes.empty() ? 0 : header.skinnedDataOffset + header.skinnedCompressedSizeInBytes;
 
-			std::vector<File::SubmeshEntry> vSubmeshEntry;
+			for (auto& entry : m_attributeBuffers) entry.fileOffset += header.attributeDataOffset;
+			for (auto& entry : m_indexBuffers) entry.fileOffset += header.indexDataOffset;
+			for (auto& entry : m_skinnedBuffers) entry.fileOffset += header.skinnedDataOffset;
 
-			for (auto& submesh : mesh.submeshes) {
-				File::SubmeshEntry submeshEntry = {};
-				CopyStringToChar50(submesh->id, submeshEntry.id);
-				submeshEntry.attributeBufferIndex = header.attributeBufferCount;
-				submeshEntry.indexBufferIndex = header.indexBufferCount;
-				submeshEntry.skinnedBufferIndex = header.skinnedBufferCount;
-				submeshEntry.topology = submesh->topology;
-				submeshEntry.aabbMin[0] = submesh->aabbMin[0];
-				submeshEntry.aabbMin[1] = submesh->aabbMin[1];
-				submeshEntry.aabbMin[2] = submesh->aabbMin[2];
-
-				submeshEntry.aabbMax[0] = submesh->aabbMax[0];
-				submeshEntry.aabbMax[1] = submesh->aabbMax[1];
-				submeshEntry.aabbMax[2] = submesh->aabbMax[2];
-
-
-				for (auto& [attributeType, attribute] : submesh->attributes) {
-					if (attributeType == AttributeType::JOINT || attributeType == AttributeType::WEIGHT) {
-						submeshEntry.skinnedBufferCount++;
-
-						File::SkinnedBufferEntry skinnedBufferEntry = {};
-						skinnedBufferEntry.format = attribute->format;
-						skinnedBufferEntry.sizeInBytes = attribute->data.size();
-						skinnedBufferEntry.type = attribute->type;
-						skinnedBufferEntry.typeIndex = attribute->semanticIndex;
-						skinnedBufferEntry.vertexCount = static_cast<uint32_t>(attribute->data.size()) / attribute->strideInBytes;
-						vSkinnedBufferEntry.push_back(std::move(skinnedBufferEntry));
-						vSkinnedBufferEntryData.push_back(std::move(attribute->data));
-
-						header.skinnedBufferCount++;
-					}
-					else {
-						submeshEntry.attributeBufferCount++;
-
-						File::AttributeBufferEntry attributeBufferEntry = {};
-						attributeBufferEntry.format = attribute->format;
-						attributeBufferEntry.sizeInBytes = attribute->data.size();
-						attributeBufferEntry.type = attribute->type;
-						attributeBufferEntry.typeIndex = attribute->semanticIndex;
-						attributeBufferEntry.vertexCount = static_cast<uint32_t>(attribute->data.size()) / attribute->strideInBytes;
-						vAttributeBufferEntry.push_back(std::move(attributeBufferEntry));
-						vAttributeBufferEntryData.push_back(std::move(attribute->data));
-
-						header.attributeBufferCount++;
-					}
+			std::vector<File::ChunkEntry> vChunkEntry;
+			vChunkEntry.reserve(header.chunkCount);
+			AddChunkEntries(vChunkEntry, attributeSection.chunks(), header.attributeDataOffset);
+			AddChunkEntries(vChunkEntry, indexSection.chunks(), header.indexDataOffset);
+			AddChunkEntries(vChunkEntry, skinnedSection.chunks(), header.skinnedDataOffset);
+
+			Hash::XXH64State tableChecksum;
+			HashTable(tableChecksum, m_attributeBuffers);
+			HashTable(tableChecksum, m_indexBuffers);
+			HashTable(tableChecksum, m_skinnedBuffers);
+			HashTable(tableChecksum, m_submeshes);
+			HashTable(tableChecksum, m_meshlets);
+			HashTable(tableChecksum, m_lods);
+			HashTable(tableChecksum, vChunkEntry);
+			HashTable(tableChecksum, m_materials);
+			HashTable(tableChecksum, m_textureReferences);
+			HashTable(tableChecksum, m_draws);
+			header.tableChecksum = tableChecksum.digest();
+			header.attributeChecksum = attributeSection.checksum();
+			header.indexChecksum = indexSection.checksum();
+			header.skinnedChecksum = skinnedSection.checksum();
+			Hash::XXH64State bvhChecksum;
+			HashTable(bvhChecksum, bvh.nodes);
+			HashTable(bvhChecksum, bvh.triangles);
+			header.bvhChecksum = bvhChecksum.digest();
+
+			std::vector<char> buffer(IO_BUFFER_SIZE);
+			{
+				std::ofstream file;
+				file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+				file.open(m_filename, std::ios::binary | std::ios::trunc);
+
+				file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				file.write(reinterpret_cast<const char*>(m_attributeBuffers.data()), m_attributeBuffers.size() * sizeof(File::AttributeBufferEntry));
+				file.write(reinterpret_cast<const char*>(m_indexBuffers.data()), m_indexBuffers.size() * sizeof(File::IndexBufferEntry));
+				file.write(reinterpret_cast<const char*>(m_skinnedBuffers.data()), m_skinnedBuffers.size() * sizeof(File::SkinnedBufferEntry));
+				file.write(reinterpret_cast<const char*>(m_submeshes.data()), m_submeshes.size() * sizeof(File::SubmeshEntry));
+				file.write(reinterpret_cast<const char*>(m_meshlets.data()), m_meshlets.size() * sizeof(File::MeshletEntry));
+				file.write(reinterpret_cast<const char*>(m_lods.data()), m_lods.size() * sizeof(File::LodEntry));
+				file.write(reinterpret_cast<const char*>(vChunkEntry.data()), vChunkEntry.size() * sizeof(File::ChunkEntry));
+				file.write(reinterpret_cast<const char*>(m_materials.data()), m_materials.size() * sizeof(File::MaterialEntry));
+				file.write(reinterpret_cast<const char*>(m_textureReferences.data()), m_textureReferences.size() * sizeof(File::TextureReferenceEntry));
+				file.write(reinterpret_cast<const char*>(m_draws.data()), m_draws.size() * sizeof(File::DrawEntry));
+
+				for (auto& section : m_sections) section->copyTo(file);
+				file.write(reinterpret_cast<const char*>(bvh.nodes.data()), bvh.nodes.size() * sizeof(File::BvhNodeEntry));
+				file.write(reinterpret_cast<const char*>(bvh.triangles.data()), bvh.triangles.size() * sizeof(File::BvhTriangleEntry));
+
+				file.flush();
+				if (!file) {
+					throw std::runtime_error("[AssetWriter] Failed to write " + m_filename.string());
 				}
+			}
+			removeSpillFiles();
+
+			if (m_compression != File::CompressionFormat::NONE && header.chunkCount) {
+				std::osyncstream(std::cout) << "[AssetWriter] " << m_id << " " << ChunkedCompression::FormatName(m_compression) << " "
+					<< attributeSection.size() + indexSection.size() + skinnedSection.size() << " -> "
+					<< header.attributeCompressedSizeInBytes + header.indexCompressedSizeInBytes + header.skinnedCompressedSizeInBytes
+					<< " bytes in " << header.chunkCount << " chunks\n";
+			}
+			return m_filename;
+		}
 
-				File::IndexBufferEntry indexBufferEntry = {};
-				indexBufferEntry.format = submesh->indices.format;
-				indexBufferEntry.indexCount = static_cast<uint32_t>(submesh->indices.data.size()) / submesh->indices.strideInBytes;
-				indexBufferEntry.sizeInBytes = submesh->indices.data.size();
-				vIndexBufferEntryData.push_back(std::move(submesh->indices.data));
-				vIndexBufferEntry.push_back(std::move(indexBufferEntry));
-				header.indexBufferCount++;
+	private:
+		// Payload of one section as it will be stored: raw and padded to 64kb, or compressed in CHUNK_SIZE chunks
+		// that are batched so a pool can compress several at once.
+		class SectionStream {
+		public:
+			static constexpr size_t BATCH_SIZE = ChunkedCompression::CHUNK_SIZE * 16;
+
+			SectionStream(fs::path spillPath, File::Section section, File::CompressionFormat compression, ThreadPool* pool)
+				: m_spillPath(std::move(spillPath)), m_section(section), m_compression(compression), m_pool(pool), m_ioBuffer(IO_BUFFER_SIZE) {
+				m_spill.rdbuf()->pubsetbuf(m_ioBuffer.data(), m_ioBuffer.size());
+				m_spill.open(m_spillPath, std::ios::binary | std::ios::trunc);
+				if (!m_spill) {
+					throw std::runtime_error("[AssetWriter] Can't create " + m_spillPath.string());
+				}
+			}
 
-				vSubmeshEntry.push_back(std::move(submeshEntry));
+			void write(const uint8_t* data, size_t size) {
+				m_size += size;
+				if (m_compression == File::CompressionFormat::NONE) {
+					m_spill.write(reinterpret_cast<const char*>(data), size);
+					m_checksum.update(data, size);
+					return;
+				}
+				while (size) {
+					size_t count = std::min(size, BATCH_SIZE - m_pending.size());
+					m_pending.insert(m_pending.end(), data, data + count);
+					data += count;
+					size -= count;
+					if (m_pending.size() == BATCH_SIZE) flush();
+				}
 			}
 
-			for (auto& v : vAttributeBufferEntryData) {
-				header.attributeSizeInBytes += v.size();
+			void align(uint64_t alignment) {
+				static constexpr uint8_t zeroes[16] = {};
+				write(zeroes, Align(m_size, alignment) - m_size);
 			}
-			for (auto& v : vIndexBufferEntryData) {
-				header.indexSizeInBytes += v.size();
+
+			void close() {
+				if (!m_spill.is_open()) return;
+				if (m_compression == File::CompressionFormat::NONE) {
+					std::vector<char> zeroes(Align(m_size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT) - m_size, 0);
+					m_spill.write(zeroes.data(), zeroes.size());
+					m_checksum.update(zeroes.data(), zeroes.size());
+					m_storedSize = m_size + zeroes.size();
+				}
+				else {
+					flush();
+					m_pending.shrink_to_fit();
+				}
+				m_spill.close();
+				if (!m_spill) {
+					throw std::runtime_error("[AssetWriter] Failed to write " + m_spillPath.string());
+				}
 			}
-			for (auto& v : vSkinnedBufferEntryData) {
-				header.skinnedSizeInBytes += v.size();
+
+			void copyTo(std::ostream& out) {
+				std::ifstream spill(m_spillPath, std::ios::binary);
+				while (spill) {
+					spill.read(m_ioBuffer.data(), m_ioBuffer.size());
+					out.write(m_ioBuffer.data(), spill.gcount());
+				}
 			}
-			uint64_t nonAlignedAttributeSize = header.attributeSizeInBytes;
-			uint64_t nonAlignedIndexSize = header.indexSizeInBytes;
-			uint64_t nonAlignedSkinnedSize = header.skinnedSizeInBytes;
-			header.attributeSizeInBytes = Align(header.attributeSizeInBytes, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
-			header.indexSizeInBytes = Align(header.indexSizeInBytes, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
-			header.skinnedSizeInBytes = Align(header.skinnedSizeInBytes, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
 
-			header.attributeDataOffset = sizeof(File::MeshHeader)
-				+ sizeof(File::AttributeBufferEntry) * vAttributeBufferEntry.size()
-				+ sizeof(File::IndexBufferEntry) * vIndexBufferEntry.size()
-				+ sizeof(File::SkinnedBufferEntry) * vSkinnedBufferEntry.size()
-				+ sizeof(File::SubmeshEntry) * vSubmeshEntry.size();
+			// Payload bytes, alignment padding included.
+			uint64_t size() const { return m_size; }
+			uint64_t storedSize() const { return m_storedSize; }
+			// Of the stored bytes, computed as they go to the spill file.
+			uint64_t checksum() const { return m_checksum.digest(); }
+			// fileOffset is relative to the start of the section.
+			const std::vector<File::ChunkEntry>& chunks() const { return m_chunks; }
+
+			void discard() {
+				m_spill.close();
+				std::error_code error;
+				fs::remove(m_spillPath, error);
+			}
 
-			header.indexDataOffset = header.attributeDataOffset + header.attributeSizeInBytes;
-			header.skinnedDataOffset = header.indexDataOffset + header.indexSizeInBytes;
+		private:
+			void flush() {
+				if (m_pending.empty()) return;
+				auto chunks = ChunkedCompression::Compress(m_pending.data(), m_pending.size(), m_compression, m_pool);
+				for (auto& chunk : chunks) {
+					File::ChunkEntry entry = {};
+					entry.section = m_section;
+					entry.format = chunk.format;
+					entry.fileOffset = m_storedSize;
+					entry.uncompressedOffset = m_flushedSize + chunk.uncompressedOffset;
+					entry.compressedSize = static_cast<uint32_t>(chunk.data.size());
+					entry.uncompressedSize = chunk.uncompressedSize;
+					m_chunks.push_back(entry);
+					m_spill.write(reinterpret_cast<const char*>(chunk.data.data()), chunk.data.size());
+					m_checksum.update(chunk.data.data(), chunk.data.size());
+					m_storedSize += chunk.data.size();
+				}
+				m_flushedSize += m_pending.size();
+				m_pending.clear();
+			}
+
+			fs::path m_spillPath;
+			File::Section m_section;
+			File::CompressionFormat m_compression;
+			ThreadPool* m_pool;
+			std::vector<char> m_ioBuffer;
+			std::ofstream m_spill;
+			std::vector<uint8_t> m_pending;
+			std::vector<File::ChunkEntry> m_chunks;
+			uint64_t m_size = 0;
+			uint64_t m_flushedSize = 0;
+			uint64_t m_storedSize = 0;
+			Hash::XXH64State m_checksum;
+		};
+
+		template<typename T>
+		static void HashTable(Hash::XXH64State& state, const std::vector<T>& table) {
+			state.update(table.data(), table.size() * sizeof(T));
+		}
+
+		fs::path SpillPath(int section) const {
+			return m_filename.string() + "." + std::to_string(section) + ".tmp";
+		}
 
-			uint64_t attributeBufferFileOffset = header.attributeDataOffset;
-			for (uint32_t i = 0; i < vAttributeBufferEntry.size(); i++) {
-				auto& entry = vAttributeBufferEntry[i];
-				auto& data = vAttributeBufferEntryData[i];
-				entry.fileOffset = attributeBufferFileOffset;
-				attributeBufferFileOffset += data.size();
+		void removeSpillFiles() {
+			for (auto& section : m_sections) {
+				if (section) section->discard();
 			}
+		}
 
-			uint64_t indexBufferFileOffset = header.indexDataOffset;
-			for (uint32_t i = 0; i < vIndexBufferEntry.size(); i++) {
-				auto& entry = vIndexBufferEntry[i];
-				auto& data = vIndexBufferEntryData[i];
-				entry.fileOffset = indexBufferFileOffset;
-				indexBufferFileOffset += data.size();
+		// Index of the material in the written table, adding it (and its textures) on first use.
+		// Submeshes without a source material share one default material.
+		uint32_t addMaterial(uint32_t sourceIndex) {
+			bool hasSource = sourceIndex < m_sourceMaterials.size();
+			uint32_t& index = hasSource ? m_materialRemap[sourceIndex] : m_defaultMaterial;
+			if (index != NO_MATERIAL) return index;
+
+			static const Material defaultMaterial = {};
+			const Material& material = hasSource ? m_sourceMaterials[sourceIndex] : defaultMaterial;
+
+			File::MaterialEntry entry = {};
+			std::copy_n(material.emissiveFactor, 4, entry.emissiveFactor);
+			std::copy_n(material.baseColorFactor, 4, entry.baseColorFactor);
+			std::copy_n(material.normalScaleOcclusionStrengthMRFactors, 4, entry.normalScaleOcclusionStrengthMRFactors);
+			for (uint32_t i = 0; i < static_cast<uint32_t>(MaterialTexture::COUNT); i++) {
+				entry.textureIndices[i] = addTextureReference(material.textures[i]);
 			}
+			entry.alphaMode = material.alphaMode;
+			entry.alphaCutoff = material.alphaCutoff;
+			entry.doubleSided = material.doubleSided;
+
+			index = static_cast<uint32_t>(m_materials.size());
+			m_materials.push_back(entry);
+			return index;
+		}
 
-			uint64_t skinnedBufferFileOffset = header.skinnedDataOffset;
-			for (uint32_t i = 0; i < vSkinnedBufferEntry.size(); i++) {
-				auto& entry = vSkinnedBufferEntry[i];
-				auto& data = vSkinnedBufferEntryData[i];
-				entry.fileOffset = skinnedBufferFileOffset;
-				skinnedBufferFileOffset += data.size();
+		uint32_t addTextureReference(const std::string& textureId) {
+			if (textureId.empty()) return File::NO_TEXTURE;
+			auto [it, inserted] = m_textureReferenceIndices.emplace(textureId, static_cast<uint32_t>(m_textureReferences.size()));
+			if (inserted) {
+				File::TextureReferenceEntry entry = {};
+				CopyStringToChar50(textureId, entry.id);
+				m_textureReferences.push_back(entry);
 			}
+			return it->second;
+		}
 
-			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
-			file.write(reinterpret_cast<const char*>(vAttributeBufferEntry.data()), vAttributeBufferEntry.size() * sizeof(File::AttributeBufferEntry));
-			file.write(reinterpret_cast<const char*>(vIndexBufferEntry.data()), vIndexBufferEntry.size() * sizeof(File::IndexBufferEntry));
-			file.write(reinterpret_cast<const char*>(vSkinnedBufferEntry.data()), vSkinnedBufferEntry.size() * sizeof(File::SkinnedBufferEntry));
-			file.write(reinterpret_cast<const char*>(vSubmeshEntry.data()), vSubmeshEntry.size() * sizeof(File::SubmeshEntry));
+		// Bounds, and for submeshes stored in this file the index view and LODs; the streams are added by AddDrawStream as
+		// they are written. A submesh without LODs draws all of its indices as LOD0, a payload reference draws nothing.
+		static File::DrawEntry MakeDraw(const SubMesh& submesh, bool stored) {
+			File::DrawEntry draw = {};
+			std::copy_n(submesh.aabbMin, 3, draw.aabbMin);
+			std::copy_n(submesh.aabbMax, 3, draw.aabbMax);
+			draw.lodCount = 1;
+			if (!stored) return draw;
 
-			{
-				for (auto& v : vAttributeBufferEntryData) {
-					file.write(reinterpret_cast<const char*>(v.data()), v.size());
+			draw.indexFormat = submesh.indices.format;
+			draw.indexSizeInBytes = static_cast<uint32_t>(submesh.indices.data.size());
+			draw.indexCount = draw.indexSizeInBytes / submesh.indices.strideInBytes;
+			draw.lods[0] = { 0, draw.indexCount, 0.f };
+			if (!submesh.lods.empty()) {
+				draw.lodCount = static_cast<uint32_t>(std::min<size_t>(submesh.lods.size(), File::DRAW_MAX_LOD_COUNT));
+				for (uint32_t i = 0; i < draw.lodCount; i++) {
+					draw.lods[i] = { submesh.lods[i].firstIndex, submesh.lods[i].indexCount, submesh.lods[i].error };
 				}
-				auto zeroes = std::vector<char>(header.attributeSizeInBytes - nonAlignedAttributeSize, 0);
-				file.write(zeroes.data(), zeroes.size());
 			}
-			{
-				for (auto& v : vIndexBufferEntryData) {
-					file.write(reinterpret_cast<const char*>(v.data()), v.size());
+			return draw;
+		}
+
+		// Same choice as the renderer made from the buffer entries: semantic index 0 only, the elements of the interleaved
+		// stream share the SURFACE view; the 16 bit formats of quantization set their DRAW_* bit.
+		static void AddDrawStream(File::DrawEntry& draw, AttributeType type, uint32_t semanticIndex, DXGI_FORMAT format,
+			File::DrawStreamEntry stream, bool interleaved) {
+			if (semanticIndex != 0) return;
+			auto set = [&](File::DrawStream slot) {
+				if (interleaved && slot != File::DrawStream::POSITION) {
+					slot = File::DrawStream::SURFACE;
+					draw.vertexFormat |= File::DRAW_INTERLEAVED;
 				}
-				auto zeroes = std::vector<char>(header.indexSizeInBytes - nonAlignedIndexSize, 0);
-				file.write(zeroes.data(), zeroes.size());
+				draw.streams[static_cast<uint32_t>(slot)] = stream;
+				};
+			switch (type) {
+			case AttributeType::POSITION:
+				set(File::DrawStream::POSITION);
+				if (format == DXGI_FORMAT_R16G16B16A16_UNORM) draw.vertexFormat |= File::DRAW_POSITION_UNORM16;
+				break;
+			case AttributeType::NORMAL:
+				set(File::DrawStream::NORMAL);
+				if (format == DXGI_FORMAT_R16G16_SNORM) draw.vertexFormat |= File::DRAW_NORMAL_OCT16;
+				break;
+			case AttributeType::TEXCOORD:
+				set(File::DrawStream::TEXCOORD);
+				if (format == DXGI_FORMAT_R16G16_FLOAT) draw.vertexFormat |= File::DRAW_TEXCOORD_HALF;
+				break;
+			case AttributeType::TANGENT:
+				set(File::DrawStream::TANGENT);
+				if (format == DXGI_FORMAT_R16G16B16A16_SNORM) draw.vertexFormat |= File::DRAW_TANGENT_OCT16;
+				break;
+			case AttributeType::JOINT:
+				set(File::DrawStream::JOINTS);
+				draw.jointsFormat = format;
+				break;
+			case AttributeType::WEIGHT:
+				set(File::DrawStream::WEIGHTS);
+				draw.weightsFormat = format;
+				break;
+			case AttributeType::COLOR:
+				set(File::DrawStream::COLOR);
+				draw.colorFormat = format;
+				break;
+			default:
+				break;
 			}
-			{
-				for (auto& v : vSkinnedBufferEntryData) {
-					file.write(reinterpret_cast<const char*>(v.data()), v.size());
+		}
+
+		static void AddChunkEntries(std::vector<File::ChunkEntry>& entries, const std::vector<File::ChunkEntry>& chunks, uint64_t sectionDataOffset) {
+			for (auto entry : chunks) {
+				entry.fileOffset += sectionDataOffset;
+				entries.push_back(entry);
+			}
+		}
+
+		std::string m_id;
+		fs::path m_filename;
+		File::CompressionFormat m_compression;
+		std::unique_ptr<SectionStream> m_sections[3]; // File::Section order
+
+		std::vector<File::AttributeBufferEntry> m_attributeBuffers;
+		std::vector<File::IndexBufferEntry> m_indexBuffers;
+		std::vector<File::SkinnedBufferEntry> m_skinnedBuffers;
+		std::vector<File::SubmeshEntry> m_submeshes;
+		std::vector<File::MeshletEntry> m_meshlets;
+		std::vector<File::LodEntry> m_lods;
+		std::vector<File::DrawEntry> m_draws; // one per submesh, stream offsets relative to their section
+
+		std::vector<Material> m_sourceMaterials;
+		std::vector<uint32_t> m_materialRemap; // source material -> table index
+		uint32_t m_defaultMaterial = NO_MATERIAL;
+		std::vector<File::MaterialEntry> m_materials;
+		std::vector<File::TextureReferenceEntry> m_textureReferences;
+		std::unordered_map<std::string, uint32_t> m_textureReferenceIndices;
+
+		std::string m_contentDirectory;
+		std::vector<uint64_t> m_payloadHashes;
+
+		bool m_bvhEnabled = true;
+		std::vector<File::BvhTriangleEntry> m_bvhTriangles;
+	};
+
+	class AssetWriter {
+	public:
+		static constexpr uint64_t INDEX_BUFFER_ALIGNMENT = StreamingAssetWriter::INDEX_BUFFER_ALIGNMENT;
+
+		static fs::path Write(const AssetsCreator::Asset::Mesh& mesh) {
+			return Write(mesh, fs::current_path() / "assets");
+		}
+
+		static fs::path Write(const AssetsCreator::Asset::Mesh& mesh, const fs::path& dir,
+			File::CompressionFormat compression = File::CompressionFormat::NONE, ThreadPool* pool = nullptr) {
+			StreamingAssetWriter writer(mesh.id, dir, compression, pool);
+			writer.setMaterials(mesh.materials);
+			for (auto& submesh : mesh.submeshes) {
+				writer.addSubmesh(*submesh);
+			}
+			return writer.finish();
+		}
+
+		// Header, then the node, mesh and instance tables; no data sections.
+		static fs::path Write(const Scene& scene, const fs::path& dir) {
+			if (!fs::exists(dir)) {
+				fs::create_directories(dir);
+			}
+			auto filename = dir / (scene.id + ".scene.asset");
+
+			std::vector<File::SceneNodeEntry> nodes;
+			nodes.reserve(scene.nodes.size());
+			for (auto& node : scene.nodes) {
+				File::SceneNodeEntry entry = {};
+				CopyStringToChar50(node.name, entry.name);
+				entry.parentIndex = node.parentIndex;
+				entry.meshIndex = node.meshIndex;
+				std::copy_n(node.local.translation, 3, entry.translation);
+				std::copy_n(node.local.rotation, 4, entry.rotation);
+				std::copy_n(node.local.scale, 3, entry.scale);
+				nodes.push_back(entry);
+			}
+
+			std::vector<File::SceneMeshEntry> meshes;
+			std::vector<File::SceneInstanceEntry> instances;
+			meshes.reserve(scene.meshes.size());
+			for (auto& mesh : scene.meshes) {
+				File::SceneMeshEntry meshEntry = {};
+				CopyStringToChar50(mesh.id, meshEntry.id);
+				meshEntry.instanceIndex = static_cast<uint32_t>(instances.size());
+				meshEntry.instanceCount = static_cast<uint32_t>(mesh.instances.size());
+				meshes.push_back(meshEntry);
+				for (auto& instance : mesh.instances) {
+					File::SceneInstanceEntry entry = {};
+					entry.nodeIndex = instance.nodeIndex;
+					std::copy_n(instance.world.translation, 3, entry.translation);
+					std::copy_n(instance.world.rotation, 4, entry.rotation);
+					std::copy_n(instance.world.scale, 3, entry.scale);
+					instances.push_back(entry);
 				}
-				auto zeroes = std::vector<char>(header.skinnedSizeInBytes - nonAlignedSkinnedSize, 0);
-				file.write(zeroes.data(), zeroes.size());
 			}
+
+			File::SceneHeader header = {};
+			CopyStringToChar50(scene.id, header.id);
+			header.nodeCount = static_cast<uint32_t>(nodes.size());
+			header.meshCount = static_cast<uint32_t>(meshes.size());
+			header.instanceCount = static_cast<uint32_t>(instances.size());
+			Hash::XXH64State tableChecksum;
+			tableChecksum.update(nodes.data(), nodes.size() * sizeof(File::SceneNodeEntry));
+			tableChecksum.update(meshes.data(), meshes.size() * sizeof(File::SceneMeshEntry));
+			tableChecksum.update(instances.data(), instances.size() * sizeof(File::SceneInstanceEntry));
+			header.tableChecksum = tableChecksum.digest();
+
+			std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(File::SceneNodeEntry));
+			file.write(reinterpret_cast<const char*>(meshes.data()), meshes.size() * sizeof(File::SceneMeshEntry));
+			file.write(reinterpret_cast<const char*>(instances.data()), instances.size() * sizeof(File::SceneInstanceEntry));
+
+			file.flush();
+			if (!file) {
+				throw std::runtime_error("[AssetWriter] Failed to write " + filename.string());
+			}
+			return filename;
+		}
+
+		// Mips are stored raw in their copyable footprint layout (see File::TextureMipEntry); BC data barely shrinks further.
+		static fs::path Write(const Texture& texture, const fs::path& dir) {
+			if (!fs::exists(dir)) {
+				fs::create_directories(dir);
+			}
+			auto filename = dir / (texture.id + ".texture.asset");
+
+			File::TextureHeader header = {};
+			CopyStringToChar50(texture.id, header.id);
+			header.usage = texture.usage;
+			header.format = texture.format;
+			header.width = texture.mips.empty() ? 0 : texture.mips[0].width;
+			header.height = texture.mips.empty() ? 0 : texture.mips[0].height;
+			header.mipCount = static_cast<uint32_t>(texture.mips.size());
+			header.dataOffset = Align(sizeof(File::TextureHeader) + sizeof(File::TextureMipEntry) * texture.mips.size(), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+			std::vector<File::TextureMipEntry> mipEntries;
+			mipEntries.reserve(texture.mips.size());
+			uint64_t offset = header.dataOffset;
+			// the zero padding between mips is part of the hashed data
+			static constexpr uint8_t zeroes[D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT] = {};
+			Hash::XXH64State dataChecksum;
+			for (auto& mip : texture.mips) {
+				mipEntries.push_back({ mip.width, mip.height, mip.rowPitch, mip.rowCount, offset, mip.data.size() });
+				uint64_t next = Align(offset + mip.data.size(), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+				dataChecksum.update(mip.data.data(), mip.data.size());
+				dataChecksum.update(zeroes, next - offset - mip.data.size());
+				offset = next;
+			}
+			header.sizeInBytes = offset - header.dataOffset;
+			header.tableChecksum = Hash::XXH64(mipEntries.data(), mipEntries.size() * sizeof(File::TextureMipEntry));
+			header.dataChecksum = dataChecksum.digest();
+
+			std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(mipEntries.data()), mipEntries.size() * sizeof(File::TextureMipEntry));
+			for (size_t i = 0; i < texture.mips.size(); i++) {
+				file.seekp(mipEntries[i].fileOffset);
+				file.write(reinterpret_cast<const char*>(texture.mips[i].data.data()), texture.mips[i].data.size());
+			}
+			// pad the last mip so sizeInBytes is what the file holds
+			if (static_cast<uint64_t>(file.tellp()) < offset) {
+				file.seekp(offset - 1);
+				file.put(0);
+			}
+
+			file.flush();
+			if (!file) {
+				throw std::runtime_error("[AssetWriter] Failed to write " + filename.string());
+			}
+			return filename;
 		}
 	};
 }
\ No newline at end of file
@@ -2,17 +2,190 @@
 //
 
 #include <iostream>
+#include <string>
 #include "GLTFStreamReader.h"
 #include "AssetWriter.h"
 #include "AssetReader.h"
+#include "BatchCooker.h"
+#include "AssetValidator.h"
 
-int main()
+static void PrintUsage()
 {
-    auto meshes = GLTFLocal::GetMeshesInfo("D:\\DX12En\\Engine\\assets\\glb\\alicev2rigged.glb", true);
-    for (auto& mesh : meshes) {
-        AssetsCreator::Asset::AssetWriter::Write(*mesh);
+    std::cout << "Usage: AssetsCreator <file.glb|file.gltf|directory|manifest> [options]\n"
+        << "       AssetsCreator <directory|file> --validate [--jobs <n>]\n"
+        << "  --out <dir>       output directory (default: ./assets)\n"
+        << "  --jobs <n>        worker threads (default: hardware concurrency)\n"
+        << "  --force           ignore the incremental cook cache\n"
+        << "  --split-meshes    write every glTF mesh into its own .mesh.asset\n"
+        << "  --merge-submeshes  merge primitives that share a material and vertex streams into one submesh (fewer draw calls)\n"
+        << "  --attribute-profile <renderer|all>  keep only the vertex streams the engine pipelines read (default), or every source stream\n"
+        << "  --no-tangents     keep primitives without TANGENT as they are (the engine binds a constant tangent)\n"
+        << "  --no-weld         keep duplicate vertices\n"
+        << "  --weld-epsilon <attribute>=<value>  weld tolerance for position|normal|tangent|texcoord|color (default: exact)\n"
+        << "  --no-vertex-cache-opt  keep the source triangle and vertex order\n"
+        << "  --no-meshlets     skip meshlet generation\n"
+        << "  --no-lods         skip the simplified LOD chain\n"
+        << "  --no-bvh          skip the triangle BVH used for raycasts and picking\n"
+        << "  --compression <none|lz4|gdeflate>  chunked section compression (default: gdeflate on Windows, lz4 elsewhere)\n"
+        << "  --quantize        quantize positions, normals, tangents and texcoords within the error budget\n"
+        << "  --vertex-layout <separate|split>  one stream per attribute, or positions + interleaved normal/texcoord/tangent\n"
+        << "  --low-memory      cook one primitive at a time; peak memory stays near the largest primitive\n"
+        << "  --no-textures     skip glTF images\n"
+        << "  --texture-format <bc7|bc1>  color textures as BC7, or BC1 (BC3 with alpha); normal maps are always BC5, occlusion BC4\n"
+        << "  --no-scene        skip the .scene.asset with the node transforms and mesh instances\n"
+        << "  --content-store   store identical cooked submeshes once in <out>/content and reference them by hash\n"
+        << "  --pak <file>      also pack every cooked asset of the output directory into one archive\n"
+        << "  --validate        check version, size and checksums of every cooked asset and pak under the input instead of cooking\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::filesystem::path input = argv[1];
+    AssetsCreator::Cook::CookOptions options{};
+    bool validate = false;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            options.outputDirectory = std::filesystem::absolute(argv[++i]);
+        }
+        else if (arg == "--jobs" && i + 1 < argc) {
+            options.threadCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--force") {
+            options.force = true;
+        }
+        else if (arg == "--split-meshes") {
+            options.compressIntoOneMesh = false;
+        }
+        else if (arg == "--merge-submeshes") {
+            options.mergeSubmeshes = true;
+        }
+        else if (arg == "--attribute-profile" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "renderer") options.attributeProfile = AssetsCreator::Asset::AttributeProfile::Preset::RENDERER;
+            else if (value == "all") options.attributeProfile = AssetsCreator::Asset::AttributeProfile::Preset::ALL;
+            else {
+                std::cerr << "Invalid --attribute-profile " << value << "\n";
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--no-tangents") {
+            options.generateTangents = false;
+        }
+        else if (arg == "--no-weld") {
+            options.weldVertices = false;
+        }
+        else if (arg == "--weld-epsilon" && i + 1 < argc) {
+            std::string value = argv[++i];
+            auto separator = value.find('=');
+            float* epsilon = nullptr;
+            if (separator != std::string::npos) {
+                auto name = value.substr(0, separator);
+                if (name == "position") epsilon = &options.weldEpsilon.position;
+                else if (name == "normal") epsilon = &options.weldEpsilon.normal;
+                else if (name == "tangent") epsilon = &options.weldEpsilon.tangent;
+                else if (name == "texcoord") epsilon = &options.weldEpsilon.texcoord;
+                else if (name == "color") epsilon = &options.weldEpsilon.color;
+            }
+            if (!epsilon) {
+                std::cerr << "Invalid --weld-epsilon " << value << "\n";
+                PrintUsage();
+                return 1;
+            }
+            *epsilon = std::stof(value.substr(separator + 1));
+        }
+        else if (arg == "--no-vertex-cache-opt") {
+            options.optimizeVertexCache = false;
+        }
+        else if (arg == "--no-meshlets") {
+            options.buildMeshlets = false;
+        }
+        else if (arg == "--no-lods") {
+            options.buildLods = false;
+        }
+        else if (arg == "--no-bvh") {
+            options.buildBvh = false;
+        }
+        else if (arg == "--compression" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "none") options.compression = AssetsCreator::Asset::File::CompressionFormat::NONE;
+            else if (value == "lz4") options.compression = AssetsCreator::Asset::File::CompressionFormat::LZ4;
+            else if (value == "gdeflate") options.compression = AssetsCreator::Asset::File::CompressionFormat::GDEFLATE;
+            else {
+                std::cerr << "Invalid --compression " << value << "\n";
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--quantize") {
+            options.quantizeVertices = true;
+        }
+        else if (arg == "--vertex-layout" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "separate") options.vertexLayout = AssetsCreator::Asset::VertexLayout::Policy::SEPARATE;
+            else if (value == "split") options.vertexLayout = AssetsCreator::Asset::VertexLayout::Policy::SPLIT;
+            else {
+                std::cerr << "Invalid --vertex-layout " << value << "\n";
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--low-memory") {
+            options.lowMemory = true;
+        }
+        else if (arg == "--no-textures") {
+            options.cookTextures = false;
+        }
+        else if (arg == "--texture-format" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "bc7") options.textureColorFormat = AssetsCreator::Asset::TextureCooker::ColorFormat::BC7;
+            else if (value == "bc1") options.textureColorFormat = AssetsCreator::Asset::TextureCooker::ColorFormat::BC1;
+            else {
+                std::cerr << "Invalid --texture-format " << value << "\n";
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--no-scene") {
+            options.cookScene = false;
+        }
+        else if (arg == "--content-store") {
+            options.contentStore = true;
+        }
+        else if (arg == "--pak" && i + 1 < argc) {
+            options.pakPath = std::filesystem::absolute(argv[++i]);
+        }
+        else if (arg == "--validate") {
+            validate = true;
+        }
+        else {
+            std::cerr << "Unknown argument " << arg << "\n";
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    try {
+        if (validate) {
+            AssetsCreator::ThreadPool pool(options.threadCount ? options.threadCount : std::max(1u, std::thread::hardware_concurrency()));
+            auto result = AssetsCreator::Asset::AssetValidator::ValidateTree(input, pool);
+            return result.failed ? 2 : 0;
+        }
+        AssetsCreator::Cook::BatchCooker cooker(options);
+        auto jobs = cooker.collectJobs(input);
+        auto result = cooker.run(jobs);
+        return result.failed ? 2 : 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
     }
-    auto h = AssetsCreator::Asset::AssetReader::ReadMeshHeaders("D:\\DX12En\\AssetsCreator\\assets\\alicev2rigged_0.mesh.asset");
 }
 
 // Run program: Ctrl + F5 or Debug > Start Without Debugging menu
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "Structures.h"
+
+namespace AssetsCreator::Asset {
+	// Vertex streams the engine's material pipelines read. Each pipeline lists the streams of its input layout; a submesh
+	// is cooked for the pipeline its own streams select and everything else is dropped before the other stages run, so
+	// unused accessors (TEXCOORD_1, COLOR_1, ...) cost neither cook time nor disk, streaming or GPU memory.
+	class AttributeProfile {
+	public:
+		enum class Preset : uint8_t {
+			ALL, // keep every source stream
+			RENDERER, // what the GBuffer pass binds, plus the skinning streams of skinned submeshes
+		};
+
+		struct Stream {
+			AttributeType type;
+			uint32_t semanticIndex;
+		};
+
+		struct Pipeline {
+			const char* name;
+			std::vector<Stream> streams;
+			bool skinned = false; // only for submeshes with JOINT0 and WEIGHT0
+		};
+
+		struct Statistics {
+			uint32_t droppedStreams = 0;
+			uint64_t droppedBytes = 0;
+		};
+
+		static const AttributeProfile& Get(Preset preset) {
+			static const AttributeProfile all{};
+			static const AttributeProfile renderer = MakeRenderer();
+			return preset == Preset::RENDERER ? renderer : all;
+		}
+
+		// First pipeline the submesh qualifies for; nullptr keeps every stream.
+		const Pipeline* select(const SubMesh& submesh) const {
+			bool skinned = Has(submesh, AttributeType::JOINT) && Has(submesh, AttributeType::WEIGHT);
+			for (auto& pipeline : m_pipelines) {
+				if (!pipeline.skinned || skinned) return &pipeline;
+			}
+			return nullptr;
+		}
+
+		Statistics strip(SubMesh& submesh) const {
+			Statistics statistics{};
+			auto* pipeline = select(submesh);
+			if (!pipeline) return statistics;
+
+			for (auto itt = submesh.attributes.begin(); itt != submesh.attributes.end();) {
+				auto& attribute = *itt->second;
+				bool used = std::any_of(pipeline->streams.begin(), pipeline->streams.end(), [&](const Stream& stream) {
+					return stream.type == attribute.type && stream.semanticIndex == attribute.semanticIndex;
+					});
+				if (used) {
+					++itt;
+					continue;
+				}
+				statistics.droppedStreams++;
+				statistics.droppedBytes += attribute.data.size();
+				itt = submesh.attributes.erase(itt);
+			}
+			return statistics;
+		}
+
+	private:
+		static AttributeProfile MakeRenderer() {
+			// GBufferPass::m_inputElementDescs; skinned streams go to the skinned heap for the skinning pass
+			std::vector<Stream> gbuffer = {
+				{ AttributeType::POSITION, 0 }, { AttributeType::NORMAL, 0 }, { AttributeType::TEXCOORD, 0 }, { AttributeType::TANGENT, 0 },
+				{ AttributeType::COLOR, 0 },
+			};
+			std::vector<Stream> skinned = gbuffer;
+			skinned.push_back({ AttributeType::JOINT, 0 });
+			skinned.push_back({ AttributeType::WEIGHT, 0 });
+
+			AttributeProfile profile;
+			profile.m_pipelines.push_back({ "gbuffer-skinned", std::move(skinned), true });
+			profile.m_pipelines.push_back({ "gbuffer", std::move(gbuffer) });
+			return profile;
+		}
+
+		static bool Has(const SubMesh& submesh, AttributeType type) {
+			auto range = submesh.attributes.equal_range(type);
+			return std::any_of(range.first, range.second, [](auto& entry) { return entry.second->semanticIndex == 0; });
+		}
+
+		std::vector<Pipeline> m_pipelines; // in selection order
+	};
+}
@@ -0,0 +1,528 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <syncstream>
+#include <unordered_map>
+#include <optional>
+#include <mutex>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+
+#include "CookOptions.h"
+#include "GLTFStreamReader.h"
+#include "AssetWriter.h"
+#include "MeshCooker.h"
+#include "ContentStore.h"
+#include "PakWriter.h"
+#include "ThreadPool.h"
+#include "Hash.h"
+
+namespace AssetsCreator::Cook {
+	namespace fs = std::filesystem;
+
+	// Remembers what every source produced last time: <source hash> <options hash> <source> <outputs...>, tab separated.
+	class CookCache {
+	public:
+		struct Entry {
+			uint64_t sourceHash = 0;
+			uint64_t optionsHash = 0;
+			std::vector<fs::path> outputs;
+		};
+
+		void load(const fs::path& path) {
+			std::ifstream file(path);
+			if (!file) return;
+
+			std::string line;
+			while (std::getline(file, line)) {
+				std::stringstream ss(line);
+				std::string sourceHash, optionsHash, source, output;
+				if (!std::getline(ss, sourceHash, '\t') || !std::getline(ss, optionsHash, '\t') || !std::getline(ss, source, '\t')) continue;
+
+				Entry entry;
+				entry.sourceHash = std::stoull(sourceHash, nullptr, 16);
+				entry.optionsHash = std::stoull(optionsHash, nullptr, 16);
+				while (std::getline(ss, output, '\t')) {
+					entry.outputs.push_back(fs::path(output));
+				}
+				m_entries[source] = std::move(entry);
+			}
+		}
+
+		// Written next to the cache and renamed over it, so a batch killed mid-write keeps the previous cache.
+		void save(const fs::path& path) const {
+			std::lock_guard lock(m_mutex);
+			auto temporary = fs::path(path).concat(".tmp");
+			{
+				std::ofstream file(temporary, std::ios::trunc);
+				for (auto& [source, entry] : m_entries) {
+					file << std::hex << entry.sourceHash << '\t' << entry.optionsHash << std::dec << '\t' << source;
+					for (auto& output : entry.outputs) {
+						file << '\t' << output.string();
+					}
+					file << '\n';
+				}
+			}
+			fs::rename(temporary, path);
+		}
+
+		std::optional<Entry> find(const fs::path& source) const {
+			std::lock_guard lock(m_mutex);
+			auto itt = m_entries.find(source.string());
+			if (itt == m_entries.end()) return std::nullopt;
+			return itt->second;
+		}
+
+		// Returns the outputs of the previous entry that the new one no longer produces.
+		std::vector<fs::path> store(const fs::path& source, Entry entry) {
+			std::lock_guard lock(m_mutex);
+			auto& stored = m_entries[source.string()];
+			std::vector<fs::path> stale;
+			std::copy_if(stored.outputs.begin(), stored.outputs.end(), std::back_inserter(stale), [&](const fs::path& output) {
+				return std::find(entry.outputs.begin(), entry.outputs.end(), output) == entry.outputs.end();
+				});
+			stored = std::move(entry);
+			return stale;
+		}
+
+		// Drops the entries of sources that no longer exist and returns their outputs.
+		std::vector<fs::path> removeMissingSources() {
+			std::lock_guard lock(m_mutex);
+			std::vector<fs::path> stale;
+			std::erase_if(m_entries, [&](auto& entry) {
+				if (fs::exists(entry.first)) return false;
+				stale.insert(stale.end(), entry.second.outputs.begin(), entry.second.outputs.end());
+				return true;
+				});
+			return stale;
+		}
+
+		// Every output of every source, shared content store payloads once.
+		std::vector<fs::path> getOutputs() const {
+			std::lock_guard lock(m_mutex);
+			std::vector<fs::path> outputs;
+			for (auto& [source, entry] : m_entries) outputs.insert(outputs.end(), entry.outputs.begin(), entry.outputs.end());
+			std::sort(outputs.begin(), outputs.end());
+			outputs.erase(std::unique(outputs.begin(), outputs.end()), outputs.end());
+			return outputs;
+		}
+
+	private:
+		std::unordered_map<std::string, Entry> m_entries;
+		mutable std::mutex m_mutex;
+	};
+
+	struct CookJob {
+		fs::path source;
+		fs::path outputDirectory;
+	};
+
+	class BatchCooker {
+	public:
+		struct Result {
+			uint32_t cooked = 0;
+			uint32_t skipped = 0;
+			uint32_t failed = 0;
+		};
+
+		static constexpr std::chrono::seconds CACHE_SAVE_INTERVAL{ 10 };
+
+		explicit BatchCooker(CookOptions options)
+			: m_options(std::move(options)),
+			m_pool(m_options.threadCount ? m_options.threadCount : std::max(1u, std::thread::hardware_concurrency())) {
+			m_optionsHash = HashCookOptions(m_options);
+			if (m_options.contentStore) {
+				m_contentStore = std::make_unique<Asset::ContentStore>(getContentDirectory(), m_options.compression, &m_pool);
+			}
+		}
+
+		// input is a single .glb/.gltf, a directory scanned recursively, or a manifest listing one source per line.
+		// Throws when two sources would write the same asset ids.
+		std::vector<CookJob> collectJobs(const fs::path& input) const {
+			std::vector<CookJob> jobs;
+			auto root = fs::absolute(input);
+
+			if (fs::is_directory(root)) {
+				for (auto& entry : fs::recursive_directory_iterator(root)) {
+					if (!entry.is_regular_file() || !IsSource(entry.path())) continue;
+					auto relative = fs::relative(entry.path().parent_path(), root);
+					jobs.push_back({ entry.path(), (m_options.outputDirectory / relative).lexically_normal() });
+				}
+			}
+			else if (IsSource(root)) {
+				jobs.push_back({ root, m_options.outputDirectory });
+			}
+			else if (fs::is_regular_file(root)) {
+				std::ifstream manifest(root);
+				std::string line;
+				while (std::getline(manifest, line)) {
+					if (!line.empty() && line.back() == '\r') line.pop_back();
+					if (line.empty() || line[0] == '#') continue;
+					fs::path source = line;
+					if (source.is_relative()) source = root.parent_path() / source;
+					jobs.push_back({ source.lexically_normal(), m_options.outputDirectory });
+				}
+			}
+			else {
+				throw std::runtime_error("[BatchCooker] Input not found " + input.string());
+			}
+
+			std::sort(jobs.begin(), jobs.end(), [](const CookJob& a, const CookJob& b) { return a.source < b.source; });
+			jobs.erase(std::unique(jobs.begin(), jobs.end(), [](const CookJob& a, const CookJob& b) { return a.source == b.source; }), jobs.end());
+
+			// every asset id starts with the source stem, so two sources with one stem in one directory overwrite each other
+			std::unordered_map<std::string, const CookJob*> owners;
+			for (auto& job : jobs) {
+				auto key = (job.outputDirectory / job.source.stem()).generic_string();
+				std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+				auto [itt, inserted] = owners.emplace(key, &job);
+				if (!inserted) {
+					throw std::runtime_error("[BatchCooker] " + itt->second->source.string() + " and " + job.source.string() + " would both write the "
+						+ (job.outputDirectory / job.source.stem()).string() + " assets; rename one of them or cook them into different directories");
+				}
+			}
+			return jobs;
+		}
+
+		Result run(const std::vector<CookJob>& jobs) {
+			auto cachePath = m_options.outputDirectory / "cook.cache";
+			fs::create_directories(m_options.outputDirectory);
+			m_cache.load(cachePath);
+			removeOutputs(m_cache.removeMissingSources());
+
+			std::atomic<uint32_t> cooked{ 0 }, skipped{ 0 }, failed{ 0 };
+			auto start = std::chrono::steady_clock::now();
+			auto lastSave = start;
+			std::mutex saveMutex;
+
+			m_pool.parallelFor(jobs.size(), [&](size_t i) {
+				auto& job = jobs[i];
+				try {
+					if (cookJob(job)) {
+						cooked++;
+						// so an interrupted batch doesn't recook what already finished, without rewriting the whole cache per job
+						std::unique_lock lock(saveMutex, std::try_to_lock);
+						if (lock && std::chrono::steady_clock::now() - lastSave >= CACHE_SAVE_INTERVAL) {
+							m_cache.save(cachePath);
+							lastSave = std::chrono::steady_clock::now();
+						}
+					}
+					else skipped++;
+				}
+				catch (const std::exception& e) {
+					failed++;
+					std::osyncstream(std::cerr) << "[BatchCooker] Failed " << job.source.string() << ": " << e.what() << "\n";
+				}
+				});
+
+			m_cache.save(cachePath);
+			removeUnreferencedPayloads();
+			if (m_contentStore) m_contentStore->printSummary();
+
+			// sources cooked by earlier batches into the same directory are packed too
+			if (!m_options.pakPath.empty()) {
+				auto outputs = m_cache.getOutputs();
+				std::erase_if(outputs, [](const fs::path& path) { return !fs::exists(path); });
+				Asset::PakWriter::Write(m_options.pakPath, m_options.outputDirectory, std::move(outputs));
+			}
+
+			Result result{ cooked.load(), skipped.load(), failed.load() };
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::cout << "[BatchCooker] cooked " << result.cooked << ", up to date " << result.skipped << ", failed " << result.failed
+				<< " in " << seconds << "s on " << m_pool.getThreadCount() << " threads\n";
+			return result;
+		}
+
+		static bool IsSource(const fs::path& path) {
+			auto ext = path.extension().string();
+			std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			return ext == ".glb" || ext == ".gltf";
+		}
+
+		// Hashes the source together with every external buffer/image it references.
+		static uint64_t HashSource(const fs::path& path) {
+			Hash::XXH64State state;
+			HashFile(path, state);
+
+			if (path.extension() == ".gltf") {
+				std::ifstream file(path, std::ios::binary);
+				std::stringstream manifest;
+				manifest << file.rdbuf();
+				auto document = Microsoft::glTF::Deserialize(manifest.str());
+
+				auto hashUri = [&](const std::string& uri) {
+					if (uri.empty() || uri.rfind("data:", 0) == 0) return;
+					HashFile(path.parent_path() / uri, state);
+					};
+				for (auto& buffer : document.buffers.Elements()) hashUri(buffer.uri);
+				for (auto& image : document.images.Elements()) hashUri(image.uri);
+			}
+			return state.digest();
+		}
+
+	private:
+		CookOptions m_options;
+		uint64_t m_optionsHash;
+		ThreadPool m_pool;
+		CookCache m_cache;
+		std::unique_ptr<Asset::ContentStore> m_contentStore;
+
+		fs::path getContentDirectory() const {
+			return m_options.outputDirectory / "content";
+		}
+
+		// Outputs a source stopped producing; only files inside the output directory are touched. Content store payloads
+		// can be shared with sources that are still cooking, they are collected by removeUnreferencedPayloads() after the batch.
+		void removeOutputs(const std::vector<fs::path>& outputs) {
+			for (auto& output : outputs) {
+				auto relative = output.lexically_relative(m_options.outputDirectory);
+				if (relative.empty() || *relative.begin() == ".." || output.parent_path() == getContentDirectory()) continue;
+				std::error_code error;
+				if (fs::remove(output, error)) {
+					std::osyncstream(std::cout) << "[BatchCooker] removed stale " << relative.generic_string() << "\n";
+				}
+			}
+		}
+
+		// Payloads no cached source references any more, e.g. after a recook changed a submesh or a source was deleted.
+		void removeUnreferencedPayloads() {
+			if (!fs::is_directory(getContentDirectory())) return;
+			auto outputs = m_cache.getOutputs();
+			std::vector<fs::path> stale;
+			for (auto& entry : fs::directory_iterator(getContentDirectory())) {
+				if (entry.is_regular_file() && !std::binary_search(outputs.begin(), outputs.end(), entry.path())) stale.push_back(entry.path());
+			}
+			std::error_code error;
+			for (auto& payload : stale) fs::remove(payload, error);
+			if (!stale.empty()) std::cout << "[BatchCooker] removed " << stale.size() << " unreferenced content payload(s)\n";
+		}
+
+		static void HashFile(const fs::path& path, Hash::XXH64State& state) {
+			std::ifstream file(path, std::ios::binary);
+			if (!file) {
+				throw std::runtime_error("[BatchCooker] Can't open " + path.string());
+			}
+			std::vector<char> buffer(1 << 20);
+			while (file) {
+				file.read(buffer.data(), buffer.size());
+				state.update(buffer.data(), static_cast<size_t>(file.gcount()));
+			}
+		}
+
+		// Returns false when the cached outputs are still valid.
+		bool cookJob(const CookJob& job) {
+			auto sourceHash = HashSource(job.source);
+
+			if (!m_options.force) {
+				auto cached = m_cache.find(job.source);
+				if (cached && cached->sourceHash == sourceHash && cached->optionsHash == m_optionsHash &&
+					std::all_of(cached->outputs.begin(), cached->outputs.end(), [](const fs::path& p) { return fs::exists(p); })) {
+					return false;
+				}
+			}
+
+			std::vector<fs::path> outputs;
+			std::vector<fs::path> payloads;
+			if (m_options.lowMemory) {
+				outputs = cookStreaming(job, payloads);
+			}
+			else {
+				auto meshes = GLTFLocal::GetMeshesInfo(job.source, m_options.compressIntoOneMesh, &m_pool);
+
+				outputs.resize(meshes.size());
+				std::vector<std::vector<fs::path>> meshPayloads(meshes.size());
+				m_pool.parallelFor(meshes.size(), [&](size_t i) {
+					CookMesh(*meshes[i], m_options, m_pool);
+					outputs[i] = writeMesh(*meshes[i], job, meshPayloads[i]);
+					});
+				for (auto& meshPayload : meshPayloads) payloads.insert(payloads.end(), meshPayload.begin(), meshPayload.end());
+			}
+			size_t meshCount = outputs.size();
+
+			// referenced payloads are outputs too, so deleting one from the store triggers a recook
+			std::sort(payloads.begin(), payloads.end());
+			payloads.erase(std::unique(payloads.begin(), payloads.end()), payloads.end());
+			outputs.insert(outputs.end(), payloads.begin(), payloads.end());
+
+			if (m_options.cookTextures) {
+				auto textures = cookTextures(job);
+				outputs.insert(outputs.end(), textures.begin(), textures.end());
+			}
+			size_t textureCount = outputs.size() - meshCount - payloads.size();
+
+			std::osyncstream log(std::cout);
+			log << "[BatchCooker] " << job.source.filename().string() << " -> " << meshCount << " mesh(es), " << textureCount << " texture(s)";
+			if (m_contentStore) log << ", " << payloads.size() << " shared payload(s)";
+			if (m_options.cookScene) {
+				if (auto scene = cookScene(job)) {
+					log << ", scene of " << scene->nodes.size() << " node(s) in " << scene->meshes.size() << " instance list(s)";
+					outputs.push_back(Asset::AssetWriter::Write(*scene, job.outputDirectory));
+				}
+			}
+			log << "\n";
+			removeOutputs(m_cache.store(job.source, { sourceHash, m_optionsHash, std::move(outputs) }));
+			return true;
+		}
+
+		std::unique_ptr<Asset::StreamingAssetWriter> createWriter(const std::string& id, const CookJob& job) {
+			auto writer = std::make_unique<Asset::StreamingAssetWriter>(id, job.outputDirectory, m_options.compression, &m_pool);
+			if (m_contentStore) {
+				writer->setContentDirectory(fs::relative(m_contentStore->getDirectory(), job.outputDirectory).generic_string());
+			}
+			return writer;
+		}
+
+		// With a content store the mesh file only references the submesh data, which goes to the store.
+		void addSubmesh(Asset::StreamingAssetWriter& writer, const Asset::SubMesh& submesh) {
+			if (m_contentStore) writer.addSubmeshReference(submesh, m_contentStore->store(submesh));
+			else writer.addSubmesh(submesh);
+		}
+
+		fs::path finishWriter(Asset::StreamingAssetWriter& writer, std::vector<fs::path>& payloads) {
+			if (m_contentStore) {
+				for (auto hash : writer.getPayloadHashes()) payloads.push_back(m_contentStore->getPayloadPath(hash));
+			}
+			return writer.finish();
+		}
+
+		fs::path writeMesh(const Asset::Mesh& mesh, const CookJob& job, std::vector<fs::path>& payloads) {
+			auto writer = createWriter(mesh.id, job);
+			writer->setMaterials(mesh.materials);
+			for (auto& submesh : mesh.submeshes) {
+				addSubmesh(*writer, *submesh);
+			}
+			return finishWriter(*writer, payloads);
+		}
+
+		// The node tree flattened into one instance list per mesh. A merged mesh holds every primitive once, in mesh space,
+		// so it only stands for the tree when every mesh is drawn exactly once without a transform; otherwise the instances
+		// would be lost, and no scene is written.
+		std::optional<Asset::Scene> cookScene(const CookJob& job) {
+			GLTFLocal::GLTFSource source(job.source);
+			auto& meshes = source.GetMeshes();
+			auto id = job.source.stem().generic_string();
+			if (meshes.empty()) return Asset::SceneBuilder::Build(id, {}, {});
+
+			std::vector<std::string> meshIds;
+			for (auto& mesh : meshes) meshIds.push_back(mesh.id);
+			auto scene = Asset::SceneBuilder::Build(id, source.ReadNodes(), meshIds);
+			if (!m_options.compressIntoOneMesh) return scene;
+
+			bool merged = scene.meshes.size() == meshes.size() && std::all_of(scene.meshes.begin(), scene.meshes.end(), [](const Asset::SceneMesh& mesh) {
+				return mesh.instances.size() == 1 && IsIdentity(mesh.instances[0].world);
+				});
+			if (!merged) {
+				std::osyncstream(std::cout) << "[BatchCooker] " << job.source.filename().string() << ": the node tree places or instances meshes, which one merged mesh "
+					"can't keep; no scene written, cook without compressIntoOneMesh for one\n";
+				return std::nullopt;
+			}
+
+			Asset::SceneNode root;
+			root.name = id;
+			root.meshIndex = 0;
+			return Asset::SceneBuilder::Build(id, { root }, { meshes[0].id });
+		}
+
+		static bool IsIdentity(const Asset::Transform& transform) {
+			constexpr float EPSILON = 1e-5f;
+			const Asset::Transform identity{};
+			for (int i = 0; i < 3; i++) {
+				if (std::fabs(transform.translation[i] - identity.translation[i]) > EPSILON) return false;
+				if (std::fabs(transform.scale[i] - identity.scale[i]) > EPSILON) return false;
+			}
+			// q and -q are the same rotation
+			float w = std::fabs(transform.rotation[3]);
+			return std::fabs(w - 1.f) <= EPSILON;
+		}
+
+		// Textures are cooked one after another in low memory mode, each one still encodes its rows in parallel.
+		std::vector<fs::path> cookTextures(const CookJob& job) {
+			GLTFLocal::GLTFSource source(job.source);
+			auto& images = source.GetImages();
+			if (images.empty()) return {};
+			if (!Asset::ImageDecoder::IsAvailable()) {
+				std::osyncstream(std::cout) << "[BatchCooker] " << job.source.filename().string() << ": no image decoder in this build, "
+					<< images.size() << " image(s) skipped\n";
+				return {};
+			}
+
+			std::vector<fs::path> outputs(images.size());
+			auto cookImage = [&](size_t i) {
+				auto image = Asset::ImageDecoder::Decode(source.ReadImage(i), images[i].id);
+				auto texture = Asset::TextureCooker::Cook(images[i].id, images[i].usage, std::move(image), m_options.textureColorFormat, &m_pool);
+				outputs[i] = Asset::AssetWriter::Write(texture, job.outputDirectory);
+				};
+			if (m_options.lowMemory) {
+				for (size_t i = 0; i < images.size(); i++) cookImage(i);
+			}
+			else {
+				m_pool.parallelFor(images.size(), cookImage);
+			}
+			return outputs;
+		}
+
+		// Only one primitive of the job is in memory at a time: it is read, cooked and appended to its asset before the next one is read.
+		// Merging holds one open group per material instead, each below 65535 vertices.
+		// Produces the same files as the in-memory path.
+		std::vector<fs::path> cookStreaming(const CookJob& job, std::vector<fs::path>& payloads) {
+			GLTFLocal::GLTFSource source(job.source);
+			auto& meshes = source.GetMeshes();
+			std::vector<fs::path> outputs;
+			if (meshes.empty()) return outputs;
+
+			auto cookInto = [&](Asset::StreamingAssetWriter& writer, Asset::SubMesh& submesh, CookReport& report) {
+				report.add(submesh, CookSubmesh(submesh, m_options));
+				addSubmesh(writer, submesh);
+				};
+			auto cookMeshInto = [&](Asset::StreamingAssetWriter& writer, size_t meshIndex, CookReport& report, Asset::SubmeshMerger* merger) {
+				for (size_t i = 0; i < meshes[meshIndex].primitiveCount; i++) {
+					auto submesh = source.ReadPrimitive(meshIndex, i);
+					if (merger) submesh = merger->add(std::move(submesh));
+					if (submesh) cookInto(writer, *submesh, report);
+				}
+				};
+			auto finishMerge = [&](Asset::StreamingAssetWriter& writer, CookReport& report, Asset::SubmeshMerger* merger) {
+				if (!merger) return;
+				for (auto& submesh : merger->finish()) {
+					cookInto(writer, *submesh, report);
+				}
+				report.addMerge(merger->getStatistics());
+				};
+			auto createMerger = [&]() {
+				return m_options.mergeSubmeshes ? std::make_unique<Asset::SubmeshMerger>(Asset::AttributeProfile::Get(m_options.attributeProfile)) : nullptr;
+				};
+
+			if (m_options.compressIntoOneMesh) {
+				auto writer = createWriter(meshes[0].id, job);
+				writer->setMaterials(source.GetMaterials());
+				CookReport report;
+				auto merger = createMerger();
+				for (size_t i = 0; i < meshes.size(); i++) {
+					cookMeshInto(*writer, i, report, merger.get());
+				}
+				finishMerge(*writer, report, merger.get());
+				report.print(meshes[0].id, m_options);
+				outputs.push_back(finishWriter(*writer, payloads));
+			}
+			else {
+				for (size_t i = 0; i < meshes.size(); i++) {
+					auto writer = createWriter(meshes[i].id, job);
+					writer->setMaterials(source.GetMaterials());
+					CookReport report;
+					auto merger = createMerger();
+					cookMeshInto(*writer, i, report, merger.get());
+					finishMerge(*writer, report, merger.get());
+					report.print(meshes[i].id, m_options);
+					outputs.push_back(finishWriter(*writer, payloads));
+				}
+			}
+			return outputs;
+		}
+	};
+}
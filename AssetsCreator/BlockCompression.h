@@ -0,0 +1,428 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "Structures.h"
+
+namespace AssetsCreator::Asset {
+	// CPU encoders for 4x4 blocks of 8 bit RGBA pixels (64 bytes, row major).
+	// Endpoints come from the principal axis of the block and are refined once by least squares against the chosen indices.
+	// BC7 only uses mode 6 (one subset, RGBA endpoints with p-bits, 4 bit indices): one mode keeps encoding fast and
+	// predictable, at some loss against a full mode search on blocks with sharp color edges.
+	class BlockCompression {
+	public:
+		static constexpr uint32_t BLOCK_DIMENSION = 4;
+
+		static bool IsSupported(DXGI_FORMAT format) {
+			return GetBlockSize(format) != 0;
+		}
+
+		// Bytes per 4x4 block, 0 for formats the encoder does not produce.
+		static uint32_t GetBlockSize(DXGI_FORMAT format) {
+			switch (format) {
+			case DXGI_FORMAT_BC1_UNORM:
+			case DXGI_FORMAT_BC1_UNORM_SRGB:
+			case DXGI_FORMAT_BC4_UNORM:
+				return 8;
+			case DXGI_FORMAT_BC3_UNORM:
+			case DXGI_FORMAT_BC3_UNORM_SRGB:
+			case DXGI_FORMAT_BC5_UNORM:
+			case DXGI_FORMAT_BC7_UNORM:
+			case DXGI_FORMAT_BC7_UNORM_SRGB:
+				return 16;
+			default:
+				return 0;
+			}
+		}
+
+		static const char* FormatName(DXGI_FORMAT format) {
+			switch (format) {
+			case DXGI_FORMAT_BC1_UNORM: return "BC1";
+			case DXGI_FORMAT_BC1_UNORM_SRGB: return "BC1 sRGB";
+			case DXGI_FORMAT_BC3_UNORM: return "BC3";
+			case DXGI_FORMAT_BC3_UNORM_SRGB: return "BC3 sRGB";
+			case DXGI_FORMAT_BC4_UNORM: return "BC4";
+			case DXGI_FORMAT_BC5_UNORM: return "BC5";
+			case DXGI_FORMAT_BC7_UNORM: return "BC7";
+			case DXGI_FORMAT_BC7_UNORM_SRGB: return "BC7 sRGB";
+			default: return "unknown";
+			}
+		}
+
+		// sRGB formats are encoded on the stored (gamma) values, like the sampler decodes them.
+		static void EncodeBlock(DXGI_FORMAT format, const uint8_t* rgba, uint8_t* out) {
+			switch (format) {
+			case DXGI_FORMAT_BC1_UNORM:
+			case DXGI_FORMAT_BC1_UNORM_SRGB:
+				EncodeBC1(rgba, out);
+				break;
+			case DXGI_FORMAT_BC3_UNORM:
+			case DXGI_FORMAT_BC3_UNORM_SRGB:
+				EncodeBC4(rgba, 3, out);
+				EncodeBC1(rgba, out + 8);
+				break;
+			case DXGI_FORMAT_BC4_UNORM:
+				EncodeBC4(rgba, 0, out);
+				break;
+			case DXGI_FORMAT_BC5_UNORM:
+				EncodeBC4(rgba, 0, out);
+				EncodeBC4(rgba, 1, out + 8);
+				break;
+			case DXGI_FORMAT_BC7_UNORM:
+			case DXGI_FORMAT_BC7_UNORM_SRGB:
+				EncodeBC7Mode6(rgba, out);
+				break;
+			default:
+				throw std::runtime_error("[BlockCompression] Unsupported format " + std::to_string(static_cast<uint32_t>(format)));
+			}
+		}
+
+	private:
+		static constexpr uint32_t PIXEL_COUNT = BLOCK_DIMENSION * BLOCK_DIMENSION;
+
+		// Principal axis of the N channels through power iteration on the covariance matrix.
+		// Returns false for blocks without variance.
+		template<uint32_t N>
+		static bool PrincipalAxis(const float(&pixels)[PIXEL_COUNT][N], float(&mean)[N], float(&axis)[N]) {
+			std::fill(std::begin(mean), std::end(mean), 0.f);
+			for (auto& pixel : pixels) {
+				for (uint32_t c = 0; c < N; c++) mean[c] += pixel[c];
+			}
+			for (auto& m : mean) m /= PIXEL_COUNT;
+
+			float covariance[N][N] = {};
+			for (auto& pixel : pixels) {
+				for (uint32_t a = 0; a < N; a++) {
+					for (uint32_t b = a; b < N; b++) {
+						covariance[a][b] += (pixel[a] - mean[a]) * (pixel[b] - mean[b]);
+					}
+				}
+			}
+			for (uint32_t a = 0; a < N; a++) {
+				for (uint32_t b = 0; b < a; b++) covariance[a][b] = covariance[b][a];
+			}
+
+			// start from the channel with the largest variance, converges in a few steps for 3-4 dimensions
+			uint32_t largest = 0;
+			for (uint32_t c = 1; c < N; c++) {
+				if (covariance[c][c] > covariance[largest][largest]) largest = c;
+			}
+			if (covariance[largest][largest] < 1e-4f) return false;
+
+			std::fill(std::begin(axis), std::end(axis), 0.f);
+			axis[largest] = 1.f;
+			for (uint32_t iteration = 0; iteration < 8; iteration++) {
+				float next[N] = {};
+				for (uint32_t a = 0; a < N; a++) {
+					for (uint32_t b = 0; b < N; b++) next[a] += covariance[a][b] * axis[b];
+				}
+				float length = 0.f;
+				for (auto v : next) length += v * v;
+				length = std::sqrt(length);
+				if (length < 1e-8f) return false;
+				for (uint32_t c = 0; c < N; c++) axis[c] = next[c] / length;
+			}
+			return true;
+		}
+
+		// Endpoints at the extreme projections on the axis, pulled inwards by `inset` of the range.
+		template<uint32_t N>
+		static void AxisEndpoints(const float(&pixels)[PIXEL_COUNT][N], const float(&mean)[N], const float(&axis)[N], float inset,
+			float(&e0)[N], float(&e1)[N]) {
+			float minT = FLT_MAX, maxT = -FLT_MAX;
+			for (auto& pixel : pixels) {
+				float t = 0.f;
+				for (uint32_t c = 0; c < N; c++) t += (pixel[c] - mean[c]) * axis[c];
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+			float shrink = (maxT - minT) * inset;
+			maxT -= shrink;
+			minT += shrink;
+			for (uint32_t c = 0; c < N; c++) {
+				e0[c] = std::clamp(mean[c] + axis[c] * maxT, 0.f, 255.f);
+				e1[c] = std::clamp(mean[c] + axis[c] * minT, 0.f, 255.f);
+			}
+		}
+
+		// Solves min sum (w_i * e0 + (1 - w_i) * e1 - x_i)^2 per channel; false when every pixel has the same weight.
+		template<uint32_t N>
+		static bool LeastSquaresEndpoints(const float(&pixels)[PIXEL_COUNT][N], const float(&weights)[PIXEL_COUNT], float(&e0)[N], float(&e1)[N]) {
+			float aa = 0.f, ab = 0.f, bb = 0.f;
+			float ax[N] = {}, bx[N] = {};
+			for (uint32_t i = 0; i < PIXEL_COUNT; i++) {
+				float a = weights[i], b = 1.f - weights[i];
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (uint32_t c = 0; c < N; c++) {
+					ax[c] += a * pixels[i][c];
+					bx[c] += b * pixels[i][c];
+				}
+			}
+			float determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f) return false;
+			for (uint32_t c = 0; c < N; c++) {
+				e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.f, 255.f);
+				e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.f, 255.f);
+			}
+			return true;
+		}
+
+		// BC1 / BC3 color
+
+		static uint16_t PackRGB565(const float(&color)[3]) {
+			uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.f / 255.f));
+			uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.f / 255.f));
+			uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.f / 255.f));
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		static void UnpackRGB565(uint16_t packed, int(&color)[3]) {
+			int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+			color[0] = (r << 3) | (r >> 2);
+			color[1] = (g << 2) | (g >> 4);
+			color[2] = (b << 3) | (b >> 2);
+		}
+
+		// Four color palette in index order (c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1); returns the squared error.
+		static uint32_t FitBC1Indices(const float(&pixels)[PIXEL_COUNT][3], uint16_t c0, uint16_t c1, uint8_t(&indices)[PIXEL_COUNT]) {
+			int palette[4][3];
+			UnpackRGB565(c0, palette[0]);
+			UnpackRGB565(c1, palette[1]);
+			for (uint32_t c = 0; c < 3; c++) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+
+			uint32_t total = 0;
+			for (uint32_t i = 0; i < PIXEL_COUNT; i++) {
+				uint32_t best = UINT32_MAX;
+				for (uint8_t p = 0; p < 4; p++) {
+					uint32_t error = 0;
+					for (uint32_t c = 0; c < 3; c++) {
+						int d = static_cast<int>(pixels[i][c]) - palette[p][c];
+						error += static_cast<uint32_t>(d * d);
+					}
+					if (error < best) {
+						best = error;
+						indices[i] = p;
+					}
+				}
+				total += best;
+			}
+			return total;
+		}
+
+		static void EncodeBC1(const uint8_t* rgba, uint8_t* out) {
+			float pixels[PIXEL_COUNT][3];
+			for (uint32_t i = 0; i < PIXEL_COUNT; i++) {
+				for (uint32_t c = 0; c < 3; c++) pixels[i][c] = rgba[i * 4 + c];
+			}
+
+			float mean[3], axis[3];
+			uint16_t c0, c1;
+			uint8_t indices[PIXEL_COUNT] = {};
+			if (!PrincipalAxis(pixels, mean, axis)) {
+				c0 = c1 = PackRGB565(mean);
+			}
+			else {
+				float e0[3], e1[3];
+				AxisEndpoints(pixels, mean, axis, 1.f / 16.f, e0, e1);
+				c0 = PackRGB565(e0);
+				c1 = PackRGB565(e1);
+				uint32_t error = FitBC1Indices(pixels, c0, c1, indices);
+
+				static constexpr float WEIGHTS[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+				float weights[PIXEL_COUNT];
+				for (uint32_t i = 0; i < PIXEL_COUNT; i++) weights[i] = WEIGHTS[indices[i]];
+				if (LeastSquaresEndpoints(pixels, weights, e0, e1)) {
+					uint16_t r0 = PackRGB565(e0), r1 = PackRGB565(e1);
+					uint8_t refined[PIXEL_COUNT];
+					if (FitBC1Indices(pixels, r0, r1, refined) < error) {
+						c0 = r0;
+						c1 = r1;
+						std::copy(std::begin(refined), std::end(refined), indices);
+					}
+				}
+			}
+
+			// c0 > c1 selects the four color mode; swapping the endpoints mirrors the palette
+			if (c0 < c1) {
+				std::swap(c0, c1);
+				static constexpr uint8_t SWAPPED[4] = { 1, 0, 3, 2 };
+				for (auto& index : indices) index = SWAPPED[index];
+			}
+			else if (c0 == c1) {
+				std::fill(std::begin(indices), std::end(indices), uint8_t(0));
+			}
+
+			uint32_t packedIndices = 0;
+			for (uint32_t i = 0; i < PIXEL_COUNT; i++) packedIndices |= static_cast<uint32_t>(indices[i]) << (i * 2);
+			out[0] = static_cast<uint8_t>(c0);
+			out[1] = static_cast<uint8_t>(c0 >> 8);
+			out[2] = static_cast<uint8_t>(c1);
+			out[3] = static_cast<uint8_t>(c1 >> 8);
+			for (uint32_t b = 0; b < 4; b++) out[4 + b] = static_cast<uint8_t>(packedIndices >> (b * 8));
+		}
+
+		// BC4 / BC3 alpha / BC5 channels, eight value mode between the block minimum and maximum
+
+		static void EncodeBC4(const uint8_t* rgba, uint32_t channel, uint8_t* out) {
+			uint8_t values[PIXEL_COUNT];
+			uint8_t minValue = 255, maxValue = 0;
+			for (uint32_t i = 0; i < PIXEL_COUNT; i++) {
+				values[i] = rgba[i * 4 + channel];
+				minValue = std::min(minValue, values[i]);
+				maxValue = std::max(maxValue, values[i]);
+			}
+
+			uint64_t packedIndices = 0;
+			if (maxValue != minValue) {
+				int palette[8];
+				palette[0] = maxValue;
+				palette[1] = minValue;
+				for (int p = 1; p < 7; p++) palette[p + 1] = ((7 - p) * maxValue + p * minValue + 3) / 7;
+
+				for (uint32_t i = 0; i < PIXEL_COUNT; i++) {
+					uint64_t bestIndex = 0;
+					int best = INT32_MAX;
+					for (uint32_t p = 0; p < 8; p++) {
+						int error = std::abs(static_cast<int>(values[i]) - palette[p]);
+						if (error < best) {
+							best = error;
+							bestIndex = p;
+						}
+					}
+					packedIndices |= bestIndex << (i * 3);
+				}
+			}
+
+			out[0] = maxValue;
+			out[1] = minValue;
+			for (uint32_t b = 0; b < 6; b++) out[2 + b] = static_cast<uint8_t>(packedIndices >> (b * 8));
+		}
+
+		// BC7 mode 6
+
+		static constexpr uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		struct BC7Endpoint {
+			uint8_t color[4]; // 7 bit
+			uint8_t pBit;
+		};
+
+		// Picks the p-bit that reconstructs the endpoint best; the stored value is color << 1 | pBit.
+		static BC7Endpoint QuantizeBC7Endpoint(const float(&color)[4]) {
+			BC7Endpoint best{};
+			float bestError = FLT_MAX;
+			for (uint8_t pBit = 0; pBit < 2; pBit++) {
+				BC7Endpoint candidate{ {}, pBit };
+				float error = 0.f;
+				for (uint32_t c = 0; c < 4; c++) {
+					int q = std::clamp(static_cast<int>(std::lround((color[c] - pBit) * 0.5f)), 0, 127);
+					candidate.color[c] = static_cast<uint8_t>(q);
+					float d = color[c] - static_cast<float>((q << 1) | pBit);
+					error += d * d;
+				}
+				if (error < bestError) {
+					bestError = error;
+					best = candidate;
+				}
+			}
+			return best;
+		}
+
+		static uint32_t FitBC7Indices(const float(&pixels)[PIXEL_COUNT][4], const BC7Endpoint& e0, const BC7Endpoint& e1, uint8_t(&indices)[PIXEL_COUNT]) {
+			int palette[16][4];
+			for (uint32_t c = 0; c < 4; c++) {
+				int a = (e0.color[c] << 1) | e0.pBit;
+				int b = (e1.color[c] << 1) | e1.pBit;
+				for (uint32_t p = 0; p < 16; p++) {
+					palette[p][c] = (a * static_cast<int>(64 - BC7_WEIGHTS[p]) + b * static_cast<int>(BC7_WEIGHTS[p]) + 32) >> 6;
+				}
+			}
+
+			uint32_t total = 0;
+			for (uint32_t i = 0; i < PIXEL_COUNT; i++) {
+				uint32_t best = UINT32_MAX;
+				for (uint8_t p = 0; p < 16; p++) {
+					uint32_t error = 0;
+					for (uint32_t c = 0; c < 4; c++) {
+						int d = static_cast<int>(pixels[i][c]) - palette[p][c];
+						error += static_cast<uint32_t>(d * d);
+					}
+					if (error < best) {
+						best = error;
+						indices[i] = p;
+					}
+				}
+				total += best;
+			}
+			return total;
+		}
+
+		static void EncodeBC7Mode6(const uint8_t* rgba, uint8_t* out) {
+			float pixels[PIXEL_COUNT][4];
+			for (uint32_t i = 0; i < PIXEL_COUNT; i++) {
+				for (uint32_t c = 0; c < 4; c++) pixels[i][c] = rgba[i * 4 + c];
+			}
+
+			float mean[4], axis[4], e0[4], e1[4];
+			if (PrincipalAxis(pixels, mean, axis)) {
+				AxisEndpoints(pixels, mean, axis, 1.f / 32.f, e0, e1);
+			}
+			else {
+				std::copy(std::begin(mean), std::end(mean), e0);
+				std::copy(std::begin(mean), std::end(mean), e1);
+			}
+
+			BC7Endpoint q0 = QuantizeBC7Endpoint(e0), q1 = QuantizeBC7Endpoint(e1);
+			uint8_t indices[PIXEL_COUNT];
+			uint32_t error = FitBC7Indices(pixels, q0, q1, indices);
+
+			float weights[PIXEL_COUNT];
+			for (uint32_t i = 0; i < PIXEL_COUNT; i++) weights[i] = 1.f - BC7_WEIGHTS[indices[i]] / 64.f;
+			if (error && LeastSquaresEndpoints(pixels, weights, e0, e1)) {
+				BC7Endpoint r0 = QuantizeBC7Endpoint(e0), r1 = QuantizeBC7Endpoint(e1);
+				uint8_t refined[PIXEL_COUNT];
+				if (FitBC7Indices(pixels, r0, r1, refined) < error) {
+					q0 = r0;
+					q1 = r1;
+					std::copy(std::begin(refined), std::end(refined), indices);
+				}
+			}
+
+			// the anchor index is stored without its top bit, so it has to be below 8
+			if (indices[0] & 8) {
+				std::swap(q0, q1);
+				for (auto& index : indices) index = static_cast<uint8_t>(15 - index);
+			}
+
+			uint64_t bits[2] = {};
+			uint32_t position = 0;
+			auto write = [&](uint32_t value, uint32_t count) {
+				for (uint32_t b = 0; b < count; b++, position++) {
+					bits[position / 64] |= static_cast<uint64_t>((value >> b) & 1) << (position % 64);
+				}
+				};
+			write(1u << 6, 7); // mode 6
+			for (uint32_t c = 0; c < 4; c++) {
+				write(q0.color[c], 7);
+				write(q1.color[c], 7);
+			}
+			write(q0.pBit, 1);
+			write(q1.pBit, 1);
+			write(indices[0], 3);
+			for (uint32_t i = 1; i < PIXEL_COUNT; i++) write(indices[i], 4);
+
+			for (uint32_t b = 0; b < 16; b++) out[b] = static_cast<uint8_t>(bits[b / 8] >> ((b % 8) * 8));
+		}
+	};
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Structures.h"
+#include "MeshUtils.h"
+
+namespace AssetsCreator::Asset {
+	// Triangle BVH for ray queries, one per mesh over the LOD0 triangles of all its submeshes.
+	// Splits use the surface area heuristic on BIN_COUNT centroid bins per axis; nodes are flattened depth first.
+	class BvhBuilder {
+	public:
+		static constexpr uint32_t BIN_COUNT = 16;
+		static constexpr uint32_t MAX_LEAF_TRIANGLES = 4;
+
+		// Copies LOD0 while positions are still float, quantization and interleaving run after it.
+		static void CaptureTriangles(SubMesh& submesh) {
+			submesh.bvhTriangles.clear();
+			if (submesh.topology != D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST) return;
+			auto* position = MeshUtils::FindAttribute(submesh, AttributeType::POSITION);
+			if (!position || position->format != DXGI_FORMAT_R32G32B32_FLOAT) return;
+
+			auto indices = MeshUtils::ReadIndices(submesh.indices);
+			size_t first = 0, count = indices.size();
+			if (!submesh.lods.empty()) {
+				first = submesh.lods[0].firstIndex;
+				count = submesh.lods[0].indexCount;
+			}
+			const uint32_t vertexCount = MeshUtils::GetVertexCount(submesh);
+			auto* positions = reinterpret_cast<const float*>(position->data.data());
+
+			submesh.bvhTriangles.reserve(count / 3 * 9);
+			for (size_t i = first; i + 2 < first + count && i + 2 < indices.size(); i += 3) {
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					uint32_t v = std::min(indices[i + corner], vertexCount - 1);
+					submesh.bvhTriangles.insert(submesh.bvhTriangles.end(), positions + v * 3, positions + v * 3 + 3);
+				}
+			}
+		}
+
+		// Appends the captured triangles of one submesh in the form the BVH stores them.
+		static void AddTriangles(std::vector<File::BvhTriangleEntry>& triangles, const SubMesh& submesh, uint32_t submeshIndex) {
+			auto& values = submesh.bvhTriangles;
+			for (size_t i = 0; i + 9 <= values.size(); i += 9) {
+				File::BvhTriangleEntry triangle = {};
+				for (uint32_t c = 0; c < 3; c++) {
+					triangle.v0[c] = values[i + c];
+					triangle.edge1[c] = values[i + 3 + c] - values[i + c];
+					triangle.edge2[c] = values[i + 6 + c] - values[i + c];
+				}
+				triangle.submeshIndex = submeshIndex;
+				triangle.triangleIndex = static_cast<uint32_t>(i / 9);
+				triangles.push_back(triangle);
+			}
+		}
+
+		// Reorders triangles so every leaf covers a contiguous range.
+		static File::MeshBvh Build(std::vector<File::BvhTriangleEntry> triangles) {
+			File::MeshBvh bvh;
+			if (triangles.empty()) return bvh;
+
+			const uint32_t triangleCount = static_cast<uint32_t>(triangles.size());
+			std::vector<Bounds> bounds(triangleCount);
+			std::vector<std::array<float, 3>> centroids(triangleCount);
+			for (uint32_t t = 0; t < triangleCount; t++) {
+				auto& triangle = triangles[t];
+				Bounds& b = bounds[t];
+				for (uint32_t c = 0; c < 3; c++) {
+					float v0 = triangle.v0[c], v1 = v0 + triangle.edge1[c], v2 = v0 + triangle.edge2[c];
+					b.min[c] = std::min({ v0, v1, v2 });
+					b.max[c] = std::max({ v0, v1, v2 });
+					centroids[t][c] = (b.min[c] + b.max[c]) * 0.5f;
+				}
+			}
+
+			std::vector<uint32_t> order(triangleCount);
+			for (uint32_t t = 0; t < triangleCount; t++) order[t] = t;
+
+			struct Range {
+				uint32_t begin, end;
+				uint32_t parent; // inner node whose right child this is, NO_PARENT for left children and the root
+			};
+			std::vector<Range> stack;
+			stack.push_back({ 0, triangleCount, NO_PARENT });
+			bvh.nodes.reserve(static_cast<size_t>(triangleCount) * 2 / MAX_LEAF_TRIANGLES + 1);
+			while (!stack.empty()) {
+				Range range = stack.back();
+				stack.pop_back();
+
+				uint32_t nodeIndex = static_cast<uint32_t>(bvh.nodes.size());
+				if (range.parent != NO_PARENT) bvh.nodes[range.parent].rightChildOrFirstTriangle = nodeIndex;
+
+				Bounds nodeBounds, centroidBounds;
+				for (uint32_t i = range.begin; i < range.end; i++) {
+					nodeBounds.grow(bounds[order[i]]);
+					centroidBounds.grow(centroids[order[i]].data());
+				}
+				File::BvhNodeEntry node = {};
+				std::copy_n(nodeBounds.min, 3, node.aabbMin);
+				std::copy_n(nodeBounds.max, 3, node.aabbMax);
+				bvh.nodes.push_back(node);
+
+				uint32_t middle = split(range.begin, range.end, nodeBounds, centroidBounds, bounds, centroids, order);
+				if (middle == range.begin || middle == range.end) {
+					bvh.nodes[nodeIndex].rightChildOrFirstTriangle = range.begin;
+					bvh.nodes[nodeIndex].triangleCount = range.end - range.begin;
+					continue;
+				}
+				// the left child is popped next, so it lands at nodeIndex + 1
+				stack.push_back({ middle, range.end, nodeIndex });
+				stack.push_back({ range.begin, middle, NO_PARENT });
+			}
+
+			bvh.triangles.reserve(triangleCount);
+			for (auto t : order) bvh.triangles.push_back(triangles[t]);
+			return bvh;
+		}
+
+	private:
+		struct Bounds {
+			float min[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+			float max[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+			void grow(const Bounds& other) {
+				for (uint32_t c = 0; c < 3; c++) {
+					min[c] = std::min(min[c], other.min[c]);
+					max[c] = std::max(max[c], other.max[c]);
+				}
+			}
+			void grow(const float* point) {
+				for (uint32_t c = 0; c < 3; c++) {
+					min[c] = std::min(min[c], point[c]);
+					max[c] = std::max(max[c], point[c]);
+				}
+			}
+			float halfArea() const {
+				if (min[0] > max[0]) return 0.f;
+				float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+				return dx * dy + dy * dz + dz * dx;
+			}
+		};
+
+		// Returns the first triangle of the right child, or begin/end to make a leaf. Ranges above MAX_LEAF_TRIANGLES are
+		// always split, by the object median when every centroid falls in one bin.
+		static uint32_t split(uint32_t begin, uint32_t end, const Bounds& nodeBounds, const Bounds& centroidBounds,
+			const std::vector<Bounds>& bounds, const std::vector<std::array<float, 3>>& centroids, std::vector<uint32_t>& order) {
+			const uint32_t count = end - begin;
+			if (count <= 1) return end;
+
+			float bestCost = std::numeric_limits<float>::max();
+			uint32_t bestAxis = 0, bestBin = 0;
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+				if (extent <= 0.f) continue;
+				float scale = BIN_COUNT / extent;
+
+				Bounds binBounds[BIN_COUNT];
+				uint32_t binCounts[BIN_COUNT] = {};
+				for (uint32_t i = begin; i < end; i++) {
+					uint32_t bin = binOf(centroids[order[i]][axis], centroidBounds.min[axis], scale);
+					binBounds[bin].grow(bounds[order[i]]);
+					binCounts[bin]++;
+				}
+
+				// cost of splitting after bin i: left area * left count + right area * right count
+				float leftCost[BIN_COUNT - 1];
+				Bounds left;
+				uint32_t leftCount = 0;
+				for (uint32_t i = 0; i < BIN_COUNT - 1; i++) {
+					left.grow(binBounds[i]);
+					leftCount += binCounts[i];
+					leftCost[i] = left.halfArea() * leftCount;
+				}
+				Bounds right;
+				uint32_t rightCount = 0;
+				for (uint32_t i = BIN_COUNT - 1; i > 0; i--) {
+					right.grow(binBounds[i]);
+					rightCount += binCounts[i];
+					float cost = leftCost[i - 1] + right.halfArea() * rightCount;
+					if (rightCount && rightCount < count && cost < bestCost) {
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = i;
+					}
+				}
+			}
+
+			// traversal costs about as much as one triangle test
+			float leafCost = static_cast<float>(count);
+			float parentArea = nodeBounds.halfArea();
+			bool hasSplit = bestCost < std::numeric_limits<float>::max();
+			if (hasSplit && parentArea > 0.f && 1.f + bestCost / parentArea >= leafCost && count <= MAX_LEAF_TRIANGLES) return end;
+			if (!hasSplit) {
+				if (count <= MAX_LEAF_TRIANGLES) return end;
+				return begin + count / 2;
+			}
+
+			float scale = BIN_COUNT / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+			auto middle = std::partition(order.begin() + begin, order.begin() + end, [&](uint32_t t) {
+				return binOf(centroids[t][bestAxis], centroidBounds.min[bestAxis], scale) < bestBin;
+				});
+			return static_cast<uint32_t>(middle - order.begin());
+		}
+
+		static uint32_t binOf(float value, float min, float scale) {
+			return std::min(BIN_COUNT - 1, static_cast<uint32_t>((value - min) * scale));
+		}
+	};
+}
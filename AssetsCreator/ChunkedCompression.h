@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include "Structures.h"
+#include "ThreadPool.h"
+#include "Lz4.h"
+
+#if defined(_WIN32)
+#include <dstorage.h>
+#include <wrl/client.h>
+#endif
+
+namespace AssetsCreator::Asset {
+	// Data sections are compressed in fixed-size chunks so they decode in parallel, on the CPU or as one DirectStorage request each.
+	// GDeflate goes through the DirectStorage codec and is only available on Windows; LZ4 works everywhere.
+	class ChunkedCompression {
+	public:
+		static constexpr uint32_t CHUNK_SIZE = 256 << 10; // 4 GDeflate tiles
+
+		struct Chunk {
+			File::CompressionFormat format;
+			uint64_t uncompressedOffset;
+			uint32_t uncompressedSize;
+			std::vector<uint8_t> data;
+		};
+
+		// Chunks that do not shrink are stored raw.
+		static std::vector<Chunk> Compress(const uint8_t* data, size_t size, File::CompressionFormat format, ThreadPool* pool) {
+			std::vector<Chunk> chunks((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+			auto compressChunk = [&](size_t i) {
+				auto& chunk = chunks[i];
+				chunk.uncompressedOffset = static_cast<uint64_t>(i) * CHUNK_SIZE;
+				chunk.uncompressedSize = static_cast<uint32_t>(std::min<size_t>(CHUNK_SIZE, size - chunk.uncompressedOffset));
+				const uint8_t* src = data + chunk.uncompressedOffset;
+
+				chunk.data = CompressChunk(format, src, chunk.uncompressedSize);
+				chunk.format = format;
+				if (chunk.data.size() >= chunk.uncompressedSize) {
+					chunk.format = File::CompressionFormat::NONE;
+					chunk.data.assign(src, src + chunk.uncompressedSize);
+				}
+				};
+
+			if (pool) {
+				pool->parallelFor(chunks.size(), compressChunk);
+			}
+			else {
+				for (size_t i = 0; i < chunks.size(); i++) compressChunk(i);
+			}
+			return chunks;
+		}
+
+		static bool DecompressChunk(File::CompressionFormat format, const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+			switch (format) {
+			case File::CompressionFormat::NONE:
+				if (srcSize != dstSize) return false;
+				std::memcpy(dst, src, srcSize);
+				return true;
+			case File::CompressionFormat::LZ4:
+				return Lz4::Decompress(src, srcSize, dst, dstSize);
+			case File::CompressionFormat::GDEFLATE:
+#if defined(_WIN32)
+			{
+				size_t written = 0;
+				return SUCCEEDED(GetGDeflateCodec()->DecompressBuffer(src, srcSize, dst, dstSize, &written)) && written == dstSize;
+			}
+#else
+				throw std::runtime_error("[ChunkedCompression] GDeflate needs the DirectStorage codec (Windows only)");
+#endif
+			}
+			return false;
+		}
+
+		// Decodes every chunk of one section, in parallel when a pool is given.
+		// sectionData holds the section as stored in the file, starting at sectionFileOffset; dst receives the decompressed section.
+		static void Decompress(const uint8_t* sectionData, uint64_t sectionFileOffset, const std::vector<File::ChunkEntry>& chunks,
+			File::Section section, uint8_t* dst, ThreadPool* pool) {
+			std::vector<const File::ChunkEntry*> sectionChunks;
+			for (auto& chunk : chunks) {
+				if (chunk.section == section) sectionChunks.push_back(&chunk);
+			}
+
+			auto decompressChunk = [&](size_t i) {
+				auto& chunk = *sectionChunks[i];
+				if (!DecompressChunk(chunk.format, sectionData + (chunk.fileOffset - sectionFileOffset), chunk.compressedSize,
+					dst + chunk.uncompressedOffset, chunk.uncompressedSize)) {
+					throw std::runtime_error("[ChunkedCompression] Corrupt chunk at file offset " + std::to_string(chunk.fileOffset));
+				}
+				};
+
+			if (pool) {
+				pool->parallelFor(sectionChunks.size(), decompressChunk);
+			}
+			else {
+				for (size_t i = 0; i < sectionChunks.size(); i++) decompressChunk(i);
+			}
+		}
+
+		static const char* FormatName(File::CompressionFormat format) {
+			switch (format) {
+			case File::CompressionFormat::GDEFLATE: return "GDeflate";
+			case File::CompressionFormat::LZ4: return "LZ4";
+			default: return "none";
+			}
+		}
+
+	private:
+		static std::vector<uint8_t> CompressChunk(File::CompressionFormat format, const uint8_t* src, size_t size) {
+			std::vector<uint8_t> compressed;
+			switch (format) {
+			case File::CompressionFormat::LZ4:
+				compressed.resize(Lz4::CompressBound(size));
+				compressed.resize(Lz4::Compress(src, size, compressed.data()));
+				break;
+			case File::CompressionFormat::GDEFLATE:
+#if defined(_WIN32)
+			{
+				auto* codec = GetGDeflateCodec();
+				size_t written = 0;
+				compressed.resize(codec->CompressBufferBound(size));
+				if (FAILED(codec->CompressBuffer(src, size, DSTORAGE_COMPRESSION_BEST_RATIO, compressed.data(), compressed.size(), &written))) {
+					throw std::runtime_error("[ChunkedCompression] GDeflate compression failed");
+				}
+				compressed.resize(written);
+				break;
+			}
+#else
+				throw std::runtime_error("[ChunkedCompression] GDeflate needs the DirectStorage codec (Windows only)");
+#endif
+			default:
+				compressed.assign(src, src + size);
+				break;
+			}
+			return compressed;
+		}
+
+#if defined(_WIN32)
+		// One codec per thread; the codec keeps scratch state between calls.
+		static IDStorageCompressionCodec* GetGDeflateCodec() {
+			thread_local Microsoft::WRL::ComPtr<IDStorageCompressionCodec> codec;
+			if (!codec && FAILED(DStorageCreateCompressionCodec(DSTORAGE_COMPRESSION_FORMAT_GDEFLATE, 1, IID_PPV_ARGS(&codec)))) {
+				throw std::runtime_error("[ChunkedCompression] Can't create the GDeflate codec");
+			}
+			return codec.Get();
+		}
+#endif
+	};
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <atomic>
+#include <unordered_set>
+#include <iostream>
+#include <syncstream>
+
+#include "Structures.h"
+#include "AssetWriter.h"
+#include "ThreadPool.h"
+#include "Hash.h"
+
+namespace AssetsCreator::Asset {
+	namespace fs = std::filesystem;
+
+	// Directory of cooked submeshes named by the hash of their cooked bytes, shared by every source of a batch.
+	// Identical geometry is written once as a single submesh .mesh.asset and the meshes using it keep a reference
+	// (File::SubmeshEntry::payloadHash), so the runtime streams and stores one copy.
+	class ContentStore {
+	public:
+		ContentStore(fs::path directory, File::CompressionFormat compression, ThreadPool* pool)
+			: m_directory(std::move(directory)), m_compression(compression), m_pool(pool) {
+			fs::create_directories(m_directory);
+		}
+
+		const fs::path& getDirectory() const { return m_directory; }
+
+		// Everything the payload file holds: streams with their descriptors, indices, meshlets and LODs.
+		// Ids and materials stay with the referencing mesh and don't take part.
+		static uint64_t HashSubmesh(const SubMesh& submesh) {
+			Hash::XXH64State state;
+			auto add = [&](const auto& value) { state.update(&value, sizeof(value)); };
+
+			add(submesh.topology);
+			for (auto& [type, attribute] : submesh.attributes) {
+				add(type);
+				add(attribute->semanticIndex);
+				add(attribute->format);
+				add(attribute->strideInBytes);
+				state.update(attribute->data.data(), attribute->data.size());
+			}
+			if (submesh.interleaved) {
+				for (auto& element : submesh.interleaved->elements) {
+					add(element.type);
+					add(element.semanticIndex);
+					add(element.format);
+					add(element.offset);
+				}
+				add(submesh.interleaved->strideInBytes);
+				state.update(submesh.interleaved->data.data(), submesh.interleaved->data.size());
+			}
+			add(submesh.indices.format);
+			state.update(submesh.indices.data.data(), submesh.indices.data.size());
+			state.update(submesh.meshlets.data(), submesh.meshlets.size() * sizeof(Meshlet));
+			state.update(submesh.lods.data(), submesh.lods.size() * sizeof(Lod));
+
+			// 0 marks inline data in SubmeshEntry::payloadHash
+			uint64_t hash = state.digest();
+			return hash ? hash : 1;
+		}
+
+		fs::path getPayloadPath(uint64_t hash) const {
+			return m_directory / (File::PayloadId(hash) + ".mesh.asset");
+		}
+
+		// Writes the submesh unless an identical payload is already stored and returns its hash.
+		// Payloads left by earlier batches are trusted; the hash covers everything they contain.
+		uint64_t store(const SubMesh& submesh) {
+			uint64_t hash = HashSubmesh(submesh);
+			{
+				std::lock_guard lock(m_mutex);
+				if (!m_payloads.insert(hash).second) {
+					m_shared.fetch_add(1, std::memory_order_relaxed);
+					return hash;
+				}
+			}
+			if (fs::exists(getPayloadPath(hash))) {
+				m_shared.fetch_add(1, std::memory_order_relaxed);
+				return hash;
+			}
+
+			StreamingAssetWriter writer(File::PayloadId(hash), m_directory, m_compression, m_pool);
+			writer.setBvh(false);
+			writer.addSubmesh(submesh);
+			writer.finish();
+			m_written.fetch_add(1, std::memory_order_relaxed);
+			return hash;
+		}
+
+		void printSummary() const {
+			std::osyncstream(std::cout) << "[ContentStore] " << m_written.load() << " payload(s) written, "
+				<< m_shared.load() << " submesh(es) shared an existing one\n";
+		}
+
+	private:
+		fs::path m_directory;
+		File::CompressionFormat m_compression;
+		ThreadPool* m_pool;
+		std::mutex m_mutex;
+		std::unordered_set<uint64_t> m_payloads;
+		std::atomic<uint64_t> m_written{ 0 };
+		std::atomic<uint64_t> m_shared{ 0 };
+	};
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <filesystem>
+#include <cstdint>
+
+#include "Hash.h"
+#include "VertexWelder.h"
+#include "VertexLayout.h"
+#include "AttributeProfile.h"
+#include "TextureCooker.h"
+#include "Structures.h"
+
+namespace AssetsCreator::Cook {
+	// Bump whenever cooked output for the same source and options changes, so incremental batches recook everything.
+	constexpr uint32_t COOKER_VERSION = 23;
+
+	struct CookOptions {
+		std::filesystem::path outputDirectory = std::filesystem::current_path() / "assets";
+		uint32_t threadCount = 0; // 0 - hardware concurrency
+		bool compressIntoOneMesh = true;
+		bool mergeSubmeshes = false; // one submesh per material and stream layout instead of one per glTF primitive
+		Asset::AttributeProfile::Preset attributeProfile = Asset::AttributeProfile::Preset::RENDERER; // vertex streams kept per submesh
+		bool generateTangents = true; // MikkTSpace style tangents for triangles with normals and uvs but no TANGENT
+		bool weldVertices = true; // merge vertices equal in every stream
+		Asset::VertexWelder::Epsilon weldEpsilon{}; // exact by default
+		bool optimizeVertexCache = true; // triangle reorder for post-transform cache + first-use vertex order
+		bool buildMeshlets = true; // 64 vertex / 124 triangle clusters with bounds and normal cones
+		bool buildLods = true; // quadric simplified index-only LOD chain per submesh
+		bool buildBvh = true; // SAH triangle BVH per mesh over LOD0 for ray queries
+		bool quantizeVertices = false; // unorm16 positions, octahedral snorm16 normals/tangents, half texcoords
+		Asset::VertexLayout::Policy vertexLayout = Asset::VertexLayout::Policy::SEPARATE;
+		bool cookTextures = true; // glTF images to block compressed .texture.asset files with mips
+		Asset::TextureCooker::ColorFormat textureColorFormat = Asset::TextureCooker::ColorFormat::BC7;
+		bool cookScene = true; // glTF node tree to a .scene.asset with per mesh instance lists
+		bool contentStore = false; // identical cooked submeshes stored once in <out>/content, meshes reference them by hash
+#if defined(_WIN32)
+		Asset::File::CompressionFormat compression = Asset::File::CompressionFormat::GDEFLATE;
+#else
+		Asset::File::CompressionFormat compression = Asset::File::CompressionFormat::LZ4;
+#endif
+		bool force = false; // ignore the incremental cache
+		bool lowMemory = false; // read, cook and write one primitive at a time; same output, less parallelism
+		std::filesystem::path pakPath; // empty - loose files; otherwise every output of the batch is also packed into this .pak
+	};
+
+	// Only options that affect the cooked bytes take part in the hash (lowMemory and pakPath do not).
+	inline uint64_t HashCookOptions(const CookOptions& options) {
+		Hash::XXH64State state;
+		state.update(&COOKER_VERSION, sizeof(COOKER_VERSION));
+		uint8_t flags[] = {
+			static_cast<uint8_t>(options.compressIntoOneMesh),
+			static_cast<uint8_t>(options.optimizeVertexCache),
+			static_cast<uint8_t>(options.quantizeVertices),
+			static_cast<uint8_t>(options.buildMeshlets),
+			static_cast<uint8_t>(options.buildLods),
+			static_cast<uint8_t>(options.weldVertices),
+			static_cast<uint8_t>(options.compression),
+			static_cast<uint8_t>(options.vertexLayout),
+			static_cast<uint8_t>(options.cookTextures),
+			static_cast<uint8_t>(options.textureColorFormat),
+			static_cast<uint8_t>(options.cookScene),
+			static_cast<uint8_t>(options.contentStore),
+			static_cast<uint8_t>(options.generateTangents),
+			static_cast<uint8_t>(options.buildBvh),
+			static_cast<uint8_t>(options.attributeProfile),
+			static_cast<uint8_t>(options.mergeSubmeshes),
+		};
+		state.update(flags, sizeof(flags));
+		float epsilons[] = {
+			options.weldEpsilon.position,
+			options.weldEpsilon.normal,
+			options.weldEpsilon.tangent,
+			options.weldEpsilon.texcoord,
+			options.weldEpsilon.color,
+		};
+		state.update(epsilons, sizeof(epsilons));
+		return state.digest();
+	}
+}
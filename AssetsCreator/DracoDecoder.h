@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <span>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if __has_include(<draco/compression/decode.h>)
+#define ASSETS_CREATOR_DRACO
+#include <draco/compression/decode.h>
+#endif
+
+namespace AssetsCreator::Asset {
+	// Decodes KHR_draco_mesh_compression primitives with the Draco library when it is on the include path.
+	// Attributes come out tightly packed in the component type their glTF accessor declares, so they convert like
+	// uncompressed accessor data; quantized positions and normals are dequantized by Draco.
+	class DracoDecoder {
+	public:
+		// glTF component type codes
+		static constexpr uint32_t COMPONENT_BYTE = 5120;
+		static constexpr uint32_t COMPONENT_UNSIGNED_BYTE = 5121;
+		static constexpr uint32_t COMPONENT_SHORT = 5122;
+		static constexpr uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+		static constexpr uint32_t COMPONENT_UNSIGNED_INT = 5125;
+		static constexpr uint32_t COMPONENT_FLOAT = 5126;
+
+		// An attribute of the extension's "attributes" map, read as components values of componentType.
+		struct AttributeRequest {
+			uint32_t uniqueId;
+			uint32_t componentType;
+			uint32_t components;
+		};
+
+		struct Result {
+			std::vector<uint32_t> indices; // triangle list
+			uint32_t vertexCount = 0;
+			std::vector<std::vector<uint8_t>> attributes; // by request
+		};
+
+		static constexpr bool IsAvailable() {
+#if defined(ASSETS_CREATOR_DRACO)
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		static Result Decode(const uint8_t* data, size_t size, std::span<const AttributeRequest> requests, const std::string& id) {
+			Result result;
+#if defined(ASSETS_CREATOR_DRACO)
+			draco::DecoderBuffer buffer;
+			buffer.Init(reinterpret_cast<const char*>(data), size);
+			draco::Decoder decoder;
+			auto decoded = decoder.DecodeMeshFromBuffer(&buffer);
+			if (!decoded.ok()) {
+				throw std::runtime_error("[DracoDecoder] Can't decode " + id + ": " + decoded.status().error_msg_string());
+			}
+			std::unique_ptr<draco::Mesh> mesh = std::move(decoded).value();
+
+			result.vertexCount = mesh->num_points();
+			result.indices.resize(static_cast<size_t>(mesh->num_faces()) * 3);
+			for (uint32_t f = 0; f < mesh->num_faces(); f++) {
+				auto& face = mesh->face(draco::FaceIndex(f));
+				for (uint32_t c = 0; c < 3; c++) result.indices[f * 3 + c] = face[c].value();
+			}
+
+			result.attributes.reserve(requests.size());
+			for (auto& request : requests) {
+				auto* attribute = mesh->GetAttributeByUniqueId(request.uniqueId);
+				if (!attribute) {
+					throw std::runtime_error("[DracoDecoder] " + id + " has no attribute " + std::to_string(request.uniqueId));
+				}
+				auto& output = result.attributes.emplace_back();
+				switch (request.componentType) {
+				case COMPONENT_BYTE: ReadAttribute<int8_t>(*mesh, *attribute, request.components, output, id); break;
+				case COMPONENT_UNSIGNED_BYTE: ReadAttribute<uint8_t>(*mesh, *attribute, request.components, output, id); break;
+				case COMPONENT_SHORT: ReadAttribute<int16_t>(*mesh, *attribute, request.components, output, id); break;
+				case COMPONENT_UNSIGNED_SHORT: ReadAttribute<uint16_t>(*mesh, *attribute, request.components, output, id); break;
+				case COMPONENT_UNSIGNED_INT: ReadAttribute<uint32_t>(*mesh, *attribute, request.components, output, id); break;
+				case COMPONENT_FLOAT: ReadAttribute<float>(*mesh, *attribute, request.components, output, id); break;
+				default: throw std::runtime_error("[DracoDecoder] Unsupported component type in " + id);
+				}
+			}
+#else
+			throw std::runtime_error("[DracoDecoder] " + id + " is KHR_draco_mesh_compression only and the cooker was built without Draco");
+#endif
+			return result;
+		}
+
+	private:
+#if defined(ASSETS_CREATOR_DRACO)
+		// per point, through the point to value map Draco uses to share values between points
+		template<typename T>
+		static void ReadAttribute(const draco::Mesh& mesh, const draco::PointAttribute& attribute, uint32_t components, std::vector<uint8_t>& output,
+			const std::string& id) {
+			output.resize(static_cast<size_t>(mesh.num_points()) * components * sizeof(T));
+			auto* dst = reinterpret_cast<T*>(output.data());
+			for (uint32_t p = 0; p < mesh.num_points(); p++, dst += components) {
+				if (!attribute.ConvertValue<T>(attribute.mapped_index(draco::PointIndex(p)), static_cast<int8_t>(components), dst)) {
+					throw std::runtime_error("[DracoDecoder] Can't convert attribute " + std::to_string(attribute.unique_id()) + " of " + id);
+				}
+			}
+		}
+#endif
+	};
+}
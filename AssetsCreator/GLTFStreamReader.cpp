@@ -1,47 +1,142 @@
 #include "GLTFStreamReader.h"
+#if defined(_WIN32)
 #include <Windows.h>
+#endif
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define GLTF_LOCAL_SSE
+#endif
 
 namespace GLTFLocal {
 	struct Vec3 {
 		float x, y, z;
 	};
 
-	inline static void computeMinMax(const std::vector<float>& data, Vec3& minVal, Vec3& maxVal) {
-		if (data.empty() || data.size() % 3 != 0) {
-			throw std::runtime_error("Invalid data format (must be multiple of 3)");
+	// xyz triples. With SSE a register holds one vertex (its fourth lane is ignored); two accumulators hide the min/max
+	// latency, and the last vertex is loaded on its own so no load reads past the end.
+	inline static void computeMinMax(const float* data, size_t vertexCount, Vec3& minVal, Vec3& maxVal) {
+		if (vertexCount == 0) {
+			throw std::runtime_error("Invalid data format (no positions)");
 		}
 
+#if defined(GLTF_LOCAL_SSE)
+		const float* last = data + (vertexCount - 1) * 3;
+		__m128 min0 = _mm_set_ps(0.f, last[2], last[1], last[0]);
+		__m128 max0 = min0, min1 = min0, max1 = min0;
+		size_t i = 0;
+		for (; i + 2 < vertexCount; i += 2) {
+			__m128 a = _mm_loadu_ps(data + i * 3);
+			__m128 b = _mm_loadu_ps(data + i * 3 + 3);
+			min0 = _mm_min_ps(min0, a);
+			max0 = _mm_max_ps(max0, a);
+			min1 = _mm_min_ps(min1, b);
+			max1 = _mm_max_ps(max1, b);
+		}
+		for (; i + 1 < vertexCount; i++) {
+			__m128 a = _mm_loadu_ps(data + i * 3);
+			min0 = _mm_min_ps(min0, a);
+			max0 = _mm_max_ps(max0, a);
+		}
+		alignas(16) float minLanes[4], maxLanes[4];
+		_mm_store_ps(minLanes, _mm_min_ps(min0, min1));
+		_mm_store_ps(maxLanes, _mm_max_ps(max0, max1));
+		minVal = { minLanes[0], minLanes[1], minLanes[2] };
+		maxVal = { maxLanes[0], maxLanes[1], maxLanes[2] };
+#else
 		minVal = { data[0], data[1], data[2] };
 		maxVal = minVal;
+		for (size_t i = 1; i < vertexCount; i++) {
+			const float* p = data + i * 3;
+			minVal.x = std::min<float>(minVal.x, p[0]);
+			minVal.y = std::min<float>(minVal.y, p[1]);
+			minVal.z = std::min<float>(minVal.z, p[2]);
+			maxVal.x = std::max<float>(maxVal.x, p[0]);
+			maxVal.y = std::max<float>(maxVal.y, p[1]);
+			maxVal.z = std::max<float>(maxVal.z, p[2]);
+		}
+#endif
+	}
+
+	// vec3 elements of T to vec4 with the given w, in place in the attribute's bytes
+	template<typename T>
+	inline static void ExpandToVec4(std::vector<uint8_t>& data, T w) {
+		size_t count = data.size() / (3 * sizeof(T));
+		std::vector<uint8_t> vec4(count * 4 * sizeof(T));
+		for (size_t i = 0; i < count; i++) {
+			std::memcpy(vec4.data() + i * 4 * sizeof(T), data.data() + i * 3 * sizeof(T), 3 * sizeof(T));
+			std::memcpy(vec4.data() + (i * 4 + 3) * sizeof(T), &w, sizeof(T));
+		}
+		data = std::move(vec4);
+	}
 
-		for (size_t i = 3; i < data.size(); i += 3) {
-			minVal.x = std::min<float>(minVal.x, data[i]);
-			minVal.y = std::min<float>(minVal.y, data[i + 1]);
-			minVal.z = std::min<float>(minVal.z, data[i + 2]);
+	template<typename T, typename C>
+	inline static std::vector<T> ReadBinaryDataAs(const GLTFResourceReader& reader, const Document& document, const Accessor& accessor) {
+		auto data = reader.ReadBinaryData<C>(document, accessor);
+		return std::vector<T>(data.begin(), data.end());
+	}
 
-			maxVal.x = std::max<float>(maxVal.x, data[i]);
-			maxVal.y = std::max<float>(maxVal.y, data[i + 1]);
-			maxVal.z = std::max<float>(maxVal.z, data[i + 2]);
+	constexpr const char* EXT_MESHOPT_COMPRESSION = "EXT_meshopt_compression";
+	constexpr const char* KHR_DRACO_MESH_COMPRESSION = "KHR_draco_mesh_compression";
+	constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942; // "BIN\0"
+
+	template<typename T, typename C>
+	inline static T ConvertComponent(const uint8_t* data, bool normalized) {
+		C value;
+		std::memcpy(&value, data, sizeof(C));
+		if constexpr (std::is_floating_point_v<T> && std::is_integral_v<C>) {
+			// signed values clamp at -1 so both -127 and -128 decode to -1
+			if (normalized) return std::max(static_cast<float>(value) / static_cast<float>(std::numeric_limits<C>::max()), -1.f);
 		}
+		return static_cast<T>(value);
 	}
 
-	inline static std::vector<uint8_t> ConvertFloatVectorToByteVector(const std::vector<float>& floatVec) {
-		std::vector<uint8_t> byteVec(floatVec.size() * sizeof(float));
-		std::memcpy(byteVec.data(), floatVec.data(), byteVec.size());
-		return byteVec;
+	template<typename T>
+	inline static T ConvertComponent(const uint8_t* data, ComponentType componentType, bool normalized) {
+		switch (componentType) {
+		case COMPONENT_BYTE: return ConvertComponent<T, int8_t>(data, normalized);
+		case COMPONENT_UNSIGNED_BYTE: return ConvertComponent<T, uint8_t>(data, normalized);
+		case COMPONENT_SHORT: return ConvertComponent<T, int16_t>(data, normalized);
+		case COMPONENT_UNSIGNED_SHORT: return ConvertComponent<T, uint16_t>(data, normalized);
+		case COMPONENT_UNSIGNED_INT: return ConvertComponent<T, uint32_t>(data, normalized);
+		case COMPONENT_FLOAT: return ConvertComponent<T, float>(data, normalized);
+		default: throw std::invalid_argument("Unsupported ComponentType");
+		}
 	}
 
-	inline static std::vector<uint8_t> ConvertUint32VectorToByteVector(const std::vector<uint32_t>& input) {
-		std::vector<uint8_t> output;
-		output.reserve(input.size() * 4);
+	// Accessor elements as T from in-memory bufferView bytes into output. Tightly packed elements of T's own type are one
+	// memcpy; anything else (strides, KHR_mesh_quantization integer positions, normalized normals and texcoords) is
+	// converted per component the way ReadFloatData converts uncompressed ones.
+	template<typename T>
+	inline static void CopyComponents(const Accessor& accessor, const uint8_t* view, size_t viewSize, size_t byteStride, std::vector<uint8_t>& output) {
+		size_t components = Accessor::GetTypeCount(accessor.type);
+		size_t componentSize = Accessor::GetComponentTypeSize(accessor.componentType);
+		size_t elementSize = components * componentSize;
+		if (accessor.count && accessor.byteOffset + (accessor.count - 1) * byteStride + elementSize > viewSize) {
+			throw std::runtime_error("[GLTFSource] Accessor " + accessor.id + " reads past its bufferView");
+		}
 
-		for (uint32_t value : input) {
-			for (int i = 0; i < 4; ++i) {
-				output.push_back(static_cast<uint8_t>((value >> (8 * i)) & 0xFF));
+		output.resize(accessor.count * components * sizeof(T));
+		const uint8_t* src = view + accessor.byteOffset;
+		bool sameType = componentSize == sizeof(T) && (accessor.componentType == COMPONENT_FLOAT) == std::is_floating_point_v<T>;
+		if (sameType && byteStride == elementSize) {
+			std::memcpy(output.data(), src, accessor.count * elementSize);
+			return;
+		}
+		if (sameType) {
+			for (size_t i = 0; i < accessor.count; i++) {
+				std::memcpy(output.data() + i * elementSize, src + i * byteStride, elementSize);
 			}
+			return;
 		}
 
-		return output;
+		uint8_t* dst = output.data();
+		for (size_t i = 0; i < accessor.count; i++) {
+			const uint8_t* element = src + i * byteStride;
+			for (size_t c = 0; c < components; c++, dst += sizeof(T)) {
+				T value = ConvertComponent<T>(element + c * componentSize, accessor.componentType, accessor.normalized);
+				std::memcpy(dst, &value, sizeof(T));
+			}
+		}
 	}
 
 	struct AttributeFormat
@@ -153,6 +248,7 @@ namespace GLTFLocal {
 	}
 }
 
+#if defined(_WIN32)
 inline static void GetAssetsPath(_Out_writes_(pathSize) WCHAR* path, UINT pathSize)
 {
 	if (path == nullptr)
@@ -172,19 +268,24 @@ inline static void GetAssetsPath(_Out_writes_(pathSize) WCHAR* path, UINT pathSi
 		*(lastSlash + 1) = L'\0';
 	}
 }
+#endif
 
 inline GLTFLocal::GLTFStreamReader::GLTFStreamReader(fs::path pathBase) : m_pathBase(std::move(pathBase))
 {
+#if defined(_WIN32)
 	WCHAR assetsPath[512];
 	GetAssetsPath(assetsPath, _countof(assetsPath));
 	fs::path assetsPathW(assetsPath);
+#else
+	fs::path assetsPathW = fs::read_symlink("/proc/self/exe").parent_path();
+#endif
 	m_pathBase = assetsPathW / m_pathBase;
 	assert(m_pathBase.has_root_path());
 }
 
 inline std::shared_ptr<std::istream> GLTFLocal::GLTFStreamReader::GetInputStream(const std::string& filename) const
 {
-	auto streamPath = m_pathBase / filename;
+	auto streamPath = GetPath(filename);
 	auto stream = std::make_shared<std::ifstream>(streamPath, std::ios_base::binary);
 
 	if (!stream || !(*stream))
@@ -195,7 +296,7 @@ inline std::shared_ptr<std::istream> GLTFLocal::GLTFStreamReader::GetInputStream
 	return stream;
 }
 
-std::vector<std::unique_ptr<AssetsCreator::Asset::Mesh>> GLTFLocal::GetMeshesInfo(const fs::path& path, bool compressIntoOneMesh) {
+GLTFLocal::GLTFSource::GLTFSource(const fs::path& path) {
 	using namespace std;
 
 	auto streamReader = make_unique<GLTFStreamReader>(path.parent_path());
@@ -211,7 +312,6 @@ std::vector<std::unique_ptr<AssetsCreator::Asset::Mesh>> GLTFLocal::GetMeshesInf
 			return "." + ext;
 		};
 
-	unique_ptr<GLTFResourceReader> resourceReader;
 	auto strReader = streamReader.get();
 
 	if (pathFileExt == MakePathExt(GLTF_EXTENSION))
@@ -224,28 +324,42 @@ std::vector<std::unique_ptr<AssetsCreator::Asset::Mesh>> GLTFLocal::GetMeshesInf
 		manifestStream << gltfStream->rdbuf();
 		manifest = manifestStream.str();
 
-		resourceReader = move(gltfResourceReader);
+		m_resourceReader = move(gltfResourceReader);
 	}
 	else if (pathFileExt == MakePathExt(GLB_EXTENSION))
 	{
+		auto glbPath = strReader->GetPath(pathFile.string());
 		auto glbStream = strReader->GetInputStream(pathFile.string());
 		auto glbResourceReader = make_unique<GLBResourceReader>(move(streamReader), move(glbStream));
 
 		manifest = glbResourceReader->GetJson();
 
-		resourceReader = move(glbResourceReader);
+		m_resourceReader = move(glbResourceReader);
+
+		// 12 byte header, the JSON chunk, then the BIN chunk; chunk lengths include their padding
+		m_glb = make_unique<AssetsCreator::MappedFile>(glbPath);
+		auto* glb = m_glb->data();
+		auto readUint32 = [&](size_t offset) {
+			uint32_t value;
+			memcpy(&value, glb + offset, sizeof(value));
+			return value;
+			};
+		if (m_glb->size() >= 20) {
+			size_t binChunk = 20 + static_cast<size_t>(readUint32(12));
+			if (binChunk + 8 <= m_glb->size() && readUint32(binChunk + 4) == GLB_CHUNK_BIN && readUint32(binChunk) <= m_glb->size() - binChunk - 8) {
+				m_binChunk = { glb + binChunk + 8, readUint32(binChunk) };
+			}
+		}
 	}
 
-	if (!resourceReader)
+	if (!m_resourceReader)
 	{
 		throw runtime_error("Command line argument path filename extension must be .gltf or .glb");
 	}
 
-	Document document;
-
 	try
 	{
-		document = Deserialize(manifest);
+		m_document = Deserialize(manifest);
 	}
 	catch (const GLTFException& ex)
 	{
@@ -257,127 +371,575 @@ std::vector<std::unique_ptr<AssetsCreator::Asset::Mesh>> GLTFLocal::GetMeshesInf
 		throw runtime_error(ss.str());
 	}
 
+	// the only buffer without a uri in a GLB is the first one, stored in the BIN chunk
+	if (!m_binChunk.empty() && m_document.buffers.Size() && m_document.buffers.Elements()[0].uri.empty()) {
+		m_binBufferId = m_document.buffers.Elements()[0].id;
+	}
+	else {
+		m_binChunk = {};
+	}
 
-	std::vector<std::unique_ptr<AssetsCreator::Asset::Mesh>> vMeshes;
-	auto& meshes = document.meshes.Elements();
 	uint32_t i = 0;
-	for (auto& mesh : meshes) {
-		auto vMesh = std::make_unique<AssetsCreator::Asset::Mesh>();
-		vMesh->id = pathFileName.generic_string() + "_" + std::to_string(i++);
-
-		auto& primitives = mesh.primitives;
-		uint32_t j = 0;
-		for (auto& primitive : primitives) {
-			auto vSubMesh = std::make_unique<AssetsCreator::Asset::SubMesh>();
-			vSubMesh->id = vMesh->id + "_" + std::to_string(j++);
-
-			auto& indicesAccessor = document.accessors.Get(primitive.indicesAccessorId);
-			auto indices = resourceReader->ReadBinaryData<uint32_t>(document, indicesAccessor);
-
-			vSubMesh->indices.data = ConvertUint32VectorToByteVector(indices);
-			vSubMesh->indices.format = DXGI_FORMAT_R32_UINT;
-			vSubMesh->indices.strideInBytes = 4;
-
-			vSubMesh->topology = MeshModeToD3DPrimitiveTopology(primitive.mode);
-
-
-			auto& attributes = primitive.attributes;
-			for (auto& attribute : attributes) {
-				auto vAttribute = std::make_unique<AssetsCreator::Asset::Attribute>();
-
-				auto& accessor = document.accessors.Get(attribute.second);
-				auto attributeFormat = GetAttributeFormat(accessor.type, accessor.componentType, accessor.normalized);
-				vAttribute->format = attributeFormat.dxgiFormat;
-				vAttribute->strideInBytes = attributeFormat.strideInBytes;
-
-				if (attribute.first == ACCESSOR_POSITION) {
-					auto data = resourceReader->ReadFloatData(document, accessor);
-					Vec3 min, max;
-					computeMinMax(data, min, max);
-
-					vAttribute->data = ConvertFloatVectorToByteVector(data);
-					vAttribute->semanticIndex = 0;
-					vAttribute->semanticName = "POSITION";
-					vAttribute->type = AssetsCreator::Asset::AttributeType::POSITION;
-
-
-					vSubMesh->aabbMin[0] = min.x;
-					vSubMesh->aabbMin[1] = min.y;
-					vSubMesh->aabbMin[2] = min.z;
-
-					vSubMesh->aabbMax[0] = max.x;
-					vSubMesh->aabbMax[1] = max.y;
-					vSubMesh->aabbMax[2] = max.z;
-
-					vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
-				}
-				else if (attribute.first == ACCESSOR_NORMAL) {
-					auto data = resourceReader->ReadFloatData(document, accessor);
-					vAttribute->data = ConvertFloatVectorToByteVector(data);
-					vAttribute->semanticIndex = 0;
-					vAttribute->semanticName = "NORMAL";
-					vAttribute->type = AssetsCreator::Asset::AttributeType::NORMAL;
-					vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
-				}
-				else if (attribute.first == ACCESSOR_TEXCOORD_0) {
-					auto data = resourceReader->ReadFloatData(document, accessor);
-					vAttribute->data = ConvertFloatVectorToByteVector(data);
-					vAttribute->semanticIndex = 0;
-					vAttribute->semanticName = "TEXCOORD";
-					vAttribute->type = AssetsCreator::Asset::AttributeType::TEXCOORD;
-					vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
-				}
-				else if (attribute.first == ACCESSOR_TEXCOORD_1) {
-					auto data = resourceReader->ReadFloatData(document, accessor);
-					vAttribute->data = ConvertFloatVectorToByteVector(data);
-					vAttribute->semanticIndex = 1;
-					vAttribute->semanticName = "TEXCOORD";
-					vAttribute->type = AssetsCreator::Asset::AttributeType::TEXCOORD;
-					vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
-				}
-				else if (attribute.first == ACCESSOR_TANGENT) {
-					auto data = resourceReader->ReadFloatData(document, accessor);
-					vAttribute->data = ConvertFloatVectorToByteVector(data);
-					vAttribute->semanticIndex = 0;
-					vAttribute->semanticName = "TANGENT";
-					vAttribute->type = AssetsCreator::Asset::AttributeType::TANGENT;
-					vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
-				}
-				else if (attribute.first == ACCESSOR_JOINTS_0) {
-					auto data = resourceReader->ReadFloatData(document, accessor);
-					vAttribute->data = ConvertFloatVectorToByteVector(data);
-					vAttribute->semanticIndex = 0;
-					vAttribute->semanticName = "JOINT";
-					vAttribute->type = AssetsCreator::Asset::AttributeType::JOINT;
-					vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
-				}
-				else if (attribute.first == ACCESSOR_WEIGHTS_0) {
-					auto data = resourceReader->ReadFloatData(document, accessor);
-					vAttribute->data = ConvertFloatVectorToByteVector(data);
-					vAttribute->semanticIndex = 0;
-					vAttribute->semanticName = "WEIGHT";
-					vAttribute->type = AssetsCreator::Asset::AttributeType::WEIGHT;
-					vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
-				}
-				else if (attribute.first == ACCESSOR_COLOR_0) {
-					auto data = resourceReader->ReadFloatData(document, accessor);
-					vAttribute->data = ConvertFloatVectorToByteVector(data);
-					vAttribute->semanticIndex = 0;
-					vAttribute->semanticName = "COLOR";
-					vAttribute->type = AssetsCreator::Asset::AttributeType::COLOR;
-					vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
-				}
+	for (auto& mesh : m_document.meshes.Elements()) {
+		m_meshes.push_back({ pathFileName.generic_string() + "_" + std::to_string(i++), mesh.primitives.size() });
+	}
 
+	using AssetsCreator::Asset::MeshoptDecoder;
+	for (size_t v = 0; v < m_document.bufferViews.Size(); v++) {
+		auto& bufferView = m_document.bufferViews.Elements()[v];
+		auto extension = bufferView.extensions.find(EXT_MESHOPT_COMPRESSION);
+		if (extension == bufferView.extensions.end()) continue;
+
+		auto json = RapidJsonUtils::CreateDocumentFromString(extension->second);
+		auto invalid = [&](const std::string& what) {
+			return runtime_error("[GLTFSource] bufferView " + to_string(v) + " has an invalid " + EXT_MESHOPT_COMPRESSION + " " + what);
+			};
+		auto getSize = [&](const char* name, bool required) -> size_t {
+			auto member = json.FindMember(name);
+			if (member == json.MemberEnd() || !member->value.IsUint64()) {
+				if (required) throw invalid(name);
+				return 0;
 			}
-			vMesh->submeshes.push_back(std::move(vSubMesh));
+			return static_cast<size_t>(member->value.GetUint64());
+			};
+		auto getString = [&](const char* name, const char* fallback) -> string {
+			auto member = json.FindMember(name);
+			return member != json.MemberEnd() && member->value.IsString() ? member->value.GetString() : fallback;
+			};
+
+		CompressedView view{};
+		size_t bufferIndex = getSize("buffer", true);
+		if (bufferIndex >= m_document.buffers.Size()) throw invalid("buffer");
+		view.source.bufferId = m_document.buffers.Elements()[bufferIndex].id;
+		view.source.byteOffset = getSize("byteOffset", false);
+		view.source.byteLength = getSize("byteLength", true);
+		view.byteStride = getSize("byteStride", true);
+		view.count = getSize("count", true);
+
+		auto mode = getString("mode", "");
+		if (mode == "ATTRIBUTES") view.mode = MeshoptDecoder::Mode::ATTRIBUTES;
+		else if (mode == "TRIANGLES") view.mode = MeshoptDecoder::Mode::TRIANGLES;
+		else if (mode == "INDICES") view.mode = MeshoptDecoder::Mode::INDICES;
+		else throw invalid("mode");
+
+		auto filter = getString("filter", "NONE");
+		if (filter == "NONE") view.filter = MeshoptDecoder::Filter::NONE;
+		else if (filter == "OCTAHEDRAL") view.filter = MeshoptDecoder::Filter::OCTAHEDRAL;
+		else if (filter == "QUATERNION") view.filter = MeshoptDecoder::Filter::QUATERNION;
+		else if (filter == "EXPONENTIAL") view.filter = MeshoptDecoder::Filter::EXPONENTIAL;
+		else throw invalid("filter");
+
+		m_compressedViews.emplace(v, std::move(view));
+	}
+	for (auto& mesh : m_document.meshes.Elements()) {
+		for (auto& primitive : mesh.primitives) {
+			for (size_t viewIndex : GetCompressedViews(primitive)) m_pendingPrimitives[viewIndex]++;
+		}
+	}
+
+	using AssetsCreator::Asset::TextureUsage;
+	for (size_t j = 0; j < m_document.images.Size(); j++) {
+		m_images.push_back({ pathFileName.generic_string() + "_image_" + std::to_string(j), TextureUsage::DEFAULT });
+	}
+	auto findImage = [&](const std::string& textureId) -> ImageInfo* {
+		if (textureId.empty() || !m_document.textures.Has(textureId)) return nullptr;
+		auto& imageId = m_document.textures.Get(textureId).imageId;
+		if (imageId.empty() || !m_document.images.Has(imageId)) return nullptr;
+		return &m_images[m_document.images.GetIndex(imageId)];
+		};
+
+	// occlusion comes last: an occlusion/roughness/metallic image shared with metallicRoughness keeps all three channels
+	for (auto& material : m_document.materials.Elements()) {
+		const std::pair<const std::string&, TextureUsage> references[] = {
+			{ material.metallicRoughness.baseColorTexture.textureId, TextureUsage::BASE_COLOR },
+			{ material.normalTexture.textureId, TextureUsage::NORMAL },
+			{ material.metallicRoughness.metallicRoughnessTexture.textureId, TextureUsage::METALLIC_ROUGHNESS },
+			{ material.emissiveTexture.textureId, TextureUsage::EMISSIVE },
+			{ material.occlusionTexture.textureId, TextureUsage::OCCLUSION },
+		};
+		for (auto& [textureId, usage] : references) {
+			auto* image = findImage(textureId);
+			if (image && image->usage == TextureUsage::DEFAULT) image->usage = usage;
+		}
+	}
+
+	using AssetsCreator::Asset::MaterialTexture;
+	for (size_t k = 0; k < m_document.materials.Size(); k++) {
+		auto& source = m_document.materials.Elements()[k];
+		AssetsCreator::Asset::Material material;
+		material.id = pathFileName.generic_string() + "_material_" + std::to_string(k);
+
+		auto& baseColor = source.metallicRoughness.baseColorFactor;
+		float baseColorFactor[4] = { baseColor.r, baseColor.g, baseColor.b, baseColor.a };
+		std::copy_n(baseColorFactor, 4, material.baseColorFactor);
+		float emissiveFactor[4] = { source.emissiveFactor.r, source.emissiveFactor.g, source.emissiveFactor.b, 1.f };
+		std::copy_n(emissiveFactor, 4, material.emissiveFactor);
+		// gbuffers.hlsl reads metallic from z and roughness from w
+		float factors[4] = { source.normalTexture.scale, source.occlusionTexture.strength, source.metallicRoughness.metallicFactor, source.metallicRoughness.roughnessFactor };
+		std::copy_n(factors, 4, material.normalScaleOcclusionStrengthMRFactors);
+
+		const std::pair<const std::string&, MaterialTexture> slots[] = {
+			{ source.metallicRoughness.baseColorTexture.textureId, MaterialTexture::BASE_COLOR },
+			{ source.emissiveTexture.textureId, MaterialTexture::EMISSIVE },
+			{ source.normalTexture.textureId, MaterialTexture::NORMAL },
+			{ source.occlusionTexture.textureId, MaterialTexture::OCCLUSION },
+			{ source.metallicRoughness.metallicRoughnessTexture.textureId, MaterialTexture::METALLIC_ROUGHNESS },
+		};
+		for (auto& [textureId, slot] : slots) {
+			if (auto* image = findImage(textureId)) material.textures[static_cast<uint32_t>(slot)] = image->id;
 		}
 
+		switch (source.alphaMode) {
+		case ALPHA_MASK: material.alphaMode = AssetsCreator::Asset::AlphaMode::ALPHA_MASK; break;
+		case ALPHA_BLEND: material.alphaMode = AssetsCreator::Asset::AlphaMode::ALPHA_BLEND; break;
+		default: material.alphaMode = AssetsCreator::Asset::AlphaMode::ALPHA_OPAQUE; break;
+		}
+		material.alphaCutoff = source.alphaCutoff;
+		material.doubleSided = source.doubleSided;
+		m_materials.push_back(std::move(material));
+	}
+}
+
+std::vector<AssetsCreator::Asset::SceneNode> GLTFLocal::GLTFSource::ReadNodes() const {
+	using AssetsCreator::Asset::NO_PARENT;
+	std::vector<std::string> roots;
+	if (m_document.scenes.Size()) {
+		auto& scene = m_document.defaultSceneId.empty() ? m_document.scenes.Elements()[0] : m_document.scenes.Get(m_document.defaultSceneId);
+		roots = scene.nodes;
+	}
+	else {
+		std::vector<bool> isChild(m_document.nodes.Size(), false);
+		for (auto& node : m_document.nodes.Elements()) {
+			for (auto& child : node.children) isChild[m_document.nodes.GetIndex(child)] = true;
+		}
+		for (size_t i = 0; i < isChild.size(); i++) {
+			if (!isChild[i]) roots.push_back(m_document.nodes.Elements()[i].id);
+		}
+	}
+
+	// depth first, so every parent is written before its children
+	std::vector<AssetsCreator::Asset::SceneNode> nodes;
+	std::vector<bool> visited(m_document.nodes.Size(), false);
+	std::vector<std::pair<std::string, uint32_t>> stack;
+	for (auto it = roots.rbegin(); it != roots.rend(); ++it) stack.emplace_back(*it, NO_PARENT);
+	while (!stack.empty()) {
+		auto [nodeId, parentIndex] = stack.back();
+		stack.pop_back();
+		size_t documentIndex = m_document.nodes.GetIndex(nodeId);
+		if (visited[documentIndex]) continue;
+		visited[documentIndex] = true;
+
+		auto& source = m_document.nodes.Get(nodeId);
+		AssetsCreator::Asset::SceneNode node;
+		node.name = source.name.empty() ? "node_" + std::to_string(documentIndex) : source.name;
+		node.parentIndex = parentIndex;
+		if (!source.meshId.empty()) node.meshIndex = static_cast<uint32_t>(m_document.meshes.GetIndex(source.meshId));
+		if (source.matrix != Matrix4::IDENTITY) {
+			AssetsCreator::Asset::SceneBuilder::Matrix matrix;
+			std::copy(source.matrix.values.begin(), source.matrix.values.end(), matrix.begin());
+			node.local = AssetsCreator::Asset::SceneBuilder::Decompose(matrix);
+		}
+		else {
+			float translation[3] = { source.translation.x, source.translation.y, source.translation.z };
+			float rotation[4] = { source.rotation.x, source.rotation.y, source.rotation.z, source.rotation.w };
+			float scale[3] = { source.scale.x, source.scale.y, source.scale.z };
+			std::copy_n(translation, 3, node.local.translation);
+			std::copy_n(rotation, 4, node.local.rotation);
+			std::copy_n(scale, 3, node.local.scale);
+		}
+
+		uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+		nodes.push_back(std::move(node));
+		for (auto it = source.children.rbegin(); it != source.children.rend(); ++it) stack.emplace_back(*it, nodeIndex);
+	}
+	return nodes;
+}
+
+std::vector<uint8_t> GLTFLocal::GLTFSource::ReadImage(size_t imageIndex) const {
+	auto& image = m_document.images.Elements()[imageIndex];
+	std::lock_guard lock(m_readerMutex);
+	return m_resourceReader->ReadBinaryData(m_document, image);
+}
+
+const uint8_t* GLTFLocal::GLTFSource::GetMappedData(const std::string& bufferId, size_t byteOffset, size_t byteLength) const {
+	if (m_binChunk.empty() || bufferId != m_binBufferId) return nullptr;
+	if (byteOffset > m_binChunk.size() || byteLength > m_binChunk.size() - byteOffset) {
+		throw std::runtime_error("[GLTFSource] bufferView range is outside the GLB BIN chunk");
+	}
+	return m_binChunk.data() + byteOffset;
+}
+
+template<typename T>
+void GLTFLocal::GLTFSource::ReadAccessor(const Accessor& accessor, std::vector<uint8_t>& output, const std::vector<uint8_t>* decoded) const {
+	if (decoded) {
+		size_t elementSize = Accessor::GetTypeCount(accessor.type) * Accessor::GetComponentTypeSize(accessor.componentType);
+		CopyComponents<T>(accessor, decoded->data(), decoded->size(), elementSize, output);
+		return;
+	}
+	if (!accessor.bufferViewId.empty()) {
+		size_t viewIndex = m_document.bufferViews.GetIndex(accessor.bufferViewId);
+		auto compressed = m_compressedViews.find(viewIndex);
+		if (compressed != m_compressedViews.end()) {
+			if (accessor.sparse.count) {
+				throw std::runtime_error("[GLTFSource] Sparse accessor " + accessor.id + " over an EXT_meshopt_compression bufferView is not supported");
+			}
+			auto view = DecodeView(viewIndex);
+			CopyComponents<T>(accessor, view->data(), view->size(), compressed->second.byteStride, output);
+			return;
+		}
+
+		auto& bufferView = m_document.bufferViews.Elements()[viewIndex];
+		auto* data = accessor.sparse.count ? nullptr : GetMappedData(bufferView.bufferId, bufferView.byteOffset, bufferView.byteLength);
+		if (data) {
+			size_t elementSize = Accessor::GetTypeCount(accessor.type) * Accessor::GetComponentTypeSize(accessor.componentType);
+			size_t byteStride = bufferView.byteStride.HasValue() ? bufferView.byteStride.Get() : elementSize;
+			CopyComponents<T>(accessor, data, bufferView.byteLength, byteStride, output);
+			return;
+		}
+	}
+
+	// external buffers and sparse accessors go through the resource reader
+	std::vector<T> data;
+	{
+		std::lock_guard lock(m_readerMutex);
+		if constexpr (std::is_same_v<T, float>) {
+			data = m_resourceReader->ReadFloatData(m_document, accessor);
+		}
+		else {
+			switch (accessor.componentType) {
+			case COMPONENT_UNSIGNED_BYTE: data = ReadBinaryDataAs<T, uint8_t>(*m_resourceReader, m_document, accessor); break;
+			case COMPONENT_UNSIGNED_SHORT: data = ReadBinaryDataAs<T, uint16_t>(*m_resourceReader, m_document, accessor); break;
+			default: data = ReadBinaryDataAs<T, uint32_t>(*m_resourceReader, m_document, accessor); break;
+			}
+		}
+	}
+	output.resize(data.size() * sizeof(T));
+	std::memcpy(output.data(), data.data(), output.size());
+}
+
+GLTFLocal::GLTFSource::DecodedView GLTFLocal::GLTFSource::DecodeView(size_t viewIndex) const {
+	std::shared_future<DecodedView> pending;
+	std::promise<DecodedView> promise;
+	{
+		std::lock_guard lock(m_decodedMutex);
+		auto [itt, inserted] = m_decodedViews.try_emplace(viewIndex);
+		if (inserted) itt->second = promise.get_future().share();
+		else pending = itt->second;
+	}
+	// decoded, or being decoded for another primitive
+	if (pending.valid()) return pending.get();
+
+	try {
+		auto& view = m_compressedViews.at(viewIndex);
+		// GLB bytes are decoded in place, other buffers are read under the lock first
+		std::vector<uint8_t> compressed;
+		const uint8_t* source = GetMappedData(view.source.bufferId, view.source.byteOffset, view.source.byteLength);
+		if (!source) {
+			std::lock_guard lock(m_readerMutex);
+			compressed = m_resourceReader->ReadBinaryData<uint8_t>(m_document, view.source);
+			source = compressed.data();
+		}
+		auto decoded = std::make_shared<std::vector<uint8_t>>(view.count * view.byteStride);
+		if (!AssetsCreator::Asset::MeshoptDecoder::Decode(view.mode, view.filter, decoded->data(), view.count, view.byteStride, source, view.source.byteLength)) {
+			throw std::runtime_error("[GLTFSource] Malformed EXT_meshopt_compression data in bufferView " + std::to_string(viewIndex));
+		}
+		promise.set_value(decoded);
+		return decoded;
+	}
+	catch (...) {
+		promise.set_exception(std::current_exception());
+		throw;
+	}
+}
+
+std::unordered_map<std::string, GLTFLocal::GLTFSource::DracoStream> GLTFLocal::GLTFSource::DecodeDraco(const MeshPrimitive& primitive, const std::string& id) const {
+	using AssetsCreator::Asset::DracoDecoder;
+	auto json = RapidJsonUtils::CreateDocumentFromString(primitive.extensions.at(KHR_DRACO_MESH_COMPRESSION));
+	auto invalid = [&](const std::string& what) {
+		return std::runtime_error("[GLTFSource] " + id + " has an invalid " + KHR_DRACO_MESH_COMPRESSION + " " + what);
+		};
+	auto bufferViewMember = json.FindMember("bufferView");
+	auto attributesMember = json.FindMember("attributes");
+	if (bufferViewMember == json.MemberEnd() || !bufferViewMember->value.IsUint64() || bufferViewMember->value.GetUint64() >= m_document.bufferViews.Size()) {
+		throw invalid("bufferView");
+	}
+	if (attributesMember == json.MemberEnd() || !attributesMember->value.IsObject()) throw invalid("attributes");
+
+	// accessors keep their type and component type, Draco decodes into them; attributes the extension leaves out stay plain
+	std::vector<std::string> accessorIds;
+	std::vector<DracoDecoder::AttributeRequest> requests;
+	for (auto attribute = attributesMember->value.MemberBegin(); attribute != attributesMember->value.MemberEnd(); ++attribute) {
+		auto itt = primitive.attributes.find(attribute->name.GetString());
+		if (itt == primitive.attributes.end()) continue;
+		if (!attribute->value.IsUint64()) throw invalid(std::string("attribute ") + attribute->name.GetString());
+		auto& accessor = m_document.accessors.Get(itt->second);
+		accessorIds.push_back(accessor.id);
+		requests.push_back({ static_cast<uint32_t>(attribute->value.GetUint64()), static_cast<uint32_t>(accessor.componentType), static_cast<uint32_t>(Accessor::GetTypeCount(accessor.type)) });
+	}
+
+	// GLB bytes are decoded in place, other buffers are read under the lock first
+	auto& bufferView = m_document.bufferViews.Elements()[bufferViewMember->value.GetUint64()];
+	std::vector<uint8_t> compressed;
+	const uint8_t* source = GetMappedData(bufferView.bufferId, bufferView.byteOffset, bufferView.byteLength);
+	if (!source) {
+		std::lock_guard lock(m_readerMutex);
+		compressed = m_resourceReader->ReadBinaryData<uint8_t>(m_document, bufferView);
+		source = compressed.data();
+	}
+	auto result = DracoDecoder::Decode(source, bufferView.byteLength, requests, id);
+
+	// Draco always decodes faces; a non-indexed primitive gets them under an empty accessor id
+	std::unordered_map<std::string, DracoStream> streams;
+	{
+		auto& indices = streams[primitive.indicesAccessorId];
+		if (!primitive.indicesAccessorId.empty()) indices.accessor = m_document.accessors.Get(primitive.indicesAccessorId);
+		else indices.accessor.type = TYPE_SCALAR;
+		indices.accessor.byteOffset = 0;
+		indices.accessor.count = result.indices.size();
+		indices.accessor.componentType = COMPONENT_UNSIGNED_INT;
+		indices.data.resize(result.indices.size() * sizeof(uint32_t));
+		std::memcpy(indices.data.data(), result.indices.data(), indices.data.size());
+	}
+	for (size_t i = 0; i < accessorIds.size(); i++) {
+		auto& stream = streams[accessorIds[i]];
+		stream.accessor = m_document.accessors.Get(accessorIds[i]);
+		stream.accessor.byteOffset = 0;
+		stream.accessor.count = result.vertexCount;
+		stream.data = std::move(result.attributes[i]);
+	}
+	return streams;
+}
+
+std::vector<size_t> GLTFLocal::GLTFSource::GetCompressedViews(const MeshPrimitive& primitive) const {
+	std::vector<size_t> viewIndices;
+	if (m_compressedViews.empty()) return viewIndices;
+	auto add = [&](const std::string& accessorId) {
+		if (accessorId.empty() || !m_document.accessors.Has(accessorId)) return;
+		auto& bufferViewId = m_document.accessors.Get(accessorId).bufferViewId;
+		if (bufferViewId.empty()) return;
+		size_t viewIndex = m_document.bufferViews.GetIndex(bufferViewId);
+		if (m_compressedViews.count(viewIndex) && std::find(viewIndices.begin(), viewIndices.end(), viewIndex) == viewIndices.end()) {
+			viewIndices.push_back(viewIndex);
+		}
+		};
+	add(primitive.indicesAccessorId);
+	for (auto& attribute : primitive.attributes) add(attribute.second);
+	return viewIndices;
+}
+
+void GLTFLocal::GLTFSource::ReleaseViews(const std::vector<size_t>& viewIndices) const {
+	std::lock_guard lock(m_decodedMutex);
+	for (size_t viewIndex : viewIndices) {
+		auto& pending = m_pendingPrimitives[viewIndex];
+		if (pending > 0) pending--;
+		if (pending == 0) m_decodedViews.erase(viewIndex);
+	}
+}
+
+std::unique_ptr<AssetsCreator::Asset::SubMesh> GLTFLocal::GLTFSource::ReadPrimitive(size_t meshIndex, size_t primitiveIndex) const {
+	auto& primitive = m_document.meshes.Elements()[meshIndex].primitives[primitiveIndex];
+	auto vSubMesh = std::make_unique<AssetsCreator::Asset::SubMesh>();
+	vSubMesh->id = m_meshes[meshIndex].id + "_" + std::to_string(primitiveIndex);
+
+	// exporters that keep KHR_draco_mesh_compression optional also write plain accessors, which are read as they are;
+	// Draco-only primitives are decoded, and throw only when the cooker was built without Draco
+	std::unordered_map<std::string, DracoStream> draco;
+	if (primitive.extensions.count(KHR_DRACO_MESH_COMPRESSION)) {
+		auto hasFallback = [&](const std::string& accessorId) {
+			return !m_document.accessors.Get(accessorId).bufferViewId.empty();
+			};
+		bool fallback = (primitive.indicesAccessorId.empty() || hasFallback(primitive.indicesAccessorId)) && std::all_of(primitive.attributes.begin(), primitive.attributes.end(),
+			[&](auto& attribute) { return hasFallback(attribute.second); });
+		if (!fallback) draco = DecodeDraco(primitive, vSubMesh->id);
+	}
+	auto getAccessor = [&](const std::string& accessorId) -> const Accessor& {
+		auto itt = draco.find(accessorId);
+		return itt != draco.end() ? itt->second.accessor : m_document.accessors.Get(accessorId);
+		};
+	auto getDecoded = [&](const Accessor& accessor) -> const std::vector<uint8_t>* {
+		auto itt = draco.find(accessor.id);
+		return itt != draco.end() ? &itt->second.data : nullptr;
+		};
+
+	// the decoded meshopt views this primitive reads are released once it is converted, or failed
+	struct ViewRelease {
+		const GLTFSource* source;
+		std::vector<size_t> viewIndices;
+		~ViewRelease() { source->ReleaseViews(viewIndices); }
+	} viewRelease{ this, GetCompressedViews(primitive) };
+
+	// every stream is decoded straight into the submesh's own buffer; a plain non-indexed primitive draws its vertices in order
+	if (!primitive.indicesAccessorId.empty() || draco.count(primitive.indicesAccessorId)) {
+		auto& indicesAccessor = getAccessor(primitive.indicesAccessorId);
+		ReadAccessor<uint32_t>(indicesAccessor, vSubMesh->indices.data, getDecoded(indicesAccessor));
+	}
+	else {
+		auto position = primitive.attributes.find(ACCESSOR_POSITION);
+		size_t vertexCount = position != primitive.attributes.end() ? getAccessor(position->second).count : 0;
+		vSubMesh->indices.data.resize(vertexCount * sizeof(uint32_t));
+		auto* indices = reinterpret_cast<uint32_t*>(vSubMesh->indices.data.data());
+		std::iota(indices, indices + vertexCount, 0u);
+	}
+	vSubMesh->indices.format = DXGI_FORMAT_R32_UINT;
+	vSubMesh->indices.strideInBytes = 4;
+
+	vSubMesh->topology = MeshModeToD3DPrimitiveTopology(primitive.mode);
+	if (!primitive.materialId.empty() && m_document.materials.Has(primitive.materialId)) {
+		vSubMesh->materialIndex = static_cast<uint32_t>(m_document.materials.GetIndex(primitive.materialId));
+	}
+
+	// Positions, normals, texcoords and tangents are float whatever the accessor stores (KHR_mesh_quantization sources included).
+	auto readFloatData = [&](const Accessor& accessor, AssetsCreator::Asset::Attribute& vAttribute) {
+		auto attributeFormat = GetAttributeFormat(accessor.type, COMPONENT_FLOAT);
+		vAttribute.format = attributeFormat.dxgiFormat;
+		vAttribute.strideInBytes = attributeFormat.strideInBytes;
+		ReadAccessor<float>(accessor, vAttribute.data, getDecoded(accessor));
+	};
+
+	// Joints, weights and colors keep the accessor's component type (u8/u16, normalized or not) so the input assembler decodes them.
+	// RGB colors get an opaque alpha: there are no 3 x 8/16 bit DXGI formats, and 4 component streams keep every buffer 4 byte aligned.
+	auto readNativeData = [&](const Accessor& accessor, AssetsCreator::Asset::Attribute& vAttribute) {
+		bool expandToVec4 = accessor.type == TYPE_VEC3;
+		auto attributeFormat = GetAttributeFormat(expandToVec4 ? TYPE_VEC4 : accessor.type, accessor.componentType, accessor.normalized);
+		if (attributeFormat.dxgiFormat == DXGI_FORMAT_UNKNOWN) {
+			throw std::runtime_error("Unsupported accessor component type for " + vSubMesh->id);
+		}
+
+		switch (accessor.componentType) {
+		case COMPONENT_UNSIGNED_BYTE:
+			ReadAccessor<uint8_t>(accessor, vAttribute.data, getDecoded(accessor));
+			if (expandToVec4) ExpandToVec4<uint8_t>(vAttribute.data, UINT8_MAX);
+			break;
+		case COMPONENT_UNSIGNED_SHORT:
+			ReadAccessor<uint16_t>(accessor, vAttribute.data, getDecoded(accessor));
+			if (expandToVec4) ExpandToVec4<uint16_t>(vAttribute.data, UINT16_MAX);
+			break;
+		default:
+			attributeFormat = GetAttributeFormat(expandToVec4 ? TYPE_VEC4 : accessor.type, COMPONENT_FLOAT);
+			ReadAccessor<float>(accessor, vAttribute.data, getDecoded(accessor));
+			if (expandToVec4) ExpandToVec4<float>(vAttribute.data, 1.f);
+			break;
+		}
+		vAttribute.format = attributeFormat.dxgiFormat;
+		vAttribute.strideInBytes = attributeFormat.strideInBytes;
+	};
+
+	auto& attributes = primitive.attributes;
+	for (auto& attribute : attributes) {
+		auto vAttribute = std::make_unique<AssetsCreator::Asset::Attribute>();
+
+		auto& accessor = getAccessor(attribute.second);
+
+		if (attribute.first == ACCESSOR_POSITION) {
+			readFloatData(accessor, *vAttribute);
+			Vec3 min, max;
+			computeMinMax(reinterpret_cast<const float*>(vAttribute->data.data()), accessor.count, min, max);
+
+			vAttribute->semanticIndex = 0;
+			vAttribute->semanticName = "POSITION";
+			vAttribute->type = AssetsCreator::Asset::AttributeType::POSITION;
+
+
+			vSubMesh->aabbMin[0] = min.x;
+			vSubMesh->aabbMin[1] = min.y;
+			vSubMesh->aabbMin[2] = min.z;
+
+			vSubMesh->aabbMax[0] = max.x;
+			vSubMesh->aabbMax[1] = max.y;
+			vSubMesh->aabbMax[2] = max.z;
+
+			vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
+		}
+		else if (attribute.first == ACCESSOR_NORMAL) {
+			readFloatData(accessor, *vAttribute);
+			vAttribute->semanticIndex = 0;
+			vAttribute->semanticName = "NORMAL";
+			vAttribute->type = AssetsCreator::Asset::AttributeType::NORMAL;
+			vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
+		}
+		else if (attribute.first == ACCESSOR_TEXCOORD_0) {
+			readFloatData(accessor, *vAttribute);
+			vAttribute->semanticIndex = 0;
+			vAttribute->semanticName = "TEXCOORD";
+			vAttribute->type = AssetsCreator::Asset::AttributeType::TEXCOORD;
+			vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
+		}
+		else if (attribute.first == ACCESSOR_TEXCOORD_1) {
+			readFloatData(accessor, *vAttribute);
+			vAttribute->semanticIndex = 1;
+			vAttribute->semanticName = "TEXCOORD";
+			vAttribute->type = AssetsCreator::Asset::AttributeType::TEXCOORD;
+			vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
+		}
+		else if (attribute.first == ACCESSOR_TANGENT) {
+			readFloatData(accessor, *vAttribute);
+			vAttribute->semanticIndex = 0;
+			vAttribute->semanticName = "TANGENT";
+			vAttribute->type = AssetsCreator::Asset::AttributeType::TANGENT;
+			vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
+		}
+		else if (attribute.first == ACCESSOR_JOINTS_0) {
+			readNativeData(accessor, *vAttribute);
+			vAttribute->semanticIndex = 0;
+			vAttribute->semanticName = "JOINT";
+			vAttribute->type = AssetsCreator::Asset::AttributeType::JOINT;
+			vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
+		}
+		else if (attribute.first == ACCESSOR_WEIGHTS_0) {
+			readNativeData(accessor, *vAttribute);
+			vAttribute->semanticIndex = 0;
+			vAttribute->semanticName = "WEIGHT";
+			vAttribute->type = AssetsCreator::Asset::AttributeType::WEIGHT;
+			vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
+		}
+		else if (attribute.first == ACCESSOR_COLOR_0) {
+			readNativeData(accessor, *vAttribute);
+			vAttribute->semanticIndex = 0;
+			vAttribute->semanticName = "COLOR";
+			vAttribute->type = AssetsCreator::Asset::AttributeType::COLOR;
+			vSubMesh->attributes.emplace(vAttribute->type, std::move(vAttribute));
+		}
+
+	}
+
+	return vSubMesh;
+}
+
+std::vector<std::unique_ptr<AssetsCreator::Asset::Mesh>> GLTFLocal::GetMeshesInfo(const fs::path& path, bool compressIntoOneMesh, AssetsCreator::ThreadPool* pool) {
+	GLTFSource source(path);
+
+	std::vector<std::unique_ptr<AssetsCreator::Asset::Mesh>> vMeshes;
+	std::vector<std::pair<size_t, size_t>> vPrimitives;
+	for (size_t i = 0; i < source.GetMeshes().size(); i++) {
+		auto& meshInfo = source.GetMeshes()[i];
+		auto vMesh = std::make_unique<AssetsCreator::Asset::Mesh>();
+		vMesh->id = meshInfo.id;
+		vMesh->materials = source.GetMaterials();
+		vMesh->submeshes.resize(meshInfo.primitiveCount);
+		for (size_t j = 0; j < meshInfo.primitiveCount; j++) {
+			vPrimitives.emplace_back(i, j);
+		}
 		vMeshes.push_back(std::move(vMesh));
 	}
 
+	auto readPrimitive = [&](size_t primitiveIndex) {
+		auto [meshIndex, submeshIndex] = vPrimitives[primitiveIndex];
+		vMeshes[meshIndex]->submeshes[submeshIndex] = source.ReadPrimitive(meshIndex, submeshIndex);
+	};
+
+	if (pool) {
+		pool->parallelFor(vPrimitives.size(), readPrimitive);
+	}
+	else {
+		for (size_t primitiveIndex = 0; primitiveIndex < vPrimitives.size(); primitiveIndex++) {
+			readPrimitive(primitiveIndex);
+		}
+	}
+
 	if (compressIntoOneMesh) {
 		auto oneMesh = std::make_unique<AssetsCreator::Asset::Mesh>();
 		oneMesh->id = vMeshes[0]->id;
+		oneMesh->materials = source.GetMaterials();
 
 		for (auto& mesh : vMeshes) {
 			for (auto& submesh : mesh->submeshes) {
@@ -3,6 +3,7 @@
 #include <GLTFSDK/GLTFResourceReader.h>
 #include <GLTFSDK/GLBResourceReader.h>
 #include <GLTFSDK/Deserialize.h>
+#include <GLTFSDK/RapidJsonUtils.h>
 #include <variant>
 
 #include <filesystem>
@@ -13,11 +14,23 @@
 #include <cstdlib>
 
 #include <future>
+#include <mutex>
 #include <atomic>
+#include <unordered_map>
+#include <span>
+#include <numeric>
+#include <limits>
+#include <type_traits>
 #include <cstdint>
+#include <cassert>
 #include <cstring>
 
 #include "Structures.h"
+#include "ThreadPool.h"
+#include "SceneBuilder.h"
+#include "MeshoptDecoder.h"
+#include "DracoDecoder.h"
+#include "MappedFile.h"
 
 
 
@@ -34,9 +47,94 @@ namespace GLTFLocal
 
 		std::shared_ptr<std::istream> GetInputStream(const std::string& filename) const override;
 
+		fs::path GetPath(const std::string& filename) const { return m_pathBase / filename; }
+
 	private:
 		fs::path m_pathBase;
 	};
 
-	std::vector<std::unique_ptr<AssetsCreator::Asset::Mesh>> GetMeshesInfo(const fs::path& path, bool compressMesh);
+	// Opens a .gltf/.glb once and reads primitives on demand; only the JSON document stays resident.
+	// A .glb is also mapped: accessors in its BIN chunk are converted from the mapping straight into the submesh buffers,
+	// without the reader lock.
+	// EXT_meshopt_compression views are decoded on first use, outside the reader lock, and kept until the last primitive
+	// referencing them was read. KHR_draco_mesh_compression primitives are read from their uncompressed fallback accessors,
+	// and decoded with DracoDecoder when they have none.
+	class GLTFSource
+	{
+	public:
+		struct MeshInfo {
+			std::string id;
+			size_t primitiveCount;
+		};
+
+		// usage is how the first material that samples the image uses it, DEFAULT for images no material references
+		struct ImageInfo {
+			std::string id;
+			AssetsCreator::Asset::TextureUsage usage;
+		};
+
+		explicit GLTFSource(const fs::path& path);
+
+		const std::vector<MeshInfo>& GetMeshes() const { return m_meshes; }
+		const std::vector<ImageInfo>& GetImages() const { return m_images; }
+		// One per glTF material, in document order; SubMesh::materialIndex indexes it and textures name GetImages() ids.
+		const std::vector<AssetsCreator::Asset::Material>& GetMaterials() const { return m_materials; }
+
+		// Safe to call from several threads: reads share one input stream and are serialized, decoding and conversions run in parallel.
+		std::unique_ptr<AssetsCreator::Asset::SubMesh> ReadPrimitive(size_t meshIndex, size_t primitiveIndex) const;
+
+		// Encoded PNG/JPEG bytes, same locking as ReadPrimitive.
+		std::vector<uint8_t> ReadImage(size_t imageIndex) const;
+
+		// Nodes of the default scene (every node when there is none), parents first; meshIndex indexes GetMeshes().
+		std::vector<AssetsCreator::Asset::SceneNode> ReadNodes() const;
+
+	private:
+		using DecodedView = std::shared_ptr<const std::vector<uint8_t>>;
+
+		// An EXT_meshopt_compression bufferView: where its compressed bytes are and how they decode.
+		struct CompressedView {
+			BufferView source;
+			size_t byteStride;
+			size_t count;
+			AssetsCreator::Asset::MeshoptDecoder::Mode mode;
+			AssetsCreator::Asset::MeshoptDecoder::Filter filter;
+		};
+
+		// A KHR_draco_mesh_compression accessor: its description with the decoded count and the tightly packed elements.
+		struct DracoStream {
+			Accessor accessor;
+			std::vector<uint8_t> data;
+		};
+
+		// Accessor elements as T into output: raw component values for integer T, the glTF normalization rules for float.
+		// decoded replaces the accessor's bufferView with elements a Draco stream decoded.
+		template<typename T>
+		void ReadAccessor(const Accessor& accessor, std::vector<uint8_t>& output, const std::vector<uint8_t>* decoded = nullptr) const;
+		// bytes of a bufferView range in the mapped GLB BIN chunk, nullptr for any other buffer
+		const uint8_t* GetMappedData(const std::string& bufferId, size_t byteOffset, size_t byteLength) const;
+		DecodedView DecodeView(size_t viewIndex) const;
+		// by accessor id, the indices and every attribute the primitive's extension compresses
+		std::unordered_map<std::string, DracoStream> DecodeDraco(const MeshPrimitive& primitive, const std::string& id) const;
+		std::vector<size_t> GetCompressedViews(const MeshPrimitive& primitive) const;
+		void ReleaseViews(const std::vector<size_t>& viewIndices) const;
+
+		std::unique_ptr<GLTFResourceReader> m_resourceReader;
+		Document m_document;
+		std::vector<MeshInfo> m_meshes;
+		std::vector<ImageInfo> m_images;
+		std::vector<AssetsCreator::Asset::Material> m_materials;
+		mutable std::mutex m_readerMutex;
+
+		std::unique_ptr<AssetsCreator::MappedFile> m_glb;
+		std::span<const uint8_t> m_binChunk;
+		std::string m_binBufferId;
+
+		std::unordered_map<size_t, CompressedView> m_compressedViews; // by bufferView index
+		mutable std::mutex m_decodedMutex;
+		mutable std::unordered_map<size_t, std::shared_future<DecodedView>> m_decodedViews;
+		mutable std::unordered_map<size_t, uint32_t> m_pendingPrimitives; // primitives left to read a view, it is dropped at 0
+	};
+
+	std::vector<std::unique_ptr<AssetsCreator::Asset::Mesh>> GetMeshesInfo(const fs::path& path, bool compressMesh, AssetsCreator::ThreadPool* pool = nullptr);
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace AssetsCreator::Hash {
+	// XXH64, used for content hashes of source files and cooked payloads.
+	class XXH64State {
+	public:
+		explicit XXH64State(uint64_t seed = 0) {
+			reset(seed);
+		}
+
+		void reset(uint64_t seed = 0) {
+			m_v[0] = seed + P1 + P2;
+			m_v[1] = seed + P2;
+			m_v[2] = seed;
+			m_v[3] = seed - P1;
+			m_seed = seed;
+			m_totalLength = 0;
+			m_bufferSize = 0;
+		}
+
+		void update(const void* data, size_t size) {
+			auto* p = static_cast<const uint8_t*>(data);
+			auto* end = p + size;
+			m_totalLength += size;
+
+			if (m_bufferSize + size < 32) {
+				if (size) std::memcpy(m_buffer + m_bufferSize, p, size);
+				m_bufferSize += static_cast<uint32_t>(size);
+				return;
+			}
+
+			if (m_bufferSize) {
+				uint32_t fill = 32 - m_bufferSize;
+				std::memcpy(m_buffer + m_bufferSize, p, fill);
+				consumeStripe(m_buffer);
+				p += fill;
+				m_bufferSize = 0;
+			}
+
+			while (p + 32 <= end) {
+				consumeStripe(p);
+				p += 32;
+			}
+
+			if (p < end) {
+				m_bufferSize = static_cast<uint32_t>(end - p);
+				std::memcpy(m_buffer, p, m_bufferSize);
+			}
+		}
+
+		uint64_t digest() const {
+			uint64_t h;
+			if (m_totalLength >= 32) {
+				h = Rotl(m_v[0], 1) + Rotl(m_v[1], 7) + Rotl(m_v[2], 12) + Rotl(m_v[3], 18);
+				h = MergeRound(h, m_v[0]);
+				h = MergeRound(h, m_v[1]);
+				h = MergeRound(h, m_v[2]);
+				h = MergeRound(h, m_v[3]);
+			}
+			else {
+				h = m_seed + P5;
+			}
+			h += m_totalLength;
+
+			const uint8_t* p = m_buffer;
+			const uint8_t* end = m_buffer + m_bufferSize;
+			while (p + 8 <= end) {
+				h ^= Round(0, Read64(p));
+				h = Rotl(h, 27) * P1 + P4;
+				p += 8;
+			}
+			if (p + 4 <= end) {
+				h ^= static_cast<uint64_t>(Read32(p)) * P1;
+				h = Rotl(h, 23) * P2 + P3;
+				p += 4;
+			}
+			while (p < end) {
+				h ^= (*p) * P5;
+				h = Rotl(h, 11) * P1;
+				p++;
+			}
+
+			h ^= h >> 33;
+			h *= P2;
+			h ^= h >> 29;
+			h *= P3;
+			h ^= h >> 32;
+			return h;
+		}
+
+	private:
+		static constexpr uint64_t P1 = 11400714785074694791ULL;
+		static constexpr uint64_t P2 = 14029467366897019727ULL;
+		static constexpr uint64_t P3 = 1609587929392839161ULL;
+		static constexpr uint64_t P4 = 9650029242287828579ULL;
+		static constexpr uint64_t P5 = 2870177450012600261ULL;
+
+		uint64_t m_v[4];
+		uint64_t m_seed;
+		uint64_t m_totalLength;
+		uint8_t m_buffer[32];
+		uint32_t m_bufferSize;
+
+		static inline uint64_t Rotl(uint64_t x, int r) {
+			return (x << r) | (x >> (64 - r));
+		}
+		static inline uint64_t Read64(const uint8_t* p) {
+			uint64_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+		static inline uint32_t Read32(const uint8_t* p) {
+			uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+		static inline uint64_t Round(uint64_t acc, uint64_t input) {
+			acc += input * P2;
+			acc = Rotl(acc, 31);
+			return acc * P1;
+		}
+		static inline uint64_t MergeRound(uint64_t acc, uint64_t val) {
+			acc ^= Round(0, val);
+			return acc * P1 + P4;
+		}
+
+		void consumeStripe(const uint8_t* p) {
+			m_v[0] = Round(m_v[0], Read64(p));
+			m_v[1] = Round(m_v[1], Read64(p + 8));
+			m_v[2] = Round(m_v[2], Read64(p + 16));
+			m_v[3] = Round(m_v[3], Read64(p + 24));
+		}
+	};
+
+	inline uint64_t XXH64(const void* data, size_t size, uint64_t seed = 0) {
+		XXH64State state(seed);
+		state.update(data, size);
+		return state.digest();
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <DirectXTex.h>
+#elif __has_include(<stb_image.h>)
+#define ASSETS_CREATOR_STB_IMAGE
+#include <stb_image.h>
+#endif
+
+namespace AssetsCreator::Asset {
+	// 8 bit RGBA, rows tightly packed.
+	struct Image {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> rgba;
+	};
+
+	// Decodes the PNG/JPEG payloads glTF references: WIC through DirectXTex on Windows, stb_image elsewhere when it is on
+	// the include path. Values are returned as stored, sRGB images are not linearized.
+	class ImageDecoder {
+	public:
+		static constexpr bool IsAvailable() {
+#if defined(_WIN32) || defined(ASSETS_CREATOR_STB_IMAGE)
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		static Image Decode(const std::vector<uint8_t>& encoded, const std::string& id) {
+			Image image;
+#if defined(_WIN32)
+			// WIC needs COM on the calling thread; pool workers initialize it on their first image
+			thread_local HRESULT comInitialized = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+			(void)comInitialized;
+
+			DirectX::ScratchImage loaded;
+			if (FAILED(DirectX::LoadFromWICMemory(encoded.data(), encoded.size(), DirectX::WIC_FLAGS_IGNORE_SRGB | DirectX::WIC_FLAGS_FORCE_RGB, nullptr, loaded))) {
+				throw std::runtime_error("[ImageDecoder] Can't decode " + id);
+			}
+			const DirectX::Image* source = loaded.GetImage(0, 0, 0);
+			bool grayscale = DirectX::BitsPerPixel(source->format) == DirectX::BitsPerColor(source->format);
+
+			DirectX::ScratchImage converted;
+			if (source->format != DXGI_FORMAT_R8G8B8A8_UNORM) {
+				if (FAILED(DirectX::Convert(*source, DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted))) {
+					throw std::runtime_error("[ImageDecoder] Can't convert " + id);
+				}
+				source = converted.GetImage(0, 0, 0);
+			}
+
+			image.width = static_cast<uint32_t>(source->width);
+			image.height = static_cast<uint32_t>(source->height);
+			image.rgba.resize(static_cast<size_t>(image.width) * image.height * 4);
+			for (uint32_t y = 0; y < image.height; y++) {
+				std::memcpy(image.rgba.data() + static_cast<size_t>(y) * image.width * 4, source->pixels + y * source->rowPitch, static_cast<size_t>(image.width) * 4);
+			}
+			// single channel images load as R, spread it like stb_image does
+			if (grayscale) {
+				for (size_t i = 0; i < image.rgba.size(); i += 4) image.rgba[i + 1] = image.rgba[i + 2] = image.rgba[i];
+			}
+#elif defined(ASSETS_CREATOR_STB_IMAGE)
+			int width = 0, height = 0, channels = 0;
+			stbi_uc* pixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &width, &height, &channels, 4);
+			if (!pixels) {
+				throw std::runtime_error("[ImageDecoder] Can't decode " + id + ": " + stbi_failure_reason());
+			}
+			image.width = static_cast<uint32_t>(width);
+			image.height = static_cast<uint32_t>(height);
+			image.rgba.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+			stbi_image_free(pixels);
+#else
+			(void)encoded;
+			throw std::runtime_error("[ImageDecoder] No image decoder in this build for " + id);
+#endif
+			return image;
+		}
+	};
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+namespace AssetsCreator::Asset {
+	// LZ4 block format (no frame): greedy single-probe compressor and a bounds-checked decoder.
+	// Output is interchangeable with LZ4_compress_default / LZ4_decompress_safe.
+	class Lz4 {
+	public:
+		static size_t CompressBound(size_t size) {
+			return size + size / 255 + 16;
+		}
+
+		// Returns the compressed size; dst must hold CompressBound(srcSize) bytes.
+		static size_t Compress(const uint8_t* src, size_t srcSize, uint8_t* dst) {
+			// a lone empty literal run; src may be null then
+			if (srcSize == 0) {
+				*dst = 0;
+				return 1;
+			}
+			uint8_t* out = dst;
+			const uint8_t* anchor = src;
+			const uint8_t* const end = src + srcSize;
+
+			if (srcSize >= MIN_INPUT) {
+				const uint8_t* const matchLimit = end - LAST_LITERALS;
+				const uint8_t* const searchLimit = end - MF_LIMIT;
+				std::vector<uint32_t> table(1u << HASH_BITS, 0);
+				const uint8_t* p = src + 1;
+				table[HashAt(src)] = 0;
+
+				while (p < searchLimit) {
+					uint32_t& slot = table[HashAt(p)];
+					const uint8_t* candidate = src + slot;
+					slot = static_cast<uint32_t>(p - src);
+					if (candidate >= p || p - candidate > MAX_DISTANCE || Read32(candidate) != Read32(p)) {
+						p++;
+						continue;
+					}
+
+					// extend backwards over pending literals, then forwards
+					while (p > anchor && candidate > src && p[-1] == candidate[-1]) {
+						p--;
+						candidate--;
+					}
+					const uint8_t* matchEnd = p + MIN_MATCH;
+					const uint8_t* candidateEnd = candidate + MIN_MATCH;
+					while (matchEnd < matchLimit && *matchEnd == *candidateEnd) {
+						matchEnd++;
+						candidateEnd++;
+					}
+
+					out = WriteSequence(out, anchor, static_cast<size_t>(p - anchor), static_cast<uint16_t>(p - candidate), static_cast<size_t>(matchEnd - p));
+					p = anchor = matchEnd;
+					if (p < searchLimit) table[HashAt(p - 2)] = static_cast<uint32_t>(p - 2 - src);
+				}
+			}
+
+			// last literals
+			size_t literals = static_cast<size_t>(end - anchor);
+			uint8_t* token = out++;
+			*token = static_cast<uint8_t>((literals >= 15 ? 15 : literals) << 4);
+			if (literals >= 15) out = WriteLength(out, literals - 15);
+			std::memcpy(out, anchor, literals);
+			out += literals;
+			return static_cast<size_t>(out - dst);
+		}
+
+		// Returns false on malformed input or when the output would not be exactly dstSize bytes.
+		static bool Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+			const uint8_t* in = src;
+			const uint8_t* const inEnd = src + srcSize;
+			uint8_t* out = dst;
+			uint8_t* const outEnd = dst + dstSize;
+
+			while (in < inEnd) {
+				uint8_t token = *in++;
+				size_t literals = token >> 4;
+				if (literals == 15 && !ReadLength(in, inEnd, literals)) return false;
+				if (literals > static_cast<size_t>(inEnd - in) || literals > static_cast<size_t>(outEnd - out)) return false;
+				if (literals <= SHORT_COPY && static_cast<size_t>(inEnd - in) - literals >= WILD_COPY && static_cast<size_t>(outEnd - out) - literals >= WILD_COPY) {
+					WildCopy(out, in, literals);
+				}
+				else if (literals) {
+					std::memcpy(out, in, literals); // out is null for an empty dst
+				}
+				in += literals;
+				out += literals;
+				if (in == inEnd) break; // the last sequence has no match
+
+				if (inEnd - in < 2) return false;
+				size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+				in += 2;
+				if (offset == 0 || offset > static_cast<size_t>(out - dst)) return false;
+
+				size_t length = token & 15;
+				if (length == 15 && !ReadLength(in, inEnd, length)) return false;
+				length += MIN_MATCH;
+				if (length > static_cast<size_t>(outEnd - out)) return false;
+
+				const uint8_t* match = out - offset;
+				if (length <= SHORT_COPY && offset >= WILD_COPY && static_cast<size_t>(outEnd - out) - length >= WILD_COPY) {
+					WildCopy(out, match, length); // every 16 byte block reads bytes written before it
+				}
+				else if (offset >= length) {
+					std::memcpy(out, match, length);
+				}
+				else {
+					// Overlapping match: the output repeats with period offset, so copy from ever longer multiples of it.
+					size_t copied = offset;
+					std::memcpy(out, match, offset);
+					while (copied < length) {
+						size_t period = copied - copied % offset;
+						size_t count = std::min(period, length - copied);
+						std::memcpy(out + copied, out + copied - period, count);
+						copied += count;
+					}
+				}
+				out += length;
+			}
+			return out == outEnd;
+		}
+
+	private:
+		static constexpr uint32_t HASH_BITS = 16;
+		static constexpr size_t MIN_MATCH = 4;
+		static constexpr size_t LAST_LITERALS = 5; // the format requires the block to end with at least 5 literals
+		static constexpr size_t MF_LIMIT = 12; // and the last match to start at least 12 bytes before the end
+		static constexpr size_t MIN_INPUT = MF_LIMIT + 1;
+		static constexpr std::ptrdiff_t MAX_DISTANCE = 65535;
+		static constexpr size_t WILD_COPY = 16;
+		static constexpr size_t SHORT_COPY = 64; // longer runs go through memcpy
+
+		// Copies in 16 byte blocks, writing up to 15 bytes past count; callers check there is room.
+		static void WildCopy(uint8_t* dst, const uint8_t* src, size_t count) {
+			for (size_t i = 0; i < count; i += WILD_COPY) std::memcpy(dst + i, src + i, WILD_COPY);
+		}
+
+		static uint32_t Read32(const uint8_t* p) {
+			uint32_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		static uint32_t HashAt(const uint8_t* p) {
+			return (Read32(p) * 2654435761u) >> (32 - HASH_BITS);
+		}
+
+		static uint8_t* WriteLength(uint8_t* out, size_t length) {
+			while (length >= 255) {
+				*out++ = 255;
+				length -= 255;
+			}
+			*out++ = static_cast<uint8_t>(length);
+			return out;
+		}
+
+		static bool ReadLength(const uint8_t*& in, const uint8_t* inEnd, size_t& length) {
+			uint8_t byte;
+			do {
+				if (in == inEnd) return false;
+				byte = *in++;
+				length += byte;
+			} while (byte == 255);
+			return true;
+		}
+
+		static uint8_t* WriteSequence(uint8_t* out, const uint8_t* literals, size_t literalCount, uint16_t offset, size_t matchLength) {
+			size_t matchCode = matchLength - MIN_MATCH;
+			uint8_t* token = out++;
+			*token = static_cast<uint8_t>(((literalCount >= 15 ? 15 : literalCount) << 4) | (matchCode >= 15 ? 15 : matchCode));
+			if (literalCount >= 15) out = WriteLength(out, literalCount - 15);
+			std::memcpy(out, literals, literalCount);
+			out += literalCount;
+			*out++ = static_cast<uint8_t>(offset & 0xFF);
+			*out++ = static_cast<uint8_t>(offset >> 8);
+			if (matchCode >= 15) out = WriteLength(out, matchCode - 15);
+			return out;
+		}
+	};
+}
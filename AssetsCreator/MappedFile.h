@@ -0,0 +1,87 @@
+#pragma once
+
+#include <filesystem>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AssetsCreator {
+	// Read-only view of a whole file. Pages are loaded on first touch and shared with the OS file cache, so sources can be
+	// read in place instead of through stream copies; the view is immutable and safe to read from any thread.
+	class MappedFile {
+	public:
+		explicit MappedFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+			m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (m_file == INVALID_HANDLE_VALUE) {
+				throw std::runtime_error("[MappedFile] Can't open " + path.string());
+			}
+			LARGE_INTEGER size{};
+			GetFileSizeEx(m_file, &size);
+			m_size = static_cast<size_t>(size.QuadPart);
+			if (m_size) {
+				m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (m_mapping) m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			}
+#else
+			m_file = open(path.c_str(), O_RDONLY);
+			if (m_file < 0) {
+				throw std::runtime_error("[MappedFile] Can't open " + path.string());
+			}
+			struct stat status {};
+			fstat(m_file, &status);
+			m_size = static_cast<size_t>(status.st_size);
+			if (m_size) {
+				void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+				if (data != MAP_FAILED) m_data = static_cast<const uint8_t*>(data);
+			}
+#endif
+			if (m_size && !m_data) {
+				close();
+				throw std::runtime_error("[MappedFile] Can't map " + path.string());
+			}
+		}
+		~MappedFile() {
+			close();
+		}
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const uint8_t* data() const { return m_data; }
+		size_t size() const { return m_size; }
+
+	private:
+		void close() {
+#if defined(_WIN32)
+			if (m_data) UnmapViewOfFile(m_data);
+			if (m_mapping) CloseHandle(m_mapping);
+			if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+			m_mapping = nullptr;
+			m_file = INVALID_HANDLE_VALUE;
+#else
+			if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+			if (m_file >= 0) ::close(m_file);
+			m_file = -1;
+#endif
+			m_data = nullptr;
+		}
+
+#if defined(_WIN32)
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+#else
+		int m_file = -1;
+#endif
+		const uint8_t* m_data = nullptr;
+		size_t m_size = 0;
+	};
+}
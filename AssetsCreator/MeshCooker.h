@@ -0,0 +1,212 @@
+#pragma once
+
+#include <iostream>
+#include <syncstream>
+#include <iomanip>
+#include <atomic>
+#include <array>
+
+#include "Structures.h"
+#include "CookOptions.h"
+#include "ThreadPool.h"
+#include "AttributeProfile.h"
+#include "SubmeshMerger.h"
+#include "TangentGenerator.h"
+#include "VertexWelder.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+#include "BvhBuilder.h"
+#include "Quantization.h"
+#include "VertexLayout.h"
+
+namespace AssetsCreator::Cook {
+	struct SubmeshCookStatistics {
+		Asset::AttributeProfile::Statistics stripped{};
+		Asset::TangentGenerator::Statistics tangents{};
+		Asset::VertexWelder::Statistics weld{};
+		Asset::MeshOptimizer::OptimizeStatistics optimize{};
+		Asset::Quantization::Error quantization{};
+		bool interleaved = false;
+		bool narrowed = false;
+	};
+
+	// Runs the optional cook stages on one submesh.
+	inline SubmeshCookStatistics CookSubmesh(Asset::SubMesh& submesh, const CookOptions& options) {
+		SubmeshCookStatistics statistics{};
+		// first, no later stage should spend time on streams that are not written
+		statistics.stripped = Asset::AttributeProfile::Get(options.attributeProfile).strip(submesh);
+		// before welding: duplicates of a vertex get the same tangent, and mirror seam copies that end up identical merge again
+		if (options.generateTangents) {
+			statistics.tangents = Asset::TangentGenerator::Generate(submesh);
+		}
+		if (options.weldVertices) {
+			statistics.weld = Asset::VertexWelder::Weld(submesh, options.weldEpsilon);
+		}
+		if (options.optimizeVertexCache) {
+			statistics.optimize = Asset::MeshOptimizer::Optimize(submesh);
+		}
+		if (options.buildMeshlets) {
+			Asset::MeshletBuilder::Build(submesh);
+		}
+		if (options.buildLods) {
+			Asset::MeshSimplifier::BuildLods(submesh);
+		}
+		if (options.buildBvh) {
+			Asset::BvhBuilder::CaptureTriangles(submesh);
+		}
+		if (options.quantizeVertices) {
+			statistics.quantization = Asset::Quantization::QuantizeSubmesh(submesh, Asset::Quantization::ErrorBudget{});
+		}
+		if (options.vertexLayout == Asset::VertexLayout::Policy::SPLIT) {
+			statistics.interleaved = Asset::VertexLayout::Interleave(submesh);
+		}
+		statistics.narrowed = Asset::MeshUtils::NarrowIndices(submesh);
+		return statistics;
+	}
+
+	// Sums the statistics of cooked submeshes for the per mesh log lines; add() only reads what it needs from the submesh,
+	// so streamed submeshes can be released right after.
+	class CookReport {
+	public:
+		// The merger strips the streams before merging, so its drops are reported here instead of per cooked submesh.
+		void addMerge(const Asset::SubmeshMerger::Statistics& statistics) {
+			m_merged = true;
+			m_sourceSubmeshCount += statistics.sourceSubmeshes;
+			m_strippedCount += statistics.strippedSubmeshes;
+			m_droppedStreams += statistics.stripped.droppedStreams;
+			m_droppedBytes += statistics.stripped.droppedBytes;
+		}
+
+		void add(const Asset::SubMesh& submesh, const SubmeshCookStatistics& statistics) {
+			m_submeshCount++;
+			if (statistics.stripped.droppedStreams) m_strippedCount++;
+			m_droppedStreams += statistics.stripped.droppedStreams;
+			m_droppedBytes += statistics.stripped.droppedBytes;
+			if (statistics.tangents.generated) m_tangentCount++;
+			m_tangentSplitVertices += statistics.tangents.splitVertices;
+			m_verticesBefore += statistics.weld.verticesBefore;
+			m_verticesAfter += statistics.weld.verticesAfter;
+
+			m_cacheBefore.misses += statistics.optimize.before.misses;
+			m_cacheBefore.triangleCount += statistics.optimize.before.triangleCount;
+			m_cacheBefore.vertexCount += statistics.optimize.before.vertexCount;
+			m_cacheAfter.misses += statistics.optimize.after.misses;
+			m_cacheAfter.triangleCount += statistics.optimize.after.triangleCount;
+			m_cacheAfter.vertexCount += statistics.optimize.after.vertexCount;
+
+			m_meshletCount += submesh.meshlets.size();
+			for (auto& meshlet : submesh.meshlets) {
+				m_meshletVertexCount += meshlet.vertexCount;
+				m_meshletIndexCount += meshlet.indexCount;
+			}
+
+			m_lodCount = std::max(m_lodCount, submesh.lods.size());
+			for (size_t i = 0; i < submesh.lods.size(); i++) {
+				m_lodTriangles[i] += submesh.lods[i].indexCount / 3;
+				m_lodErrors[i] = std::max(m_lodErrors[i], submesh.lods[i].error);
+			}
+
+			auto& e = statistics.quantization;
+			m_quantization.position = std::max(m_quantization.position, e.position);
+			m_quantization.normalDegrees = std::max(m_quantization.normalDegrees, e.normalDegrees);
+			m_quantization.tangentDegrees = std::max(m_quantization.tangentDegrees, e.tangentDegrees);
+			m_quantization.texcoord = std::max(m_quantization.texcoord, e.texcoord);
+			m_quantization.quantizedAttributes += e.quantizedAttributes;
+			m_quantization.rejectedAttributes += e.rejectedAttributes;
+
+			if (statistics.interleaved) m_interleavedCount++;
+			if (statistics.narrowed) m_narrowedCount++;
+		}
+
+		void print(const std::string& meshId, const CookOptions& options) const {
+			if (m_merged) {
+				std::osyncstream(std::cout) << "[SubmeshMerger] " << meshId << " " << m_sourceSubmeshCount << " -> " << m_submeshCount << " submeshes\n";
+			}
+			if (m_droppedStreams) {
+				std::osyncstream(std::cout) << "[AttributeProfile] " << meshId << " dropped " << m_droppedStreams << " unused streams ("
+					<< m_droppedBytes / 1024 << " KB) in " << m_strippedCount << "/" << (m_merged ? m_sourceSubmeshCount : m_submeshCount) << " submeshes\n";
+			}
+			if (options.generateTangents && m_tangentCount) {
+				std::osyncstream(std::cout) << "[TangentGenerator] " << meshId << " tangents for " << m_tangentCount << "/" << m_submeshCount
+					<< " submeshes, " << m_tangentSplitVertices << " vertices split on mirror seams\n";
+			}
+			if (options.weldVertices) {
+				std::osyncstream(std::cout) << "[VertexWelder] " << meshId << " " << m_verticesBefore << " -> " << m_verticesAfter << " vertices\n";
+			}
+			if (options.optimizeVertexCache) {
+				auto ratio = [](size_t a, size_t b) { return b ? static_cast<float>(a) / b : 0.f; };
+				std::osyncstream(std::cout) << std::fixed << std::setprecision(3)
+					<< "[MeshOptimizer] " << meshId
+					<< " ACMR " << ratio(m_cacheBefore.misses, m_cacheBefore.triangleCount) << " -> " << ratio(m_cacheAfter.misses, m_cacheAfter.triangleCount)
+					<< ", ATVR " << ratio(m_cacheBefore.misses, m_cacheBefore.vertexCount) << " -> " << ratio(m_cacheAfter.misses, m_cacheAfter.vertexCount) << "\n";
+			}
+			if (options.buildMeshlets && m_meshletCount) {
+				std::osyncstream(std::cout) << std::fixed << std::setprecision(1)
+					<< "[MeshletBuilder] " << meshId << " " << m_meshletCount << " meshlets, avg "
+					<< static_cast<float>(m_meshletVertexCount) / m_meshletCount << " vertices, "
+					<< static_cast<float>(m_meshletIndexCount) / 3 / m_meshletCount << " triangles\n";
+			}
+			if (options.buildLods) {
+				std::osyncstream out(std::cout);
+				out << std::setprecision(6) << "[MeshSimplifier] " << meshId << " " << m_lodCount << " LODs:";
+				for (size_t i = 0; i < m_lodCount; i++) {
+					out << " " << m_lodTriangles[i] << " tris (error " << m_lodErrors[i] << ")";
+				}
+				out << "\n";
+			}
+			if (options.quantizeVertices) {
+				std::osyncstream(std::cout) << std::setprecision(6)
+					<< "[Quantization] " << meshId
+					<< " max error: position " << m_quantization.position << " of diagonal, normal " << m_quantization.normalDegrees
+					<< " deg, tangent " << m_quantization.tangentDegrees << " deg, texcoord " << m_quantization.texcoord
+					<< "; " << m_quantization.quantizedAttributes << " attributes quantized, " << m_quantization.rejectedAttributes << " over budget kept as float\n";
+			}
+			if (options.vertexLayout == Asset::VertexLayout::Policy::SPLIT) {
+				std::osyncstream(std::cout) << "[VertexLayout] " << meshId << " split position/surface streams in " << m_interleavedCount << "/" << m_submeshCount << " submeshes\n";
+			}
+			std::osyncstream(std::cout) << "[MeshCooker] " << meshId << " 16 bit indices in " << m_narrowedCount << "/" << m_submeshCount << " submeshes\n";
+		}
+
+	private:
+		// 64 bit sums, a streamed scene can overflow the 32 bit counters of a single submesh
+		struct CacheStatistics {
+			size_t misses = 0;
+			size_t triangleCount = 0;
+			size_t vertexCount = 0;
+		};
+
+		size_t m_submeshCount = 0;
+		bool m_merged = false;
+		size_t m_sourceSubmeshCount = 0; // before merging
+		size_t m_strippedCount = 0, m_droppedStreams = 0, m_droppedBytes = 0;
+		size_t m_tangentCount = 0, m_tangentSplitVertices = 0;
+		size_t m_verticesBefore = 0, m_verticesAfter = 0;
+		CacheStatistics m_cacheBefore, m_cacheAfter;
+		size_t m_meshletCount = 0, m_meshletVertexCount = 0, m_meshletIndexCount = 0;
+		size_t m_lodCount = 0;
+		std::array<size_t, Asset::MeshSimplifier::MAX_LOD_COUNT> m_lodTriangles{};
+		std::array<float, Asset::MeshSimplifier::MAX_LOD_COUNT> m_lodErrors{};
+		Asset::Quantization::Error m_quantization{};
+		size_t m_interleavedCount = 0;
+		size_t m_narrowedCount = 0;
+	};
+
+	// Cooks every submesh of a mesh, submeshes in parallel.
+	inline void CookMesh(Asset::Mesh& mesh, const CookOptions& options, ThreadPool& pool) {
+		CookReport report;
+		if (options.mergeSubmeshes) {
+			report.addMerge(Asset::SubmeshMerger::Merge(mesh, Asset::AttributeProfile::Get(options.attributeProfile)));
+		}
+
+		std::vector<SubmeshCookStatistics> statistics(mesh.submeshes.size());
+		pool.parallelFor(mesh.submeshes.size(), [&](size_t i) {
+			statistics[i] = CookSubmesh(*mesh.submeshes[i], options);
+			});
+
+		for (size_t i = 0; i < mesh.submeshes.size(); i++) {
+			report.add(*mesh.submeshes[i], statistics[i]);
+		}
+		report.print(mesh.id, options);
+	}
+}
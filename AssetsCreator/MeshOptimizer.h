@@ -0,0 +1,229 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "Structures.h"
+#include "MeshUtils.h"
+
+namespace AssetsCreator::Asset {
+	class MeshOptimizer {
+	public:
+		struct VertexCacheStatistics {
+			float acmr = 0.f; // cache misses per triangle, 0.5 is ideal for a regular grid, 3 is the worst case
+			float atvr = 0.f; // cache misses per vertex, 1 is ideal
+			uint32_t misses = 0;
+			uint32_t triangleCount = 0;
+			uint32_t vertexCount = 0;
+		};
+
+		struct OptimizeStatistics {
+			VertexCacheStatistics before;
+			VertexCacheStatistics after;
+		};
+
+		// FIFO post-transform cache simulation.
+		static VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 16) {
+			VertexCacheStatistics result{};
+			std::vector<uint32_t> timestamps(vertexCount, 0);
+			uint32_t time = cacheSize + 1;
+
+			for (auto index : indices) {
+				if (time - timestamps[index] > cacheSize) {
+					timestamps[index] = time++;
+					result.misses++;
+				}
+			}
+
+			result.triangleCount = static_cast<uint32_t>(indices.size() / 3);
+			result.vertexCount = vertexCount;
+			result.acmr = result.triangleCount ? static_cast<float>(result.misses) / result.triangleCount : 0.f;
+			result.atvr = vertexCount ? static_cast<float>(result.misses) / vertexCount : 0.f;
+			return result;
+		}
+
+		// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation" with a 32 entry LRU model.
+		static std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount) {
+			const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+			std::vector<uint32_t> result;
+			result.reserve(triangleCount * 3);
+			if (triangleCount == 0) return result;
+
+			std::vector<uint32_t> activeCount(vertexCount, 0);
+			for (uint32_t i = 0; i < triangleCount * 3; i++) {
+				activeCount[indices[i]]++;
+			}
+
+			std::vector<uint32_t> offsets(vertexCount + 1, 0);
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				offsets[v + 1] = offsets[v] + activeCount[v];
+			}
+			std::vector<uint32_t> adjacency(offsets[vertexCount]);
+			{
+				std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+				for (uint32_t t = 0; t < triangleCount; t++) {
+					for (uint32_t k = 0; k < 3; k++) {
+						adjacency[fill[indices[t * 3 + k]]++] = t;
+					}
+				}
+			}
+
+			std::vector<int32_t> cachePosition(vertexCount, -1);
+			std::vector<float> vertexScore(vertexCount);
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				vertexScore[v] = VertexScore(-1, activeCount[v]);
+			}
+
+			std::vector<float> triangleScore(triangleCount);
+			std::vector<uint8_t> emitted(triangleCount, 0);
+			int64_t best = 0;
+			for (uint32_t t = 0; t < triangleCount; t++) {
+				triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+				if (triangleScore[t] > triangleScore[best]) best = t;
+			}
+
+			std::array<uint32_t, CACHE_SIZE + 3> cache{};
+			std::array<uint32_t, CACHE_SIZE + 3> newCache{};
+			uint32_t cacheCount = 0;
+			uint32_t cursor = 0;
+
+			while (result.size() < triangleCount * 3) {
+				if (best < 0) {
+					while (emitted[cursor]) cursor++;
+					best = cursor;
+				}
+
+				const uint32_t t = static_cast<uint32_t>(best);
+				const uint32_t tri[3] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+				result.insert(result.end(), tri, tri + 3);
+				emitted[t] = 1;
+
+				for (uint32_t k = 0; k < 3; k++) {
+					uint32_t v = tri[k];
+					uint32_t* begin = adjacency.data() + offsets[v];
+					uint32_t* end = begin + activeCount[v];
+					auto* found = std::find(begin, end, t);
+					if (found != end) {
+						std::swap(*found, *(end - 1));
+						activeCount[v]--;
+					}
+				}
+
+				uint32_t newCount = 0;
+				for (uint32_t k = 0; k < 3; k++) {
+					if (std::find(newCache.begin(), newCache.begin() + newCount, tri[k]) == newCache.begin() + newCount) {
+						newCache[newCount++] = tri[k];
+					}
+				}
+				for (uint32_t i = 0; i < cacheCount; i++) {
+					uint32_t v = cache[i];
+					if (v != tri[0] && v != tri[1] && v != tri[2]) {
+						newCache[newCount++] = v;
+					}
+				}
+
+				for (uint32_t i = CACHE_SIZE; i < newCount; i++) {
+					cachePosition[newCache[i]] = -1;
+					updateVertexScore(newCache[i], adjacency, offsets, activeCount, cachePosition, vertexScore, triangleScore);
+				}
+				cacheCount = std::min<uint32_t>(newCount, CACHE_SIZE);
+				for (uint32_t i = 0; i < cacheCount; i++) {
+					cache[i] = newCache[i];
+					cachePosition[cache[i]] = static_cast<int32_t>(i);
+				}
+				for (uint32_t i = 0; i < cacheCount; i++) {
+					updateVertexScore(cache[i], adjacency, offsets, activeCount, cachePosition, vertexScore, triangleScore);
+				}
+
+				best = -1;
+				float bestScore = -std::numeric_limits<float>::max();
+				for (uint32_t i = 0; i < cacheCount; i++) {
+					uint32_t v = cache[i];
+					for (uint32_t a = offsets[v]; a < offsets[v] + activeCount[v]; a++) {
+						uint32_t candidate = adjacency[a];
+						if (triangleScore[candidate] > bestScore) {
+							bestScore = triangleScore[candidate];
+							best = candidate;
+						}
+					}
+				}
+			}
+
+			return result;
+		}
+
+		// Renumbers vertices in first-use order, rewrites indices and drops unreferenced vertices. Returns the new vertex count.
+		static uint32_t OptimizeVertexFetchRemap(std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& remap) {
+			remap.assign(vertexCount, ~0u);
+			uint32_t next = 0;
+			for (auto& index : indices) {
+				if (remap[index] == ~0u) {
+					remap[index] = next++;
+				}
+				index = remap[index];
+			}
+			return next;
+		}
+
+		static OptimizeStatistics Optimize(SubMesh& submesh) {
+			OptimizeStatistics statistics{};
+			if (submesh.topology != D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST) return statistics;
+
+			auto vertexCount = MeshUtils::GetVertexCount(submesh);
+			auto indices = MeshUtils::ReadIndices(submesh.indices);
+			if (vertexCount == 0 || indices.empty()) return statistics;
+
+			// the reorder is greedy and already well ordered input can beat it, the source order is kept then
+			statistics.before = AnalyzeVertexCache(indices, vertexCount);
+			auto optimized = OptimizeVertexCache(indices, vertexCount);
+			if (AnalyzeVertexCache(optimized, vertexCount).misses < statistics.before.misses) {
+				indices = std::move(optimized);
+			}
+
+			std::vector<uint32_t> remap;
+			auto newVertexCount = OptimizeVertexFetchRemap(indices, vertexCount, remap);
+			MeshUtils::RemapVertexStreams(submesh, remap, newVertexCount);
+			MeshUtils::WriteIndices(submesh.indices, indices);
+
+			// ATVR before and after over the same, referenced, vertices; unreferenced ones were just dropped
+			statistics.before.vertexCount = newVertexCount;
+			statistics.before.atvr = newVertexCount ? static_cast<float>(statistics.before.misses) / newVertexCount : 0.f;
+			statistics.after = AnalyzeVertexCache(indices, newVertexCount);
+			return statistics;
+		}
+
+	private:
+		static constexpr uint32_t CACHE_SIZE = 32;
+
+		static float VertexScore(int32_t cachePosition, uint32_t activeTriangles) {
+			if (activeTriangles == 0) return -1.f;
+
+			float score = 0.f;
+			if (cachePosition >= 0) {
+				if (cachePosition < 3) {
+					score = 0.75f;
+				}
+				else {
+					const float scaler = 1.f / (CACHE_SIZE - 3);
+					score = std::pow(1.f - (cachePosition - 3) * scaler, 1.5f);
+				}
+			}
+			score += 2.f / std::sqrt(static_cast<float>(activeTriangles));
+			return score;
+		}
+
+		static void updateVertexScore(uint32_t v, const std::vector<uint32_t>& adjacency,
+			const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& activeCount, const std::vector<int32_t>& cachePosition,
+			std::vector<float>& vertexScore, std::vector<float>& triangleScore) {
+			float score = VertexScore(cachePosition[v], activeCount[v]);
+			float delta = score - vertexScore[v];
+			vertexScore[v] = score;
+			for (uint32_t a = offsets[v]; a < offsets[v] + activeCount[v]; a++) {
+				triangleScore[adjacency[a]] += delta;
+			}
+		}
+	};
+}
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <unordered_map>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "Structures.h"
+#include "MeshUtils.h"
+#include "MeshOptimizer.h"
+
+namespace AssetsCreator::Asset {
+	// Quadric error metric edge collapse (Garland & Heckbert) producing index-only LODs that share the submesh vertex buffer.
+	// Vertices are only collapsed onto existing vertices. Attribute seams and open borders are locked so LODs never crack.
+	class MeshSimplifier {
+	public:
+		static constexpr uint32_t MAX_LOD_COUNT = 5; // including LOD0
+		static constexpr float LOD_TRIANGLE_RATIO = 0.5f; // every LOD targets half the triangles of the previous one
+		static constexpr float MIN_LOD_REDUCTION = 0.9f; // drop a LOD that keeps more than 90% of the previous one
+		static constexpr float MAX_RELATIVE_ERROR = 0.05f; // of the AABB diagonal
+
+		// Appends LOD1..N after LOD0 in the submesh index buffer and fills submesh.lods.
+		static void BuildLods(SubMesh& submesh) {
+			submesh.lods.clear();
+			auto indices = MeshUtils::ReadIndices(submesh.indices);
+			submesh.lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.f });
+
+			if (submesh.topology != D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST || indices.size() < 3) return;
+			auto* position = MeshUtils::FindAttribute(submesh, AttributeType::POSITION);
+			if (!position || position->format != DXGI_FORMAT_R32G32B32_FLOAT) return;
+
+			const uint32_t vertexCount = MeshUtils::GetVertexCount(submesh);
+			float diagonal = 0.f;
+			for (int c = 0; c < 3; c++) diagonal += (submesh.aabbMax[c] - submesh.aabbMin[c]) * (submesh.aabbMax[c] - submesh.aabbMin[c]);
+			diagonal = std::sqrt(diagonal);
+
+			Simplifier simplifier(reinterpret_cast<const float*>(position->data.data()), vertexCount, indices);
+			std::vector<uint32_t> all = indices;
+			uint32_t previousTriangles = static_cast<uint32_t>(indices.size() / 3);
+
+			while (submesh.lods.size() < MAX_LOD_COUNT) {
+				uint32_t target = static_cast<uint32_t>(previousTriangles * LOD_TRIANGLE_RATIO);
+				if (target < 1) break;
+				if (!simplifier.simplify(target, diagonal * MAX_RELATIVE_ERROR)) {
+					// ran out of collapses within the error limit; keep the result only if it is still a worthwhile step
+					if (simplifier.triangleCount() > previousTriangles * MIN_LOD_REDUCTION) break;
+				}
+
+				auto lod = simplifier.getIndices();
+				if (lod.empty()) break;
+				lod = MeshOptimizer::OptimizeVertexCache(lod, vertexCount);
+
+				submesh.lods.push_back({ static_cast<uint32_t>(all.size()), static_cast<uint32_t>(lod.size()), simplifier.error() });
+				all.insert(all.end(), lod.begin(), lod.end());
+				previousTriangles = static_cast<uint32_t>(lod.size() / 3);
+				if (simplifier.exhausted()) break;
+			}
+
+			if (submesh.lods.size() > 1) {
+				MeshUtils::WriteIndices(submesh.indices, all);
+			}
+		}
+
+	private:
+		struct Quadric {
+			// symmetric 4x4: a2 ab ac ad b2 bc bd c2 cd d2, plus the accumulated area weight
+			double m[10] = {};
+			double weight = 0.0;
+
+			static Quadric FromPlane(double a, double b, double c, double d, double w) {
+				Quadric q;
+				q.m[0] = a * a * w; q.m[1] = a * b * w; q.m[2] = a * c * w; q.m[3] = a * d * w;
+				q.m[4] = b * b * w; q.m[5] = b * c * w; q.m[6] = b * d * w;
+				q.m[7] = c * c * w; q.m[8] = c * d * w;
+				q.m[9] = d * d * w;
+				q.weight = w;
+				return q;
+			}
+
+			void add(const Quadric& other) {
+				for (int i = 0; i < 10; i++) m[i] += other.m[i];
+				weight += other.weight;
+			}
+
+			// mean squared distance to the accumulated planes
+			double evaluate(const float* p) const {
+				double x = p[0], y = p[1], z = p[2];
+				double e = m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x
+					+ m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y
+					+ m[7] * z * z + 2 * m[8] * z
+					+ m[9];
+				return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+			}
+		};
+
+		struct Collapse {
+			double cost;
+			uint32_t from;
+			uint32_t to;
+		};
+
+		class Simplifier {
+		public:
+			Simplifier(const float* positions, uint32_t vertexCount, const std::vector<uint32_t>& indices)
+				: m_positions(positions), m_indices(indices), m_triangleCount(static_cast<uint32_t>(indices.size() / 3)) {
+				m_alive.assign(m_triangleCount, 1);
+				m_vertexTriangles.resize(vertexCount);
+				m_locked.assign(vertexCount, 0);
+				m_canonical.resize(vertexCount);
+
+				// Vertices sharing a position are attribute seams: they are locked and share one quadric.
+				std::unordered_map<Key, uint32_t, KeyHash> firstWithPosition;
+				firstWithPosition.reserve(vertexCount);
+				std::vector<uint32_t> positionUsers(vertexCount, 0);
+				for (uint32_t v = 0; v < vertexCount; v++) {
+					Key key;
+					std::memcpy(key.p, positions + static_cast<size_t>(v) * 3, sizeof(key.p));
+					auto [itt, inserted] = firstWithPosition.emplace(key, v);
+					m_canonical[v] = itt->second;
+					positionUsers[itt->second]++;
+				}
+				for (uint32_t v = 0; v < vertexCount; v++) {
+					if (positionUsers[m_canonical[v]] > 1) m_locked[v] = 1;
+				}
+
+				// Open borders (edges with a single triangle, compared by position) are locked as well.
+				std::unordered_map<uint64_t, uint32_t> edgeUse;
+				edgeUse.reserve(indices.size());
+				for (uint32_t t = 0; t < m_triangleCount; t++) {
+					for (uint32_t k = 0; k < 3; k++) {
+						edgeUse[EdgeKey(m_canonical[indices[t * 3 + k]], m_canonical[indices[t * 3 + (k + 1) % 3]])]++;
+					}
+				}
+				std::vector<uint8_t> borderPosition(vertexCount, 0);
+				for (uint32_t t = 0; t < m_triangleCount; t++) {
+					for (uint32_t k = 0; k < 3; k++) {
+						uint32_t a = m_canonical[indices[t * 3 + k]], b = m_canonical[indices[t * 3 + (k + 1) % 3]];
+						if (edgeUse[EdgeKey(a, b)] == 1) {
+							borderPosition[a] = 1;
+							borderPosition[b] = 1;
+						}
+					}
+				}
+				for (uint32_t v = 0; v < vertexCount; v++) {
+					if (borderPosition[m_canonical[v]]) m_locked[v] = 1;
+				}
+
+				m_quadrics.resize(vertexCount);
+				for (uint32_t t = 0; t < m_triangleCount; t++) {
+					const uint32_t* tri = &m_indices[t * 3];
+					for (uint32_t k = 0; k < 3; k++) m_vertexTriangles[tri[k]].push_back(t);
+
+					double n[3];
+					double area = TriangleNormal(p(tri[0]), p(tri[1]), p(tri[2]), n);
+					if (area <= 0.0) continue;
+					const float* a = p(tri[0]);
+					double d = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]);
+					auto plane = Quadric::FromPlane(n[0], n[1], n[2], d, area);
+					for (uint32_t k = 0; k < 3; k++) m_quadrics[m_canonical[tri[k]]].add(plane);
+				}
+
+			}
+
+			// Collapses until the target triangle count; returns false if the error limit stopped it first.
+			// Every pass picks the cheapest edge of each vertex and applies them in cost order, skipping collapses
+			// next to one already made in the same pass, so costs never go stale inside a pass.
+			bool simplify(uint32_t targetTriangles, float maxError) {
+				const double maxCost = static_cast<double>(maxError) * maxError;
+				std::vector<Collapse> candidates;
+				std::vector<uint8_t> touched(m_vertexTriangles.size());
+				std::vector<uint32_t> neighbours;
+
+				while (m_triangleCount > targetTriangles) {
+					candidates.clear();
+					for (uint32_t v = 0; v < m_vertexTriangles.size(); v++) {
+						if (m_locked[v] || m_vertexTriangles[v].empty()) continue;
+						Collapse best{ std::numeric_limits<double>::max(), v, v };
+						for (auto t : m_vertexTriangles[v]) {
+							// neighbour lists are only compacted for collapse targets, a removed triangle is no edge anymore
+							if (!m_alive[t]) continue;
+							for (uint32_t k = 0; k < 3; k++) {
+								uint32_t n = m_indices[t * 3 + k];
+								if (n == v) continue;
+								double cost = collapseCost(v, n);
+								if (cost < best.cost) best = { cost, v, n };
+							}
+						}
+						if (best.to != v && best.cost <= maxCost) candidates.push_back(best);
+					}
+					if (candidates.empty()) {
+						m_exhausted = true;
+						return false;
+					}
+					std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+					std::fill(touched.begin(), touched.end(), 0);
+					uint32_t collapsed = 0;
+					for (auto& collapse : candidates) {
+						if (m_triangleCount <= targetTriangles) break;
+						if (touched[collapse.from] || touched[collapse.to]) continue;
+						if (!canCollapse(collapse.from, collapse.to)) continue;
+
+						neighbours.clear();
+						collectNeighbours(collapse.from, neighbours);
+						apply(collapse.from, collapse.to);
+						m_error = std::max(m_error, static_cast<float>(std::sqrt(collapse.cost)));
+						collapsed++;
+
+						touched[collapse.from] = 1;
+						touched[collapse.to] = 1;
+						for (auto n : neighbours) touched[n] = 1;
+					}
+					if (collapsed == 0) {
+						m_exhausted = true;
+						return false;
+					}
+				}
+				return true;
+			}
+
+			std::vector<uint32_t> getIndices() const {
+				std::vector<uint32_t> result;
+				result.reserve(static_cast<size_t>(m_triangleCount) * 3);
+				for (size_t t = 0; t < m_alive.size(); t++) {
+					if (m_alive[t]) result.insert(result.end(), m_indices.begin() + t * 3, m_indices.begin() + t * 3 + 3);
+				}
+				return result;
+			}
+
+			uint32_t triangleCount() const { return m_triangleCount; }
+			float error() const { return m_error; }
+			bool exhausted() const { return m_exhausted; }
+
+		private:
+			struct Key {
+				float p[3];
+				bool operator==(const Key& other) const { return std::memcmp(p, other.p, sizeof(p)) == 0; }
+			};
+			struct KeyHash {
+				size_t operator()(const Key& key) const {
+					uint32_t h[3];
+					std::memcpy(h, key.p, sizeof(h));
+					return (static_cast<size_t>(h[0]) * 73856093u) ^ (static_cast<size_t>(h[1]) * 19349663u) ^ (static_cast<size_t>(h[2]) * 83492791u);
+				}
+			};
+
+			const float* m_positions;
+			std::vector<uint32_t> m_indices;
+			std::vector<uint8_t> m_alive;
+			std::vector<std::vector<uint32_t>> m_vertexTriangles;
+			std::vector<uint8_t> m_locked;
+			std::vector<uint32_t> m_canonical;
+			std::vector<Quadric> m_quadrics;
+			uint32_t m_triangleCount;
+			float m_error = 0.f;
+			bool m_exhausted = false;
+
+			const float* p(uint32_t v) const { return m_positions + static_cast<size_t>(v) * 3; }
+
+			static uint64_t EdgeKey(uint32_t a, uint32_t b) {
+				if (a > b) std::swap(a, b);
+				return (static_cast<uint64_t>(a) << 32) | b;
+			}
+
+			static double TriangleNormal(const float* a, const float* b, const float* c, double n[3]) {
+				double e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				double e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+				n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+				n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+				n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+				double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if (length == 0.0) return 0.0;
+				for (int k = 0; k < 3; k++) n[k] /= length;
+				return length * 0.5;
+			}
+
+			double collapseCost(uint32_t from, uint32_t to) const {
+				Quadric q = m_quadrics[m_canonical[from]];
+				q.add(m_quadrics[m_canonical[to]]);
+				return q.evaluate(p(to));
+			}
+
+			bool canCollapse(uint32_t from, uint32_t to) {
+				// link condition: an interior edge may share exactly two neighbours, more would pinch the surface
+				std::vector<uint32_t> fromNeighbours, toNeighbours;
+				collectNeighbours(from, fromNeighbours);
+				collectNeighbours(to, toNeighbours);
+				if (std::find(fromNeighbours.begin(), fromNeighbours.end(), to) == fromNeighbours.end()) return false;
+				uint32_t shared = 0;
+				for (auto n : fromNeighbours) {
+					if (std::find(toNeighbours.begin(), toNeighbours.end(), n) != toNeighbours.end()) shared++;
+				}
+				if (shared > 2) return false;
+
+				// reject collapses that flip or nearly flip a triangle
+				for (auto t : m_vertexTriangles[from]) {
+					if (!m_alive[t]) continue;
+					const uint32_t* tri = &m_indices[t * 3];
+					if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+
+					double before[3], after[3];
+					const float* corners[3] = { p(tri[0]), p(tri[1]), p(tri[2]) };
+					if (TriangleNormal(corners[0], corners[1], corners[2], before) == 0.0) continue;
+					for (uint32_t k = 0; k < 3; k++) {
+						if (tri[k] == from) corners[k] = p(to);
+					}
+					if (TriangleNormal(corners[0], corners[1], corners[2], after) == 0.0) return false;
+					if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] < 0.25) return false;
+				}
+				return true;
+			}
+
+			void collectNeighbours(uint32_t v, std::vector<uint32_t>& neighbours) {
+				for (auto t : m_vertexTriangles[v]) {
+					if (!m_alive[t]) continue;
+					for (uint32_t k = 0; k < 3; k++) {
+						uint32_t n = m_indices[t * 3 + k];
+						if (n != v && std::find(neighbours.begin(), neighbours.end(), n) == neighbours.end()) neighbours.push_back(n);
+					}
+				}
+			}
+
+			void apply(uint32_t from, uint32_t to) {
+				for (auto t : m_vertexTriangles[from]) {
+					if (!m_alive[t]) continue;
+					uint32_t* tri = &m_indices[t * 3];
+					if (tri[0] == to || tri[1] == to || tri[2] == to) {
+						m_alive[t] = 0;
+						m_triangleCount--;
+						continue;
+					}
+					for (uint32_t k = 0; k < 3; k++) {
+						if (tri[k] == from) tri[k] = to;
+					}
+					m_vertexTriangles[to].push_back(t);
+				}
+				m_vertexTriangles[from].clear();
+				m_quadrics[m_canonical[to]].add(m_quadrics[m_canonical[from]]);
+
+				auto& triangles = m_vertexTriangles[to];
+				triangles.erase(std::remove_if(triangles.begin(), triangles.end(), [this](uint32_t t) { return !m_alive[t]; }), triangles.end());
+			}
+		};
+	};
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESH_UTILS_SSE2
+#endif
+
+#include "Structures.h"
+
+namespace AssetsCreator::Asset::MeshUtils {
+	inline std::vector<uint32_t> ReadIndices(const Indices& indices) {
+		std::vector<uint32_t> result(indices.data.size() / indices.strideInBytes);
+		if (indices.strideInBytes == 4) {
+			std::memcpy(result.data(), indices.data.data(), indices.data.size());
+		}
+		else if (indices.strideInBytes == 2) {
+			auto* src = reinterpret_cast<const uint16_t*>(indices.data.data());
+			for (size_t i = 0; i < result.size(); i++) {
+				result[i] = src[i];
+			}
+		}
+		else {
+			throw std::runtime_error("[MeshUtils] Unsupported index stride");
+		}
+		return result;
+	}
+
+	inline void WriteIndices(Indices& indices, const std::vector<uint32_t>& values) {
+		indices.format = DXGI_FORMAT_R32_UINT;
+		indices.strideInBytes = 4;
+		indices.data.resize(values.size() * sizeof(uint32_t));
+		std::memcpy(indices.data.data(), values.data(), indices.data.size());
+	}
+
+	// SSE2 has no unsigned 32 -> 16 pack, so values are biased into the signed range, packed with saturation and biased back.
+	// Builds without SSE2 (ARM) take the scalar loop for everything. Every value must already fit in 16 bits.
+	inline void NarrowIndicesToUint16(const uint32_t* src, uint16_t* dst, size_t count) {
+		size_t i = 0;
+#if defined(MESH_UTILS_SSE2)
+		const __m128i bias32 = _mm_set1_epi32(0x8000);
+		const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+		for (; i + 8 <= count; i += 8) {
+			__m128i a = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), bias32);
+			__m128i b = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4)), bias32);
+			__m128i packed = _mm_add_epi16(_mm_packs_epi32(a, b), bias16);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+		}
+#endif
+		for (; i < count; i++) {
+			dst[i] = static_cast<uint16_t>(src[i]);
+		}
+	}
+
+	inline void WriteIndices16(Indices& indices, const std::vector<uint32_t>& values) {
+		indices.format = DXGI_FORMAT_R16_UINT;
+		indices.strideInBytes = 2;
+		indices.data.resize(values.size() * sizeof(uint16_t));
+		NarrowIndicesToUint16(values.data(), reinterpret_cast<uint16_t*>(indices.data.data()), values.size());
+	}
+
+	// Stores indices as R16_UINT when the submesh has fewer than 65536 vertices; 0xFFFF stays free as the strip cut value.
+	// Returns true if the indices are 16 bit afterwards.
+	inline bool NarrowIndices(SubMesh& submesh) {
+		if (submesh.indices.strideInBytes == 2) return true;
+
+		auto values = ReadIndices(submesh.indices);
+		if (std::any_of(values.begin(), values.end(), [](uint32_t index) { return index >= 0xFFFF; })) return false;
+
+		WriteIndices16(submesh.indices, values);
+		return true;
+	}
+
+	inline Attribute* FindAttribute(SubMesh& submesh, AttributeType type, uint32_t semanticIndex = 0) {
+		auto range = submesh.attributes.equal_range(type);
+		for (auto itt = range.first; itt != range.second; ++itt) {
+			if (itt->second->semanticIndex == semanticIndex) return itt->second.get();
+		}
+		return nullptr;
+	}
+
+	inline uint32_t GetVertexCount(const SubMesh& submesh) {
+		auto itt = submesh.attributes.find(AttributeType::POSITION);
+		if (itt == submesh.attributes.end()) return 0;
+		return static_cast<uint32_t>(itt->second->data.size() / itt->second->strideInBytes);
+	}
+
+	// Moves every vertex v of every stream to remap[v]; vertices mapped to ~0u are dropped.
+	inline void RemapVertexStreams(SubMesh& submesh, const std::vector<uint32_t>& remap, uint32_t newVertexCount) {
+		for (auto& [type, attribute] : submesh.attributes) {
+			const size_t stride = attribute->strideInBytes;
+			const size_t vertexCount = attribute->data.size() / stride;
+			std::vector<uint8_t> remapped(newVertexCount * stride);
+			for (size_t v = 0; v < vertexCount && v < remap.size(); v++) {
+				if (remap[v] == ~0u) continue;
+				std::memcpy(remapped.data() + remap[v] * stride, attribute->data.data() + v * stride, stride);
+			}
+			attribute->data = std::move(remapped);
+		}
+	}
+}
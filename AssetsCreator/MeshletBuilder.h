@@ -0,0 +1,213 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "Structures.h"
+#include "MeshUtils.h"
+
+namespace AssetsCreator::Asset {
+	// Splits a triangle list into meshlets of at most MAX_VERTICES unique vertices and MAX_TRIANGLES triangles.
+	// Triangles are regrouped so every meshlet is a contiguous index range; vertices are left untouched.
+	class MeshletBuilder {
+	public:
+		static constexpr uint32_t MAX_VERTICES = 64;
+		static constexpr uint32_t MAX_TRIANGLES = 124;
+
+		static void Build(SubMesh& submesh) {
+			submesh.meshlets.clear();
+			if (submesh.topology != D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST) return;
+
+			auto* position = MeshUtils::FindAttribute(submesh, AttributeType::POSITION);
+			if (!position || position->format != DXGI_FORMAT_R32G32B32_FLOAT) return;
+
+			const uint32_t vertexCount = MeshUtils::GetVertexCount(submesh);
+			auto indices = MeshUtils::ReadIndices(submesh.indices);
+			const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+			if (triangleCount == 0) return;
+
+			auto* positions = reinterpret_cast<const float*>(position->data.data());
+
+			// vertex -> triangles
+			std::vector<uint32_t> offsets(vertexCount + 1, 0);
+			for (auto index : indices) offsets[index + 1]++;
+			for (uint32_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+			std::vector<uint32_t> adjacency(offsets[vertexCount]);
+			{
+				std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+				for (uint32_t t = 0; t < triangleCount; t++) {
+					for (uint32_t k = 0; k < 3; k++) adjacency[fill[indices[t * 3 + k]]++] = t;
+				}
+			}
+
+			std::vector<uint8_t> emitted(triangleCount, 0);
+			std::vector<uint32_t> localIndex(vertexCount, ~0u);
+			std::vector<uint32_t> meshletVertices;
+			std::vector<uint32_t> meshletTriangles;
+			std::vector<uint32_t> reordered;
+			reordered.reserve(indices.size());
+			uint32_t cursor = 0;
+
+			auto newVertices = [&](uint32_t t) {
+				uint32_t count = 0;
+				for (uint32_t k = 0; k < 3; k++) count += localIndex[indices[t * 3 + k]] == ~0u;
+				return count;
+				};
+
+			auto flush = [&]() {
+				if (meshletTriangles.empty()) return;
+				Meshlet meshlet{};
+				meshlet.firstIndex = static_cast<uint32_t>(reordered.size());
+				meshlet.indexCount = static_cast<uint32_t>(meshletTriangles.size() * 3);
+				meshlet.vertexCount = static_cast<uint32_t>(meshletVertices.size());
+				for (auto t : meshletTriangles) {
+					reordered.insert(reordered.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+				}
+				ComputeBounds(meshlet, positions, indices, meshletTriangles, meshletVertices);
+				submesh.meshlets.push_back(meshlet);
+
+				for (auto v : meshletVertices) localIndex[v] = ~0u;
+				meshletVertices.clear();
+				meshletTriangles.clear();
+				};
+
+			for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+				// Prefer the neighbour that adds the fewest vertices, ties go to the earliest (cache optimized) triangle.
+				uint32_t best = ~0u;
+				uint32_t bestScore = ~0u;
+				for (auto v : meshletVertices) {
+					for (uint32_t a = offsets[v]; a < offsets[v + 1]; a++) {
+						uint32_t t = adjacency[a];
+						if (emitted[t]) continue;
+						uint32_t score = newVertices(t);
+						if (score < bestScore || (score == bestScore && t < best)) {
+							best = t;
+							bestScore = score;
+						}
+					}
+				}
+				if (best == ~0u) {
+					while (emitted[cursor]) cursor++;
+					best = cursor;
+					bestScore = newVertices(best);
+				}
+
+				if (meshletVertices.size() + bestScore > MAX_VERTICES || meshletTriangles.size() + 1 > MAX_TRIANGLES) {
+					flush();
+				}
+
+				for (uint32_t k = 0; k < 3; k++) {
+					uint32_t v = indices[best * 3 + k];
+					if (localIndex[v] == ~0u) {
+						localIndex[v] = static_cast<uint32_t>(meshletVertices.size());
+						meshletVertices.push_back(v);
+					}
+				}
+				meshletTriangles.push_back(best);
+				emitted[best] = 1;
+			}
+			flush();
+
+			MeshUtils::WriteIndices(submesh.indices, reordered);
+		}
+
+	private:
+		static void ComputeBounds(Meshlet& meshlet, const float* positions, const std::vector<uint32_t>& indices,
+			const std::vector<uint32_t>& triangles, const std::vector<uint32_t>& vertices) {
+			auto p = [&](uint32_t v) { return positions + static_cast<size_t>(v) * 3; };
+
+			// Ritter's sphere: start from the pair spanning the longest axis, grow until every vertex is inside.
+			uint32_t minV[3], maxV[3];
+			for (int c = 0; c < 3; c++) minV[c] = maxV[c] = vertices[0];
+			for (auto v : vertices) {
+				for (int c = 0; c < 3; c++) {
+					if (p(v)[c] < p(minV[c])[c]) minV[c] = v;
+					if (p(v)[c] > p(maxV[c])[c]) maxV[c] = v;
+				}
+			}
+			int axis = 0;
+			float longest = -1.f;
+			for (int c = 0; c < 3; c++) {
+				float d = Distance2(p(minV[c]), p(maxV[c]));
+				if (d > longest) {
+					longest = d;
+					axis = c;
+				}
+			}
+			float center[3];
+			for (int c = 0; c < 3; c++) center[c] = (p(minV[axis])[c] + p(maxV[axis])[c]) * 0.5f;
+			float radius = std::sqrt(longest) * 0.5f;
+			for (auto v : vertices) {
+				float d = std::sqrt(Distance2(p(v), center));
+				if (d > radius) {
+					float k = (d - radius) * 0.5f / d;
+					for (int c = 0; c < 3; c++) center[c] += (p(v)[c] - center[c]) * k;
+					radius = (radius + d) * 0.5f;
+				}
+			}
+			for (int c = 0; c < 3; c++) meshlet.center[c] = center[c];
+			meshlet.radius = radius;
+
+			// Normal cone: average triangle normal, opening set by the normal farthest from it.
+			std::vector<float> normals(triangles.size() * 3, 0.f);
+			float axisSum[3] = { 0.f, 0.f, 0.f };
+			for (size_t i = 0; i < triangles.size(); i++) {
+				uint32_t t = triangles[i];
+				const float* a = p(indices[t * 3]);
+				const float* b = p(indices[t * 3 + 1]);
+				const float* c = p(indices[t * 3 + 2]);
+				float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				float e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+				float n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+				float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if (length == 0.f) continue;
+				for (int k = 0; k < 3; k++) {
+					normals[i * 3 + k] = n[k] / length;
+					axisSum[k] += n[k] / length;
+				}
+			}
+
+			float axisLength = std::sqrt(axisSum[0] * axisSum[0] + axisSum[1] * axisSum[1] + axisSum[2] * axisSum[2]);
+			meshlet.coneCutoff = 1.f; // never culled
+			for (int c = 0; c < 3; c++) {
+				meshlet.coneApex[c] = center[c];
+				meshlet.coneAxis[c] = 0.f;
+			}
+			if (axisLength == 0.f) return;
+			float coneAxis[3] = { axisSum[0] / axisLength, axisSum[1] / axisLength, axisSum[2] / axisLength };
+
+			float minDot = 1.f;
+			for (size_t i = 0; i < triangles.size(); i++) {
+				const float* n = &normals[i * 3];
+				if (n[0] == 0.f && n[1] == 0.f && n[2] == 0.f) continue;
+				minDot = std::min(minDot, n[0] * coneAxis[0] + n[1] * coneAxis[1] + n[2] * coneAxis[2]);
+			}
+			// Wider than ~84 degrees the cone rejects too little to be worth testing.
+			if (minDot <= 0.1f) return;
+
+			// Move the apex back along the axis until every triangle plane is in front of it.
+			float maxT = 0.f;
+			for (size_t i = 0; i < triangles.size(); i++) {
+				const float* n = &normals[i * 3];
+				if (n[0] == 0.f && n[1] == 0.f && n[2] == 0.f) continue;
+				const float* a = p(indices[triangles[i] * 3]);
+				float dc = (center[0] - a[0]) * n[0] + (center[1] - a[1]) * n[1] + (center[2] - a[2]) * n[2];
+				float dn = coneAxis[0] * n[0] + coneAxis[1] * n[1] + coneAxis[2] * n[2];
+				maxT = std::max(maxT, dc / dn);
+			}
+
+			for (int c = 0; c < 3; c++) {
+				meshlet.coneApex[c] = center[c] - coneAxis[c] * maxT;
+				meshlet.coneAxis[c] = coneAxis[c];
+			}
+			meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+		}
+
+		static float Distance2(const float* a, const float* b) {
+			float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+			return dx * dx + dy * dy + dz * dz;
+		}
+	};
+}
@@ -0,0 +1,365 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace AssetsCreator::Asset {
+	// EXT_meshopt_compression bitstreams: vertex codec version 0, index codec versions 0/1, index sequences and the
+	// OCTAHEDRAL/QUATERNION/EXPONENTIAL filters. Output matches meshopt_decodeVertexBuffer / meshopt_decodeIndexBuffer /
+	// meshopt_decodeIndexSequence followed by meshopt_decode*Filter. Every decoder is bounds-checked and returns false on
+	// malformed input instead of reading past it.
+	class MeshoptDecoder {
+	public:
+		enum class Mode : uint8_t {
+			ATTRIBUTES,
+			TRIANGLES,
+			INDICES,
+		};
+
+		enum class Filter : uint8_t {
+			NONE,
+			OCTAHEDRAL,
+			QUATERNION,
+			EXPONENTIAL,
+		};
+
+		// Decodes count elements of stride bytes into dst (count * stride bytes) and applies the filter.
+		static bool Decode(Mode mode, Filter filter, uint8_t* dst, size_t count, size_t stride, const uint8_t* src, size_t srcSize) {
+			bool decoded = false;
+			switch (mode) {
+			case Mode::ATTRIBUTES: decoded = DecodeVertexBuffer(dst, count, stride, src, srcSize); break;
+			case Mode::TRIANGLES: decoded = DecodeIndexBuffer(dst, count, stride, src, srcSize); break;
+			case Mode::INDICES: decoded = DecodeIndexSequence(dst, count, stride, src, srcSize); break;
+			}
+			return decoded && ApplyFilter(filter, dst, count, stride);
+		}
+
+		static bool DecodeVertexBuffer(uint8_t* dst, size_t vertexCount, size_t vertexSize, const uint8_t* src, size_t srcSize) {
+			if (vertexSize == 0 || vertexSize > 256 || vertexSize % 4 != 0) return false;
+			if (srcSize < 1 + vertexSize) return false;
+			if ((src[0] & 0xf0) != VERTEX_HEADER || (src[0] & 0x0f) > 0) return false;
+
+			const uint8_t* data = src + 1;
+			const uint8_t* const dataEnd = src + srcSize;
+			// the encoder stores the first vertex in the tail; deltas of the first block are taken against it
+			uint8_t lastVertex[256];
+			std::memcpy(lastVertex, dataEnd - vertexSize, vertexSize);
+
+			size_t blockSize = std::min(VERTEX_BLOCK_SIZE_BYTES / vertexSize & ~(BYTE_GROUP_SIZE - 1), VERTEX_BLOCK_MAX_SIZE);
+			for (size_t vertexOffset = 0; vertexOffset < vertexCount; vertexOffset += blockSize) {
+				size_t blockVertices = std::min(blockSize, vertexCount - vertexOffset);
+				data = DecodeVertexBlock(data, dataEnd, dst + vertexOffset * vertexSize, blockVertices, vertexSize, lastVertex);
+				if (!data) return false;
+			}
+			return static_cast<size_t>(dataEnd - data) == std::max(vertexSize, TAIL_MAX_SIZE);
+		}
+
+		// Triangle lists; indexSize is 2 or 4.
+		static bool DecodeIndexBuffer(uint8_t* dst, size_t indexCount, size_t indexSize, const uint8_t* src, size_t srcSize) {
+			if (indexCount % 3 != 0 || (indexSize != 2 && indexSize != 4)) return false;
+			// header, one code byte per triangle and the 16 byte codeaux table
+			if (srcSize < 1 + indexCount / 3 + 16) return false;
+			if ((src[0] & 0xf0) != INDEX_HEADER) return false;
+			int version = src[0] & 0x0f;
+			if (version > 1) return false;
+
+			uint32_t edgeFifo[16][2];
+			uint32_t vertexFifo[16];
+			std::memset(edgeFifo, -1, sizeof(edgeFifo));
+			std::memset(vertexFifo, -1, sizeof(vertexFifo));
+			size_t edgeFifoOffset = 0;
+			size_t vertexFifoOffset = 0;
+			auto pushEdge = [&](uint32_t a, uint32_t b) {
+				edgeFifo[edgeFifoOffset][0] = a;
+				edgeFifo[edgeFifoOffset][1] = b;
+				edgeFifoOffset = (edgeFifoOffset + 1) & 15;
+				};
+			auto pushVertex = [&](uint32_t v, bool condition = true) {
+				vertexFifo[vertexFifoOffset] = v;
+				vertexFifoOffset = (vertexFifoOffset + condition) & 15;
+				};
+
+			uint32_t next = 0;
+			uint32_t last = 0;
+			// version 1 spends fec 13/14 on +-1 deltas of the last free index
+			int fecMax = version >= 1 ? 13 : 15;
+
+			const uint8_t* code = src + 1;
+			const uint8_t* data = code + indexCount / 3;
+			const uint8_t* const dataSafeEnd = src + srcSize - 16;
+			const uint8_t* const codeauxTable = dataSafeEnd;
+
+			for (size_t i = 0; i < indexCount; i += 3) {
+				// a triangle reads at most 16 data bytes (one codeaux and three 5 byte indices), which the table covers
+				if (data > dataSafeEnd) return false;
+				uint8_t codetri = *code++;
+				uint32_t a, b, c;
+
+				if (codetri < 0xf0) {
+					int fe = codetri >> 4;
+					a = edgeFifo[(edgeFifoOffset - 1 - fe) & 15][0];
+					b = edgeFifo[(edgeFifoOffset - 1 - fe) & 15][1];
+					int fec = codetri & 15;
+					if (fec < fecMax) {
+						bool fec0 = fec == 0;
+						c = fec0 ? next : vertexFifo[(vertexFifoOffset - 1 - fec) & 15];
+						next += fec0;
+						pushVertex(c, fec0);
+					}
+					else {
+						// fec - (fec ^ 3) maps 13, 14 to -1, +1
+						last = c = fec != 15 ? last + (fec - (fec ^ 3)) : DecodeIndex(data, last);
+						pushVertex(c);
+					}
+					pushEdge(c, b);
+					pushEdge(a, c);
+				}
+				else {
+					int fea, feb, fec;
+					if (codetri < 0xfe) {
+						// the table never holds feb/fec 15
+						uint8_t codeaux = codeauxTable[codetri & 15];
+						fea = 0;
+						feb = codeaux >> 4;
+						fec = codeaux & 15;
+					}
+					else {
+						uint8_t codeaux = *data++;
+						fea = codetri == 0xfe ? 0 : 15;
+						feb = codeaux >> 4;
+						fec = codeaux & 15;
+						// reset marker
+						if (codeaux == 0) next = 0;
+					}
+
+					// next advances for all three vertices before the free indices are read, as in the encoder
+					a = fea == 0 ? next++ : 0;
+					b = feb == 0 ? next++ : vertexFifo[(vertexFifoOffset - feb) & 15];
+					c = fec == 0 ? next++ : vertexFifo[(vertexFifoOffset - fec) & 15];
+					if (fea == 15) last = a = DecodeIndex(data, last);
+					if (feb == 15) last = b = DecodeIndex(data, last);
+					if (fec == 15) last = c = DecodeIndex(data, last);
+
+					pushVertex(a);
+					pushVertex(b, feb == 0 || feb == 15);
+					pushVertex(c, fec == 0 || fec == 15);
+					pushEdge(b, a);
+					pushEdge(c, b);
+					pushEdge(a, c);
+				}
+				WriteIndex(dst, indexSize, i + 0, a);
+				WriteIndex(dst, indexSize, i + 1, b);
+				WriteIndex(dst, indexSize, i + 2, c);
+			}
+			return data == dataSafeEnd;
+		}
+
+		// Any index list (strips, points, lines); indexSize is 2 or 4.
+		static bool DecodeIndexSequence(uint8_t* dst, size_t indexCount, size_t indexSize, const uint8_t* src, size_t srcSize) {
+			if (indexSize != 2 && indexSize != 4) return false;
+			// header, at least one byte per index and a 4 byte tail
+			if (srcSize < 1 + indexCount + 4) return false;
+			if ((src[0] & 0xf0) != SEQUENCE_HEADER || (src[0] & 0x0f) > 1) return false;
+
+			const uint8_t* data = src + 1;
+			const uint8_t* const dataSafeEnd = src + srcSize - 4;
+			uint32_t last[2] = {};
+			for (size_t i = 0; i < indexCount; i++) {
+				// an index reads at most 5 bytes, the tail covers the overrun
+				if (data >= dataSafeEnd) return false;
+				uint32_t v = DecodeVByte(data);
+				// the low bit selects one of two baselines
+				uint32_t baseline = v & 1;
+				v >>= 1;
+				uint32_t index = last[baseline] + Unzigzag(v);
+				last[baseline] = index;
+				WriteIndex(dst, indexSize, i, index);
+			}
+			return data == dataSafeEnd;
+		}
+
+		static bool ApplyFilter(Filter filter, uint8_t* data, size_t count, size_t stride) {
+			switch (filter) {
+			case Filter::NONE:
+				return true;
+			case Filter::OCTAHEDRAL:
+				if (stride == 4) OctahedralFilter(reinterpret_cast<int8_t*>(data), count);
+				else if (stride == 8) OctahedralFilter(reinterpret_cast<int16_t*>(data), count);
+				else return false;
+				return true;
+			case Filter::QUATERNION:
+				if (stride != 8) return false;
+				QuaternionFilter(reinterpret_cast<int16_t*>(data), count);
+				return true;
+			case Filter::EXPONENTIAL:
+				if (stride % 4 != 0) return false;
+				ExponentialFilter(data, count * stride / 4);
+				return true;
+			}
+			return false;
+		}
+
+	private:
+		static constexpr uint8_t VERTEX_HEADER = 0xa0;
+		static constexpr uint8_t INDEX_HEADER = 0xe0;
+		static constexpr uint8_t SEQUENCE_HEADER = 0xd0;
+		static constexpr size_t VERTEX_BLOCK_SIZE_BYTES = 8192;
+		static constexpr size_t VERTEX_BLOCK_MAX_SIZE = 256;
+		static constexpr size_t BYTE_GROUP_SIZE = 16;
+		static constexpr size_t BYTE_GROUP_DECODE_LIMIT = 24;
+		static constexpr size_t TAIL_MAX_SIZE = 32;
+
+		static uint8_t Unzigzag8(uint8_t v) {
+			return static_cast<uint8_t>(-(v & 1) ^ (v >> 1));
+		}
+
+		static uint32_t Unzigzag(uint32_t v) {
+			return (v >> 1) ^ (0u - (v & 1));
+		}
+
+		static uint32_t DecodeVByte(const uint8_t*& data) {
+			uint8_t lead = *data++;
+			if (lead < 128) return lead;
+			uint32_t result = lead & 127;
+			uint32_t shift = 7;
+			for (int i = 0; i < 4; i++) {
+				uint8_t group = *data++;
+				result |= static_cast<uint32_t>(group & 127) << shift;
+				shift += 7;
+				if (group < 128) break;
+			}
+			return result;
+		}
+
+		static uint32_t DecodeIndex(const uint8_t*& data, uint32_t last) {
+			return last + Unzigzag(DecodeVByte(data));
+		}
+
+		static void WriteIndex(uint8_t* dst, size_t indexSize, size_t i, uint32_t index) {
+			if (indexSize == 2) {
+				uint16_t value = static_cast<uint16_t>(index);
+				std::memcpy(dst + i * 2, &value, 2);
+			}
+			else {
+				std::memcpy(dst + i * 4, &index, 4);
+			}
+		}
+
+		// 16 bytes packed at 0, 2, 4 or 8 bits each; a value of all ones is an escape to a full byte stored after the group.
+		static const uint8_t* DecodeBytesGroup(const uint8_t* data, uint8_t* buffer, int bitsLog2) {
+			if (bitsLog2 == 0) {
+				std::memset(buffer, 0, BYTE_GROUP_SIZE);
+				return data;
+			}
+			if (bitsLog2 == 3) {
+				std::memcpy(buffer, data, BYTE_GROUP_SIZE);
+				return data + BYTE_GROUP_SIZE;
+			}
+			int bits = 1 << bitsLog2;
+			uint8_t escape = static_cast<uint8_t>((1 << bits) - 1);
+			const uint8_t* variable = data + bits * BYTE_GROUP_SIZE / 8;
+			for (size_t i = 0; i < BYTE_GROUP_SIZE; i++) {
+				uint8_t byte = data[i * bits / 8];
+				uint8_t value = static_cast<uint8_t>(byte << (i * bits % 8)) >> (8 - bits);
+				buffer[i] = value == escape ? *variable++ : value;
+			}
+			return variable;
+		}
+
+		static const uint8_t* DecodeBytes(const uint8_t* data, const uint8_t* dataEnd, uint8_t* buffer, size_t bufferSize) {
+			// 2 header bits per group
+			const uint8_t* header = data;
+			size_t headerSize = (bufferSize / BYTE_GROUP_SIZE + 3) / 4;
+			if (static_cast<size_t>(dataEnd - data) < headerSize) return nullptr;
+			data += headerSize;
+
+			for (size_t i = 0; i < bufferSize; i += BYTE_GROUP_SIZE) {
+				// a group reads at most 24 bytes; valid streams always have the tail after the last group
+				if (static_cast<size_t>(dataEnd - data) < BYTE_GROUP_DECODE_LIMIT) return nullptr;
+				size_t group = i / BYTE_GROUP_SIZE;
+				int bitsLog2 = (header[group / 4] >> (group % 4 * 2)) & 3;
+				data = DecodeBytesGroup(data, buffer + i, bitsLog2);
+			}
+			return data;
+		}
+
+		// Byte k of every vertex in the block is one delta stream against the previous vertex.
+		static const uint8_t* DecodeVertexBlock(const uint8_t* data, const uint8_t* dataEnd, uint8_t* vertexData, size_t vertexCount, size_t vertexSize, uint8_t lastVertex[256]) {
+			uint8_t buffer[VERTEX_BLOCK_MAX_SIZE];
+			size_t alignedCount = (vertexCount + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+			for (size_t k = 0; k < vertexSize; k++) {
+				data = DecodeBytes(data, dataEnd, buffer, alignedCount);
+				if (!data) return nullptr;
+				uint8_t p = lastVertex[k];
+				for (size_t i = 0; i < vertexCount; i++) {
+					p = static_cast<uint8_t>(Unzigzag8(buffer[i]) + p);
+					vertexData[i * vertexSize + k] = p;
+				}
+			}
+			std::memcpy(lastVertex, vertexData + (vertexCount - 1) * vertexSize, vertexSize);
+			return data;
+		}
+
+		// x, y in octahedral space and the encoding's 1.0 in z; w is left alone.
+		template<typename T>
+		static void OctahedralFilter(T* data, size_t count) {
+			const float max = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+			for (size_t i = 0; i < count; i++) {
+				float x = static_cast<float>(data[i * 4 + 0]);
+				float y = static_cast<float>(data[i * 4 + 1]);
+				float z = static_cast<float>(data[i * 4 + 2]) - std::fabs(x) - std::fabs(y);
+				// fold the lower hemisphere back
+				float t = z < 0.f ? z : 0.f;
+				x += x >= 0.f ? t : -t;
+				y += y >= 0.f ? t : -t;
+				float scale = max / std::sqrt(x * x + y * y + z * z);
+				data[i * 4 + 0] = static_cast<T>(RoundToInt(x * scale));
+				data[i * 4 + 1] = static_cast<T>(RoundToInt(y * scale));
+				data[i * 4 + 2] = static_cast<T>(RoundToInt(z * scale));
+			}
+		}
+
+		// Three components scaled by the range in the high bits of w; the low two bits of w place the reconstructed component.
+		static void QuaternionFilter(int16_t* data, size_t count) {
+			const float scale = 1.f / std::sqrt(2.f);
+			for (size_t i = 0; i < count; i++) {
+				int16_t* q = data + i * 4;
+				float ss = scale / static_cast<float>(q[3] | 3);
+				float x = static_cast<float>(q[0]) * ss;
+				float y = static_cast<float>(q[1]) * ss;
+				float z = static_cast<float>(q[2]) * ss;
+				float ww = 1.f - x * x - y * y - z * z;
+				float w = std::sqrt(ww >= 0.f ? ww : 0.f);
+
+				int qc = q[3] & 3;
+				q[(qc + 1) & 3] = static_cast<int16_t>(RoundToInt(x * 32767.f));
+				q[(qc + 2) & 3] = static_cast<int16_t>(RoundToInt(y * 32767.f));
+				q[(qc + 3) & 3] = static_cast<int16_t>(RoundToInt(z * 32767.f));
+				q[(qc + 0) & 3] = static_cast<int16_t>(static_cast<int>(w * 32767.f + 0.5f));
+			}
+		}
+
+		// 24 bit signed mantissa and 8 bit signed exponent per 32 bit value, decoded to float.
+		static void ExponentialFilter(uint8_t* data, size_t count) {
+			for (size_t i = 0; i < count; i++) {
+				uint32_t v;
+				std::memcpy(&v, data + i * 4, 4);
+				int32_t mantissa = static_cast<int32_t>(v << 8) >> 8;
+				int32_t exponent = static_cast<int32_t>(v) >> 24;
+				// ldexp(mantissa, exponent) with the power of two built directly
+				uint32_t bits = static_cast<uint32_t>(exponent + 127) << 23;
+				float power;
+				std::memcpy(&power, &bits, 4);
+				float value = power * static_cast<float>(mantissa);
+				std::memcpy(data + i * 4, &value, 4);
+			}
+		}
+
+		static int RoundToInt(float v) {
+			return static_cast<int>(v + (v >= 0.f ? 0.5f : -0.5f));
+		}
+	};
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Structures.h"
+
+namespace AssetsCreator::Asset {
+	namespace fs = std::filesystem;
+
+	// Packs cooked assets into one .pak so the runtime keeps a single file open instead of one per asset.
+	// Files are copied byte for byte, each starting on PAK_ALIGNMENT; the TOC is sorted by id for binary search.
+	class PakWriter {
+	public:
+		// files must live under root, their ids are the paths relative to it.
+		static fs::path Write(const fs::path& pakPath, const fs::path& root, std::vector<fs::path> files) {
+			std::vector<File::PakEntry> entries;
+			entries.reserve(files.size());
+			for (auto& path : files) {
+				auto id = fs::relative(path, root).generic_string();
+				if (id.empty() || id.rfind("..", 0) == 0) {
+					throw std::runtime_error("[PakWriter] " + path.string() + " is outside " + root.string());
+				}
+				if (id.size() >= sizeof(File::PakEntry::id)) {
+					throw std::runtime_error("[PakWriter] Id too long " + id);
+				}
+				File::PakEntry entry = {};
+				std::memcpy(entry.id, id.c_str(), id.size());
+				entry.fileType = ReadFileType(path);
+				entry.sizeInBytes = fs::file_size(path);
+				entries.push_back(entry);
+			}
+
+			// files and entries are sorted together by id
+			std::vector<size_t> order(entries.size());
+			for (size_t i = 0; i < order.size(); i++) order[i] = i;
+			std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return std::strcmp(entries[a].id, entries[b].id) < 0; });
+			for (size_t i = 1; i < order.size(); i++) {
+				if (std::strcmp(entries[order[i - 1]].id, entries[order[i]].id) == 0) {
+					throw std::runtime_error(std::string("[PakWriter] Duplicate id ") + entries[order[i]].id);
+				}
+			}
+			std::vector<File::PakEntry> sortedEntries;
+			std::vector<fs::path> sortedFiles;
+			sortedEntries.reserve(entries.size());
+			sortedFiles.reserve(files.size());
+			for (auto i : order) {
+				sortedEntries.push_back(entries[i]);
+				sortedFiles.push_back(std::move(files[i]));
+			}
+
+			File::PakHeader header = {};
+			header.entryCount = static_cast<uint32_t>(sortedEntries.size());
+			header.tocOffset = sizeof(File::PakHeader);
+			header.dataOffset = Align(header.tocOffset + sortedEntries.size() * sizeof(File::PakEntry));
+			uint64_t offset = header.dataOffset;
+			for (auto& entry : sortedEntries) {
+				entry.offset = offset;
+				offset = Align(offset + entry.sizeInBytes);
+			}
+
+			fs::create_directories(pakPath.parent_path());
+			std::ofstream pak(pakPath, std::ios::binary | std::ios::trunc);
+			if (!pak) {
+				throw std::runtime_error("[PakWriter] Can't create " + pakPath.string());
+			}
+			pak.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			pak.write(reinterpret_cast<const char*>(sortedEntries.data()), sortedEntries.size() * sizeof(File::PakEntry));
+
+			std::vector<char> buffer(1 << 20);
+			for (size_t i = 0; i < sortedEntries.size(); i++) {
+				Pad(pak, sortedEntries[i].offset);
+				std::ifstream file(sortedFiles[i], std::ios::binary);
+				uint64_t copied = 0;
+				while (file) {
+					file.read(buffer.data(), buffer.size());
+					pak.write(buffer.data(), file.gcount());
+					copied += static_cast<uint64_t>(file.gcount());
+				}
+				if (copied != sortedEntries[i].sizeInBytes) {
+					throw std::runtime_error("[PakWriter] Short read of " + sortedFiles[i].string());
+				}
+			}
+			if (!pak) {
+				throw std::runtime_error("[PakWriter] Write failed " + pakPath.string());
+			}
+
+			std::cout << "[PakWriter] " << pakPath.filename().string() << ": " << sortedEntries.size() << " asset(s), "
+				<< static_cast<uint64_t>(pak.tellp()) << " bytes\n";
+			return pakPath;
+		}
+
+	private:
+		static uint64_t Align(uint64_t value) {
+			return (value + File::PAK_ALIGNMENT - 1) & ~(File::PAK_ALIGNMENT - 1);
+		}
+
+		static void Pad(std::ofstream& pak, uint64_t offset) {
+			static const char zeros[File::PAK_ALIGNMENT] = {};
+			auto position = static_cast<uint64_t>(pak.tellp());
+			pak.write(zeros, static_cast<std::streamsize>(offset - position));
+		}
+
+		// Every cooked header starts with magic and file type.
+		static uint32_t ReadFileType(const fs::path& path) {
+			uint32_t magicAndType[2] = {};
+			std::ifstream file(path, std::ios::binary);
+			file.read(reinterpret_cast<char*>(magicAndType), sizeof(magicAndType));
+			if (!file || magicAndType[0] != File::ASSET_MAGIC) {
+				throw std::runtime_error("[PakWriter] Not a cooked asset " + path.string());
+			}
+			return magicAndType[1];
+		}
+	};
+}
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "Structures.h"
+
+namespace AssetsCreator::Asset {
+	// Vertex attribute quantization. The decode helpers mirror gbuffers.hlsl; the cooker round-trips every value through them to measure the error.
+	//   POSITION  R32G32B32_FLOAT    -> R16G16B16A16_UNORM, relative to the submesh AABB
+	//   NORMAL    R32G32B32_FLOAT    -> R16G16_SNORM, octahedral
+	//   TANGENT   R32G32B32A32_FLOAT -> R16G16B16A16_SNORM, octahedral xy + handedness in z
+	//   TEXCOORD  R32G32_FLOAT       -> R16G16_FLOAT
+	class Quantization {
+	public:
+		struct ErrorBudget {
+			float position = 1e-4f; // fraction of the AABB diagonal
+			float normalDegrees = 0.05f;
+			float tangentDegrees = 0.05f;
+			float texcoord = 1.f / 2048.f; // absolute, in uv units
+		};
+
+		struct Error {
+			float position = 0.f; // fraction of the AABB diagonal
+			float normalDegrees = 0.f;
+			float tangentDegrees = 0.f;
+			float texcoord = 0.f;
+			uint32_t quantizedAttributes = 0;
+			uint32_t rejectedAttributes = 0; // over budget, kept as float
+		};
+
+		static int16_t FloatToSnorm16(float v) {
+			return static_cast<int16_t>(std::lround(std::clamp(v, -1.f, 1.f) * 32767.f));
+		}
+
+		static float Snorm16ToFloat(int16_t v) {
+			return std::max(static_cast<float>(v) / 32767.f, -1.f);
+		}
+
+		static uint16_t FloatToUnorm16(float v) {
+			return static_cast<uint16_t>(std::lround(std::clamp(v, 0.f, 1.f) * 65535.f));
+		}
+
+		static float Unorm16ToFloat(uint16_t v) {
+			return static_cast<float>(v) / 65535.f;
+		}
+
+		// IEEE 754 binary16, round to nearest even, overflow to infinity.
+		static uint16_t FloatToHalf(float value) {
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			uint32_t sign = (bits >> 16) & 0x8000u;
+			uint32_t exponent = (bits >> 23) & 0xFFu;
+			uint32_t mantissa = bits & 0x7FFFFFu;
+
+			if (exponent == 0xFFu) return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+
+			int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+			if (halfExponent >= 31) return static_cast<uint16_t>(sign | 0x7C00u);
+			if (halfExponent <= 0) {
+				if (halfExponent < -10) return static_cast<uint16_t>(sign);
+				mantissa |= 0x800000u;
+				uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+				uint32_t half = mantissa >> shift;
+				uint32_t remainder = mantissa & ((1u << shift) - 1u);
+				uint32_t halfway = 1u << (shift - 1);
+				if (remainder > halfway || (remainder == halfway && (half & 1u))) half++;
+				return static_cast<uint16_t>(sign | half);
+			}
+
+			uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+			uint32_t remainder = mantissa & 0x1FFFu;
+			if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) half++; // may carry into the exponent, which is still correct
+			return static_cast<uint16_t>(sign | half);
+		}
+
+		static float HalfToFloat(uint16_t half) {
+			uint32_t sign = (half & 0x8000u) << 16;
+			uint32_t exponent = (half >> 10) & 0x1Fu;
+			uint32_t mantissa = half & 0x3FFu;
+			uint32_t bits;
+
+			if (exponent == 0) {
+				if (mantissa == 0) {
+					bits = sign;
+				}
+				else {
+					exponent = 127 - 15 + 1;
+					while (!(mantissa & 0x400u)) {
+						mantissa <<= 1;
+						exponent--;
+					}
+					bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+				}
+			}
+			else if (exponent == 0x1F) {
+				bits = sign | 0x7F800000u | (mantissa << 13);
+			}
+			else {
+				bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+			}
+
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		static void OctEncode(const float n[3], int16_t out[2]) {
+			float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+			float x = l1 > 0.f ? n[0] / l1 : 0.f;
+			float y = l1 > 0.f ? n[1] / l1 : 0.f;
+			if (n[2] < 0.f) {
+				float fx = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+				float fy = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+				x = fx;
+				y = fy;
+			}
+			out[0] = FloatToSnorm16(x);
+			out[1] = FloatToSnorm16(y);
+		}
+
+		static void OctDecode(const int16_t in[2], float n[3]) {
+			float x = Snorm16ToFloat(in[0]);
+			float y = Snorm16ToFloat(in[1]);
+			float z = 1.f - std::abs(x) - std::abs(y);
+			float t = std::clamp(-z, 0.f, 1.f);
+			x += x >= 0.f ? -t : t;
+			y += y >= 0.f ? -t : t;
+			float length = std::sqrt(x * x + y * y + z * z);
+			n[0] = x / length;
+			n[1] = y / length;
+			n[2] = z / length;
+		}
+
+		// Quantizes the float attributes of a submesh in place. Attributes whose decode error exceeds the budget stay float.
+		static Error QuantizeSubmesh(SubMesh& submesh, const ErrorBudget& budget) {
+			Error error{};
+			for (auto& [type, attribute] : submesh.attributes) {
+				if (attribute->semanticIndex != 0) continue;
+
+				// the quantized stream is built first: its error decides whether it is applied
+				switch (type) {
+				case AttributeType::POSITION:
+					if (attribute->format == DXGI_FORMAT_R32G32B32_FLOAT) {
+						auto quantized = quantizePositions(*attribute, submesh.aabbMin, submesh.aabbMax, error.position);
+						apply(*attribute, std::move(quantized), error.position <= budget.position, error);
+					}
+					break;
+				case AttributeType::NORMAL:
+					if (attribute->format == DXGI_FORMAT_R32G32B32_FLOAT) {
+						auto quantized = quantizeNormals(*attribute, error.normalDegrees);
+						apply(*attribute, std::move(quantized), error.normalDegrees <= budget.normalDegrees, error);
+					}
+					break;
+				case AttributeType::TANGENT:
+					if (attribute->format == DXGI_FORMAT_R32G32B32A32_FLOAT) {
+						auto quantized = quantizeTangents(*attribute, error.tangentDegrees);
+						apply(*attribute, std::move(quantized), error.tangentDegrees <= budget.tangentDegrees, error);
+					}
+					break;
+				case AttributeType::TEXCOORD:
+					if (attribute->format == DXGI_FORMAT_R32G32_FLOAT) {
+						auto quantized = quantizeTexcoords(*attribute, error.texcoord);
+						apply(*attribute, std::move(quantized), error.texcoord <= budget.texcoord, error);
+					}
+					break;
+				default:
+					break;
+				}
+			}
+			return error;
+		}
+
+	private:
+		struct Quantized {
+			DXGI_FORMAT format;
+			uint8_t strideInBytes;
+			std::vector<uint8_t> data;
+		};
+
+		static void apply(Attribute& attribute, Quantized&& quantized, bool withinBudget, Error& error) {
+			if (!withinBudget) {
+				error.rejectedAttributes++;
+				return;
+			}
+			attribute.format = quantized.format;
+			attribute.strideInBytes = quantized.strideInBytes;
+			attribute.data = std::move(quantized.data);
+			error.quantizedAttributes++;
+		}
+
+		static float AngleDegrees(const float a[3], const float b[3]) {
+			float la = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+			float lb = std::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+			if (la == 0.f || lb == 0.f) return 0.f;
+			float c = std::clamp((a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) / (la * lb), -1.f, 1.f);
+			return std::acos(c) * 57.29578f;
+		}
+
+		static Quantized quantizePositions(const Attribute& attribute, const float aabbMin[3], const float aabbMax[3], float& maxError) {
+			const size_t count = attribute.data.size() / attribute.strideInBytes;
+			auto* src = reinterpret_cast<const float*>(attribute.data.data());
+
+			float extent[3];
+			float diagonal = 0.f;
+			for (int c = 0; c < 3; c++) {
+				extent[c] = aabbMax[c] - aabbMin[c];
+				diagonal += extent[c] * extent[c];
+			}
+			diagonal = std::sqrt(diagonal);
+
+			Quantized result{ DXGI_FORMAT_R16G16B16A16_UNORM, 8, std::vector<uint8_t>(count * 8) };
+			auto* dst = reinterpret_cast<uint16_t*>(result.data.data());
+			for (size_t v = 0; v < count; v++) {
+				float distance = 0.f;
+				for (int c = 0; c < 3; c++) {
+					float p = src[v * 3 + c];
+					uint16_t q = FloatToUnorm16(extent[c] > 0.f ? (p - aabbMin[c]) / extent[c] : 0.f);
+					dst[v * 4 + c] = q;
+					float decoded = aabbMin[c] + Unorm16ToFloat(q) * extent[c];
+					distance += (decoded - p) * (decoded - p);
+				}
+				dst[v * 4 + 3] = 0xFFFF;
+				if (diagonal > 0.f) maxError = std::max(maxError, std::sqrt(distance) / diagonal);
+			}
+			return result;
+		}
+
+		static Quantized quantizeNormals(const Attribute& attribute, float& maxError) {
+			const size_t count = attribute.data.size() / attribute.strideInBytes;
+			auto* src = reinterpret_cast<const float*>(attribute.data.data());
+
+			Quantized result{ DXGI_FORMAT_R16G16_SNORM, 4, std::vector<uint8_t>(count * 4) };
+			auto* dst = reinterpret_cast<int16_t*>(result.data.data());
+			for (size_t v = 0; v < count; v++) {
+				float decoded[3];
+				OctEncode(src + v * 3, dst + v * 2);
+				OctDecode(dst + v * 2, decoded);
+				maxError = std::max(maxError, AngleDegrees(src + v * 3, decoded));
+			}
+			return result;
+		}
+
+		static Quantized quantizeTangents(const Attribute& attribute, float& maxError) {
+			const size_t count = attribute.data.size() / attribute.strideInBytes;
+			auto* src = reinterpret_cast<const float*>(attribute.data.data());
+
+			Quantized result{ DXGI_FORMAT_R16G16B16A16_SNORM, 8, std::vector<uint8_t>(count * 8) };
+			auto* dst = reinterpret_cast<int16_t*>(result.data.data());
+			for (size_t v = 0; v < count; v++) {
+				float decoded[3];
+				OctEncode(src + v * 4, dst + v * 4);
+				OctDecode(dst + v * 4, decoded);
+				dst[v * 4 + 2] = src[v * 4 + 3] < 0.f ? -32767 : 32767;
+				dst[v * 4 + 3] = 0;
+				maxError = std::max(maxError, AngleDegrees(src + v * 4, decoded));
+			}
+			return result;
+		}
+
+		static Quantized quantizeTexcoords(const Attribute& attribute, float& maxError) {
+			const size_t count = attribute.data.size() / sizeof(float);
+			auto* src = reinterpret_cast<const float*>(attribute.data.data());
+
+			Quantized result{ DXGI_FORMAT_R16G16_FLOAT, 4, std::vector<uint8_t>(count * 2) };
+			auto* dst = reinterpret_cast<uint16_t*>(result.data.data());
+			for (size_t i = 0; i < count; i++) {
+				dst[i] = FloatToHalf(src[i]);
+				maxError = std::max(maxError, std::abs(HalfToFloat(dst[i]) - src[i]));
+			}
+			return result;
+		}
+	};
+}
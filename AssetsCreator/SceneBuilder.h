@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "Structures.h"
+
+namespace AssetsCreator::Asset {
+	// Flattens a node hierarchy into per mesh instance lists with world transforms, so the runtime can place a whole
+	// prefab without walking the tree. World transforms are decomposed back into TRS; a non-uniform parent scale
+	// under a rotated child shears, which TRS can't express, and is approximated by the column lengths.
+	class SceneBuilder {
+	public:
+		using Matrix = std::array<float, 16>; // column major, like glTF
+
+		// nodes must list parents before their children; their meshIndex refers to meshIds.
+		// Meshes no node draws are left out and meshIndex is remapped to the scene's mesh list.
+		static Scene Build(std::string id, std::vector<SceneNode> nodes, const std::vector<std::string>& meshIds) {
+			Scene scene;
+			scene.id = std::move(id);
+
+			std::vector<SceneMesh> meshes(meshIds.size());
+			for (size_t i = 0; i < meshIds.size(); i++) meshes[i].id = meshIds[i];
+
+			std::vector<Matrix> world(nodes.size());
+			for (uint32_t i = 0; i < nodes.size(); i++) {
+				auto& node = nodes[i];
+				Matrix local = Compose(node.local);
+				if (node.parentIndex == NO_PARENT) {
+					world[i] = local;
+				}
+				else if (node.parentIndex < i) {
+					world[i] = Multiply(world[node.parentIndex], local);
+				}
+				else {
+					throw std::runtime_error("[SceneBuilder] Node " + node.name + " comes before its parent");
+				}
+
+				if (node.meshIndex == NO_MESH) continue;
+				if (node.meshIndex >= meshes.size()) {
+					throw std::runtime_error("[SceneBuilder] Node " + node.name + " references a missing mesh");
+				}
+				meshes[node.meshIndex].instances.push_back({ i, Decompose(world[i]) });
+			}
+
+			std::vector<uint32_t> remap(meshes.size(), NO_MESH);
+			for (size_t i = 0; i < meshes.size(); i++) {
+				if (meshes[i].instances.empty()) continue;
+				remap[i] = static_cast<uint32_t>(scene.meshes.size());
+				scene.meshes.push_back(std::move(meshes[i]));
+			}
+			for (auto& node : nodes) {
+				if (node.meshIndex != NO_MESH) node.meshIndex = remap[node.meshIndex];
+			}
+			scene.nodes = std::move(nodes);
+			return scene;
+		}
+
+		// translation * rotation * scale
+		static Matrix Compose(const Transform& transform) {
+			auto& q = transform.rotation;
+			float xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+			float xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+			float wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+
+			Matrix m = {
+				1.f - 2.f * (yy + zz), 2.f * (xy + wz), 2.f * (xz - wy), 0.f,
+				2.f * (xy - wz), 1.f - 2.f * (xx + zz), 2.f * (yz + wx), 0.f,
+				2.f * (xz + wy), 2.f * (yz - wx), 1.f - 2.f * (xx + yy), 0.f,
+				transform.translation[0], transform.translation[1], transform.translation[2], 1.f,
+			};
+			for (uint32_t column = 0; column < 3; column++) {
+				for (uint32_t row = 0; row < 3; row++) m[column * 4 + row] *= transform.scale[column];
+			}
+			return m;
+		}
+
+		// Assumes an affine matrix; a negative determinant is folded into the x scale.
+		static Transform Decompose(const Matrix& m) {
+			Transform transform;
+			for (uint32_t i = 0; i < 3; i++) transform.translation[i] = m[12 + i];
+
+			const float* c[3] = { &m[0], &m[4], &m[8] };
+			for (uint32_t i = 0; i < 3; i++) {
+				transform.scale[i] = std::sqrt(c[i][0] * c[i][0] + c[i][1] * c[i][1] + c[i][2] * c[i][2]);
+			}
+			float determinant = c[0][0] * (c[1][1] * c[2][2] - c[1][2] * c[2][1])
+				- c[1][0] * (c[0][1] * c[2][2] - c[0][2] * c[2][1])
+				+ c[2][0] * (c[0][1] * c[1][2] - c[0][2] * c[1][1]);
+			if (determinant < 0.f) transform.scale[0] = -transform.scale[0];
+			if (transform.scale[0] == 0.f || transform.scale[1] == 0.f || transform.scale[2] == 0.f) return transform;
+
+			// r(row, column) of the pure rotation
+			auto r = [&](uint32_t row, uint32_t column) { return c[column][row] / transform.scale[column]; };
+			float* q = transform.rotation;
+			float trace = r(0, 0) + r(1, 1) + r(2, 2);
+			if (trace > 0.f) {
+				float s = std::sqrt(trace + 1.f) * 2.f;
+				q[3] = 0.25f * s;
+				q[0] = (r(2, 1) - r(1, 2)) / s;
+				q[1] = (r(0, 2) - r(2, 0)) / s;
+				q[2] = (r(1, 0) - r(0, 1)) / s;
+			}
+			else if (r(0, 0) > r(1, 1) && r(0, 0) > r(2, 2)) {
+				float s = std::sqrt(1.f + r(0, 0) - r(1, 1) - r(2, 2)) * 2.f;
+				q[3] = (r(2, 1) - r(1, 2)) / s;
+				q[0] = 0.25f * s;
+				q[1] = (r(0, 1) + r(1, 0)) / s;
+				q[2] = (r(0, 2) + r(2, 0)) / s;
+			}
+			else if (r(1, 1) > r(2, 2)) {
+				float s = std::sqrt(1.f + r(1, 1) - r(0, 0) - r(2, 2)) * 2.f;
+				q[3] = (r(0, 2) - r(2, 0)) / s;
+				q[0] = (r(0, 1) + r(1, 0)) / s;
+				q[1] = 0.25f * s;
+				q[2] = (r(1, 2) + r(2, 1)) / s;
+			}
+			else {
+				float s = std::sqrt(1.f + r(2, 2) - r(0, 0) - r(1, 1)) * 2.f;
+				q[3] = (r(1, 0) - r(0, 1)) / s;
+				q[0] = (r(0, 2) + r(2, 0)) / s;
+				q[1] = (r(1, 2) + r(2, 1)) / s;
+				q[2] = 0.25f * s;
+			}
+			float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+			for (uint32_t i = 0; i < 4; i++) q[i] /= length;
+			return transform;
+		}
+
+		static Matrix Multiply(const Matrix& a, const Matrix& b) {
+			Matrix result{};
+			for (uint32_t column = 0; column < 4; column++) {
+				for (uint32_t row = 0; row < 4; row++) {
+					float sum = 0.f;
+					for (uint32_t k = 0; k < 4; k++) sum += a[k * 4 + row] * b[column * 4 + k];
+					result[column * 4 + row] = sum;
+				}
+			}
+			return result;
+		}
+	};
+}
@@ -5,6 +5,8 @@
 #include <d3d12.h>
 #include <map>
 #include <string>
+#include <optional>
+#include <cstdio>
 
 namespace AssetsCreator::Asset {
 	enum class AttributeType {
@@ -27,12 +29,44 @@ namespace AssetsCreator::Asset {
 		std::vector<uint8_t> data;
 	};
 
+	// Attributes sharing one vertex stream, elements packed in declaration order.
+	struct InterleavedStream {
+		struct Element {
+			AttributeType type;
+			uint32_t semanticIndex;
+			DXGI_FORMAT format;
+			uint32_t offset; // inside the vertex
+		};
+		std::vector<Element> elements;
+		uint32_t strideInBytes = 0;
+		std::vector<uint8_t> data;
+	};
+
 	struct Indices {
 		DXGI_FORMAT format;
 		uint8_t strideInBytes;
 		std::vector<uint8_t> data;
 	};
 
+	struct Meshlet {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t vertexCount;
+		float center[3];
+		float radius;
+		float coneApex[3];
+		float coneAxis[3];
+		float coneCutoff;
+	};
+
+	struct Lod {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error; // object space distance to LOD0
+	};
+
+	constexpr uint32_t NO_MATERIAL = ~0u;
+
 	struct SubMesh
 	{
 		std::string id;
@@ -41,23 +75,151 @@ namespace AssetsCreator::Asset {
 		float aabbMax[3];
 		Indices indices;
 		D3D_PRIMITIVE_TOPOLOGY topology;
+		std::vector<Meshlet> meshlets; // LOD0 only
+		std::vector<Lod> lods; // LOD0 first, all in one index buffer
+		std::optional<InterleavedStream> interleaved; // built last, its elements are no longer in attributes
+		uint32_t materialIndex = NO_MATERIAL; // into Mesh::materials
+		std::vector<float> bvhTriangles; // LOD0 in float, 9 per triangle; captured before quantization for the mesh BVH
+	};
+
+	// Same values as Engine::Structures::AlphaMode.
+	enum class AlphaMode : uint32_t {
+		ALPHA_OPAQUE,
+		ALPHA_MASK,
+		ALPHA_BLEND,
+	};
+
+	// Texture slots of a material in the order of CPUMaterialCBVData (gbuffers.hlsl): diffuse, emissive, normal,
+	// occlusion in the first uint4, metallic-roughness in the second.
+	enum class MaterialTexture : uint32_t {
+		BASE_COLOR,
+		EMISSIVE,
+		NORMAL,
+		OCCLUSION,
+		METALLIC_ROUGHNESS,
+		COUNT,
+	};
+
+	// glTF metallic-roughness material; an empty texture id leaves the engine default texture in the slot.
+	struct Material {
+		std::string id;
+		float emissiveFactor[4] = { 0.f, 0.f, 0.f, 1.f };
+		float baseColorFactor[4] = { 1.f, 1.f, 1.f, 1.f };
+		float normalScaleOcclusionStrengthMRFactors[4] = { 1.f, 1.f, 1.f, 1.f }; // normal scale, occlusion strength, metallic, roughness
+		std::string textures[static_cast<uint32_t>(MaterialTexture::COUNT)]; // .texture.asset ids
+		AlphaMode alphaMode = AlphaMode::ALPHA_OPAQUE;
+		float alphaCutoff = 0.5f;
+		bool doubleSided = false;
 	};
 
 	struct Mesh {
 		std::string id;
 		std::vector<std::unique_ptr<SubMesh>> submeshes;
+		std::vector<Material> materials; // shared by the submeshes
+	};
+
+	// What a glTF material samples the texture as; same values as Engine::Structures::TextureType.
+	enum class TextureUsage : uint32_t {
+		DEFAULT,
+		BASE_COLOR,
+		NORMAL,
+		OCCLUSION,
+		EMISSIVE,
+		METALLIC_ROUGHNESS,
+	};
+
+	// Block compressed mip, rows of 4x4 blocks rowPitch bytes apart.
+	struct TextureMip {
+		uint32_t width;
+		uint32_t height;
+		uint32_t rowPitch;
+		uint32_t rowCount;
+		std::vector<uint8_t> data;
+	};
+
+	struct Texture {
+		std::string id;
+		TextureUsage usage;
+		DXGI_FORMAT format;
+		std::vector<TextureMip> mips; // largest first
+	};
+
+	constexpr uint32_t NO_PARENT = ~0u;
+	constexpr uint32_t NO_MESH = ~0u;
+
+	// glTF conventions: rotation is an x, y, z, w quaternion, applied as scale, then rotation, then translation.
+	struct Transform {
+		float translation[3] = { 0.f, 0.f, 0.f };
+		float rotation[4] = { 0.f, 0.f, 0.f, 1.f };
+		float scale[3] = { 1.f, 1.f, 1.f };
+	};
+
+	struct SceneNode {
+		std::string name;
+		uint32_t parentIndex = NO_PARENT; // parents come before their children
+		uint32_t meshIndex = NO_MESH; // into Scene::meshes
+		Transform local;
+	};
+
+	struct SceneInstance {
+		uint32_t nodeIndex;
+		Transform world;
+	};
+
+	// Every node drawing the mesh, so a prefab registers each mesh once.
+	struct SceneMesh {
+		std::string id; // <id>.mesh.asset
+		std::vector<SceneInstance> instances;
+	};
+
+	struct Scene {
+		std::string id;
+		std::vector<SceneNode> nodes;
+		std::vector<SceneMesh> meshes;
 	};
 }
 
 namespace AssetsCreator::Asset::File {
 	constexpr uint32_t ASSET_MAGIC = 0x4D404D4; // "MESH"
 	constexpr uint32_t ASSET_MESH = 0x1; // "MESH"
+	constexpr uint32_t ASSET_TEXTURE = 0x2;
+	constexpr uint32_t NO_TEXTURE = ~0u; // MaterialEntry::textureIndices of a slot that keeps the default texture
+	constexpr uint32_t ASSET_SCENE = 0x3;
+	constexpr uint32_t ASSET_PAK = 0x4;
+	constexpr uint64_t PAK_ALIGNMENT = 4096; // every packed asset starts on a page
+
+	// DrawEntry::vertexFormat bits, same values as Engine::Render::Manager::VertexFormatFlags.
+	constexpr uint32_t DRAW_POSITION_UNORM16 = 1 << 0;
+	constexpr uint32_t DRAW_NORMAL_OCT16 = 1 << 1;
+	constexpr uint32_t DRAW_TEXCOORD_HALF = 1 << 2;
+	constexpr uint32_t DRAW_TANGENT_OCT16 = 1 << 3;
+	constexpr uint32_t DRAW_INTERLEAVED = 1 << 4;
+	constexpr uint32_t DRAW_MAX_LOD_COUNT = 5; // MeshSimplifier::MAX_LOD_COUNT
+
+	// Content store payloads are <payloadHash as 16 hex digits>.mesh.asset inside MeshHeader::contentDirectory.
+	inline std::string PayloadId(uint64_t payloadHash) {
+		char id[17];
+		std::snprintf(id, sizeof(id), "%016llx", static_cast<unsigned long long>(payloadHash));
+		return id;
+	}
+
+	enum class CompressionFormat : uint32_t {
+		NONE = 0,
+		GDEFLATE = 1, // DirectStorage GPU decompression
+		LZ4 = 2, // LZ4 block, CPU only
+	};
+
+	enum class Section : uint32_t {
+		ATTRIBUTE = 0,
+		INDEX = 1,
+		SKINNED = 2,
+	};
 
 #pragma pack(push, 1)
 	struct MeshHeader {
 		uint32_t magic = ASSET_MAGIC;
 		uint32_t fileType = ASSET_MESH;
-		uint32_t version = 1;
+		uint32_t version = 10;
 		char id[50];
 
 		uint32_t attributeBufferCount;
@@ -65,7 +227,9 @@ namespace AssetsCreator::Asset::File {
 		uint32_t skinnedBufferCount;
 		uint32_t submeshCount;
 
-		uint32_t reserved[3] = { 0 };
+		uint32_t meshletCount;
+		uint32_t lodCount;
+		uint32_t chunkCount; // 0 - sections are stored raw
 		uint64_t attributeDataOffset;
 		uint64_t indexDataOffset;
 		uint64_t skinnedDataOffset;
@@ -73,8 +237,30 @@ namespace AssetsCreator::Asset::File {
 		uint64_t attributeSizeInBytes; // includes 64kb alignment
 		uint64_t indexSizeInBytes;  // includes 64kb alignment
 		uint64_t skinnedSizeInBytes; // includes 64kb alignment
+
+		CompressionFormat compression;
+		uint32_t chunkSize; // uncompressed bytes per chunk, the last chunk of a section may be shorter
+		uint64_t attributeCompressedSizeInBytes; // bytes the section occupies in the file, equal to attributeSizeInBytes when raw
+		uint64_t indexCompressedSizeInBytes;
+		uint64_t skinnedCompressedSizeInBytes;
+
+		uint32_t materialCount;
+		uint32_t textureReferenceCount;
+		char contentDirectory[50]; // content store of the payloadHash submeshes, relative to this file
+
+		uint32_t bvhNodeCount; // 0 - no BVH
+		uint32_t bvhTriangleCount;
+		uint64_t bvhDataOffset; // optional raw section after the data sections: nodes, then triangles; read on demand
+
+		// XXH64 of the bytes as stored in the file, so a check never has to decompress
+		uint64_t tableChecksum; // every entry table between the header and attributeDataOffset
+		uint64_t attributeChecksum;
+		uint64_t indexChecksum;
+		uint64_t skinnedChecksum;
+		uint64_t bvhChecksum;
 	};
 
+	// Entries of an interleaved stream share fileOffset, sizeInBytes and strideInBytes and differ in elementOffset.
 	struct AttributeBufferEntry {
 		DXGI_FORMAT format;
 		AttributeType type;
@@ -82,6 +268,8 @@ namespace AssetsCreator::Asset::File {
 		uint32_t vertexCount;
 		uint64_t fileOffset; 
 		uint64_t sizeInBytes;
+		uint32_t strideInBytes;
+		uint32_t elementOffset;
 	};
 
 	struct IndexBufferEntry {
@@ -100,6 +288,38 @@ namespace AssetsCreator::Asset::File {
 		uint64_t sizeInBytes;
 	};
 
+	// Contiguous index range of a submesh with its culling bounds.
+	// Backfacing when dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff; a cutoff of 1 never culls.
+	struct MeshletEntry {
+		uint32_t firstIndex; // relative to the submesh index buffer
+		uint32_t indexCount;
+		uint32_t vertexCount;
+		float center[3];
+		float radius;
+		float coneApex[3];
+		float coneAxis[3];
+		float coneCutoff;
+	};
+
+	// Index range of one detail level inside the submesh index buffer, LOD0 first.
+	// error is the object space distance to LOD0; scale it by the instance scale and project it to pick a level.
+	struct LodEntry {
+		uint32_t firstIndex; // relative to the submesh index buffer
+		uint32_t indexCount;
+		float error;
+	};
+
+	// Independently compressed piece of a data section. With compression the buffer entries' fileOffset minus the
+	// section's data offset is the offset inside the decompressed section, not a position in the file.
+	struct ChunkEntry {
+		Section section;
+		CompressionFormat format; // NONE for chunks that did not shrink
+		uint64_t fileOffset;
+		uint64_t uncompressedOffset; // relative to the section start
+		uint32_t compressedSize;
+		uint32_t uncompressedSize;
+	};
+
 	struct SubmeshEntry {
 		char id[50];
 		uint32_t attributeBufferIndex;
@@ -113,8 +333,191 @@ namespace AssetsCreator::Asset::File {
 		float aabbMax[3];
 
 		D3D_PRIMITIVE_TOPOLOGY topology;
-		uint32_t materialID = 0;
-		uint32_t reserved[3] = { 0 };
+		uint32_t materialID = 0; // into the material table
+		uint32_t meshletIndex;
+		uint32_t meshletCount;
+		uint32_t lodIndex;
+		uint32_t lodCount;
+		// 0 - buffers, meshlets and LODs are in this file; otherwise they are in the single submesh payload
+		// <contentDirectory>/<payloadHash as 16 hex digits>.mesh.asset and this entry only has bounds and material.
+		uint64_t payloadHash;
+	};
+
+	// Node of the mesh BVH in depth first order: the left child of an inner node directly follows it, rightChild is the other.
+	// A leaf (triangleCount > 0) covers triangleCount triangles from firstTriangle.
+	struct BvhNodeEntry {
+		float aabbMin[3];
+		uint32_t rightChildOrFirstTriangle;
+		float aabbMax[3];
+		uint32_t triangleCount;
+	};
+
+	// Mesh space triangle as a vertex and two edges, the form the ray test uses.
+	struct BvhTriangleEntry {
+		float v0[3];
+		float edge1[3];
+		float edge2[3];
+		uint32_t submeshIndex;
+		uint32_t triangleIndex; // in the submesh's LOD0
+	};
+
+	// The factors have the layout of Engine::Scene::Asset::TypePBRMaterialData and the start of CPUMaterialCBVData
+	// (gbuffers.hlsl), so the table can be copied into one material buffer as is.
+	struct MaterialEntry {
+		float emissiveFactor[4];
+		float baseColorFactor[4];
+		float normalScaleOcclusionStrengthMRFactors[4];
+		uint32_t textureIndices[static_cast<uint32_t>(MaterialTexture::COUNT)]; // into the texture references or NO_TEXTURE
+		AlphaMode alphaMode;
+		float alphaCutoff;
+		uint32_t doubleSided;
+	};
+
+	// <id>.texture.asset next to the mesh file.
+	struct TextureReferenceEntry {
+		char id[50];
+	};
+
+	// Stream of a DrawEntry in the layout of D3D12_VERTEX_BUFFER_VIEW; offset is relative to the start of the stream's
+	// section (the GPU buffer of that section), sizeInBytes 0 - the submesh has no such stream.
+	struct DrawStreamEntry {
+		uint64_t offset;
+		uint32_t sizeInBytes;
+		uint32_t strideInBytes;
+	};
+
+	enum class DrawStream : uint32_t {
+		POSITION,
+		NORMAL,
+		TEXCOORD,
+		TANGENT,
+		SURFACE, // DRAW_INTERLEAVED: normal/texcoord/tangent in one stream
+		JOINTS, // skinned section
+		WEIGHTS, // skinned section
+		COLOR,
+		COUNT,
+	};
+
+	// Everything the renderer needs to draw a submesh, resolved at cook time so registering a mesh is a copy of this
+	// table plus the section base addresses. One per submesh in submesh order; payloadHash submeshes have no streams
+	// and take the entry of their payload.
+	struct DrawEntry {
+		DrawStreamEntry streams[static_cast<uint32_t>(DrawStream::COUNT)]; // by DrawStream, offsets relative to the stream's section
+		DXGI_FORMAT jointsFormat;
+		DXGI_FORMAT weightsFormat;
+		DXGI_FORMAT colorFormat;
+		// index view in the layout of D3D12_INDEX_BUFFER_VIEW, offset relative to the index section
+		uint64_t indexOffset;
+		uint32_t indexSizeInBytes;
+		DXGI_FORMAT indexFormat;
+		uint32_t indexCount;
+		uint32_t vertexFormat; // DRAW_* bits
+		float aabbMin[3];
+		float aabbMax[3];
+		uint32_t lodCount; // at least 1, LOD0 covers every index when the submesh has no LODs
+		LodEntry lods[DRAW_MAX_LOD_COUNT];
+	};
+
+	struct TextureHeader {
+		uint32_t magic = ASSET_MAGIC;
+		uint32_t fileType = ASSET_TEXTURE;
+		uint32_t version = 2;
+		char id[50];
+
+		TextureUsage usage;
+		DXGI_FORMAT format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipCount;
+		uint64_t dataOffset;
+		uint64_t sizeInBytes; // all mips with their padding
+
+		uint64_t tableChecksum; // XXH64 of the mip table
+		uint64_t dataChecksum; // XXH64 of sizeInBytes from dataOffset
+	};
+
+	// One mip in the D3D12 copyable footprint layout: rows padded to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and every mip
+	// starting at D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, so each mip can be streamed into its subresource on its own.
+	struct TextureMipEntry {
+		uint32_t width;
+		uint32_t height;
+		uint32_t rowPitch;
+		uint32_t rowCount; // rows of 4x4 blocks
+		uint64_t fileOffset;
+		uint64_t sizeInBytes;
+	};
+
+	struct TextureAsset {
+		TextureHeader header;
+		std::vector<TextureMipEntry> mips;
+	};
+
+	struct SceneHeader {
+		uint32_t magic = ASSET_MAGIC;
+		uint32_t fileType = ASSET_SCENE;
+		uint32_t version = 2;
+		char id[50];
+
+		uint32_t nodeCount;
+		uint32_t meshCount;
+		uint32_t instanceCount;
+
+		uint64_t tableChecksum; // XXH64 of the node, mesh and instance tables
+	};
+
+	// Local transform of a glTF node; the hierarchy is kept for tools, the runtime only needs the instances.
+	struct SceneNodeEntry {
+		char name[50];
+		uint32_t parentIndex; // NO_PARENT for roots, parents come first
+		uint32_t meshIndex; // NO_MESH for pure transform nodes
+		float translation[3];
+		float rotation[4];
+		float scale[3];
+	};
+
+	// Mesh referenced by the scene, its instances are contiguous in the instance table.
+	struct SceneMeshEntry {
+		char id[50]; // <id>.mesh.asset next to the scene
+		uint32_t instanceIndex;
+		uint32_t instanceCount;
+	};
+
+	// World transform of a node drawing the mesh, flattened at cook time.
+	struct SceneInstanceEntry {
+		uint32_t nodeIndex;
+		float translation[3];
+		float rotation[4];
+		float scale[3];
+	};
+
+	struct SceneAsset {
+		SceneHeader header;
+		std::vector<SceneNodeEntry> nodes;
+		std::vector<SceneMeshEntry> meshes;
+		std::vector<SceneInstanceEntry> instances;
+	};
+
+	struct MeshBvh {
+		std::vector<BvhNodeEntry> nodes;
+		std::vector<BvhTriangleEntry> triangles;
+	};
+
+	// Many cooked assets in one file. The TOC directly follows the header and is sorted by id (byte wise), so it can be
+	// mapped and binary searched as is; asset offsets are relative to the asset start, add PakEntry::offset.
+	struct PakHeader {
+		uint32_t magic = ASSET_MAGIC;
+		uint32_t fileType = ASSET_PAK;
+		uint32_t version = 1;
+		uint32_t entryCount;
+		uint64_t tocOffset;
+		uint64_t dataOffset;
+	};
+
+	struct PakEntry {
+		char id[128]; // path relative to the cooked output directory with '/' separators, e.g. content/<hash>.mesh.asset
+		uint32_t fileType; // ASSET_MESH, ASSET_TEXTURE or ASSET_SCENE
+		uint64_t offset;
+		uint64_t sizeInBytes;
 	};
 
 	struct MeshAsset {
@@ -123,13 +526,25 @@ namespace AssetsCreator::Asset::File {
 		std::vector<IndexBufferEntry> indexBuffers;
 		std::vector<SkinnedBufferEntry> skinnedBuffers;
 		std::vector<SubmeshEntry> submeshes;
+		std::vector<MeshletEntry> meshlets;
+		std::vector<LodEntry> lods;
+		std::vector<ChunkEntry> chunks;
+		std::vector<MaterialEntry> materials;
+		std::vector<TextureReferenceEntry> textureReferences;
+		std::vector<DrawEntry> draws; // header.submeshCount entries
 		// Move constructor
 		MeshAsset(MeshAsset&& other) noexcept
 			: header(std::move(other.header)),
 			attributeBuffers(std::move(other.attributeBuffers)),
 			indexBuffers(std::move(other.indexBuffers)),
 			skinnedBuffers(std::move(other.skinnedBuffers)),
-			submeshes(std::move(other.submeshes)) {
+			submeshes(std::move(other.submeshes)),
+			meshlets(std::move(other.meshlets)),
+			lods(std::move(other.lods)),
+			chunks(std::move(other.chunks)),
+			materials(std::move(other.materials)),
+			textureReferences(std::move(other.textureReferences)),
+			draws(std::move(other.draws)) {
 		}
 
 		// Move assignment operator
@@ -140,6 +555,12 @@ namespace AssetsCreator::Asset::File {
 				indexBuffers = std::move(other.indexBuffers);
 				skinnedBuffers = std::move(other.skinnedBuffers);
 				submeshes = std::move(other.submeshes);
+				meshlets = std::move(other.meshlets);
+				lods = std::move(other.lods);
+				chunks = std::move(other.chunks);
+				materials = std::move(other.materials);
+				textureReferences = std::move(other.textureReferences);
+				draws = std::move(other.draws);
 			}
 			return *this;
 		}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+
+#include "Structures.h"
+#include "MeshUtils.h"
+#include "AttributeProfile.h"
+
+namespace AssetsCreator::Asset {
+	// Concatenates triangle list submeshes that share a material and the same vertex streams into one submesh, so the
+	// engine issues one draw per material instead of one per glTF primitive. Vertex streams are appended, indices rebased
+	// onto the appended vertices and the AABBs merged. A group is closed before it would pass 65535 vertices, so merged
+	// submeshes still narrow to 16 bit indices. Runs before the cook stages, which then see one submesh per group.
+	//
+	// Submeshes are fed one at a time and only the open group of every material is held, so the streaming cook can merge too.
+	// Streams the attribute profile drops are stripped on add(); otherwise an unused TEXCOORD_1 on one primitive would
+	// keep it apart from the rest of its material.
+	class SubmeshMerger {
+	public:
+		static constexpr uint32_t MAX_GROUP_VERTICES = 0xFFFF; // 0xFFFF itself stays free as the strip cut value
+
+		struct Statistics {
+			uint32_t sourceSubmeshes = 0;
+			uint32_t mergedSubmeshes = 0;
+			AttributeProfile::Statistics stripped{};
+			uint32_t strippedSubmeshes = 0;
+		};
+
+		explicit SubmeshMerger(const AttributeProfile& profile) : m_profile(profile) {}
+
+		// Returns a finished submesh if one is ready: the input itself when it can't be merged, or a group the input closed.
+		std::unique_ptr<SubMesh> add(std::unique_ptr<SubMesh> submesh) {
+			m_statistics.sourceSubmeshes++;
+			auto stripped = m_profile.strip(*submesh);
+			if (stripped.droppedStreams) m_statistics.strippedSubmeshes++;
+			m_statistics.stripped.droppedStreams += stripped.droppedStreams;
+			m_statistics.stripped.droppedBytes += stripped.droppedBytes;
+
+			const uint32_t vertexCount = MeshUtils::GetVertexCount(*submesh);
+			if (!IsMergeable(*submesh, vertexCount)) return emit(std::move(submesh));
+
+			auto group = std::find_if(m_groups.begin(), m_groups.end(), [&](const Group& group) { return IsCompatible(*group.submesh, *submesh); });
+			if (group == m_groups.end()) {
+				m_groups.push_back({ std::move(submesh), vertexCount });
+				return nullptr;
+			}
+			if (group->vertexCount + vertexCount > MAX_GROUP_VERTICES) {
+				auto closed = std::move(group->submesh);
+				*group = { std::move(submesh), vertexCount };
+				return emit(std::move(closed));
+			}
+			Append(*group->submesh, group->vertexCount, *submesh);
+			group->vertexCount += vertexCount;
+			return nullptr;
+		}
+
+		// The groups still open, in the order they were started.
+		std::vector<std::unique_ptr<SubMesh>> finish() {
+			std::vector<std::unique_ptr<SubMesh>> result;
+			for (auto& group : m_groups) {
+				result.push_back(emit(std::move(group.submesh)));
+			}
+			m_groups.clear();
+			return result;
+		}
+
+		const Statistics& getStatistics() const { return m_statistics; }
+
+		// In-memory variant; the submesh order matches what add()/finish() produce for the streaming cook.
+		static Statistics Merge(Mesh& mesh, const AttributeProfile& profile) {
+			SubmeshMerger merger(profile);
+			std::vector<std::unique_ptr<SubMesh>> merged;
+			for (auto& submesh : mesh.submeshes) {
+				if (auto ready = merger.add(std::move(submesh))) merged.push_back(std::move(ready));
+			}
+			for (auto& submesh : merger.finish()) {
+				merged.push_back(std::move(submesh));
+			}
+			mesh.submeshes = std::move(merged);
+			return merger.getStatistics();
+		}
+
+	private:
+		struct Group {
+			std::unique_ptr<SubMesh> submesh;
+			uint32_t vertexCount;
+		};
+
+		std::unique_ptr<SubMesh> emit(std::unique_ptr<SubMesh> submesh) {
+			m_statistics.mergedSubmeshes++;
+			return submesh;
+		}
+
+		static bool IsMergeable(const SubMesh& submesh, uint32_t vertexCount) {
+			if (submesh.topology != D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST) return false;
+			if (vertexCount == 0 || vertexCount > MAX_GROUP_VERTICES || submesh.indices.data.empty()) return false;
+			if (submesh.interleaved || !submesh.meshlets.empty() || !submesh.lods.empty()) return false;
+			return std::all_of(submesh.attributes.begin(), submesh.attributes.end(), [&](auto& entry) {
+				return entry.second->data.size() == static_cast<size_t>(vertexCount) * entry.second->strideInBytes;
+				});
+		}
+
+		// Same material and the same streams in the same formats; the multimap keeps both in the same order.
+		static bool IsCompatible(const SubMesh& a, const SubMesh& b) {
+			if (a.materialIndex != b.materialIndex || a.attributes.size() != b.attributes.size()) return false;
+			return std::equal(a.attributes.begin(), a.attributes.end(), b.attributes.begin(), [](auto& x, auto& y) {
+				return x.second->type == y.second->type && x.second->semanticIndex == y.second->semanticIndex
+					&& x.second->format == y.second->format && x.second->strideInBytes == y.second->strideInBytes;
+				});
+		}
+
+		static void Append(SubMesh& target, uint32_t baseVertex, const SubMesh& source) {
+			auto s = source.attributes.begin();
+			for (auto t = target.attributes.begin(); t != target.attributes.end(); ++t, ++s) {
+				auto& data = t->second->data;
+				data.insert(data.end(), s->second->data.begin(), s->second->data.end());
+			}
+
+			// the group keeps 32 bit indices until NarrowIndices, so every append only touches the new ones
+			if (target.indices.strideInBytes != 4) {
+				MeshUtils::WriteIndices(target.indices, MeshUtils::ReadIndices(target.indices));
+			}
+			auto appended = MeshUtils::ReadIndices(source.indices);
+			for (auto& index : appended) {
+				index += baseVertex;
+			}
+			auto& data = target.indices.data;
+			size_t offset = data.size();
+			data.resize(offset + appended.size() * sizeof(uint32_t));
+			std::memcpy(data.data() + offset, appended.data(), appended.size() * sizeof(uint32_t));
+
+			for (int i = 0; i < 3; i++) {
+				target.aabbMin[i] = std::min(target.aabbMin[i], source.aabbMin[i]);
+				target.aabbMax[i] = std::max(target.aabbMax[i], source.aabbMax[i]);
+			}
+		}
+
+		const AttributeProfile& m_profile;
+		std::vector<Group> m_groups; // one open group per material and stream layout
+		Statistics m_statistics{};
+	};
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <array>
+
+#include "Structures.h"
+#include "MeshUtils.h"
+#include "Hash.h"
+
+namespace AssetsCreator::Asset {
+	// MikkTSpace style tangents for triangle lists that have normals and TEXCOORD_0 but no TANGENT.
+	// Face tangents (du direction, flipped with the uv winding) are projected onto each vertex normal and averaged with
+	// the corner angle as weight. Like MikkTSpace, corners are averaged per group of vertices with bit-identical position,
+	// normal and uv, not per index, so unwelded duplicates get the same tangent and still weld afterwards. Within a group only
+	// corners of the same uv winding are averaged; a vertex on a mirror seam is split in two, each copy with its own
+	// handedness in w. Degenerate uv triangles don't contribute.
+	class TangentGenerator {
+	public:
+		struct Statistics {
+			bool generated = false;
+			uint32_t splitVertices = 0; // vertices duplicated because both uv windings meet at them
+		};
+
+		static Statistics Generate(SubMesh& submesh) {
+			Statistics statistics{};
+			if (submesh.topology != D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST) return statistics;
+			if (MeshUtils::FindAttribute(submesh, AttributeType::TANGENT)) return statistics;
+
+			auto* positionAttribute = MeshUtils::FindAttribute(submesh, AttributeType::POSITION);
+			auto* normalAttribute = MeshUtils::FindAttribute(submesh, AttributeType::NORMAL);
+			auto* texcoordAttribute = MeshUtils::FindAttribute(submesh, AttributeType::TEXCOORD, 0);
+			if (!positionAttribute || !normalAttribute || !texcoordAttribute) return statistics;
+			if (positionAttribute->format != DXGI_FORMAT_R32G32B32_FLOAT || normalAttribute->format != DXGI_FORMAT_R32G32B32_FLOAT ||
+				texcoordAttribute->format != DXGI_FORMAT_R32G32_FLOAT) return statistics;
+
+			const uint32_t vertexCount = MeshUtils::GetVertexCount(submesh);
+			if (normalAttribute->data.size() != vertexCount * sizeof(Float3) || texcoordAttribute->data.size() != vertexCount * 2 * sizeof(float)) {
+				return statistics;
+			}
+			auto* positions = reinterpret_cast<const Float3*>(positionAttribute->data.data());
+			auto* normals = reinterpret_cast<const Float3*>(normalAttribute->data.data());
+			auto* texcoords = reinterpret_cast<const float*>(texcoordAttribute->data.data());
+
+			auto indices = MeshUtils::ReadIndices(submesh.indices);
+			const size_t triangleCount = indices.size() / 3;
+			const std::vector<uint32_t> group = GroupVertices(positions, normals, texcoords, vertexCount);
+
+			// two accumulators per group, indexed by its first vertex: [g * 2 + 1] for corners with preserved uv orientation,
+			// [g * 2] for mirrored; referenced tracks the windings per vertex, for the seam split
+			std::vector<Float3> sums(static_cast<size_t>(vertexCount) * 2, Float3{});
+			std::vector<uint8_t> referenced(static_cast<size_t>(vertexCount) * 2, 0);
+			std::vector<uint8_t> orientation(triangleCount, NO_ORIENTATION);
+			for (size_t t = 0; t < triangleCount; t++) {
+				const uint32_t* corner = &indices[t * 3];
+				if (corner[0] >= vertexCount || corner[1] >= vertexCount || corner[2] >= vertexCount) continue;
+
+				Float3 p0 = positions[corner[0]], p1 = positions[corner[1]], p2 = positions[corner[2]];
+				Float3 e1 = Sub(p1, p0), e2 = Sub(p2, p0);
+				// glTF v points down, DCC tools bake their normal maps with v up
+				float du1 = texcoords[corner[1] * 2] - texcoords[corner[0] * 2];
+				float dv1 = texcoords[corner[0] * 2 + 1] - texcoords[corner[1] * 2 + 1];
+				float du2 = texcoords[corner[2] * 2] - texcoords[corner[0] * 2];
+				float dv2 = texcoords[corner[0] * 2 + 1] - texcoords[corner[2] * 2 + 1];
+				float signedArea = du1 * dv2 - du2 * dv1;
+				Float3 faceTangent = Sub(Scale(e1, dv2), Scale(e2, dv1));
+				if (std::fabs(signedArea) <= UV_AREA_EPSILON || Length(faceTangent) <= 0.f) continue;
+
+				bool preserved = signedArea > 0.f;
+				orientation[t] = preserved;
+				faceTangent = Normalize(Scale(faceTangent, preserved ? 1.f : -1.f));
+
+				for (uint32_t i = 0; i < 3; i++) {
+					uint32_t v = corner[i];
+					referenced[static_cast<size_t>(v) * 2 + preserved] = 1;
+					Float3 n = Normalize(normals[v]);
+					Float3 tangent = Sub(faceTangent, Scale(n, Dot(n, faceTangent)));
+					float length = Length(tangent);
+					if (length <= 0.f) continue;
+
+					Float3 a = Normalize(Sub(positions[corner[(i + 1) % 3]], positions[v]));
+					Float3 b = Normalize(Sub(positions[corner[(i + 2) % 3]], positions[v]));
+					float angle = std::acos(std::clamp(Dot(a, b), -1.f, 1.f));
+
+					size_t slot = static_cast<size_t>(group[v]) * 2 + preserved;
+					sums[slot] = Add(sums[slot], Scale(tangent, angle / length));
+				}
+			}
+
+			// the preserved group keeps the vertex, a mirrored group sharing it moves to a copy at the end
+			std::vector<uint32_t> mirroredCopy(vertexCount, ~0u);
+			std::vector<uint32_t> copies;
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				if (referenced[v * 2] && referenced[v * 2 + 1]) {
+					mirroredCopy[v] = vertexCount + static_cast<uint32_t>(copies.size());
+					copies.push_back(v);
+				}
+			}
+			if (!copies.empty()) {
+				for (size_t t = 0; t < triangleCount; t++) {
+					if (orientation[t] != 0) continue;
+					for (uint32_t i = 0; i < 3; i++) {
+						auto& index = indices[t * 3 + i];
+						if (index < vertexCount && mirroredCopy[index] != ~0u) index = mirroredCopy[index];
+					}
+				}
+				for (auto& [type, attribute] : submesh.attributes) {
+					const size_t stride = attribute->strideInBytes;
+					attribute->data.resize((static_cast<size_t>(vertexCount) + copies.size()) * stride);
+					for (size_t i = 0; i < copies.size(); i++) {
+						std::memcpy(attribute->data.data() + (vertexCount + i) * stride, attribute->data.data() + copies[i] * stride, stride);
+					}
+				}
+				MeshUtils::WriteIndices(submesh.indices, indices);
+				normals = reinterpret_cast<const Float3*>(normalAttribute->data.data());
+			}
+
+			const size_t outputCount = static_cast<size_t>(vertexCount) + copies.size();
+			auto tangentAttribute = std::make_unique<Attribute>();
+			tangentAttribute->type = AttributeType::TANGENT;
+			tangentAttribute->semanticName = "TANGENT";
+			tangentAttribute->semanticIndex = 0;
+			tangentAttribute->format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+			tangentAttribute->strideInBytes = 4 * sizeof(float);
+			tangentAttribute->data.resize(outputCount * tangentAttribute->strideInBytes);
+			auto* tangents = reinterpret_cast<float*>(tangentAttribute->data.data());
+			for (size_t v = 0; v < outputCount; v++) {
+				uint32_t source = v < vertexCount ? static_cast<uint32_t>(v) : copies[v - vertexCount];
+				bool preserved = v < vertexCount ? referenced[source * 2 + 1] || !referenced[source * 2] : false;
+				Float3 sum = sums[static_cast<size_t>(group[source]) * 2 + preserved];
+				Float3 tangent = Length(sum) > 0.f ? Normalize(sum) : AnyPerpendicular(Normalize(normals[source]));
+				tangents[v * 4 + 0] = tangent.x;
+				tangents[v * 4 + 1] = tangent.y;
+				tangents[v * 4 + 2] = tangent.z;
+				tangents[v * 4 + 3] = preserved ? 1.f : -1.f;
+			}
+			submesh.attributes.emplace(AttributeType::TANGENT, std::move(tangentAttribute));
+
+			statistics.generated = true;
+			statistics.splitVertices = static_cast<uint32_t>(copies.size());
+			return statistics;
+		}
+
+	private:
+		static constexpr uint8_t NO_ORIENTATION = 2; // degenerate uv triangle
+		static constexpr float UV_AREA_EPSILON = 1e-20f;
+
+		struct Float3 {
+			float x = 0.f, y = 0.f, z = 0.f;
+		};
+
+		static Float3 Add(Float3 a, Float3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+		static Float3 Sub(Float3 a, Float3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		static Float3 Scale(Float3 a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+		static float Dot(Float3 a, Float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+		static float Length(Float3 a) { return std::sqrt(Dot(a, a)); }
+		static Float3 Normalize(Float3 a) {
+			float length = Length(a);
+			return length > 0.f ? Scale(a, 1.f / length) : Float3{ 0.f, 0.f, 1.f };
+		}
+
+		// Vertices only touched by degenerate triangles still get a valid frame.
+		static Float3 AnyPerpendicular(Float3 n) {
+			Float3 axis = std::fabs(n.x) < 0.9f ? Float3{ 1.f, 0.f, 0.f } : Float3{ 0.f, 1.f, 0.f };
+			return Normalize(Sub(axis, Scale(n, Dot(n, axis))));
+		}
+
+		// First vertex with the same position, normal and uv for every vertex; -0 and +0 are the same value.
+		static std::vector<uint32_t> GroupVertices(const Float3* positions, const Float3* normals, const float* texcoords, uint32_t vertexCount) {
+			using Key = std::array<uint32_t, 8>;
+			auto makeKey = [&](uint32_t v) {
+				float values[8] = { positions[v].x, positions[v].y, positions[v].z, normals[v].x, normals[v].y, normals[v].z,
+					texcoords[v * 2], texcoords[v * 2 + 1] };
+				Key key;
+				for (uint32_t c = 0; c < 8; c++) {
+					if (values[c] == 0.f) values[c] = 0.f;
+					std::memcpy(&key[c], &values[c], sizeof(float));
+				}
+				return key;
+			};
+
+			size_t tableSize = 1;
+			while (tableSize < static_cast<size_t>(vertexCount) * 2) tableSize <<= 1;
+			std::vector<uint32_t> table(tableSize, ~0u);
+			std::vector<Key> keys(vertexCount);
+			std::vector<uint32_t> group(vertexCount);
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				keys[v] = makeKey(v);
+				size_t slot = Hash::XXH64(keys[v].data(), sizeof(Key)) & (tableSize - 1);
+				while (table[slot] != ~0u && keys[table[slot]] != keys[v]) {
+					slot = (slot + 1) & (tableSize - 1);
+				}
+				if (table[slot] == ~0u) table[slot] = v;
+				group[v] = table[slot];
+			}
+			return group;
+		}
+	};
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <array>
+#include <algorithm>
+#include <iostream>
+#include <syncstream>
+
+#include "Structures.h"
+#include "ImageDecoder.h"
+#include "BlockCompression.h"
+#include "ThreadPool.h"
+
+namespace AssetsCreator::Asset {
+	// Turns a decoded image into a block compressed texture with a full mip chain.
+	// Mips are box filtered from the previous level (in linear space for sRGB data, renormalized for normal maps);
+	// every level is filtered and encoded row by row in parallel.
+	class TextureCooker {
+	public:
+		enum class ColorFormat : uint8_t {
+			BC7, // base color / emissive / metallic-roughness as BC7
+			BC1, // BC1, or BC3 for base color with alpha: half the size of BC7 for opaque textures, lower quality
+		};
+
+		// Normal maps keep x/y in BC5 (z is reconstructed when sampling), occlusion keeps its red channel in BC4.
+		static DXGI_FORMAT SelectFormat(TextureUsage usage, ColorFormat colorFormat, bool hasAlpha) {
+			switch (usage) {
+			case TextureUsage::NORMAL:
+				return DXGI_FORMAT_BC5_UNORM;
+			case TextureUsage::OCCLUSION:
+				return DXGI_FORMAT_BC4_UNORM;
+			case TextureUsage::METALLIC_ROUGHNESS:
+				return colorFormat == ColorFormat::BC7 ? DXGI_FORMAT_BC7_UNORM : DXGI_FORMAT_BC1_UNORM;
+			case TextureUsage::EMISSIVE:
+				return colorFormat == ColorFormat::BC7 ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM_SRGB;
+			default:
+				if (colorFormat == ColorFormat::BC7) return DXGI_FORMAT_BC7_UNORM_SRGB;
+				return hasAlpha ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM_SRGB;
+			}
+		}
+
+		static bool IsSrgb(DXGI_FORMAT format) {
+			return format == DXGI_FORMAT_BC1_UNORM_SRGB || format == DXGI_FORMAT_BC3_UNORM_SRGB || format == DXGI_FORMAT_BC7_UNORM_SRGB;
+		}
+
+		static Texture Cook(std::string id, TextureUsage usage, Image image, ColorFormat colorFormat, ThreadPool* pool = nullptr) {
+			if (image.width == 0 || image.height == 0) {
+				throw std::runtime_error("[TextureCooker] Empty image " + id);
+			}
+
+			bool hasAlpha = false;
+			for (size_t i = 3; i < image.rgba.size() && !hasAlpha; i += 4) hasAlpha = image.rgba[i] != 255;
+
+			Texture texture;
+			texture.id = std::move(id);
+			texture.usage = usage;
+			texture.format = SelectFormat(usage, colorFormat, hasAlpha);
+
+			uint32_t sourceWidth = image.width, sourceHeight = image.height;
+			// D3D12 wants the top level of a block compressed texture in whole blocks
+			if (image.width % BlockCompression::BLOCK_DIMENSION || image.height % BlockCompression::BLOCK_DIMENSION) {
+				image = ResizeToBlockMultiple(image, pool);
+			}
+
+			uint32_t mipCount = 1 + static_cast<uint32_t>(std::floor(std::log2(std::max(image.width, image.height))));
+			texture.mips.reserve(mipCount);
+			bool srgb = IsSrgb(texture.format);
+			for (uint32_t mip = 0; mip < mipCount; mip++) {
+				if (mip) image = Downsample(image, usage == TextureUsage::NORMAL, srgb, pool);
+				texture.mips.push_back(Encode(image, texture.format, pool));
+			}
+
+			size_t cookedSize = 0;
+			for (auto& mip : texture.mips) cookedSize += mip.data.size();
+			std::osyncstream(std::cout) << "[TextureCooker] " << texture.id << " " << sourceWidth << "x" << sourceHeight << " "
+				<< BlockCompression::FormatName(texture.format) << ", " << texture.mips.size() << " mips, "
+				<< static_cast<size_t>(sourceWidth) * sourceHeight * 4 << " -> " << cookedSize << " bytes\n";
+			return texture;
+		}
+
+	private:
+		template<typename F>
+		static void ForEachRow(uint32_t rowCount, ThreadPool* pool, F&& fn) {
+			if (pool) {
+				pool->parallelFor(rowCount, fn);
+			}
+			else {
+				for (uint32_t i = 0; i < rowCount; i++) fn(i);
+			}
+		}
+
+		static const std::array<float, 256>& SrgbToLinearTable() {
+			static const std::array<float, 256> table = []() {
+				std::array<float, 256> values{};
+				for (uint32_t i = 0; i < 256; i++) {
+					float c = i / 255.f;
+					values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+				}
+				return values;
+				}();
+			return table;
+		}
+
+		static uint8_t LinearToSrgb(float linear) {
+			float c = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.f / 2.4f) - 0.055f;
+			return static_cast<uint8_t>(std::clamp(std::lround(c * 255.f), 0l, 255l));
+		}
+
+		static uint8_t ToUnorm8(float value) {
+			return static_cast<uint8_t>(std::clamp(std::lround(value * 255.f), 0l, 255l));
+		}
+
+		// Bilinear stretch of a non multiple of 4 image up to the next multiple, the uv mapping stays the same.
+		static Image ResizeToBlockMultiple(const Image& source, ThreadPool* pool) {
+			Image resized;
+			resized.width = (source.width + 3) & ~3u;
+			resized.height = (source.height + 3) & ~3u;
+			resized.rgba.resize(static_cast<size_t>(resized.width) * resized.height * 4);
+
+			float scaleX = static_cast<float>(source.width) / resized.width;
+			float scaleY = static_cast<float>(source.height) / resized.height;
+			ForEachRow(resized.height, pool, [&](size_t y) {
+				float sy = std::clamp((y + 0.5f) * scaleY - 0.5f, 0.f, static_cast<float>(source.height - 1));
+				uint32_t y0 = static_cast<uint32_t>(sy), y1 = std::min(y0 + 1, source.height - 1);
+				float fy = sy - y0;
+				for (uint32_t x = 0; x < resized.width; x++) {
+					float sx = std::clamp((x + 0.5f) * scaleX - 0.5f, 0.f, static_cast<float>(source.width - 1));
+					uint32_t x0 = static_cast<uint32_t>(sx), x1 = std::min(x0 + 1, source.width - 1);
+					float fx = sx - x0;
+					auto texel = [&](uint32_t tx, uint32_t ty, uint32_t c) {
+						return static_cast<float>(source.rgba[(static_cast<size_t>(ty) * source.width + tx) * 4 + c]);
+						};
+					for (uint32_t c = 0; c < 4; c++) {
+						float top = texel(x0, y0, c) + (texel(x1, y0, c) - texel(x0, y0, c)) * fx;
+						float bottom = texel(x0, y1, c) + (texel(x1, y1, c) - texel(x0, y1, c)) * fx;
+						resized.rgba[(y * resized.width + x) * 4 + c] = static_cast<uint8_t>(std::lround(top + (bottom - top) * fy));
+					}
+				}
+				});
+			return resized;
+		}
+
+		// 2x2 box filter; odd sized levels drop their last row/column.
+		static Image Downsample(const Image& source, bool normalMap, bool srgb, ThreadPool* pool) {
+			Image target;
+			target.width = std::max(1u, source.width / 2);
+			target.height = std::max(1u, source.height / 2);
+			target.rgba.resize(static_cast<size_t>(target.width) * target.height * 4);
+
+			auto& toLinear = SrgbToLinearTable();
+			ForEachRow(target.height, pool, [&](size_t y) {
+				uint32_t sy[2] = { std::min(static_cast<uint32_t>(y) * 2, source.height - 1), std::min(static_cast<uint32_t>(y) * 2 + 1, source.height - 1) };
+				for (uint32_t x = 0; x < target.width; x++) {
+					uint32_t sx[2] = { std::min(x * 2, source.width - 1), std::min(x * 2 + 1, source.width - 1) };
+					float sum[4] = {};
+					for (uint32_t j = 0; j < 2; j++) {
+						for (uint32_t i = 0; i < 2; i++) {
+							const uint8_t* texel = &source.rgba[(static_cast<size_t>(sy[j]) * source.width + sx[i]) * 4];
+							for (uint32_t c = 0; c < 3; c++) {
+								if (normalMap) sum[c] += texel[c] / 255.f * 2.f - 1.f;
+								else if (srgb) sum[c] += toLinear[texel[c]];
+								else sum[c] += texel[c] / 255.f;
+							}
+							sum[3] += texel[3] / 255.f;
+						}
+					}
+
+					uint8_t* out = &target.rgba[(y * target.width + x) * 4];
+					if (normalMap) {
+						float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+						float n[3] = { 0.f, 0.f, 1.f };
+						if (length > 1e-6f) {
+							for (uint32_t c = 0; c < 3; c++) n[c] = sum[c] / length;
+						}
+						for (uint32_t c = 0; c < 3; c++) out[c] = ToUnorm8(n[c] * 0.5f + 0.5f);
+					}
+					else {
+						for (uint32_t c = 0; c < 3; c++) out[c] = srgb ? LinearToSrgb(sum[c] * 0.25f) : ToUnorm8(sum[c] * 0.25f);
+					}
+					out[3] = ToUnorm8(sum[3] * 0.25f);
+				}
+				});
+			return target;
+		}
+
+		// Partial blocks of the small mips repeat their last row/column.
+		static TextureMip Encode(const Image& image, DXGI_FORMAT format, ThreadPool* pool) {
+			constexpr uint32_t B = BlockCompression::BLOCK_DIMENSION;
+			TextureMip mip;
+			mip.width = image.width;
+			mip.height = image.height;
+			uint32_t blocksWide = (image.width + B - 1) / B;
+			mip.rowCount = (image.height + B - 1) / B;
+			uint32_t blockSize = BlockCompression::GetBlockSize(format);
+			mip.rowPitch = static_cast<uint32_t>((blocksWide * blockSize + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1));
+			mip.data.resize(static_cast<size_t>(mip.rowPitch) * mip.rowCount, 0);
+
+			ForEachRow(mip.rowCount, pool, [&](size_t row) {
+				uint8_t block[B * B * 4];
+				for (uint32_t column = 0; column < blocksWide; column++) {
+					for (uint32_t j = 0; j < B; j++) {
+						uint32_t y = std::min(static_cast<uint32_t>(row) * B + j, image.height - 1);
+						for (uint32_t i = 0; i < B; i++) {
+							uint32_t x = std::min(column * B + i, image.width - 1);
+							std::memcpy(&block[(j * B + i) * 4], &image.rgba[(static_cast<size_t>(y) * image.width + x) * 4], 4);
+						}
+					}
+					BlockCompression::EncodeBlock(format, block, &mip.data[row * mip.rowPitch + column * blockSize]);
+				}
+				});
+			return mip;
+		}
+	};
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <algorithm>
+
+namespace AssetsCreator {
+	// Work-stealing pool. Every worker owns a deque: it pops its own work LIFO and steals FIFO from the others.
+	// parallelFor hands the indices of a batch out through a shared counter: helper tasks queued on the pool and the calling
+	// thread all claim indices until none are left, then the caller blocks until the claimed ones are done. A waiting caller
+	// only ever runs its own batch, so nested parallelFor calls (files -> meshes -> primitives) neither deadlock nor pick up
+	// an unrelated whole-file job while an inner batch waits.
+	class ThreadPool {
+	public:
+		explicit ThreadPool(uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+			m_queues.resize(threadCount);
+			for (auto& queue : m_queues) {
+				queue = std::make_unique<WorkerQueue>();
+			}
+			m_threads.reserve(threadCount);
+			for (uint32_t i = 0; i < threadCount; i++) {
+				m_threads.emplace_back([this, i]() { workerLoop(i); });
+			}
+		}
+
+		~ThreadPool() {
+			{
+				std::lock_guard lock(m_sleepMutex);
+				m_stop = true;
+			}
+			m_sleepCondition.notify_all();
+			for (auto& thread : m_threads) {
+				thread.join();
+			}
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		uint32_t getThreadCount() const {
+			return static_cast<uint32_t>(m_threads.size());
+		}
+
+		template<typename F>
+		void parallelFor(size_t count, F&& fn) {
+			if (count == 0) return;
+			if (count == 1) {
+				fn(size_t(0));
+				return;
+			}
+
+			struct Batch {
+				std::atomic<size_t> next{ 0 };
+				std::atomic<size_t> remaining;
+				std::exception_ptr exception;
+				std::mutex mutex;
+				std::condition_variable done;
+			};
+			auto batch = std::make_shared<Batch>();
+			batch->remaining.store(count, std::memory_order_relaxed);
+
+			// fn is only touched while an index is claimed, i.e. before remaining reaches 0 and this call returns;
+			// helpers that start later find nothing to claim
+			auto runBatch = [batch, &fn, count]() {
+				for (size_t i = batch->next.fetch_add(1, std::memory_order_relaxed); i < count; i = batch->next.fetch_add(1, std::memory_order_relaxed)) {
+					try {
+						fn(i);
+					}
+					catch (...) {
+						std::lock_guard lock(batch->mutex);
+						if (!batch->exception) batch->exception = std::current_exception();
+					}
+					if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+						std::lock_guard lock(batch->mutex);
+						batch->done.notify_all();
+					}
+				}
+				};
+
+			size_t helperCount = std::min(count - 1, m_queues.size());
+			for (size_t i = 0; i < helperCount; i++) {
+				push(runBatch);
+			}
+			runBatch();
+
+			{
+				std::unique_lock lock(batch->mutex);
+				batch->done.wait(lock, [&]() { return batch->remaining.load(std::memory_order_acquire) == 0; });
+			}
+
+			if (batch->exception) {
+				std::rethrow_exception(batch->exception);
+			}
+		}
+
+	private:
+		struct WorkerQueue {
+			std::deque<std::function<void()>> tasks;
+			std::mutex mutex;
+		};
+
+		std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+		std::vector<std::thread> m_threads;
+		std::atomic<uint64_t> m_pending{ 0 };
+		std::atomic<uint32_t> m_nextQueue{ 0 };
+
+		std::mutex m_sleepMutex;
+		std::condition_variable m_sleepCondition;
+		bool m_stop = false;
+
+		inline static thread_local const ThreadPool* t_pool = nullptr;
+		inline static thread_local uint32_t t_workerIndex = 0;
+
+		void push(std::function<void()> task) {
+			uint32_t index = t_pool == this
+				? t_workerIndex
+				: m_nextQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(m_queues.size());
+			{
+				auto& queue = *m_queues[index];
+				std::lock_guard lock(queue.mutex);
+				queue.tasks.push_back(std::move(task));
+			}
+			m_pending.fetch_add(1, std::memory_order_release);
+			{
+				std::lock_guard lock(m_sleepMutex);
+			}
+			m_sleepCondition.notify_one();
+		}
+
+		bool tryRunOne(uint32_t ownIndex) {
+			std::function<void()> task;
+			{
+				auto& own = *m_queues[ownIndex];
+				std::lock_guard lock(own.mutex);
+				if (!own.tasks.empty()) {
+					task = std::move(own.tasks.back());
+					own.tasks.pop_back();
+				}
+			}
+			if (!task) {
+				uint32_t queueCount = static_cast<uint32_t>(m_queues.size());
+				for (uint32_t offset = 1; offset < queueCount && !task; offset++) {
+					auto& victim = *m_queues[(ownIndex + offset) % queueCount];
+					std::lock_guard lock(victim.mutex);
+					if (!victim.tasks.empty()) {
+						task = std::move(victim.tasks.front());
+						victim.tasks.pop_front();
+					}
+				}
+			}
+			if (!task) return false;
+
+			m_pending.fetch_sub(1, std::memory_order_acq_rel);
+			task();
+			return true;
+		}
+
+		void workerLoop(uint32_t index) {
+			t_pool = this;
+			t_workerIndex = index;
+			while (true) {
+				if (tryRunOne(index)) continue;
+
+				std::unique_lock lock(m_sleepMutex);
+				m_sleepCondition.wait(lock, [this]() {
+					return m_stop || m_pending.load(std::memory_order_acquire) != 0;
+					});
+				if (m_stop) return;
+			}
+		}
+	};
+}
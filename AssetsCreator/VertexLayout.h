@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "Structures.h"
+#include "MeshUtils.h"
+
+namespace AssetsCreator::Asset {
+	// How a cooked submesh lays out its vertex streams.
+	class VertexLayout {
+	public:
+		enum class Policy : uint8_t {
+			SEPARATE, // one stream per attribute
+			SPLIT, // tightly packed positions for depth-only passes + one normal/texcoord/tangent stream for shading
+		};
+
+		// Moves NORMAL, TEXCOORD0 and TANGENT into one interleaved stream, in that order and without padding:
+		// the engine declares them with D3D12_APPEND_ALIGNED_ELEMENT in the same order.
+		// Returns false and leaves the submesh alone unless all three exist with one value per vertex.
+		static bool Interleave(SubMesh& submesh) {
+			static constexpr AttributeType ORDER[] = { AttributeType::NORMAL, AttributeType::TEXCOORD, AttributeType::TANGENT };
+
+			const uint32_t vertexCount = MeshUtils::GetVertexCount(submesh);
+			if (vertexCount == 0 || submesh.interleaved) return false;
+
+			decltype(submesh.attributes)::iterator sources[std::size(ORDER)];
+			InterleavedStream stream;
+			for (size_t i = 0; i < std::size(ORDER); i++) {
+				auto range = submesh.attributes.equal_range(ORDER[i]);
+				auto itt = std::find_if(range.first, range.second, [](auto& entry) { return entry.second->semanticIndex == 0; });
+				if (itt == range.second) return false;
+
+				auto& attribute = *itt->second;
+				if (attribute.data.size() != static_cast<size_t>(attribute.strideInBytes) * vertexCount) return false;
+				sources[i] = itt;
+				stream.elements.push_back({ attribute.type, attribute.semanticIndex, attribute.format, stream.strideInBytes });
+				stream.strideInBytes += attribute.strideInBytes;
+			}
+
+			stream.data.resize(static_cast<size_t>(stream.strideInBytes) * vertexCount);
+			for (size_t i = 0; i < std::size(ORDER); i++) {
+				auto& attribute = *sources[i]->second;
+				const uint8_t* src = attribute.data.data();
+				uint8_t* dst = stream.data.data() + stream.elements[i].offset;
+				for (uint32_t v = 0; v < vertexCount; v++) {
+					std::memcpy(dst, src, attribute.strideInBytes);
+					src += attribute.strideInBytes;
+					dst += stream.strideInBytes;
+				}
+			}
+
+			for (auto& source : sources) submesh.attributes.erase(source);
+			submesh.interleaved = std::move(stream);
+			return true;
+		}
+	};
+}
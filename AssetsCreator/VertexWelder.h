@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "Structures.h"
+#include "MeshUtils.h"
+#include "Hash.h"
+
+namespace AssetsCreator::Asset {
+	// Merges vertices that are equal across every attribute stream of a submesh and rewrites the indices.
+	// Float components are compared on a grid of the attribute's epsilon, everything else byte for byte.
+	// The first vertex of every group is kept and vertices keep their relative order, so the result only depends on the input.
+	class VertexWelder {
+	public:
+		// Grid size per attribute, in attribute units; 0 welds bit-identical values only (+0 and -0 are equal).
+		// Joints and weights are always exact.
+		struct Epsilon {
+			float position = 0.f;
+			float normal = 0.f;
+			float tangent = 0.f;
+			float texcoord = 0.f;
+			float color = 0.f;
+
+			float get(AttributeType type) const {
+				switch (type) {
+				case AttributeType::POSITION: return position;
+				case AttributeType::NORMAL: return normal;
+				case AttributeType::TANGENT:
+				case AttributeType::BITANGENT: return tangent;
+				case AttributeType::TEXCOORD: return texcoord;
+				case AttributeType::COLOR: return color;
+				default: return 0.f;
+				}
+			}
+		};
+
+		struct Statistics {
+			uint32_t verticesBefore = 0;
+			uint32_t verticesAfter = 0;
+		};
+
+		static Statistics Weld(SubMesh& submesh, const Epsilon& epsilon) {
+			Statistics statistics{};
+			const uint32_t vertexCount = MeshUtils::GetVertexCount(submesh);
+			statistics.verticesBefore = statistics.verticesAfter = vertexCount;
+			if (vertexCount == 0 || submesh.indices.data.empty()) return statistics;
+
+			// Key layout: one 64 bit word per float component, byte attributes padded to whole words.
+			struct Stream {
+				const Attribute* attribute;
+				uint32_t floatComponents; // 0 - compare bytes
+				float epsilon;
+			};
+			std::vector<Stream> streams;
+			size_t keyWords = 0;
+			for (auto& [type, attribute] : submesh.attributes) {
+				if (attribute->data.size() / attribute->strideInBytes != vertexCount) return statistics;
+				uint32_t components = FloatComponents(attribute->format);
+				streams.push_back({ attribute.get(), components, components ? epsilon.get(type) : 0.f });
+				keyWords += components ? components : (attribute->strideInBytes + 7) / 8;
+			}
+
+			std::vector<uint64_t> keys(keyWords * vertexCount, 0);
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				uint64_t* key = &keys[v * keyWords];
+				for (auto& stream : streams) {
+					const uint8_t* data = stream.attribute->data.data() + static_cast<size_t>(v) * stream.attribute->strideInBytes;
+					if (stream.floatComponents) {
+						for (uint32_t c = 0; c < stream.floatComponents; c++) {
+							float value;
+							std::memcpy(&value, data + c * sizeof(float), sizeof(float));
+							*key++ = QuantizeComponent(value, stream.epsilon);
+						}
+					}
+					else {
+						std::memcpy(key, data, stream.attribute->strideInBytes);
+						key += (stream.attribute->strideInBytes + 7) / 8;
+					}
+				}
+			}
+
+			// Open addressing table of representatives, probed in vertex order.
+			const size_t keyBytes = keyWords * sizeof(uint64_t);
+			size_t tableSize = 1;
+			while (tableSize < static_cast<size_t>(vertexCount) * 2) tableSize <<= 1;
+			std::vector<uint32_t> table(tableSize, ~0u);
+			std::vector<uint32_t> indexRemap(vertexCount);
+			std::vector<uint32_t> vertexRemap(vertexCount, ~0u);
+			uint32_t uniqueCount = 0;
+
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				const uint64_t* key = &keys[v * keyWords];
+				size_t slot = Hash::XXH64(key, keyBytes) & (tableSize - 1);
+				while (table[slot] != ~0u && std::memcmp(&keys[table[slot] * keyWords], key, keyBytes) != 0) {
+					slot = (slot + 1) & (tableSize - 1);
+				}
+				if (table[slot] == ~0u) {
+					table[slot] = v;
+					vertexRemap[v] = uniqueCount++;
+				}
+				indexRemap[v] = vertexRemap[table[slot]];
+			}
+
+			statistics.verticesAfter = uniqueCount;
+			if (uniqueCount == vertexCount) return statistics;
+
+			auto indices = MeshUtils::ReadIndices(submesh.indices);
+			for (auto& index : indices) index = indexRemap[index];
+			MeshUtils::WriteIndices(submesh.indices, indices);
+			MeshUtils::RemapVertexStreams(submesh, vertexRemap, uniqueCount);
+			return statistics;
+		}
+
+	private:
+		static uint32_t FloatComponents(DXGI_FORMAT format) {
+			switch (format) {
+			case DXGI_FORMAT_R32_FLOAT: return 1;
+			case DXGI_FORMAT_R32G32_FLOAT: return 2;
+			case DXGI_FORMAT_R32G32B32_FLOAT: return 3;
+			case DXGI_FORMAT_R32G32B32A32_FLOAT: return 4;
+			default: return 0;
+			}
+		}
+
+		static uint64_t QuantizeComponent(float value, float epsilon) {
+			if (epsilon > 0.f && std::isfinite(value)) {
+				return static_cast<uint64_t>(static_cast<int64_t>(std::floor(static_cast<double>(value) / epsilon + 0.5)));
+			}
+			if (value == 0.f) value = 0.f; // -0 -> +0
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return bits | (1ull << 63); // keeps exact values apart from grid cells of the same stream
+		}
+	};
+}
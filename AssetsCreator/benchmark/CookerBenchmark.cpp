@@ -0,0 +1,445 @@
+// CookerBenchmark.cpp : times the cooker stages over the bundled glTF models and synthetic meshes.
+//
+// parse   - GLTFSource: GLB container and JSON document
+// decode  - GetMeshesInfo: every primitive's accessors into SubMeshes (parses the document again)
+// convert - CookSubmesh with the default CookOptions
+// write   - AssetWriter::Write into a scratch directory
+//
+// Every stage reports the median wall time over --repeat runs, MB/s of its input (output for write) and the peak RSS
+// while it ran. Results go to a JSON file so runs before and after a change can be compared.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <limits>
+
+#include "../GLTFStreamReader.h"
+#include "../AssetWriter.h"
+#include "../MeshCooker.h"
+#include "../ThreadPool.h"
+
+#ifndef COOKER_BENCHMARK_MODELS
+#define COOKER_BENCHMARK_MODELS "../../Engine/assets/glb"
+#endif
+
+namespace fs = std::filesystem;
+using AssetsCreator::Asset::SubMesh;
+using AssetsCreator::Asset::Mesh;
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	struct BenchmarkOptions {
+		fs::path models = COOKER_BENCHMARK_MODELS;
+		fs::path json = "cooker_benchmark.json";
+		fs::path scratch = fs::temp_directory_path() / "cooker_benchmark";
+		uint32_t repeat = 3;
+		uint32_t threadCount = 0;
+		bool fixedSeed = false;
+		uint64_t seed = 0;
+		uint32_t gridSize = 1024; // vertices per side of the synthetic terrain
+		uint32_t soupTriangles = 500000;
+		bool synthetic = true;
+	};
+
+	struct Stage {
+		std::string name;
+		std::vector<double> seconds;
+		uint64_t bytes = 0;
+		uint64_t peakRssBytes = 0;
+
+		double median() const {
+			auto sorted = seconds;
+			std::sort(sorted.begin(), sorted.end());
+			return sorted.empty() ? 0.0 : sorted[sorted.size() / 2];
+		}
+	};
+
+	struct Case {
+		std::string name;
+		std::string kind; // gltf | synthetic
+		uint64_t vertexCount = 0;
+		uint64_t triangleCount = 0;
+		std::vector<Stage> stages;
+
+		Stage& stage(const std::string& stageName) {
+			for (auto& s : stages) {
+				if (s.name == stageName) return s;
+			}
+			return stages.emplace_back(Stage{ stageName });
+		}
+	};
+
+	// VmHWM is reset through clear_refs, so every stage reports its own peak instead of the process maximum.
+	void ResetPeakRss() {
+#if defined(__linux__)
+		std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+	}
+
+	uint64_t ReadPeakRss() {
+#if defined(__linux__)
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line)) {
+			if (line.rfind("VmHWM:", 0) == 0) {
+				return std::stoull(line.substr(6)) * 1024;
+			}
+		}
+#endif
+		return 0;
+	}
+
+	template<typename F>
+	void Measure(Stage& stage, F&& fn) {
+		ResetPeakRss();
+		auto start = Clock::now();
+		stage.bytes = fn();
+		stage.seconds.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+		stage.peakRssBytes = std::max(stage.peakRssBytes, ReadPeakRss());
+	}
+
+	uint64_t SubmeshBytes(const SubMesh& submesh) {
+		uint64_t bytes = submesh.indices.data.size();
+		for (auto& [type, attribute] : submesh.attributes) bytes += attribute->data.size();
+		return bytes;
+	}
+
+	uint64_t MeshBytes(const Mesh& mesh) {
+		uint64_t bytes = 0;
+		for (auto& submesh : mesh.submeshes) bytes += SubmeshBytes(*submesh);
+		return bytes;
+	}
+
+	void CountGeometry(Case& benchmarkCase, const std::vector<std::unique_ptr<Mesh>>& meshes) {
+		benchmarkCase.vertexCount = 0;
+		benchmarkCase.triangleCount = 0;
+		for (auto& mesh : meshes) {
+			for (auto& submesh : mesh->submeshes) {
+				benchmarkCase.vertexCount += AssetsCreator::Asset::MeshUtils::GetVertexCount(*submesh);
+				benchmarkCase.triangleCount += submesh->indices.data.size() / std::max<uint32_t>(1, submesh->indices.strideInBytes) / 3;
+			}
+		}
+	}
+
+	// convert and write, shared by the glTF and the synthetic cases
+	void CookAndWrite(Case& benchmarkCase, std::vector<std::unique_ptr<Mesh>>& meshes, const AssetsCreator::Cook::CookOptions& cookOptions,
+		const fs::path& outputDirectory, AssetsCreator::ThreadPool& pool) {
+		Measure(benchmarkCase.stage("convert"), [&]() {
+			uint64_t bytes = 0;
+			for (auto& mesh : meshes) {
+				bytes += MeshBytes(*mesh);
+				pool.parallelFor(mesh->submeshes.size(), [&](size_t i) {
+					AssetsCreator::Cook::CookSubmesh(*mesh->submeshes[i], cookOptions);
+					});
+			}
+			return bytes;
+			});
+		Measure(benchmarkCase.stage("write"), [&]() {
+			uint64_t bytes = 0;
+			for (auto& mesh : meshes) {
+				auto path = AssetsCreator::Asset::AssetWriter::Write(*mesh, outputDirectory, cookOptions.compression, &pool);
+				bytes += fs::file_size(path);
+			}
+			return bytes;
+			});
+	}
+
+	void RunGltf(Case& benchmarkCase, const fs::path& path, const AssetsCreator::Cook::CookOptions& cookOptions,
+		const fs::path& outputDirectory, AssetsCreator::ThreadPool& pool) {
+		uint64_t sourceBytes = fs::file_size(path);
+		Measure(benchmarkCase.stage("parse"), [&]() {
+			GLTFLocal::GLTFSource source(path);
+			return sourceBytes;
+			});
+
+		std::vector<std::unique_ptr<Mesh>> meshes;
+		Measure(benchmarkCase.stage("decode"), [&]() {
+			meshes = GLTFLocal::GetMeshesInfo(path, cookOptions.compressIntoOneMesh, &pool);
+			return sourceBytes;
+			});
+		CountGeometry(benchmarkCase, meshes);
+		CookAndWrite(benchmarkCase, meshes, cookOptions, outputDirectory, pool);
+	}
+
+	std::unique_ptr<AssetsCreator::Asset::Attribute> MakeFloatAttribute(AssetsCreator::Asset::AttributeType type, const char* semanticName,
+		DXGI_FORMAT format, uint8_t stride, const std::vector<float>& values) {
+		auto attribute = std::make_unique<AssetsCreator::Asset::Attribute>();
+		attribute->type = type;
+		attribute->semanticName = semanticName;
+		attribute->semanticIndex = 0;
+		attribute->format = format;
+		attribute->strideInBytes = stride;
+		attribute->data.resize(values.size() * sizeof(float));
+		std::memcpy(attribute->data.data(), values.data(), attribute->data.size());
+		return attribute;
+	}
+
+	std::unique_ptr<SubMesh> MakeSubmesh(const std::string& id, const std::vector<float>& positions, const std::vector<float>& normals,
+		const std::vector<float>& texcoords, const std::vector<uint32_t>& indices) {
+		using AssetsCreator::Asset::AttributeType;
+		auto submesh = std::make_unique<SubMesh>();
+		submesh->id = id;
+		submesh->topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		submesh->attributes.emplace(AttributeType::POSITION, MakeFloatAttribute(AttributeType::POSITION, "POSITION", DXGI_FORMAT_R32G32B32_FLOAT, 12, positions));
+		submesh->attributes.emplace(AttributeType::NORMAL, MakeFloatAttribute(AttributeType::NORMAL, "NORMAL", DXGI_FORMAT_R32G32B32_FLOAT, 12, normals));
+		submesh->attributes.emplace(AttributeType::TEXCOORD, MakeFloatAttribute(AttributeType::TEXCOORD, "TEXCOORD", DXGI_FORMAT_R32G32_FLOAT, 8, texcoords));
+		for (int c = 0; c < 3; c++) {
+			submesh->aabbMin[c] = std::numeric_limits<float>::max();
+			submesh->aabbMax[c] = -std::numeric_limits<float>::max();
+		}
+		for (size_t i = 0; i < positions.size(); i += 3) {
+			for (int c = 0; c < 3; c++) {
+				submesh->aabbMin[c] = std::min(submesh->aabbMin[c], positions[i + c]);
+				submesh->aabbMax[c] = std::max(submesh->aabbMax[c], positions[i + c]);
+			}
+		}
+		AssetsCreator::Asset::MeshUtils::WriteIndices(submesh->indices, indices);
+		return submesh;
+	}
+
+	// Heightfield made of a few random sine waves: shared vertices and good locality, the common case.
+	std::unique_ptr<Mesh> MakeTerrain(uint32_t size, std::mt19937_64& random) {
+		std::uniform_real_distribution<float> frequency(0.005f, 0.05f), phase(0.f, 6.2831853f), amplitude(0.5f, 4.f);
+		struct Wave { float fx, fz, phase, amplitude; };
+		std::vector<Wave> waves(6);
+		for (auto& wave : waves) wave = { frequency(random), frequency(random), phase(random), amplitude(random) };
+
+		std::vector<float> positions, normals, texcoords;
+		positions.reserve(static_cast<size_t>(size) * size * 3);
+		normals.reserve(positions.capacity());
+		texcoords.reserve(static_cast<size_t>(size) * size * 2);
+		for (uint32_t z = 0; z < size; z++) {
+			for (uint32_t x = 0; x < size; x++) {
+				float height = 0.f, dx = 0.f, dz = 0.f;
+				for (auto& wave : waves) {
+					float angle = wave.fx * x + wave.fz * z + wave.phase;
+					height += wave.amplitude * std::sin(angle);
+					dx += wave.amplitude * wave.fx * std::cos(angle);
+					dz += wave.amplitude * wave.fz * std::cos(angle);
+				}
+				float length = std::sqrt(dx * dx + 1.f + dz * dz);
+				positions.insert(positions.end(), { static_cast<float>(x), height, static_cast<float>(z) });
+				normals.insert(normals.end(), { -dx / length, 1.f / length, -dz / length });
+				texcoords.insert(texcoords.end(), { static_cast<float>(x) / size, static_cast<float>(z) / size });
+			}
+		}
+		std::vector<uint32_t> indices;
+		indices.reserve(static_cast<size_t>(size - 1) * (size - 1) * 6);
+		for (uint32_t z = 0; z + 1 < size; z++) {
+			for (uint32_t x = 0; x + 1 < size; x++) {
+				uint32_t v = z * size + x;
+				indices.insert(indices.end(), { v, v + size, v + 1, v + 1, v + size, v + size + 1 });
+			}
+		}
+
+		auto mesh = std::make_unique<Mesh>();
+		mesh->id = "synthetic_terrain";
+		mesh->submeshes.push_back(MakeSubmesh("terrain", positions, normals, texcoords, indices));
+		return mesh;
+	}
+
+	// Unshared, shuffled triangles: worst case for welding, the vertex cache optimizer and the BVH.
+	std::unique_ptr<Mesh> MakeSoup(uint32_t triangleCount, std::mt19937_64& random) {
+		std::uniform_real_distribution<float> center(-100.f, 100.f), offset(-1.f, 1.f), uv(0.f, 1.f);
+		std::vector<float> positions, normals, texcoords;
+		positions.reserve(static_cast<size_t>(triangleCount) * 9);
+		normals.reserve(positions.capacity());
+		texcoords.reserve(static_cast<size_t>(triangleCount) * 6);
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			float c[3] = { center(random), center(random), center(random) };
+			float p[9];
+			for (int i = 0; i < 9; i++) p[i] = c[i % 3] + offset(random);
+			float e1[3] = { p[3] - p[0], p[4] - p[1], p[5] - p[2] };
+			float e2[3] = { p[6] - p[0], p[7] - p[1], p[8] - p[2] };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float length = std::max(1e-12f, std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]));
+			for (int corner = 0; corner < 3; corner++) {
+				positions.insert(positions.end(), p + corner * 3, p + corner * 3 + 3);
+				normals.insert(normals.end(), { n[0] / length, n[1] / length, n[2] / length });
+				texcoords.insert(texcoords.end(), { uv(random), uv(random) });
+			}
+		}
+		std::vector<uint32_t> indices(static_cast<size_t>(triangleCount) * 3);
+		std::vector<uint32_t> order(triangleCount);
+		for (uint32_t t = 0; t < triangleCount; t++) order[t] = t;
+		std::shuffle(order.begin(), order.end(), random);
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			for (uint32_t corner = 0; corner < 3; corner++) indices[t * 3 + corner] = order[t] * 3 + corner;
+		}
+
+		auto mesh = std::make_unique<Mesh>();
+		mesh->id = "synthetic_soup";
+		mesh->submeshes.push_back(MakeSubmesh("soup", positions, normals, texcoords, indices));
+		return mesh;
+	}
+
+	std::string Escape(const std::string& value) {
+		std::string escaped;
+		for (char c : value) {
+			if (c == '"' || c == '\\') escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
+
+	void WriteJson(const fs::path& path, const BenchmarkOptions& options, uint32_t threadCount, const std::vector<Case>& cases) {
+		std::ofstream json(path, std::ios::trunc);
+		json << "{\n";
+		json << "  \"cookerVersion\": " << AssetsCreator::Cook::COOKER_VERSION << ",\n";
+		json << "  \"threads\": " << threadCount << ",\n";
+		json << "  \"repeat\": " << options.repeat << ",\n";
+		json << "  \"fixedSeed\": " << (options.fixedSeed ? "true" : "false") << ",\n";
+		json << "  \"seed\": " << options.seed << ",\n";
+		json << "  \"cases\": [\n";
+		for (size_t c = 0; c < cases.size(); c++) {
+			auto& benchmarkCase = cases[c];
+			json << "    {\n";
+			json << "      \"name\": \"" << Escape(benchmarkCase.name) << "\",\n";
+			json << "      \"kind\": \"" << benchmarkCase.kind << "\",\n";
+			json << "      \"vertices\": " << benchmarkCase.vertexCount << ",\n";
+			json << "      \"triangles\": " << benchmarkCase.triangleCount << ",\n";
+			json << "      \"stages\": [\n";
+			for (size_t s = 0; s < benchmarkCase.stages.size(); s++) {
+				auto& stage = benchmarkCase.stages[s];
+				double seconds = stage.median();
+				double throughput = seconds > 0.0 ? stage.bytes / (1024.0 * 1024.0) / seconds : 0.0;
+				json << "        { \"name\": \"" << stage.name << "\", \"seconds\": " << seconds
+					<< ", \"bytes\": " << stage.bytes << ", \"mbPerSecond\": " << throughput
+					<< ", \"peakRssBytes\": " << stage.peakRssBytes << ", \"runs\": [";
+				for (size_t r = 0; r < stage.seconds.size(); r++) json << (r ? ", " : "") << stage.seconds[r];
+				json << "] }" << (s + 1 < benchmarkCase.stages.size() ? "," : "") << "\n";
+			}
+			json << "      ]\n";
+			json << "    }" << (c + 1 < cases.size() ? "," : "") << "\n";
+		}
+		json << "  ]\n";
+		json << "}\n";
+		if (!json) {
+			throw std::runtime_error("[CookerBenchmark] Failed to write " + path.string());
+		}
+	}
+
+	void PrintUsage() {
+		std::cout << "Usage: CookerBenchmark [options]\n"
+			<< "  --models <dir>     glTF/GLB models to cook (default: " << COOKER_BENCHMARK_MODELS << ")\n"
+			<< "  --json <file>      results (default: cooker_benchmark.json)\n"
+			<< "  --scratch <dir>    where cooked assets are written and removed again\n"
+			<< "  --repeat <n>       runs per case, stages report the median (default: 3)\n"
+			<< "  --jobs <n>         worker threads (default: hardware concurrency)\n"
+			<< "  --seed <n>         fixed seed for the synthetic meshes; without it a random seed is drawn and recorded\n"
+			<< "  --fixed            stable numbers: seed 1 and one worker thread unless --seed/--jobs say otherwise\n"
+			<< "  --grid <n>         vertices per side of the synthetic terrain (default: 1024)\n"
+			<< "  --soup <n>         triangles of the synthetic soup (default: 500000)\n"
+			<< "  --no-synthetic     only the glTF models\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkOptions options;
+	bool seedGiven = false, jobsGiven = false;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--models" && i + 1 < argc) options.models = argv[++i];
+		else if (arg == "--json" && i + 1 < argc) options.json = argv[++i];
+		else if (arg == "--scratch" && i + 1 < argc) options.scratch = argv[++i];
+		else if (arg == "--repeat" && i + 1 < argc) options.repeat = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+		else if (arg == "--jobs" && i + 1 < argc) {
+			options.threadCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+			jobsGiven = true;
+		}
+		else if (arg == "--seed" && i + 1 < argc) {
+			options.seed = std::stoull(argv[++i]);
+			options.fixedSeed = seedGiven = true;
+		}
+		else if (arg == "--fixed") options.fixedSeed = true;
+		else if (arg == "--grid" && i + 1 < argc) options.gridSize = std::max(2u, static_cast<uint32_t>(std::stoul(argv[++i])));
+		else if (arg == "--soup" && i + 1 < argc) options.soupTriangles = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--no-synthetic") options.synthetic = false;
+		else {
+			std::cerr << "Unknown argument " << arg << "\n";
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (options.fixedSeed) {
+		if (!seedGiven) options.seed = 1;
+		if (!jobsGiven) options.threadCount = 1;
+	}
+	else {
+		options.seed = std::random_device{}();
+	}
+
+	try {
+		uint32_t threadCount = options.threadCount ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+		AssetsCreator::ThreadPool pool(threadCount);
+		AssetsCreator::Cook::CookOptions cookOptions{};
+		cookOptions.threadCount = threadCount;
+
+		std::vector<fs::path> models;
+		if (fs::is_directory(options.models)) {
+			for (auto& entry : fs::directory_iterator(options.models)) {
+				auto extension = entry.path().extension().string();
+				if (extension == ".glb" || extension == ".gltf") models.push_back(entry.path());
+			}
+		}
+		std::sort(models.begin(), models.end());
+		if (models.empty()) {
+			std::cerr << "[CookerBenchmark] No models in " << options.models.string() << "\n";
+		}
+
+		std::vector<Case> cases;
+		for (auto& model : models) {
+			Case& benchmarkCase = cases.emplace_back(Case{ model.filename().string(), "gltf" });
+			for (uint32_t run = 0; run < options.repeat; run++) {
+				RunGltf(benchmarkCase, model, cookOptions, options.scratch, pool);
+				fs::remove_all(options.scratch);
+			}
+		}
+
+		if (options.synthetic) {
+			using Generator = std::function<std::unique_ptr<Mesh>(std::mt19937_64&)>;
+			std::vector<std::pair<std::string, Generator>> generators = {
+				{ "terrain_" + std::to_string(options.gridSize), [&](std::mt19937_64& random) { return MakeTerrain(options.gridSize, random); } },
+				{ "soup_" + std::to_string(options.soupTriangles), [&](std::mt19937_64& random) { return MakeSoup(options.soupTriangles, random); } },
+			};
+			for (auto& [name, generate] : generators) {
+				Case& benchmarkCase = cases.emplace_back(Case{ name, "synthetic" });
+				for (uint32_t run = 0; run < options.repeat; run++) {
+					// same input every run, generation is not timed
+					std::mt19937_64 random(options.seed);
+					std::vector<std::unique_ptr<Mesh>> meshes;
+					meshes.push_back(generate(random));
+					CountGeometry(benchmarkCase, meshes);
+					CookAndWrite(benchmarkCase, meshes, cookOptions, options.scratch, pool);
+					fs::remove_all(options.scratch);
+				}
+			}
+		}
+
+		for (auto& benchmarkCase : cases) {
+			for (auto& stage : benchmarkCase.stages) {
+				double seconds = stage.median();
+				std::cout << "[CookerBenchmark] " << benchmarkCase.name << " " << stage.name << ": " << seconds * 1000.0 << " ms, "
+					<< (seconds > 0.0 ? stage.bytes / (1024.0 * 1024.0) / seconds : 0.0) << " MB/s, peak RSS "
+					<< stage.peakRssBytes / (1024 * 1024) << " MB\n";
+			}
+		}
+		WriteJson(options.json, options, threadCount, cases);
+		std::cout << "[CookerBenchmark] " << options.json.string() << "\n";
+		return 0;
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+}
@@ -0,0 +1,5 @@
+// StbImage.cpp : the stb_image implementation for the Linux build; ImageDecoder.h only includes the declarations.
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#include <stb_image.h>
@@ -0,0 +1,271 @@
+// BlockCompressionTests.cpp : encode -> decode of synthetic 4x4 blocks through reference decoders written from the BC
+// format specification, so the test does not share code (or bugs) with the encoder.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+#include "../BlockCompression.h"
+
+using AssetsCreator::Asset::BlockCompression;
+
+namespace {
+	using Block = std::array<uint8_t, 64>; // 16 RGBA pixels, row major
+
+	void DecodeRGB565(uint16_t packed, int(&color)[3]) {
+		int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// BC1 color block; fourColor forces the four color palette like the color half of BC3 does
+	void DecodeBC1(const uint8_t* block, Block& out, bool fourColor) {
+		uint16_t c0 = static_cast<uint16_t>(block[0] | block[1] << 8), c1 = static_cast<uint16_t>(block[2] | block[3] << 8);
+		int palette[4][4] = {};
+		DecodeRGB565(c0, reinterpret_cast<int(&)[3]>(palette[0]));
+		DecodeRGB565(c1, reinterpret_cast<int(&)[3]>(palette[1]));
+		palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+		for (int c = 0; c < 3; c++) {
+			if (c0 > c1 || fourColor) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+			else {
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		if (!(c0 > c1 || fourColor)) palette[3][3] = 0;
+
+		uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | static_cast<uint32_t>(block[7]) << 24;
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++) out[i * 4 + c] = static_cast<uint8_t>(palette[(indices >> (2 * i)) & 3][c]);
+		}
+	}
+
+	void DecodeBC4(const uint8_t* block, Block& out, int channel) {
+		float palette[8] = { static_cast<float>(block[0]), static_cast<float>(block[1]) };
+		if (block[0] > block[1]) {
+			for (int p = 1; p < 7; p++) palette[p + 1] = ((7 - p) * palette[0] + p * palette[1]) / 7.f;
+		}
+		else {
+			for (int p = 1; p < 5; p++) palette[p + 1] = ((5 - p) * palette[0] + p * palette[1]) / 5.f;
+			palette[6] = 0.f;
+			palette[7] = 255.f;
+		}
+		uint64_t indices = 0;
+		for (int b = 0; b < 6; b++) indices |= static_cast<uint64_t>(block[2 + b]) << (8 * b);
+		for (int i = 0; i < 16; i++) out[i * 4 + channel] = static_cast<uint8_t>(std::lround(palette[(indices >> (3 * i)) & 7]));
+	}
+
+	// BC7, mode 6 only: the encoder never writes another mode, anything else fails the test
+	bool DecodeBC7(const uint8_t* block, Block& out) {
+		uint32_t position = 0;
+		auto read = [&](uint32_t count) {
+			uint32_t value = 0;
+			for (uint32_t b = 0; b < count; b++, position++) value |= ((block[position / 8] >> (position % 8)) & 1u) << b;
+			return value;
+			};
+		if (read(7) != (1u << 6)) return false;
+
+		int endpoints[2][4];
+		for (int c = 0; c < 4; c++) {
+			endpoints[0][c] = static_cast<int>(read(7));
+			endpoints[1][c] = static_cast<int>(read(7));
+		}
+		for (auto& endpoint : endpoints) {
+			uint32_t pBit = read(1);
+			for (int& value : endpoint) value = value << 1 | static_cast<int>(pBit);
+		}
+		static constexpr int WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		for (int i = 0; i < 16; i++) {
+			uint32_t index = read(i == 0 ? 3 : 4);
+			for (int c = 0; c < 4; c++) {
+				out[i * 4 + c] = static_cast<uint8_t>((endpoints[0][c] * (64 - WEIGHTS[index]) + endpoints[1][c] * WEIGHTS[index] + 32) >> 6);
+			}
+		}
+		return position == 128;
+	}
+
+	Block RoundTrip(DXGI_FORMAT format, const Block& source) {
+		uint8_t encoded[16] = {};
+		BlockCompression::EncodeBlock(format, source.data(), encoded);
+		Block decoded = source;
+		switch (format) {
+		case DXGI_FORMAT_BC1_UNORM:
+			DecodeBC1(encoded, decoded, false);
+			break;
+		case DXGI_FORMAT_BC4_UNORM:
+			DecodeBC4(encoded, decoded, 0);
+			break;
+		case DXGI_FORMAT_BC5_UNORM:
+			DecodeBC4(encoded, decoded, 0);
+			DecodeBC4(encoded + 8, decoded, 1);
+			break;
+		case DXGI_FORMAT_BC7_UNORM:
+			REQUIRE(DecodeBC7(encoded, decoded));
+			break;
+		default:
+			FAIL("no reference decoder");
+		}
+		return decoded;
+	}
+
+	struct BlockError {
+		int maxError = 0;
+		double rmse = 0.0;
+	};
+
+	BlockError Measure(const Block& a, const Block& b, std::initializer_list<int> channels) {
+		BlockError error;
+		double sum = 0.0;
+		for (int i = 0; i < 16; i++) {
+			for (int c : channels) {
+				int d = std::abs(a[i * 4 + c] - b[i * 4 + c]);
+				error.maxError = std::max(error.maxError, d);
+				sum += d * d;
+			}
+		}
+		error.rmse = std::sqrt(sum / (16.0 * channels.size()));
+		return error;
+	}
+
+	Block Solid(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+		Block block;
+		for (int i = 0; i < 16; i++) {
+			block[i * 4 + 0] = r;
+			block[i * 4 + 1] = g;
+			block[i * 4 + 2] = b;
+			block[i * 4 + 3] = a;
+		}
+		return block;
+	}
+
+	// a linear ramp between two colors along x + y, the case every endpoint encoder is built for
+	Block Gradient(const uint8_t(&from)[4], const uint8_t(&to)[4]) {
+		Block block;
+		for (int y = 0; y < 4; y++) {
+			for (int x = 0; x < 4; x++) {
+				float t = (x + y) / 6.f;
+				for (int c = 0; c < 4; c++) block[(y * 4 + x) * 4 + c] = static_cast<uint8_t>(std::lround(from[c] + (to[c] - from[c]) * t));
+			}
+		}
+		return block;
+	}
+
+	Block Noise(std::mt19937& rng, int low, int high) {
+		std::uniform_int_distribution<int> value(low, high);
+		Block block;
+		for (auto& channel : block) channel = static_cast<uint8_t>(value(rng));
+		return block;
+	}
+
+	std::vector<Block> SolidBlocks() {
+		std::vector<Block> blocks;
+		for (int v : { 0, 1, 127, 128, 254, 255 }) blocks.push_back(Solid(static_cast<uint8_t>(v), static_cast<uint8_t>(v), static_cast<uint8_t>(v), 255));
+		std::mt19937 rng(5);
+		std::uniform_int_distribution<int> value(0, 255);
+		for (int i = 0; i < 64; i++) {
+			blocks.push_back(Solid(static_cast<uint8_t>(value(rng)), static_cast<uint8_t>(value(rng)), static_cast<uint8_t>(value(rng)), static_cast<uint8_t>(value(rng))));
+		}
+		return blocks;
+	}
+
+	std::vector<Block> GradientBlocks() {
+		std::vector<Block> blocks;
+		blocks.push_back(Gradient({ 0, 0, 0, 255 }, { 255, 255, 255, 255 }));
+		blocks.push_back(Gradient({ 255, 0, 0, 255 }, { 0, 0, 255, 255 }));
+		blocks.push_back(Gradient({ 40, 90, 20, 0 }, { 60, 120, 30, 255 }));
+		std::mt19937 rng(9);
+		std::uniform_int_distribution<int> value(0, 255);
+		for (int i = 0; i < 64; i++) {
+			uint8_t from[4], to[4];
+			for (int c = 0; c < 4; c++) {
+				from[c] = static_cast<uint8_t>(value(rng));
+				to[c] = static_cast<uint8_t>(value(rng));
+			}
+			blocks.push_back(Gradient(from, to));
+		}
+		return blocks;
+	}
+}
+
+TEST_CASE("BC1 round trips synthetic blocks", "[BlockCompression]") {
+	// a solid color lands on the 565 grid or between two of its points, within half a 5 bit step
+	for (auto& block : SolidBlocks()) {
+		auto decoded = RoundTrip(DXGI_FORMAT_BC1_UNORM, block);
+		CHECK(Measure(block, decoded, { 0, 1, 2 }).maxError <= 4);
+		for (int i = 0; i < 16; i++) CHECK(decoded[i * 4 + 3] == 255); // never the punch-through palette
+	}
+	// seven ramp steps onto four palette entries: half a palette step (a sixth of the range) plus the 565 rounding
+	for (auto& block : GradientBlocks()) {
+		auto decoded = RoundTrip(DXGI_FORMAT_BC1_UNORM, block);
+		for (int c : { 0, 1, 2 }) {
+			int range = std::abs(block[c] - block[15 * 4 + c]);
+			INFO("channel " << c);
+			CHECK(Measure(block, decoded, { c }).maxError <= range / 6 + 8);
+		}
+		for (int i = 0; i < 16; i++) CHECK(decoded[i * 4 + 3] == 255);
+	}
+	// two colors on the 565 grid are reproduced exactly
+	Block twoColors = Solid(255, 0, 0, 255);
+	for (int i = 8; i < 16; i++) twoColors[i * 4 + 0] = 0, twoColors[i * 4 + 2] = 255;
+	CHECK(Measure(twoColors, RoundTrip(DXGI_FORMAT_BC1_UNORM, twoColors), { 0, 1, 2 }).maxError == 0);
+
+	std::mt19937 rng(1);
+	for (int i = 0; i < 64; i++) {
+		auto block = Noise(rng, 0, 255);
+		CHECK(Measure(block, RoundTrip(DXGI_FORMAT_BC1_UNORM, block), { 0, 1, 2 }).rmse <= 100.0);
+	}
+}
+
+TEST_CASE("BC4 and BC5 round trip synthetic blocks", "[BlockCompression]") {
+	for (auto& block : SolidBlocks()) {
+		CHECK(Measure(block, RoundTrip(DXGI_FORMAT_BC4_UNORM, block), { 0 }).maxError == 0);
+		CHECK(Measure(block, RoundTrip(DXGI_FORMAT_BC5_UNORM, block), { 0, 1 }).maxError == 0);
+	}
+	// eight values between the block minimum and maximum: at most half a palette step off, plus rounding
+	for (auto& block : GradientBlocks()) {
+		for (auto format : { DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC5_UNORM }) {
+			auto decoded = RoundTrip(format, block);
+			for (int c : { 0, 1 }) {
+				if (c == 1 && format == DXGI_FORMAT_BC4_UNORM) continue;
+				int low = 255, high = 0;
+				for (int i = 0; i < 16; i++) {
+					low = std::min<int>(low, block[i * 4 + c]);
+					high = std::max<int>(high, block[i * 4 + c]);
+				}
+				INFO(BlockCompression::FormatName(format) << " channel " << c);
+				CHECK(Measure(block, decoded, { c }).maxError <= (high - low) / 14 + 1);
+			}
+		}
+	}
+	std::mt19937 rng(2);
+	for (int i = 0; i < 64; i++) {
+		auto block = Noise(rng, 100, 140);
+		CHECK(Measure(block, RoundTrip(DXGI_FORMAT_BC5_UNORM, block), { 0, 1 }).maxError <= 40 / 14 + 1);
+	}
+}
+
+TEST_CASE("BC7 mode 6 round trips synthetic blocks", "[BlockCompression]") {
+	// 7 bit endpoints with a shared p-bit still reach every 8 bit value through the interpolation
+	for (auto& block : SolidBlocks()) {
+		CHECK(Measure(block, RoundTrip(DXGI_FORMAT_BC7_UNORM, block), { 0, 1, 2, 3 }).maxError <= 1);
+	}
+	for (auto& block : GradientBlocks()) {
+		auto error = Measure(block, RoundTrip(DXGI_FORMAT_BC7_UNORM, block), { 0, 1, 2, 3 });
+		CHECK(error.maxError <= 8);
+		CHECK(error.rmse <= 4.0);
+	}
+	std::mt19937 rng(3);
+	for (int i = 0; i < 64; i++) {
+		auto block = Noise(rng, 0, 255);
+		CHECK(Measure(block, RoundTrip(DXGI_FORMAT_BC7_UNORM, block), { 0, 1, 2, 3 }).rmse <= 100.0);
+	}
+}
@@ -0,0 +1,97 @@
+// MeshOptimizerTests.cpp : the vertex cache and vertex fetch optimization over the bundled glTF models.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+
+#include "../GLTFStreamReader.h"
+#include "../MeshCooker.h"
+#include "../ThreadPool.h"
+
+#ifndef COOKER_TEST_MODELS
+#define COOKER_TEST_MODELS "../../Engine/assets/glb"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+	std::vector<fs::path> BundledModels() {
+		std::vector<fs::path> models;
+		for (auto& entry : fs::directory_iterator(COOKER_TEST_MODELS)) {
+			if (entry.path().extension() == ".glb") models.push_back(entry.path());
+		}
+		std::sort(models.begin(), models.end());
+		return models;
+	}
+}
+
+// Runs the whole submesh cook, so the optimizer sees welded indices like it does in the cooker.
+TEST_CASE("Vertex cache optimization never makes the bundled models worse", "[MeshOptimizer]") {
+	auto models = BundledModels();
+	REQUIRE(!models.empty());
+
+	AssetsCreator::ThreadPool pool(2);
+	AssetsCreator::Cook::CookOptions options;
+	for (auto& model : models) {
+		DYNAMIC_SECTION(model.filename().string()) {
+			auto meshes = GLTFLocal::GetMeshesInfo(model, false, &pool);
+			REQUIRE(!meshes.empty());
+
+			uint64_t missesBefore = 0, missesAfter = 0;
+			for (auto& mesh : meshes) {
+				for (auto& submesh : mesh->submeshes) {
+					INFO(submesh->id);
+					auto statistics = AssetsCreator::Cook::CookSubmesh(*submesh, options).optimize;
+					REQUIRE(statistics.before.triangleCount > 0);
+					CHECK(statistics.after.triangleCount == statistics.before.triangleCount);
+					CHECK(statistics.after.acmr <= statistics.before.acmr);
+					CHECK(statistics.after.atvr <= statistics.before.atvr);
+
+					missesBefore += statistics.before.misses;
+					missesAfter += statistics.after.misses;
+				}
+			}
+			CHECK(missesAfter <= missesBefore);
+		}
+	}
+}
+
+// A grid in scan order with vertices no triangle references: optimizing twice must not undo the first pass, and ATVR is
+// compared over the referenced vertices only.
+TEST_CASE("Vertex cache optimization keeps orders it can't improve", "[MeshOptimizer]") {
+	constexpr uint32_t SIZE = 32, UNREFERENCED = 100;
+	std::vector<float> positions;
+	for (uint32_t y = 0; y <= SIZE; y++) {
+		for (uint32_t x = 0; x <= SIZE; x++) positions.insert(positions.end(), { static_cast<float>(x), static_cast<float>(y), 0.f });
+	}
+	positions.resize(positions.size() + UNREFERENCED * 3, 0.f);
+	std::vector<uint32_t> indices;
+	for (uint32_t y = 0; y < SIZE; y++) {
+		for (uint32_t x = 0; x < SIZE; x++) {
+			uint32_t v = y * (SIZE + 1) + x;
+			indices.insert(indices.end(), { v, v + 1, v + SIZE + 2, v, v + SIZE + 2, v + SIZE + 1 });
+		}
+	}
+
+	AssetsCreator::Asset::SubMesh submesh;
+	submesh.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	auto attribute = std::make_unique<AssetsCreator::Asset::Attribute>();
+	attribute->type = AssetsCreator::Asset::AttributeType::POSITION;
+	attribute->format = DXGI_FORMAT_R32G32B32_FLOAT;
+	attribute->strideInBytes = 12;
+	attribute->data.resize(positions.size() * sizeof(float));
+	std::memcpy(attribute->data.data(), positions.data(), attribute->data.size());
+	submesh.attributes.emplace(attribute->type, std::move(attribute));
+	AssetsCreator::Asset::MeshUtils::WriteIndices(submesh.indices, indices);
+
+	for (int pass = 0; pass < 2; pass++) {
+		INFO("pass " << pass);
+		auto statistics = AssetsCreator::Asset::MeshOptimizer::Optimize(submesh);
+		CHECK(statistics.before.vertexCount == (SIZE + 1) * (SIZE + 1));
+		CHECK(statistics.after.vertexCount == statistics.before.vertexCount);
+		CHECK(statistics.after.acmr <= statistics.before.acmr);
+		CHECK(statistics.after.atvr <= statistics.before.atvr);
+	}
+}
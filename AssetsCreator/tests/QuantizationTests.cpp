@@ -0,0 +1,264 @@
+// QuantizationTests.cpp : encode -> decode round trips of the quantized vertex formats against the cooker's error budgets.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "../Quantization.h"
+
+using AssetsCreator::Asset::Quantization;
+using AssetsCreator::Asset::Attribute;
+using AssetsCreator::Asset::AttributeType;
+using AssetsCreator::Asset::SubMesh;
+
+namespace {
+	const Quantization::ErrorBudget BUDGET{};
+
+	void AddAttribute(SubMesh& submesh, AttributeType type, DXGI_FORMAT format, uint8_t stride, const std::vector<float>& values) {
+		auto attribute = std::make_unique<Attribute>();
+		attribute->type = type;
+		attribute->semanticIndex = 0;
+		attribute->format = format;
+		attribute->strideInBytes = stride;
+		attribute->data.resize(values.size() * sizeof(float));
+		std::memcpy(attribute->data.data(), values.data(), attribute->data.size());
+		submesh.attributes.emplace(type, std::move(attribute));
+	}
+
+	const Attribute& Get(const SubMesh& submesh, AttributeType type) {
+		return *submesh.attributes.find(type)->second;
+	}
+
+	template<typename T>
+	const T* As(const Attribute& attribute) {
+		return reinterpret_cast<const T*>(attribute.data.data());
+	}
+
+	float AngleDegrees(const float a[3], const float b[3]) {
+		float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+		float la = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+		float lb = std::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+		return std::acos(std::clamp(dot / (la * lb), -1.f, 1.f)) * 57.29578f;
+	}
+
+	// the six axes, the eight octant diagonals and the octahedron edges and fold seams, then random directions
+	std::vector<float> TestDirections(size_t randomCount) {
+		std::vector<float> directions;
+		for (int axis = 0; axis < 3; axis++) {
+			for (float sign : { 1.f, -1.f }) {
+				float d[3] = {};
+				d[axis] = sign;
+				directions.insert(directions.end(), d, d + 3);
+			}
+		}
+		for (float x : { -1.f, 1.f }) for (float y : { -1.f, 1.f }) for (float z : { -1.f, 0.f, 1.f }) {
+			float l = std::sqrt(x * x + y * y + z * z);
+			directions.insert(directions.end(), { x / l, y / l, z / l });
+		}
+		directions.insert(directions.end(), { 0.f, 0.6f, -0.8f, 0.6f, 0.f, -0.8f, 1e-7f, 0.f, -1.f, 0.f, -1e-7f, -1.f });
+
+		std::mt19937 rng(7);
+		std::normal_distribution<float> gaussian;
+		for (size_t i = 0; i < randomCount; i++) {
+			float d[3] = { gaussian(rng), gaussian(rng), gaussian(rng) };
+			float l = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+			if (l < 1e-6f) continue;
+			directions.insert(directions.end(), { d[0] / l, d[1] / l, d[2] / l });
+		}
+		return directions;
+	}
+}
+
+TEST_CASE("Snorm16 and unorm16 round trips", "[Quantization]") {
+	CHECK(Quantization::Snorm16ToFloat(Quantization::FloatToSnorm16(1.f)) == 1.f);
+	CHECK(Quantization::Snorm16ToFloat(Quantization::FloatToSnorm16(-1.f)) == -1.f);
+	CHECK(Quantization::Snorm16ToFloat(Quantization::FloatToSnorm16(0.f)) == 0.f);
+	CHECK(Quantization::Snorm16ToFloat(-32768) == -1.f);
+	CHECK(Quantization::Unorm16ToFloat(Quantization::FloatToUnorm16(0.f)) == 0.f);
+	CHECK(Quantization::Unorm16ToFloat(Quantization::FloatToUnorm16(1.f)) == 1.f);
+	CHECK(Quantization::FloatToUnorm16(-0.5f) == 0);
+	CHECK(Quantization::FloatToUnorm16(2.f) == 0xFFFF);
+
+	for (int i = 0; i <= 1000; i++) {
+		float u = i / 1000.f;
+		float s = u * 2.f - 1.f;
+		CHECK(std::abs(Quantization::Unorm16ToFloat(Quantization::FloatToUnorm16(u)) - u) <= 0.5f / 65535.f + 1e-7f);
+		CHECK(std::abs(Quantization::Snorm16ToFloat(Quantization::FloatToSnorm16(s)) - s) <= 0.5f / 32767.f + 1e-7f);
+	}
+}
+
+TEST_CASE("Half floats round trip within half a unit in the last place", "[Quantization]") {
+	for (float exact : { 0.f, -0.f, 1.f, -2.f, 0.5f, 0.25f, 1024.f, 65504.f, 6.103515625e-05f, 5.960464477539063e-08f }) {
+		CHECK(Quantization::HalfToFloat(Quantization::FloatToHalf(exact)) == exact);
+	}
+	CHECK(std::signbit(Quantization::HalfToFloat(Quantization::FloatToHalf(-0.f))));
+	CHECK(std::isinf(Quantization::HalfToFloat(Quantization::FloatToHalf(1e6f))));
+	CHECK(std::isnan(Quantization::HalfToFloat(Quantization::FloatToHalf(std::nanf("")))));
+	CHECK(Quantization::FloatToHalf(1e-9f) == 0);
+
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> exponent(-14.f, 15.f);
+	for (int i = 0; i < 10000; i++) {
+		float value = std::exp2(exponent(rng)) * (i & 1 ? -1.f : 1.f);
+		float decoded = Quantization::HalfToFloat(Quantization::FloatToHalf(value));
+		CHECK(std::abs(decoded - value) <= std::abs(value) * std::exp2(-11.f));
+	}
+	// halves are at most 2^-11 apart in [0, 1], so texcoords in the unit square are always inside the budget
+	for (int i = 0; i <= 4096; i++) {
+		float uv = i / 4096.f + 1.f / 8192.f;
+		CHECK(std::abs(Quantization::HalfToFloat(Quantization::FloatToHalf(uv)) - uv) <= BUDGET.texcoord);
+	}
+}
+
+TEST_CASE("Octahedral directions decode within the normal budget", "[Quantization]") {
+	auto directions = TestDirections(20000);
+	float maxError = 0.f;
+	for (size_t i = 0; i < directions.size(); i += 3) {
+		const float* n = directions.data() + i;
+		int16_t encoded[2];
+		float decoded[3];
+		Quantization::OctEncode(n, encoded);
+		Quantization::OctDecode(encoded, decoded);
+		INFO("direction " << n[0] << " " << n[1] << " " << n[2]);
+		CHECK(std::abs(decoded[0] * decoded[0] + decoded[1] * decoded[1] + decoded[2] * decoded[2] - 1.f) < 1e-5f);
+		maxError = std::max(maxError, AngleDegrees(n, decoded));
+	}
+	CHECK(maxError <= BUDGET.normalDegrees);
+
+	// axes, +z and -z (the fold's corner) decode exactly
+	for (size_t i = 0; i < 18; i += 3) {
+		const float* n = directions.data() + i;
+		int16_t encoded[2];
+		float decoded[3];
+		Quantization::OctEncode(n, encoded);
+		Quantization::OctDecode(encoded, decoded);
+		CHECK(decoded[0] == n[0]);
+		CHECK(decoded[1] == n[1]);
+		CHECK(decoded[2] == n[2]);
+	}
+}
+
+TEST_CASE("QuantizeSubmesh keeps every stream within the budget", "[Quantization]") {
+	SubMesh submesh;
+	submesh.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	const float aabbMin[3] = { -12.5f, 0.f, 3.f };
+	const float aabbMax[3] = { 40.f, 0.25f, 1003.f };
+	std::copy(aabbMin, aabbMin + 3, submesh.aabbMin);
+	std::copy(aabbMax, aabbMax + 3, submesh.aabbMax);
+
+	auto directions = TestDirections(5000);
+	const size_t count = directions.size() / 3;
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::vector<float> positions, tangents, texcoords;
+	for (size_t v = 0; v < count; v++) {
+		for (int c = 0; c < 3; c++) positions.push_back(v < 2 ? (v ? aabbMax[c] : aabbMin[c]) : aabbMin[c] + unit(rng) * (aabbMax[c] - aabbMin[c]));
+		const float* n = directions.data() + ((v + 1) % count) * 3;
+		tangents.insert(tangents.end(), { n[0], n[1], n[2], v % 3 ? 1.f : -1.f });
+		texcoords.insert(texcoords.end(), { unit(rng), v % 2 ? 1.f : unit(rng) });
+	}
+	AddAttribute(submesh, AttributeType::POSITION, DXGI_FORMAT_R32G32B32_FLOAT, 12, positions);
+	AddAttribute(submesh, AttributeType::NORMAL, DXGI_FORMAT_R32G32B32_FLOAT, 12, directions);
+	AddAttribute(submesh, AttributeType::TANGENT, DXGI_FORMAT_R32G32B32A32_FLOAT, 16, tangents);
+	AddAttribute(submesh, AttributeType::TEXCOORD, DXGI_FORMAT_R32G32_FLOAT, 8, texcoords);
+
+	auto error = Quantization::QuantizeSubmesh(submesh, BUDGET);
+	CHECK(error.quantizedAttributes == 4);
+	CHECK(error.rejectedAttributes == 0);
+	CHECK(error.position <= BUDGET.position);
+	CHECK(error.normalDegrees <= BUDGET.normalDegrees);
+	CHECK(error.tangentDegrees <= BUDGET.tangentDegrees);
+	CHECK(error.texcoord <= BUDGET.texcoord);
+
+	// decode like gbuffers.hlsl and check against the source values, not just the reported error
+	auto& position = Get(submesh, AttributeType::POSITION);
+	auto& normal = Get(submesh, AttributeType::NORMAL);
+	auto& tangent = Get(submesh, AttributeType::TANGENT);
+	auto& texcoord = Get(submesh, AttributeType::TEXCOORD);
+	REQUIRE(position.format == DXGI_FORMAT_R16G16B16A16_UNORM);
+	REQUIRE(normal.format == DXGI_FORMAT_R16G16_SNORM);
+	REQUIRE(tangent.format == DXGI_FORMAT_R16G16B16A16_SNORM);
+	REQUIRE(texcoord.format == DXGI_FORMAT_R16G16_FLOAT);
+
+	float diagonal = 0.f;
+	for (int c = 0; c < 3; c++) diagonal += (aabbMax[c] - aabbMin[c]) * (aabbMax[c] - aabbMin[c]);
+	diagonal = std::sqrt(diagonal);
+
+	for (size_t v = 0; v < count; v++) {
+		INFO("vertex " << v);
+		float distance = 0.f;
+		for (int c = 0; c < 3; c++) {
+			float decoded = aabbMin[c] + Quantization::Unorm16ToFloat(As<uint16_t>(position)[v * 4 + c]) * (aabbMax[c] - aabbMin[c]);
+			distance += (decoded - positions[v * 3 + c]) * (decoded - positions[v * 3 + c]);
+		}
+		CHECK(std::sqrt(distance) <= BUDGET.position * diagonal);
+
+		float decoded[3];
+		Quantization::OctDecode(As<int16_t>(normal) + v * 2, decoded);
+		CHECK(AngleDegrees(directions.data() + v * 3, decoded) <= BUDGET.normalDegrees);
+
+		Quantization::OctDecode(As<int16_t>(tangent) + v * 4, decoded);
+		CHECK(AngleDegrees(tangents.data() + v * 4, decoded) <= BUDGET.tangentDegrees);
+		CHECK(Quantization::Snorm16ToFloat(As<int16_t>(tangent)[v * 4 + 2]) == tangents[v * 4 + 3]);
+
+		for (int c = 0; c < 2; c++) {
+			CHECK(std::abs(Quantization::HalfToFloat(As<uint16_t>(texcoord)[v * 2 + c]) - texcoords[v * 2 + c]) <= BUDGET.texcoord);
+		}
+	}
+}
+
+TEST_CASE("Zero extent AABBs quantize without error on the flat axes", "[Quantization]") {
+	// a quad in the xz plane (y extent 0), and a single point repeated (no extent at all)
+	for (bool point : { false, true }) {
+		SubMesh submesh;
+		submesh.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		std::vector<float> positions = point
+			? std::vector<float>{ 2.f, -3.f, 7.f, 2.f, -3.f, 7.f, 2.f, -3.f, 7.f }
+			: std::vector<float>{ -1.f, 5.f, -1.f, 1.f, 5.f, -1.f, 1.f, 5.f, 1.f, -1.f, 5.f, 1.f, 0.3f, 5.f, -0.7f };
+		for (int c = 0; c < 3; c++) {
+			submesh.aabbMin[c] = submesh.aabbMax[c] = positions[c];
+			for (size_t i = c; i < positions.size(); i += 3) {
+				submesh.aabbMin[c] = std::min(submesh.aabbMin[c], positions[i]);
+				submesh.aabbMax[c] = std::max(submesh.aabbMax[c], positions[i]);
+			}
+		}
+		AddAttribute(submesh, AttributeType::POSITION, DXGI_FORMAT_R32G32B32_FLOAT, 12, positions);
+
+		auto error = Quantization::QuantizeSubmesh(submesh, BUDGET);
+		CHECK(error.quantizedAttributes == 1);
+		CHECK(std::isfinite(error.position));
+		CHECK(error.position <= BUDGET.position);
+
+		auto& position = Get(submesh, AttributeType::POSITION);
+		REQUIRE(position.format == DXGI_FORMAT_R16G16B16A16_UNORM);
+		for (size_t v = 0; v < positions.size() / 3; v++) {
+			for (int c = 0; c < 3; c++) {
+				float extent = submesh.aabbMax[c] - submesh.aabbMin[c];
+				float decoded = submesh.aabbMin[c] + Quantization::Unorm16ToFloat(As<uint16_t>(position)[v * 4 + c]) * extent;
+				if (extent == 0.f) CHECK(decoded == positions[v * 3 + c]);
+				else CHECK(std::abs(decoded - positions[v * 3 + c]) <= extent * 0.5f / 65535.f + 1e-6f);
+			}
+		}
+	}
+}
+
+TEST_CASE("Streams over the budget stay float", "[Quantization]") {
+	// tiled texcoords: half spacing at 1000 is 0.5, far over the 1/2048 budget
+	SubMesh submesh;
+	submesh.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	std::vector<float> texcoords = { 0.f, 0.f, 1000.3f, 0.5f, 0.25f, 999.7f };
+	AddAttribute(submesh, AttributeType::TEXCOORD, DXGI_FORMAT_R32G32_FLOAT, 8, texcoords);
+
+	auto error = Quantization::QuantizeSubmesh(submesh, BUDGET);
+	CHECK(error.quantizedAttributes == 0);
+	CHECK(error.rejectedAttributes == 1);
+	CHECK(error.texcoord > BUDGET.texcoord);
+
+	auto& texcoord = Get(submesh, AttributeType::TEXCOORD);
+	CHECK(texcoord.format == DXGI_FORMAT_R32G32_FLOAT);
+	CHECK(std::equal(texcoords.begin(), texcoords.end(), As<float>(texcoord)));
+}
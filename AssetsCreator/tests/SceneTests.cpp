@@ -0,0 +1,89 @@
+// SceneTests.cpp : the .scene.asset the batch cooker writes for a glTF node tree.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+
+#include "../BatchCooker.h"
+#include "../AssetReader.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	// One triangle drawn by two nodes, the second one moved along x.
+	fs::path WriteInstancedTriangle(const fs::path& directory) {
+		fs::remove_all(directory);
+		fs::create_directories(directory);
+
+		const float positions[9] = { 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f };
+		const uint16_t indices[4] = { 0, 1, 2, 0 }; // padded to 4 bytes
+		std::ofstream bin(directory / "instanced.bin", std::ios::binary);
+		bin.write(reinterpret_cast<const char*>(positions), sizeof(positions));
+		bin.write(reinterpret_cast<const char*>(indices), sizeof(indices));
+		bin.close();
+
+		std::ofstream gltf(directory / "instanced.gltf");
+		gltf << R"({
+			"asset": { "version": "2.0" },
+			"buffers": [ { "uri": "instanced.bin", "byteLength": 44 } ],
+			"bufferViews": [
+				{ "buffer": 0, "byteOffset": 0, "byteLength": 36 },
+				{ "buffer": 0, "byteOffset": 36, "byteLength": 6 }
+			],
+			"accessors": [
+				{ "bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3", "min": [ 0, 0, 0 ], "max": [ 1, 1, 0 ] },
+				{ "bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR" }
+			],
+			"meshes": [ { "primitives": [ { "attributes": { "POSITION": 0 }, "indices": 1 } ] } ],
+			"nodes": [
+				{ "name": "first", "mesh": 0 },
+				{ "name": "second", "mesh": 0, "translation": [ 2, 0, 0 ] }
+			],
+			"scenes": [ { "nodes": [ 0, 1 ] } ],
+			"scene": 0
+		})";
+		return directory / "instanced.gltf";
+	}
+
+	AssetsCreator::Cook::BatchCooker::Result Cook(const fs::path& source, const AssetsCreator::Cook::CookOptions& options) {
+		AssetsCreator::Cook::BatchCooker cooker(options);
+		return cooker.run(cooker.collectJobs(source));
+	}
+}
+
+TEST_CASE("A merged mesh doesn't get a scene that drops its instances", "[Scene]") {
+	auto directory = fs::temp_directory_path() / "CookerTests" / "SceneMerged";
+	auto source = WriteInstancedTriangle(directory);
+
+	AssetsCreator::Cook::CookOptions options;
+	options.outputDirectory = directory / "out";
+	options.threadCount = 1;
+	REQUIRE(options.compressIntoOneMesh);
+	REQUIRE(options.cookScene);
+
+	auto result = Cook(source, options);
+	REQUIRE(result.cooked == 1);
+	CHECK(fs::exists(options.outputDirectory / "instanced_0.mesh.asset"));
+	CHECK_FALSE(fs::exists(options.outputDirectory / "instanced.scene.asset"));
+}
+
+TEST_CASE("Split meshes keep one instance per node", "[Scene]") {
+	auto directory = fs::temp_directory_path() / "CookerTests" / "SceneSplit";
+	auto source = WriteInstancedTriangle(directory);
+
+	AssetsCreator::Cook::CookOptions options;
+	options.outputDirectory = directory / "out";
+	options.threadCount = 1;
+	options.compressIntoOneMesh = false;
+
+	auto result = Cook(source, options);
+	REQUIRE(result.cooked == 1);
+	auto scene = AssetsCreator::Asset::AssetReader::ReadScene(options.outputDirectory / "instanced.scene.asset", true);
+	REQUIRE(scene->meshes.size() == 1);
+	CHECK(std::strcmp(scene->meshes[0].id, "instanced_0") == 0);
+	REQUIRE(scene->instances.size() == 2);
+	CHECK(scene->instances[0].translation[0] == 0.f);
+	CHECK(scene->instances[1].translation[0] == 2.f);
+}
@@ -0,0 +1,87 @@
+// TangentGeneratorTests.cpp : generated tangents must not keep the welder from merging duplicated vertices.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+#include "../TangentGenerator.h"
+#include "../VertexWelder.h"
+
+using AssetsCreator::Asset::TangentGenerator;
+using AssetsCreator::Asset::VertexWelder;
+using AssetsCreator::Asset::Attribute;
+using AssetsCreator::Asset::AttributeType;
+using AssetsCreator::Asset::SubMesh;
+
+namespace {
+	void AddAttribute(SubMesh& submesh, AttributeType type, DXGI_FORMAT format, uint8_t stride, const std::vector<float>& values) {
+		auto attribute = std::make_unique<Attribute>();
+		attribute->type = type;
+		attribute->semanticIndex = 0;
+		attribute->format = format;
+		attribute->strideInBytes = stride;
+		attribute->data.resize(values.size() * sizeof(float));
+		std::memcpy(attribute->data.data(), values.data(), attribute->data.size());
+		submesh.attributes.emplace(type, std::move(attribute));
+	}
+
+	// A flat size x size grid as a triangle soup: every triangle has its own three vertices, like an unindexed glTF
+	// primitive. v is sheared more in every column, so the face tangents differ from column to column. With mirrored, u runs
+	// away from the middle column on both halves, so the middle column is a mirror seam.
+	SubMesh TriangleSoupGrid(uint32_t size, bool mirrored) {
+		std::vector<float> positions, normals, texcoords;
+		auto addVertex = [&](uint32_t x, uint32_t y) {
+			positions.insert(positions.end(), { static_cast<float>(x), static_cast<float>(y), 0.f });
+			normals.insert(normals.end(), { 0.f, 0.f, 1.f });
+			float u = mirrored ? std::fabs(static_cast<float>(x) - size / 2.f) : static_cast<float>(x);
+			float v = static_cast<float>(y) + 0.5f * u * u / size;
+			texcoords.insert(texcoords.end(), { u / size, v / size });
+		};
+		for (uint32_t y = 0; y < size; y++) {
+			for (uint32_t x = 0; x < size; x++) {
+				addVertex(x, y); addVertex(x + 1, y); addVertex(x + 1, y + 1);
+				addVertex(x, y); addVertex(x + 1, y + 1); addVertex(x, y + 1);
+			}
+		}
+
+		SubMesh submesh;
+		submesh.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		AddAttribute(submesh, AttributeType::POSITION, DXGI_FORMAT_R32G32B32_FLOAT, 12, positions);
+		AddAttribute(submesh, AttributeType::NORMAL, DXGI_FORMAT_R32G32B32_FLOAT, 12, normals);
+		AddAttribute(submesh, AttributeType::TEXCOORD, DXGI_FORMAT_R32G32_FLOAT, 8, texcoords);
+		std::vector<uint32_t> indices(positions.size() / 3);
+		for (uint32_t i = 0; i < indices.size(); i++) indices[i] = i;
+		AssetsCreator::Asset::MeshUtils::WriteIndices(submesh.indices, indices);
+		return submesh;
+	}
+}
+
+TEST_CASE("Duplicated vertices weld to the same count with and without tangents", "[TangentGenerator]") {
+	constexpr uint32_t SIZE = 120;
+	auto plain = TriangleSoupGrid(SIZE, false);
+	auto withTangents = TriangleSoupGrid(SIZE, false);
+
+	auto tangents = TangentGenerator::Generate(withTangents);
+	REQUIRE(tangents.generated);
+	CHECK(tangents.splitVertices == 0);
+
+	auto weldPlain = VertexWelder::Weld(plain, VertexWelder::Epsilon{});
+	auto weldTangents = VertexWelder::Weld(withTangents, VertexWelder::Epsilon{});
+	CHECK(weldPlain.verticesBefore == SIZE * SIZE * 6);
+	CHECK(weldPlain.verticesAfter == (SIZE + 1) * (SIZE + 1));
+	CHECK(weldTangents.verticesAfter == weldPlain.verticesAfter);
+}
+
+TEST_CASE("A mirror seam keeps one extra vertex per seam position after welding", "[TangentGenerator]") {
+	constexpr uint32_t SIZE = 120;
+	auto plain = TriangleSoupGrid(SIZE, true);
+	auto withTangents = TriangleSoupGrid(SIZE, true);
+
+	REQUIRE(TangentGenerator::Generate(withTangents).generated);
+
+	auto weldPlain = VertexWelder::Weld(plain, VertexWelder::Epsilon{});
+	auto weldTangents = VertexWelder::Weld(withTangents, VertexWelder::Epsilon{});
+	CHECK(weldTangents.verticesAfter == weldPlain.verticesAfter + SIZE + 1);
+}
@@ -21,7 +21,7 @@ VSOutput VSMain(VSInput input)
 
 cbuffer globals : register(b0)
 {
-    uint transformsIndex, screenX, screenY, unsued;
+    uint transformsIndex, screenX, screenY, materialsIndex;
 };
 
 Texture2D<float4> lightingTexture : register(t0); // Lighting texture (SRV at slot 1)
@@ -6,6 +6,7 @@ struct PSInput
     float3 worldTangent : TEXCOORD2;
     float4 tangent : TANGENT;
     float2 texcoords : TEXCOORD3;
+    float4 color : COLOR;
     
     //float3 ndcPosition : TEXCOORD4;
     //float3 ndcPrevPosition : TEXCOORD5;
@@ -38,6 +39,7 @@ struct VertexShaderInput
     float3 normal : NORMAL;
     float2 texcoords : TEXCOORD;
     float4 tangent : TANGENT;
+    float4 color : COLOR; // COLOR_0, white when the mesh has none
 };
 
 cbuffer camera : register(b0)
@@ -49,23 +51,57 @@ cbuffer camera : register(b0)
 };
 cbuffer globals : register(b1)
 {    
-    uint transformsIndex, screenX, screenY, unsued;
+    uint transformsIndex, screenX, screenY, materialsIndex;
 };
 cbuffer mesh : register(b2)
 {
     uint transformIndex;
     uint materialIndex;
+    uint vertexFormat;
+    uint meshUnused0;
+    float3 positionMin;
+    float meshUnused1;
+    float3 positionExtent;
 }
+
+// Keep in sync with Render::Manager::VertexFormatFlags
+#define VERTEX_POSITION_UNORM16 (1u << 0)
+#define VERTEX_NORMAL_OCT16 (1u << 1)
+#define VERTEX_TEXCOORD_HALF (1u << 2)
+#define VERTEX_TANGENT_OCT16 (1u << 3)
+#define VERTEX_INTERLEAVED (1u << 4) // input layout only, nothing to decode
 ConstantBuffer<CPUMaterialCBVData> g_cbvs[] : register(b3, space0);
 
 Texture2D<float4> g_textures[] : register(t0, space0);
 StructuredBuffer<TransformBuffer> g_buffers[] : register(t0, space1);
+StructuredBuffer<CPUMaterialCBVData> g_materials[] : register(t0, space2); // RenderableManager material buffer at materialsIndex
 
 SamplerState g_samplers[] : register(s0, space0);
 
+float3 OctDecode(float2 e)
+{
+    float3 n = float3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += (1.0 - 2.0 * step(0.0, n.xy)) * t;
+    return normalize(n);
+}
+
+// Half texcoords need no decode, the input assembler widens R16G16_FLOAT.
+VertexShaderInput DecodeVertex(VertexShaderInput input)
+{
+    if (vertexFormat & VERTEX_POSITION_UNORM16)
+        input.position = positionMin + input.position * positionExtent;
+    if (vertexFormat & VERTEX_NORMAL_OCT16)
+        input.normal = OctDecode(input.normal.xy);
+    if (vertexFormat & VERTEX_TANGENT_OCT16)
+        input.tangent = float4(OctDecode(input.tangent.xy), input.tangent.z < 0.0 ? -1.0 : 1.0);
+    return input;
+}
+
 PSInput VSMain(VertexShaderInput input)
 {
     PSInput result;
+    input = DecodeVertex(input);
     TransformBuffer t = g_buffers[transformsIndex][transformIndex];
     
     float4x4 MVrP = mul(t.modelMatrix, viewReverseProjMatrix);
@@ -75,6 +111,7 @@ PSInput VSMain(VertexShaderInput input)
     result.worldTangent = mul(input.tangent.xyz, (float3x3) t.modelMatrix);
     result.worldNormal = mul(input.normal, (float3x3) t.modelMatrix);
     result.tangent = input.tangent;
+    result.color = input.color;
     // Convert to NDC
     //float4 ndcPosition = result.position / result.position.w;
     //float4 ndcPrevPosition = mul(float4(input.position, 1.0), prevModelMatrix);
@@ -101,7 +138,7 @@ struct PSOutput
 PSOutput PSMain(PSInput input)
 {
     PSOutput output;
-    CPUMaterialCBVData cbvMat = g_cbvs[materialIndex];
+    CPUMaterialCBVData cbvMat = g_materials[materialsIndex][materialIndex];
     Texture2D<float4> diffuseTex = g_textures[cbvMat.diffuseEmissiveNormalOcclusionTexSlots.x];
     Texture2D<float4> emissiveTex = g_textures[cbvMat.diffuseEmissiveNormalOcclusionTexSlots.y];
     Texture2D<float4> normalTex = g_textures[cbvMat.diffuseEmissiveNormalOcclusionTexSlots.z];
@@ -119,7 +156,7 @@ PSOutput PSMain(PSInput input)
     float roughnessFactor = cbvMat.normalScaleOcclusionStrengthMRFactors.w;
     float metallicFactor = cbvMat.normalScaleOcclusionStrengthMRFactors.z;
     
-    float4 diffuse = diffuseTex.Sample(diffuseSam, input.texcoords) * cbvMat.baseColorFactor;
+    float4 diffuse = diffuseTex.Sample(diffuseSam, input.texcoords) * cbvMat.baseColorFactor * input.color;
     float4 emissive = emissiveTex.Sample(emissiveSam, input.texcoords) * cbvMat.emissiveFactor;
     
     float3 normal = normalTex.Sample(normalSam, input.texcoords).rgb;
@@ -22,7 +22,7 @@ cbuffer camera : register(b0)
 };
 cbuffer globals : register(b1)
 {
-    uint transformsIndex, screenX, screenY, unsued;
+    uint transformsIndex, screenX, screenY, materialsIndex;
 };
 
 Texture2D<float4> albedoBuffer : register(t0); // Albedo G-buffer
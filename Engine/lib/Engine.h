@@ -7,6 +7,7 @@
 #include "systems/stream/StreamingSystem.h"
 
 #include "scene/Scene.h"
+#include "scene/prefab/Prefab.h"
 
 #include "Keyboard.h"
 #include "Mouse.h"
@@ -25,7 +26,7 @@ namespace Engine {
 			m_inputSystem.initialize(m_scene);
 			m_renderSystem.initialize(m_scene, m_useWarpDevice, hwnd, m_width, m_height);
 			m_streamSystem.initialize(m_scene, m_renderSystem.getDirectQueue(), &m_taskScheduler);
-			m_scene.initialize(m_renderSystem.getDirectQueue(), m_renderSystem.getComputeQueue());
+			m_scene.initialize(m_renderSystem.getDirectQueue(), m_renderSystem.getComputeQueue(), m_renderSystem.getBindlessHeap());
 			//test
 			auto camera = m_scene.entityManager.createEntity();
 			auto componentCamera = ECS::Component::ComponentCamera{};
@@ -29,6 +29,22 @@ namespace Engine::ECS {
 			(addComponent(entity, std::forward<Components>(components)), ...);
 		}
 
+		// Creates count entities with their components in a single command, for prefabs and other bulk spawns.
+		// A std::vector argument holds one value per entity, any other argument is shared by all of them.
+		// Returns the first id; the entities are first .. first + count - 1 once the command has run.
+		template<typename... Components>
+		Entity createEntities(uint32_t count, Components&&... components) {
+			Entity first = m_nextEntityId.fetch_add(count, std::memory_order_seq_cst);
+			m_commandQueue.push([first, count, values = std::make_tuple(std::decay_t<Components>(std::forward<Components>(components))...)](entt::basic_registry<Entity>& registry) mutable {
+				std::vector<Entity> entities(count);
+				for (uint32_t i = 0; i < count; i++) {
+					entities[i] = registry.create(first + i);
+				}
+				std::apply([&](auto&... value) { (insertComponents(registry, entities, value), ...); }, values);
+				});
+			return first;
+		}
+
 		template<typename... Components>
 		void removeComponent(Entity entity) {
 			m_commandQueue.push([entity](entt::basic_registry<Entity>& registry) {
@@ -59,6 +75,16 @@ namespace Engine::ECS {
 		entt::basic_registry<Entity> m_registry;
 
 
+		template<typename Component>
+		static void insertComponents(entt::basic_registry<Entity>& registry, const std::vector<Entity>& entities, std::vector<Component>& values) {
+			registry.insert<Component>(entities.begin(), entities.end(), values.begin());
+		}
+
+		template<typename Component>
+		static void insertComponents(entt::basic_registry<Entity>& registry, const std::vector<Entity>& entities, Component& value) {
+			registry.insert<Component>(entities.begin(), entities.end(), value);
+		}
+
 		template<typename Component>
 		void addComponent(Entity entity, Component&& component) {
 			using T = std::decay_t<Component>;
@@ -283,6 +283,16 @@ namespace Engine::Helpers {
 		case DXGI_FORMAT_R10G10B10A2_UNORM:    return 4;
 		case DXGI_FORMAT_R11G11B10_FLOAT:      return 4;
 		case DXGI_FORMAT_R8G8_UNORM:           return 2;
+		case DXGI_FORMAT_R16_UINT:             return 2;
+		case DXGI_FORMAT_R16G16B16A16_UNORM:   return 8;
+		case DXGI_FORMAT_R16G16B16A16_SNORM:   return 8;
+		case DXGI_FORMAT_R16G16_UNORM:         return 4;
+		case DXGI_FORMAT_R16G16_SNORM:         return 4;
+		case DXGI_FORMAT_R16G16_UINT:          return 4;
+		case DXGI_FORMAT_R8G8B8A8_SNORM:       return 4;
+		case DXGI_FORMAT_R8G8_UINT:            return 2;
+		case DXGI_FORMAT_R8G8_SNORM:           return 2;
+		case DXGI_FORMAT_R8_UINT:              return 1;
 			// Add more as needed...
 
 		default:
@@ -4,6 +4,7 @@
 #include "../ecs/EntityManager.h"
 #include "graph/SceneGraph.h"
 #include "assets/AssetManager.h"
+#include "raycast/Raycaster.h"
 #include "../systems/render/managers/ResourceManager.h"
 #include "../systems/render/managers/RenderableManager.h"
 #include "../systems/render/memory/pools/HeapPool.h"
@@ -18,17 +19,19 @@ namespace Engine::Scene {
 	constexpr uint64_t MB64 = 64 * 1024 * 1024;
 
 	struct Scene {
-		void initialize(Render::Queue::DirectQueue& directQueue, Render::Queue::ComputeQueue& computeQueue) {
+		void initialize(Render::Queue::DirectQueue& directQueue, Render::Queue::ComputeQueue& computeQueue, Render::Descriptor::BindlessHeapDescriptor* bindlessHeap) {
 			attDefaultHeapPool.initialize(D3D12_HEAP_TYPE_DEFAULT, MB64, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS, &resourceManager);
 			indDefaultHeapPool.initialize(D3D12_HEAP_TYPE_DEFAULT, MB64, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS, &resourceManager);
 			skiDefaultHeapPool.initialize(D3D12_HEAP_TYPE_DEFAULT, MB64, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS, &resourceManager);
 
 			uploadHeapPool.initialize(D3D12_HEAP_TYPE_UPLOAD, MB64, D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES, &resourceManager);
-			renderableManager.initialize(directQueue);
+			renderableManager.initialize(directQueue, bindlessHeap);
+			raycaster.initialize(&entityManager, &assetManager);
 		}
 		ECS::EntityManager entityManager;
 		SceneGraph sceneGraph;
 		AssetManager assetManager;
+		Raycaster raycaster;
 		Render::Manager::ResourceManager resourceManager;
 		Render::Manager::RenderableManager renderableManager;
 		Render::Memory::HeapPool attDefaultHeapPool;
@@ -35,6 +35,17 @@ namespace Engine::Scene {
             return id;
         }
 
+        // Content store payloads are shared by every mesh that references them: the first reference registers the payload
+        // as a mesh of its own, later ones get the same id, so it is streamed and kept on the GPU once.
+        Asset::MeshId registerPayload(uint64_t payloadHash, const std::filesystem::path& path, const System::Streaming::PakArchive* pak = nullptr) {
+            std::lock_guard lock(m_payloadMutex);
+            auto itt = m_payloadMeshIds.find(payloadHash);
+            if (itt != m_payloadMeshIds.end()) return itt->second;
+            auto id = registerMesh(Asset::UsageMesh::Static, Asset::SourceMesh::File, Asset::FileSourceMesh{ path, pak });
+            m_payloadMeshIds.emplace(payloadHash, id);
+            return id;
+        }
+
         Asset::MaterialId registerMaterial(Asset::UsageMaterial usage, Asset::SourceMaterial source, Asset::MaterialSourceData sourceData) {
             auto id = generateMaterialAssetId();
             auto meshMaterialValue = std::make_shared<Asset::MaterialMapValue>();
@@ -42,10 +53,11 @@ namespace Engine::Scene {
             meshMaterialValue->source = source;
             meshMaterialValue->sourceData = sourceData;
 
-            m_materialAssetMap.emplace(id, std::move(meshMaterialValue));
+            auto& asset = m_materialAssetMap.emplace(id, std::move(meshMaterialValue)).first->second;
             
             Asset::MaterialAssetEvent event{};
             event.id = id;
+            event.asset = asset.get();
             event.oldStatus = Asset::Status::Unknown;
             event.newStatus = Asset::Status::Unknown;
             event.type = Asset::IAssetEvent::Type::Registered;
@@ -135,6 +147,9 @@ namespace Engine::Scene {
         tbb::concurrent_unordered_map<Asset::MaterialId, std::shared_ptr<Asset::MaterialMapValue>> m_materialAssetMap;
         tbb::concurrent_unordered_map<Asset::MaterialInstanceId, std::shared_ptr<Asset::MaterialInstanceMapValue>> m_materialInstanceAssetMap;
 
+        std::mutex m_payloadMutex;
+        std::unordered_map<uint64_t, Asset::MeshId> m_payloadMeshIds;
+
         std::vector<Asset::MeshAssetEventCallback> m_meshSubscribers;
         std::vector<Asset::MaterialAssetEventCallback> m_materialSubscribers;
         std::vector<Asset::MaterialInstanceAssetEventCallback> m_materialInstanceSubscribers;
@@ -6,6 +6,10 @@
 #include "material/AssetMaterial.h"
 #include <Structures.h>
 
+namespace Engine::System::Streaming {
+	class PakArchive;
+}
+
 namespace Engine::Scene::Asset {
 	enum class Type {
 		Mesh,
@@ -31,7 +35,8 @@ namespace Engine::Scene::Asset {
 	};
 
 	struct FileSourceMesh {
-		std::filesystem::path path;
+		std::filesystem::path path; // entry id when pak is set
+		const System::Streaming::PakArchive* pak = nullptr;
 	};
 	struct ProceduralSourceMesh {
 		//
@@ -40,6 +45,8 @@ namespace Engine::Scene::Asset {
 
 	struct FileMeshAdditionalData {
 		AssetsCreator::Asset::File::MeshAsset file;
+		uint64_t fileOffset = 0; // of the asset inside its pak, header offsets are relative to it
+		std::array<D3D12_GPU_VIRTUAL_ADDRESS, 3> sectionGpuVirtualAddresses{}; // by File::Section, set by GpuUploadPlanner; the draw table is relative to them
 	};
 	struct ProceduraMeshAdditionalData {
 	};
@@ -59,7 +66,9 @@ namespace Engine::Scene::Asset {
 		EngineInternal,
 	};
 	struct FileSourceMaterial {
-		std::filesystem::path path;
+		std::filesystem::path path; // .mesh.asset holding the material table, entry id when pak is set
+		uint32_t materialIndex = 0;
+		const System::Streaming::PakArchive* pak = nullptr;
 	};
 	struct ProceduralSourceMaterial {
 		//
@@ -135,6 +144,7 @@ namespace Engine::Scene::Asset {
 	};
 	struct MaterialAssetEvent : public IAssetEvent {
 		MaterialId id;
+		MaterialMapValue* asset;
 	};
 	struct MaterialInstanceAssetEvent : public IAssetEvent {
 		MaterialInstanceId id;
@@ -6,6 +6,7 @@
 #include "../../../systems/render/memory/Heap.h"
 #include "../../../systems/render/RenderStructures.h"
 #include "../../../structures.h"
+#include "../material/AssetMaterial.h"
 
 namespace Engine::Scene::Asset {
 	struct CpuAttributeData {
@@ -36,17 +37,50 @@ namespace Engine::Scene::Asset {
 		uint64_t totalGPUSizeInBytes;
 	};
 
+	// Cluster of a submesh: an index range with a bounding sphere and a backface normal cone.
+	// Culled when dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff.
+	struct Meshlet {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		DX::XMFLOAT4 sphere; // center + radius
+		DX::XMFLOAT3 coneApex;
+		DX::XMFLOAT3 coneAxis;
+		float coneCutoff;
+	};
+
+	// Index range of one detail level in the submesh index buffer; error is the object space distance to LOD0.
+	struct Lod {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error;
+	};
+
 	struct SubMesh {
 		std::string name;
+		// Procedural meshes; cooked files are drawn from their draw table (File::DrawEntry) and leave these empty.
 		CpuDataSubMesh cpuData;
 		GpuDataSubMesh gpuData;
 		D3D_PRIMITIVE_TOPOLOGY topology;
 		Structures::AABB aabb;
+		std::vector<Meshlet> meshlets;
+		std::vector<Lod> lods; // LOD0 first
+		uint32_t materialIndex = 0; // into Mesh::materials
+		std::optional<uint64_t> payloadMeshId; // content store payload holding the data, drawn with the payload's draw entry once it is Ready
+	};
+
+	// Material cooked into the mesh file; textures name .texture.asset files next to it, empty keeps the default texture.
+	struct MeshMaterial {
+		TypePBRMaterialData data;
+		std::array<std::string, 5> textures; // CPUMaterialCBVData slot order: diffuse, emissive, normal, occlusion, metallic-roughness
+		Structures::AlphaMode alphaMode = Structures::AlphaMode::Opaque;
+		float alphaCutoff = 0.5f;
+		bool doubleSided = false;
 	};
 
 	struct Mesh {
 		std::string name;
 		std::vector<SubMesh> subMeshes;
+		std::vector<MeshMaterial> materials; // in file order, so the table can be uploaded as one buffer
 		uint64_t totalCPUIndicesSizeInBytes;
 		uint64_t totalGPUIndicesSizeInBytes;
 		uint64_t totalCPUAttributesSizeInBytes;
@@ -0,0 +1,69 @@
+#include "stdafx.h"
+
+#pragma once
+
+#include <AssetReader.h>
+
+#include "../Scene.h"
+#include "../../systems/stream/PakArchive.h"
+
+namespace Engine::Scene {
+	// Meshes and entities created for one placement of a .scene.asset.
+	struct PrefabInstance {
+		struct InstanceList {
+			Asset::MeshId meshId;
+			ECS::Entity firstEntity; // firstEntity .. firstEntity + count - 1
+			uint32_t count;
+		};
+		std::vector<InstanceList> instanceLists;
+	};
+
+	// Places a cooked scene in one go: every referenced mesh is registered once and each of its instance lists becomes
+	// one bulk entity creation, instead of an asset registration and an entity command per node.
+	class Prefab {
+	public:
+		// With a pak, path is the scene's id inside it and the meshes are streamed from the same pak.
+		static PrefabInstance Instantiate(Scene& scene, const std::filesystem::path& path, const ECS::Component::ComponentTransform& root,
+			Asset::UsageMesh usage = Asset::UsageMesh::Static, const System::Streaming::PakArchive* pak = nullptr) {
+			auto file = pak ? pak->readScene(path) : AssetsCreator::Asset::AssetReader::ReadScene(path);
+
+			DX::XMMATRIX rootMatrix = ToMatrix(DX::XMLoadFloat4(&root.scale), DX::XMLoadFloat4(&root.rotation), DX::XMLoadFloat4(&root.position));
+
+			PrefabInstance prefabInstance;
+			prefabInstance.instanceLists.reserve(file->meshes.size());
+			for (auto& mesh : file->meshes) {
+				if (!mesh.instanceCount) continue;
+				auto meshPath = path.parent_path() / (std::string(mesh.id) + ".mesh.asset");
+				auto meshId = scene.assetManager.registerMesh(usage, Asset::SourceMesh::File, Asset::FileSourceMesh{ meshPath, pak });
+
+				std::vector<ECS::Component::ComponentTransform> transforms(mesh.instanceCount);
+				for (uint32_t i = 0; i < mesh.instanceCount; i++) {
+					auto& instance = file->instances.at(static_cast<size_t>(mesh.instanceIndex) + i);
+					DX::XMMATRIX world = DX::XMMatrixMultiply(ToMatrix(
+						DX::XMVectorSet(instance.scale[0], instance.scale[1], instance.scale[2], 1.f),
+						DX::XMVectorSet(instance.rotation[0], instance.rotation[1], instance.rotation[2], instance.rotation[3]),
+						DX::XMVectorSet(instance.translation[0], instance.translation[1], instance.translation[2], 1.f)), rootMatrix);
+
+					DX::XMVECTOR scale, rotation, translation;
+					DX::XMMatrixDecompose(&scale, &rotation, &translation, world);
+					auto& transform = transforms[i];
+					DX::XMStoreFloat4(&transform.position, DX::XMVectorSetW(translation, 1.f));
+					DX::XMStoreFloat4(&transform.rotation, rotation);
+					DX::XMStoreFloat4(&transform.scale, DX::XMVectorSetW(scale, 1.f));
+				}
+
+				auto componentMesh = ECS::Component::ComponentMesh{};
+				componentMesh.assetId = meshId;
+				auto firstEntity = scene.entityManager.createEntities(mesh.instanceCount, std::move(transforms), componentMesh, ECS::Component::ComponentTransformDirty{});
+				prefabInstance.instanceLists.push_back({ meshId, firstEntity, mesh.instanceCount });
+			}
+			return prefabInstance;
+		}
+
+	private:
+		static DX::XMMATRIX ToMatrix(DX::FXMVECTOR scale, DX::FXMVECTOR rotation, DX::FXMVECTOR translation) {
+			return DX::XMMatrixMultiply(DX::XMMatrixMultiply(DX::XMMatrixScalingFromVector(scale), DX::XMMatrixRotationQuaternion(rotation)),
+				DX::XMMatrixTranslationFromVector(translation));
+		}
+	};
+}
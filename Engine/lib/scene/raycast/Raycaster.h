@@ -0,0 +1,247 @@
+#include "stdafx.h"
+
+#pragma once
+
+#include <AssetReader.h>
+
+#include "../../ecs/EntityManager.h"
+#include "../assets/AssetManager.h"
+#include "../../systems/stream/PakArchive.h"
+
+namespace Engine::Scene {
+	struct Ray {
+		DX::XMFLOAT3 origin;
+		DX::XMFLOAT3 direction; // any length
+		float maxDistance = FLT_MAX;
+	};
+
+	struct RaycastHit {
+		ECS::Entity entity;
+		Asset::MeshId meshId;
+		uint32_t submeshIndex;
+		uint32_t triangleIndex; // in the submesh's LOD0
+		float distance; // world units along the ray
+		DX::XMFLOAT3 position; // world space
+		DX::XMFLOAT2 barycentrics; // weights of the triangle's second and third vertex
+	};
+
+	// Ray queries against every entity with ComponentMesh and ComponentTransform, for picking and line of sight.
+	// Rays are moved into mesh space and traverse the cooked BVH (.mesh.asset BVH section), which is read the first time
+	// a Ready mesh is queried and kept afterwards. Meshes cooked without a BVH or not Ready yet are skipped.
+	class Raycaster {
+	public:
+		void initialize(ECS::EntityManager* entityManager, AssetManager* assetManager) {
+			m_entityManager = entityManager;
+			m_assetManager = assetManager;
+		}
+
+		// Closest hit. Reads the registry, so call it where the other systems do (not while commands are processed).
+		std::optional<RaycastHit> raycast(const Ray& ray) {
+			std::optional<RaycastHit> closest;
+			forEachCandidate(ray, [&](const Candidate& candidate) {
+				if (traverse(candidate, false)) {
+					closest = candidate.hit;
+				}
+				return true;
+				});
+			return closest;
+		}
+
+		// True when something is between from and to; stops at the first triangle found.
+		bool isOccluded(const DX::XMFLOAT3& from, const DX::XMFLOAT3& to) {
+			DX::XMVECTOR delta = DX::XMVectorSubtract(DX::XMLoadFloat3(&to), DX::XMLoadFloat3(&from));
+			Ray ray{ from, {}, DX::XMVectorGetX(DX::XMVector3Length(delta)) };
+			DX::XMStoreFloat3(&ray.direction, delta);
+
+			bool occluded = false;
+			forEachCandidate(ray, [&](const Candidate& candidate) {
+				occluded = traverse(candidate, true);
+				return !occluded;
+				});
+			return occluded;
+		}
+
+		// Drops the cached BVH, e.g. after the mesh was unloaded or recooked.
+		void evict(Asset::MeshId meshId) {
+			std::lock_guard lock(m_bvhMutex);
+			m_bvhs.erase(meshId);
+		}
+
+	private:
+		using Bvh = AssetsCreator::Asset::File::MeshBvh;
+
+		// One entity's ray in mesh space; hit keeps the closest result across candidates.
+		struct Candidate {
+			const Bvh* bvh;
+			DX::XMVECTOR origin;
+			DX::XMVECTOR direction;
+			DX::XMVECTOR inverseDirection;
+			DX::XMMATRIX world;
+			mutable float maxT;
+			mutable RaycastHit hit;
+		};
+
+		template<typename F>
+		void forEachCandidate(const Ray& ray, F&& visit) {
+			DX::XMVECTOR worldDirection = DX::XMLoadFloat3(&ray.direction);
+			if (DX::XMVector3Equal(worldDirection, DX::XMVectorZero())) return;
+			worldDirection = DX::XMVector3Normalize(worldDirection);
+			DX::XMVECTOR worldOrigin = DX::XMLoadFloat3(&ray.origin);
+
+			Candidate candidate{};
+			candidate.maxT = ray.maxDistance;
+			auto& registry = m_entityManager->getRegistry();
+			const auto& group = registry.group_if_exists<ECS::Component::ComponentMesh>(entt::get<ECS::Component::ComponentTransform>);
+			for (const auto& [entity, mesh, transform] : group.each()) {
+				auto bvh = getBvh(mesh.assetId);
+				if (!bvh || bvh->nodes.empty()) continue;
+
+				DX::XMMATRIX world = DX::XMMatrixMultiply(DX::XMMatrixScalingFromVector(DX::XMLoadFloat4(&transform.scale)),
+					DX::XMMatrixMultiply(DX::XMMatrixRotationQuaternion(DX::XMLoadFloat4(&transform.rotation)),
+						DX::XMMatrixTranslationFromVector(DX::XMLoadFloat4(&transform.position))));
+				DX::XMVECTOR determinant;
+				DX::XMMATRIX inverse = DX::XMMatrixInverse(&determinant, world);
+				if (DX::XMVectorGetX(determinant) == 0.f) continue;
+
+				// the mesh space direction is not normalized, so t stays the world distance
+				candidate.bvh = bvh.get();
+				candidate.world = world;
+				candidate.origin = DX::XMVector3TransformCoord(worldOrigin, inverse);
+				candidate.direction = DX::XMVector3TransformNormal(worldDirection, inverse);
+				// axis aligned rays would give 0 * inf in the slab test
+				candidate.inverseDirection = DX::XMVectorReciprocal(DX::XMVectorSelect(candidate.direction, DX::XMVectorReplicate(1e-30f),
+					DX::XMVectorEqual(candidate.direction, DX::XMVectorZero())));
+				candidate.hit.entity = entity;
+				candidate.hit.meshId = mesh.assetId;
+				if (!visit(candidate)) return;
+			}
+		}
+
+		// Near child first with a small stack, spilled to the heap for trees deeper than it; returns true when the candidate's hit was replaced (or anything hit for anyHit).
+		static bool traverse(const Candidate& candidate, bool anyHit) {
+			auto& nodes = candidate.bvh->nodes;
+			auto& triangles = candidate.bvh->triangles;
+			bool found = false;
+
+			float rootNear;
+			if (!intersectBox(candidate, nodes[0], rootNear)) return false;
+
+			uint32_t stack[64];
+			uint32_t stackSize = 0;
+			std::vector<uint32_t> overflow; // only grows while stack is full, so popping it first keeps the order
+			uint32_t nodeIndex = 0;
+			while (true) {
+				auto& node = nodes[nodeIndex];
+				if (node.triangleCount) {
+					for (uint32_t t = node.rightChildOrFirstTriangle; t < node.rightChildOrFirstTriangle + node.triangleCount; t++) {
+						float distance, u, v;
+						if (!intersectTriangle(candidate, triangles[t], distance, u, v)) continue;
+						candidate.maxT = distance;
+						candidate.hit.submeshIndex = triangles[t].submeshIndex;
+						candidate.hit.triangleIndex = triangles[t].triangleIndex;
+						candidate.hit.distance = distance;
+						candidate.hit.barycentrics = { u, v };
+						found = true;
+						if (anyHit) return true;
+					}
+				}
+				else {
+					uint32_t nearChild = nodeIndex + 1, farChild = node.rightChildOrFirstTriangle;
+					float nearT, farT;
+					bool hitNear = intersectBox(candidate, nodes[nearChild], nearT);
+					bool hitFar = intersectBox(candidate, nodes[farChild], farT);
+					if (hitNear && hitFar) {
+						if (farT < nearT) std::swap(nearChild, farChild);
+						if (stackSize < std::size(stack)) stack[stackSize++] = farChild;
+						else overflow.push_back(farChild);
+						nodeIndex = nearChild;
+						continue;
+					}
+					if (hitNear || hitFar) {
+						nodeIndex = hitNear ? nearChild : farChild;
+						continue;
+					}
+				}
+				if (!overflow.empty()) {
+					nodeIndex = overflow.back();
+					overflow.pop_back();
+					continue;
+				}
+				if (!stackSize) break;
+				nodeIndex = stack[--stackSize];
+			}
+
+			if (found) {
+				DX::XMVECTOR local = DX::XMVectorMultiplyAdd(candidate.direction, DX::XMVectorReplicate(candidate.hit.distance), candidate.origin);
+				DX::XMStoreFloat3(&candidate.hit.position, DX::XMVector3TransformCoord(local, candidate.world));
+			}
+			return found;
+		}
+
+		// Slab test on all three axes at once; misses boxes beyond the current closest hit.
+		static bool intersectBox(const Candidate& candidate, const AssetsCreator::Asset::File::BvhNodeEntry& node, float& tNear) {
+			DX::XMVECTOR boxMin = DX::XMLoadFloat3(reinterpret_cast<const DX::XMFLOAT3*>(node.aabbMin));
+			DX::XMVECTOR boxMax = DX::XMLoadFloat3(reinterpret_cast<const DX::XMFLOAT3*>(node.aabbMax));
+			DX::XMVECTOR t0 = DX::XMVectorMultiply(DX::XMVectorSubtract(boxMin, candidate.origin), candidate.inverseDirection);
+			DX::XMVECTOR t1 = DX::XMVectorMultiply(DX::XMVectorSubtract(boxMax, candidate.origin), candidate.inverseDirection);
+			DX::XMVECTOR tMin = DX::XMVectorMin(t0, t1);
+			DX::XMVECTOR tMax = DX::XMVectorMax(t0, t1);
+			float enter = std::max({ DX::XMVectorGetX(tMin), DX::XMVectorGetY(tMin), DX::XMVectorGetZ(tMin), 0.f });
+			float exit = std::min({ DX::XMVectorGetX(tMax), DX::XMVectorGetY(tMax), DX::XMVectorGetZ(tMax), candidate.maxT });
+			tNear = enter;
+			return enter <= exit;
+		}
+
+		// Möller-Trumbore, both faces.
+		static bool intersectTriangle(const Candidate& candidate, const AssetsCreator::Asset::File::BvhTriangleEntry& triangle, float& distance, float& u, float& v) {
+			DX::XMVECTOR edge1 = DX::XMLoadFloat3(reinterpret_cast<const DX::XMFLOAT3*>(triangle.edge1));
+			DX::XMVECTOR edge2 = DX::XMLoadFloat3(reinterpret_cast<const DX::XMFLOAT3*>(triangle.edge2));
+			DX::XMVECTOR p = DX::XMVector3Cross(candidate.direction, edge2);
+			float determinant = DX::XMVectorGetX(DX::XMVector3Dot(edge1, p));
+			if (std::fabs(determinant) < 1e-12f) return false;
+			float inverse = 1.f / determinant;
+
+			DX::XMVECTOR s = DX::XMVectorSubtract(candidate.origin, DX::XMLoadFloat3(reinterpret_cast<const DX::XMFLOAT3*>(triangle.v0)));
+			u = DX::XMVectorGetX(DX::XMVector3Dot(s, p)) * inverse;
+			if (u < 0.f || u > 1.f) return false;
+			DX::XMVECTOR q = DX::XMVector3Cross(s, edge1);
+			v = DX::XMVectorGetX(DX::XMVector3Dot(candidate.direction, q)) * inverse;
+			if (v < 0.f || u + v > 1.f) return false;
+			distance = DX::XMVectorGetX(DX::XMVector3Dot(edge2, q)) * inverse;
+			return distance >= 0.f && distance < candidate.maxT;
+		}
+
+		// nullptr until the mesh is Ready; an empty BVH is cached for meshes cooked without one or with a corrupt one.
+		std::shared_ptr<const Bvh> getBvh(Asset::MeshId meshId) {
+			{
+				std::lock_guard lock(m_bvhMutex);
+				auto itt = m_bvhs.find(meshId);
+				if (itt != m_bvhs.end()) return itt->second;
+			}
+
+			auto* asset = m_assetManager->getMeshAsset(meshId);
+			if (asset->status.load(std::memory_order_acquire) != Asset::Status::Ready || asset->source != Asset::SourceMesh::File) return nullptr;
+			auto& sourceData = std::get<Asset::FileSourceMesh>(asset->sourceData);
+			auto& file = std::get<Asset::FileMeshAdditionalData>(asset->additionalData).file;
+			std::shared_ptr<const Bvh> bvh;
+			try {
+				bvh = std::make_shared<const Bvh>(sourceData.pak
+					? sourceData.pak->readBvh(sourceData.path, file)
+					: AssetsCreator::Asset::AssetReader::ReadBvh(sourceData.path, file));
+			}
+			catch (const std::exception& e) {
+				// a corrupt BVH makes the mesh unpickable instead of returning wrong hits
+				std::osyncstream(std::cout) << e.what() << "\n";
+				bvh = std::make_shared<const Bvh>();
+			}
+
+			std::lock_guard lock(m_bvhMutex);
+			return m_bvhs.emplace(meshId, std::move(bvh)).first->second;
+		}
+
+		ECS::EntityManager* m_entityManager = nullptr;
+		AssetManager* m_assetManager = nullptr;
+		std::mutex m_bvhMutex;
+		std::unordered_map<Asset::MeshId, std::shared_ptr<const Bvh>> m_bvhs;
+	};
+}
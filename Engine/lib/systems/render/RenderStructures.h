@@ -10,5 +10,7 @@ namespace Engine::Render {
 		uint32_t typeIndex;
 		DXGI_FORMAT format;
 		uint64_t sizeInBytes;
+		uint32_t strideInBytes = 0; // 0 - GetFormatStride(format)
+		uint32_t elementOffset = 0; // inside the vertex of an interleaved stream
 	};
 }
@@ -60,6 +60,7 @@ namespace Engine::System {
 			globals.screenX = m_width;
 			globals.screenY = m_height;
 			globals.transformsIndex = m_transfromMatrixManager.getBindlessSlot();
+			globals.materialsIndex = m_scene->renderableManager.getMaterialsBindlessSlot();
 
 			auto* cameraResource = m_cameraManager.update();
 			auto* transformResource = m_transfromMatrixManager.update();
@@ -121,6 +122,9 @@ namespace Engine::System {
 		Render::Queue::DirectQueue& getDirectQueue() {
 			return m_directCommandQueue;
 		}
+		Render::Descriptor::BindlessHeapDescriptor* getBindlessHeap() {
+			return &m_bindlessHeap;
+		}
 	private:
 		inline static const UINT FrameCount = 2;
 		Scene::Scene* m_scene;
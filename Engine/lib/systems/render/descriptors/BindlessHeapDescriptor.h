@@ -86,6 +86,13 @@ namespace Engine::Render::Descriptor {
 		}
 	};
 
+	// Bindless slots of the default PBR textures and their samplers, in MeshMaterial::textures order:
+	// diffuse, emissive, normal, occlusion, metallic-roughness.
+	struct DefaultPBRSlots {
+		std::array<uint32_t, 5> textures;
+		std::array<uint32_t, 5> samplers;
+	};
+
 	class BindlessHeapDescriptor {
 	public:
 		BindlessHeapDescriptor() {
@@ -121,17 +128,21 @@ namespace Engine::Render::Descriptor {
 
 
 			m_defaultPBRTextures = Helpers::CreateDefaultPBRTextures(m_device.Get());
-			this->addTexture(m_defaultPBRTextures.baseColor);
-			this->addTexture(m_defaultPBRTextures.emissive);
-			this->addTexture(m_defaultPBRTextures.metallicRoughness);
-			this->addTexture(m_defaultPBRTextures.normal);
-			this->addTexture(m_defaultPBRTextures.occlusion);
-
-			this->addSampler(GetSamplerDescForTexture(Structures::TextureType::BASE_COLOR));
-			this->addSampler(GetSamplerDescForTexture(Structures::TextureType::EMISSIVE));
-			this->addSampler(GetSamplerDescForTexture(Structures::TextureType::METALLIC_ROUGHNESS));
-			this->addSampler(GetSamplerDescForTexture(Structures::TextureType::NORMAL));
-			this->addSampler(GetSamplerDescForTexture(Structures::TextureType::OCCLUSION));
+			m_defaultPBRSlots.textures[0] = this->addTexture(m_defaultPBRTextures.baseColor);
+			m_defaultPBRSlots.textures[1] = this->addTexture(m_defaultPBRTextures.emissive);
+			m_defaultPBRSlots.textures[4] = this->addTexture(m_defaultPBRTextures.metallicRoughness);
+			m_defaultPBRSlots.textures[2] = this->addTexture(m_defaultPBRTextures.normal);
+			m_defaultPBRSlots.textures[3] = this->addTexture(m_defaultPBRTextures.occlusion);
+
+			m_defaultPBRSlots.samplers[0] = this->addSampler(GetSamplerDescForTexture(Structures::TextureType::BASE_COLOR));
+			m_defaultPBRSlots.samplers[1] = this->addSampler(GetSamplerDescForTexture(Structures::TextureType::EMISSIVE));
+			m_defaultPBRSlots.samplers[4] = this->addSampler(GetSamplerDescForTexture(Structures::TextureType::METALLIC_ROUGHNESS));
+			m_defaultPBRSlots.samplers[2] = this->addSampler(GetSamplerDescForTexture(Structures::TextureType::NORMAL));
+			m_defaultPBRSlots.samplers[3] = this->addSampler(GetSamplerDescForTexture(Structures::TextureType::OCCLUSION));
+		}
+
+		const DefaultPBRSlots& getDefaultPBRSlots() const {
+			return m_defaultPBRSlots;
 		}
 
 		uint32_t addTexture(WPtr<ID3D12Resource> texture) {
@@ -340,6 +351,7 @@ namespace Engine::Render::Descriptor {
 		std::mutex m_srv;
 
 		Helpers::DefaultPBRTextures m_defaultPBRTextures;
+		DefaultPBRSlots m_defaultPBRSlots{};
 
 		WPtr<ID3D12Resource> m_dummyResource;
 	};
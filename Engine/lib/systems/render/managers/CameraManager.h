@@ -22,6 +22,8 @@ namespace Engine::Render::Manager {
 			auto group = registry.group_if_exists<ECS::Component::ComponentCamera>(entt::get<ECS::Component::ComponentTransform>);
 			for (const auto& [entity, camera, transform] : group.each()) {
 				if (camera.isMain) {
+					m_mainCamera = camera;
+					m_mainCameraPosition = DX::XMFLOAT3(transform.position.x, transform.position.y, transform.position.z);
 					ECS::Class::ClassCamera classCamera(camera, transform);
 					auto cameraData = classCamera.getCameraData();
 					m_resource->writeDataD(cameraData.get(), 0, sizeof(ECS::Class::ClassCamera::CameraData));
@@ -31,9 +33,19 @@ namespace Engine::Render::Manager {
 
 			return m_resource.get();
 		}
+
+		// Main camera as of the last update(), used on the CPU for LOD selection.
+		const ECS::Component::ComponentCamera& getMainCamera() const {
+			return m_mainCamera;
+		}
+		const DX::XMFLOAT3& getMainCameraPosition() const {
+			return m_mainCameraPosition;
+		}
 	private:
 		Scene::Scene* m_scene;
 		std::unique_ptr<Render::Memory::Resource> m_resource;
+		ECS::Component::ComponentCamera m_mainCamera{ DX::XM_PIDIV4, 0.1f, 1000.f, 1.f, true };
+		DX::XMFLOAT3 m_mainCameraPosition{ 0.f, 0.f, 0.f };
 
 		void createCameraBuffer() {
 			m_resource = Render::Memory::Resource::Create(D3D12_HEAP_TYPE_GPU_UPLOAD, sizeof(ECS::Class::ClassCamera::CameraData));
@@ -13,7 +13,7 @@ namespace Engine::Render::Manager {
 	class GlobalsManager {
 	public:
 		struct Globals {
-			uint32_t transformsIndex, screenX, screenY, unsued;
+			uint32_t transformsIndex, screenX, screenY, materialsIndex;
 		};
 		void initialize(Scene::Scene* scene) {
 			m_scene = scene;
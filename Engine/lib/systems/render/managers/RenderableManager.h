@@ -7,17 +7,22 @@
 #include "../../../helpers.h"
 #include "../queus/DirectQueue.h"
 #include "../Device.h"
+#include "../descriptors/BindlessHeapDescriptor.h"
 #include "./RenderableManagerStructures.h"
 
 
 namespace Engine::Render::Manager {
 	class RenderableManager {
+		static constexpr size_t MATERIAL_SIZE = sizeof(GpuMaterial);
+		static constexpr uint64_t MATERIAL_COUNT = 16384;
+		static constexpr size_t MATERIALS_RESOURCE_SIZE = (MATERIAL_COUNT * MATERIAL_SIZE + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1);
 	public:
 		RenderableManager() {
 			m_meshRenderables.reserve(2ULL << 10);
 			m_meshIdRenderablePosition.reserve(2ULL << 10);
 		}
-		void initialize(Queue::DirectQueue& directQueue) {
+		void initialize(Queue::DirectQueue& directQueue, Descriptor::BindlessHeapDescriptor* bindlessHeap) {
+			createMaterialsResource(bindlessHeap);
 			auto* device = Device::GetDevice();
 			WPtr<ID3D12GraphicsCommandList> commandList;
 			WPtr<ID3D12CommandAllocator> commandAllocator;
@@ -70,14 +75,79 @@ namespace Engine::Render::Manager {
 			}
 			CloseHandle(fenceEvent);
 		}
+		// Cooked meshes: the draw entries already hold the views relative to each section, so a submesh is one copy plus
+		// the section base addresses; streams the submesh does not have keep the default attribute.
+		void addCookedMesh(Scene::Asset::MeshId meshId, const Scene::Asset::Mesh& mesh, std::span<const CookedDraw> draws) {
+			using namespace AssetsCreator::Asset;
+			static_assert(sizeof(File::LodEntry) == sizeof(RenderableLod));
+			struct StreamView {
+				D3D12_VERTEX_BUFFER_VIEW RenderableSubMesh::* view;
+				std::optional<AttributeType> fallback; // default attribute, POSITION and SURFACE have none
+			};
+			// by DrawStream; the skinning streams have no view until a skinning pass reads them
+			static constexpr std::array<StreamView, static_cast<uint32_t>(File::DrawStream::COUNT)> streamViews = { {
+				{ &RenderableSubMesh::position, std::nullopt }, { &RenderableSubMesh::normal, AttributeType::NORMAL },
+				{ &RenderableSubMesh::texcoord, AttributeType::TEXCOORD }, { &RenderableSubMesh::tangent, AttributeType::TANGENT },
+				{ &RenderableSubMesh::surface, std::nullopt }, { nullptr, std::nullopt }, { nullptr, std::nullopt },
+				{ &RenderableSubMesh::color, AttributeType::COLOR },
+			} };
+
+			RenderableMesh renderableMesh{.meshId = meshId};
+			renderableMesh.subMeshes.reserve(draws.size());
+			auto materialsBase = uploadMaterials(mesh.materials);
+			for (uint32_t d = 0; d < draws.size(); d++) {
+				auto& draw = draws[d];
+				auto& entry = *draw.entry;
+				auto& renderableSubMesh = renderableMesh.subMeshes.emplace_back();
+				renderableSubMesh.materialIndex = getMaterialIndex(mesh, materialsBase, mesh.subMeshes.at(d).materialIndex);
+				for (uint32_t i = 0; i < streamViews.size(); i++) {
+					if (!streamViews[i].view) continue;
+					auto& view = renderableSubMesh.*streamViews[i].view;
+					auto& stream = entry.streams[i];
+					if (stream.sizeInBytes) {
+						view.BufferLocation = draw.sectionGpuVirtualAddresses[static_cast<uint32_t>(File::Section::ATTRIBUTE)] + stream.offset;
+						view.SizeInBytes = stream.sizeInBytes;
+						view.StrideInBytes = stream.strideInBytes;
+					}
+					else if (streamViews[i].fallback) {
+						view = m_defaultAttributes[static_cast<uint64_t>(*streamViews[i].fallback)].second;
+					}
+				}
+				renderableSubMesh.colorFormat = entry.colorFormat != DXGI_FORMAT_UNKNOWN
+					? entry.colorFormat : m_defaultAttributes[static_cast<uint64_t>(AttributeType::COLOR)].first.attribute.format;
+
+				renderableSubMesh.index.BufferLocation = draw.sectionGpuVirtualAddresses[static_cast<uint32_t>(File::Section::INDEX)] + entry.indexOffset;
+				renderableSubMesh.index.SizeInBytes = entry.indexSizeInBytes;
+				renderableSubMesh.index.Format = entry.indexFormat;
+				renderableSubMesh.indexCount = entry.indexCount;
+				renderableSubMesh.vertexFormat = entry.vertexFormat;
+				renderableSubMesh.aabb.min = DX::XMVectorSet(entry.aabbMin[0], entry.aabbMin[1], entry.aabbMin[2], 0);
+				renderableSubMesh.aabb.max = DX::XMVectorSet(entry.aabbMax[0], entry.aabbMax[1], entry.aabbMax[2], 0);
+				renderableSubMesh.positionMin = DX::XMFLOAT3(entry.aabbMin);
+				renderableSubMesh.positionExtent = DX::XMFLOAT3(entry.aabbMax[0] - entry.aabbMin[0], entry.aabbMax[1] - entry.aabbMin[1], entry.aabbMax[2] - entry.aabbMin[2]);
+				uint32_t lodCount = entry.lodCount;
+				renderableSubMesh.lodCount = std::clamp(lodCount, 1u, MAX_LOD_COUNT);
+				std::memcpy(renderableSubMesh.lods.data(), entry.lods, sizeof(entry.lods));
+			}
+			addRenderableMesh(meshId, std::move(renderableMesh));
+		}
+
 		void addMeshAsset(Scene::Asset::MeshId meshId, Scene::Asset::Mesh& mesh) {
 			RenderableMesh renderableMesh{.meshId = meshId};
+			auto materialsBase = uploadMaterials(mesh.materials);
 
 			for (auto& submesh : mesh.subMeshes) {
 				RenderableSubMesh renderableSubMesh{};
+				renderableSubMesh.materialIndex = getMaterialIndex(mesh, materialsBase, submesh.materialIndex);
 				renderableSubMesh.normal = m_defaultAttributes[static_cast<uint64_t>(AssetsCreator::Asset::AttributeType::NORMAL)].second;
 				renderableSubMesh.tangent = m_defaultAttributes[static_cast<uint64_t>(AssetsCreator::Asset::AttributeType::TANGENT)].second;
 				renderableSubMesh.texcoord = m_defaultAttributes[static_cast<uint64_t>(AssetsCreator::Asset::AttributeType::TEXCOORD)].second;
+				auto setDefault = [&](AssetsCreator::Asset::AttributeType type, D3D12_VERTEX_BUFFER_VIEW& view, DXGI_FORMAT& format) {
+					auto& defaultAttribute = m_defaultAttributes[static_cast<uint64_t>(type)];
+					view = defaultAttribute.second;
+					format = defaultAttribute.first.attribute.format;
+					};
+				setDefault(AssetsCreator::Asset::AttributeType::COLOR, renderableSubMesh.color, renderableSubMesh.colorFormat);
 				D3D12_INDEX_BUFFER_VIEW indexView{};
 				indexView.BufferLocation = *submesh.gpuData.indexGpuVirtualAddress;
 				indexView.Format = submesh.gpuData.indicesFormat;
@@ -87,37 +157,68 @@ namespace Engine::Render::Manager {
 				renderableSubMesh.index = std::move(indexView);
 				renderableSubMesh.indexCount = submesh.gpuData.indicesSizeInBytes / Helpers::GetFormatStride(submesh.gpuData.indicesFormat);
 				renderableSubMesh.aabb = submesh.aabb;
+				DX::XMStoreFloat3(&renderableSubMesh.positionMin, submesh.aabb.min);
+				DX::XMStoreFloat3(&renderableSubMesh.positionExtent, DX::XMVectorSubtract(submesh.aabb.max, submesh.aabb.min));
+
+				if (submesh.lods.empty()) {
+					renderableSubMesh.lods[0] = { 0, static_cast<uint32_t>(renderableSubMesh.indexCount), 0.f };
+					renderableSubMesh.lodCount = 1;
+				}
+				for (auto& lod : submesh.lods) {
+					if (renderableSubMesh.lodCount == MAX_LOD_COUNT) break;
+					renderableSubMesh.lods[renderableSubMesh.lodCount++] = { lod.firstIndex, lod.indexCount, lod.error };
+				}
 
 				for (auto& att : submesh.gpuData.attributes) {
 					D3D12_VERTEX_BUFFER_VIEW view{};
 					view.BufferLocation = *att.gpuVirtualAddress;
 					view.SizeInBytes = static_cast<uint32_t>(att.attribute.sizeInBytes);
-					view.StrideInBytes = Helpers::GetFormatStride(att.attribute.format);
+					view.StrideInBytes = att.attribute.strideInBytes ? att.attribute.strideInBytes : Helpers::GetFormatStride(att.attribute.format);
+					// normal/texcoord/tangent elements of one interleaved stream share a view, bound once in slot 1
+					bool interleaved = view.StrideInBytes != Helpers::GetFormatStride(att.attribute.format) || att.attribute.elementOffset != 0;
 
 					if (att.attribute.typeIndex == 0) {
 						switch (att.attribute.type) {
 						case AssetsCreator::Asset::AttributeType::POSITION:
 							renderableSubMesh.position = std::move(view);
+							if (att.attribute.format == DXGI_FORMAT_R16G16B16A16_UNORM) renderableSubMesh.vertexFormat |= VERTEX_POSITION_UNORM16;
 							break;
 						case AssetsCreator::Asset::AttributeType::NORMAL:
-							renderableSubMesh.normal = std::move(view);
+							if (interleaved) {
+								renderableSubMesh.surface = view;
+								renderableSubMesh.vertexFormat |= VERTEX_INTERLEAVED;
+							}
+							else renderableSubMesh.normal = std::move(view);
+							if (att.attribute.format == DXGI_FORMAT_R16G16_SNORM) renderableSubMesh.vertexFormat |= VERTEX_NORMAL_OCT16;
 							break;
 						case AssetsCreator::Asset::AttributeType::TEXCOORD:
-							renderableSubMesh.texcoord = std::move(view);
+							if (interleaved) {
+								renderableSubMesh.surface = view;
+								renderableSubMesh.vertexFormat |= VERTEX_INTERLEAVED;
+							}
+							else renderableSubMesh.texcoord = std::move(view);
+							if (att.attribute.format == DXGI_FORMAT_R16G16_FLOAT) renderableSubMesh.vertexFormat |= VERTEX_TEXCOORD_HALF;
 							break;
 						case AssetsCreator::Asset::AttributeType::TANGENT:
-							renderableSubMesh.tangent = std::move(view);
+							if (interleaved) {
+								renderableSubMesh.surface = view;
+								renderableSubMesh.vertexFormat |= VERTEX_INTERLEAVED;
+							}
+							else renderableSubMesh.tangent = std::move(view);
+							if (att.attribute.format == DXGI_FORMAT_R16G16B16A16_SNORM) renderableSubMesh.vertexFormat |= VERTEX_TANGENT_OCT16;
+							break;
+						case AssetsCreator::Asset::AttributeType::COLOR:
+							renderableSubMesh.color = std::move(view);
+							renderableSubMesh.colorFormat = att.attribute.format;
+							break;
+						default:
 							break;
 						}
 					}
 				}
 				renderableMesh.subMeshes.push_back(renderableSubMesh);
 			}
-			auto index = meshCount.fetch_add(1, std::memory_order_relaxed);
-			if (index >= m_meshRenderables.size())
-				m_meshRenderables.grow_to_at_least(index + 1);
-			m_meshRenderables[index] = std::move(renderableMesh);
-			m_meshIdRenderablePosition[meshId] = index;
+			addRenderableMesh(meshId, std::move(renderableMesh));
 		}
 		tbb::concurrent_vector<RenderableMesh>& getMeshRenderables() {
 			return m_meshRenderables;
@@ -128,6 +229,10 @@ namespace Engine::Render::Manager {
 			if (itt == m_meshIdRenderablePosition.end()) return std::nullopt;
 			return itt->second;
 		}
+
+		uint32_t getMaterialsBindlessSlot() {
+			return m_materialsBindlessSlot;
+		}
 	private:
 		tbb::concurrent_vector<RenderableMesh> m_meshRenderables;
 		tbb::concurrent_unordered_map<Scene::Asset::MeshId, size_t> m_meshIdRenderablePosition;
@@ -136,6 +241,82 @@ namespace Engine::Render::Manager {
 		std::vector<std::pair<Scene::Asset::CpuAttributeData, D3D12_VERTEX_BUFFER_VIEW>> m_defaultAttributes = GenerateGLTFDefaultCPUAttributes();
 		std::unique_ptr<Memory::Resource> m_resource;
 
+		std::unique_ptr<Memory::Resource> m_materialsResource;
+		std::atomic<size_t> m_materialCount{ 0 };
+		uint32_t m_materialsBindlessSlot = 0;
+		Descriptor::DefaultPBRSlots m_defaultPBRSlots{};
+
+		// Entry 0 is the default material, drawn by submeshes without one.
+		void createMaterialsResource(Descriptor::BindlessHeapDescriptor* bindlessHeap) {
+			m_defaultPBRSlots = bindlessHeap->getDefaultPBRSlots();
+			m_materialsResource = Memory::Resource::Create(D3D12_HEAP_TYPE_GPU_UPLOAD, MATERIALS_RESOURCE_SIZE);
+
+			D3D12_SHADER_RESOURCE_VIEW_DESC desc{};
+			desc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+			desc.Format = DXGI_FORMAT_UNKNOWN;
+			desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+			desc.Buffer.NumElements = MATERIAL_COUNT;
+			desc.Buffer.StructureByteStride = MATERIAL_SIZE;
+			desc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+			m_materialsBindlessSlot = bindlessHeap->addSrv(m_materialsResource.get(), desc);
+
+			uploadMaterials(std::vector<Scene::Asset::MeshMaterial>(1));
+		}
+
+		// Writes a mesh's material table in one range and returns the index of its first entry.
+		// Textures stay on the default slots until material textures are streamed.
+		uint32_t uploadMaterials(const std::vector<Scene::Asset::MeshMaterial>& materials) {
+			if (materials.empty()) return 0;
+			auto base = m_materialCount.fetch_add(materials.size(), std::memory_order_relaxed);
+			if (base + materials.size() > MATERIAL_COUNT) throw std::runtime_error("[RenderableManager] too many materials");
+
+			std::vector<GpuMaterial> gpuMaterials(materials.size());
+			for (size_t i = 0; i < materials.size(); i++) {
+				auto& gpuMaterial = gpuMaterials[i];
+				gpuMaterial.factors = materials[i].data;
+				gpuMaterial.textureSlots = { m_defaultPBRSlots.textures[0], m_defaultPBRSlots.textures[1], m_defaultPBRSlots.textures[2], m_defaultPBRSlots.textures[3] };
+				gpuMaterial.mrTextureSlot = { m_defaultPBRSlots.textures[4], 0, 0, 0 };
+				gpuMaterial.samplerSlots = { m_defaultPBRSlots.samplers[0], m_defaultPBRSlots.samplers[1], m_defaultPBRSlots.samplers[2], m_defaultPBRSlots.samplers[3] };
+				gpuMaterial.mrSamplerSlot = { m_defaultPBRSlots.samplers[4], 0, 0, 0 };
+			}
+			m_materialsResource->writeDataD(gpuMaterials.data(), base * MATERIAL_SIZE, gpuMaterials.size() * MATERIAL_SIZE);
+			return static_cast<uint32_t>(base);
+		}
+
+		static uint32_t getMaterialIndex(const Scene::Asset::Mesh& mesh, uint32_t materialsBase, uint32_t materialIndex) {
+			return materialIndex < mesh.materials.size() ? materialsBase + materialIndex : 0;
+		}
+
+		// Mesh level LOD errors and bounds from the finished submeshes, then publishes the mesh.
+		void addRenderableMesh(Scene::Asset::MeshId meshId, RenderableMesh&& renderableMesh) {
+			auto meshMin = DX::XMVectorReplicate(FLT_MAX);
+			auto meshMax = DX::XMVectorReplicate(-FLT_MAX);
+			for (auto& renderableSubMesh : renderableMesh.subMeshes) {
+				// every published submesh has at least LOD0, the whole index buffer when nothing else was cooked
+				if (renderableSubMesh.lodCount == 0) {
+					renderableSubMesh.lods[0] = { 0, static_cast<uint32_t>(renderableSubMesh.indexCount), 0.f };
+					renderableSubMesh.lodCount = 1;
+				}
+				for (uint32_t i = 0; i < MAX_LOD_COUNT; i++) {
+					auto& lod = renderableSubMesh.lods[std::min(i, renderableSubMesh.lodCount - 1)];
+					renderableMesh.lodErrors[i] = std::max(renderableMesh.lodErrors[i], lod.error);
+				}
+				renderableMesh.lodCount = std::max(renderableMesh.lodCount, renderableSubMesh.lodCount);
+				meshMin = DX::XMVectorMin(meshMin, renderableSubMesh.aabb.min);
+				meshMax = DX::XMVectorMax(meshMax, renderableSubMesh.aabb.max);
+			}
+			if (!renderableMesh.subMeshes.empty()) {
+				auto center = DX::XMVectorScale(DX::XMVectorAdd(meshMin, meshMax), 0.5f);
+				auto radius = DX::XMVector3Length(DX::XMVectorSubtract(meshMax, center));
+				DX::XMStoreFloat4(&renderableMesh.boundingSphere, DX::XMVectorSelect(radius, center, DX::g_XMSelect1110));
+			}
+			auto index = meshCount.fetch_add(1, std::memory_order_relaxed);
+			if (index >= m_meshRenderables.size())
+				m_meshRenderables.grow_to_at_least(index + 1);
+			m_meshRenderables[index] = std::move(renderableMesh);
+			m_meshIdRenderablePosition[meshId] = index;
+		}
+
 		static std::vector<std::pair<Scene::Asset::CpuAttributeData, D3D12_VERTEX_BUFFER_VIEW>> GenerateGLTFDefaultCPUAttributes() {
 			using namespace AssetsCreator::Asset;
 
@@ -154,9 +335,10 @@ namespace Engine::Render::Manager {
 					data.emplace(sizeInBytes);
 					std::memcpy(data->data(), defaultRawData, sizeInBytes);
 				}
+				// stride 0: every vertex of a submesh without the stream fetches the one default element
 				D3D12_VERTEX_BUFFER_VIEW view{};
 				view.SizeInBytes = static_cast<uint32_t>(sizeInBytes);
-				view.StrideInBytes = Helpers::GetFormatStride(format);
+				view.StrideInBytes = 0;
 
 				attributes.push_back(std::pair{ Scene::Asset::CpuAttributeData{ attr, std::move(data) }, view });
 				};
@@ -178,11 +360,11 @@ namespace Engine::Render::Manager {
 			const uint8_t joints[4] = { 0, 0, 0, 0 };
 			add(AttributeType::JOINT, 0, DXGI_FORMAT_R8G8B8A8_UINT, sizeof(joints), joints);
 
-			const float weights[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-			add(AttributeType::WEIGHT, 0, DXGI_FORMAT_R32G32B32A32_FLOAT, sizeof(weights), weights);
+			const uint8_t weights[4] = { 0, 0, 0, 0 };
+			add(AttributeType::WEIGHT, 0, DXGI_FORMAT_R8G8B8A8_UNORM, sizeof(weights), weights);
 
-			const float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-			add(AttributeType::COLOR, 0, DXGI_FORMAT_R32G32B32A32_FLOAT, sizeof(color), color);
+			const uint8_t color[4] = { 255, 255, 255, 255 };
+			add(AttributeType::COLOR, 0, DXGI_FORMAT_R8G8B8A8_UNORM, sizeof(color), color);
 
 			return attributes;
 		}
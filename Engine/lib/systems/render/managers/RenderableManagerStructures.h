@@ -13,17 +13,72 @@ namespace Engine::Render::Manager {
 	//	{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 2, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 	//	{ "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 3, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 	//};
+	// Quantized vertex streams, selects the input layout and the decode path in gbuffers.hlsl (keep in sync with VERTEX_* there).
+	enum VertexFormatFlags : uint32_t {
+		VERTEX_FORMAT_FLOAT = 0,
+		VERTEX_POSITION_UNORM16 = 1 << 0, // R16G16B16A16_UNORM relative to the submesh AABB
+		VERTEX_NORMAL_OCT16 = 1 << 1, // R16G16_SNORM octahedral
+		VERTEX_TEXCOORD_HALF = 1 << 2, // R16G16_FLOAT
+		VERTEX_TANGENT_OCT16 = 1 << 3, // R16G16B16A16_SNORM octahedral xy + handedness in z
+		VERTEX_INTERLEAVED = 1 << 4, // normal, texcoord and tangent packed in one stream (input slot 1), layout only
+	};
+
+	constexpr uint32_t MAX_LOD_COUNT = 5; // MeshSimplifier::MAX_LOD_COUNT
+
+	// The cooked draw table (File::DrawEntry) is written with the same values.
+	static_assert(VERTEX_POSITION_UNORM16 == AssetsCreator::Asset::File::DRAW_POSITION_UNORM16);
+	static_assert(VERTEX_NORMAL_OCT16 == AssetsCreator::Asset::File::DRAW_NORMAL_OCT16);
+	static_assert(VERTEX_TEXCOORD_HALF == AssetsCreator::Asset::File::DRAW_TEXCOORD_HALF);
+	static_assert(VERTEX_TANGENT_OCT16 == AssetsCreator::Asset::File::DRAW_TANGENT_OCT16);
+	static_assert(VERTEX_INTERLEAVED == AssetsCreator::Asset::File::DRAW_INTERLEAVED);
+	static_assert(MAX_LOD_COUNT == AssetsCreator::Asset::File::DRAW_MAX_LOD_COUNT);
+
+	struct RenderableLod {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error; // object space
+	};
+
 	struct RenderableSubMesh {
 		D3D12_VERTEX_BUFFER_VIEW position;
 		D3D12_VERTEX_BUFFER_VIEW normal;
 		D3D12_VERTEX_BUFFER_VIEW texcoord;
 		D3D12_VERTEX_BUFFER_VIEW tangent;
+		D3D12_VERTEX_BUFFER_VIEW surface; // VERTEX_INTERLEAVED: normal/texcoord/tangent, position stays a tight stream for depth-only passes
+		// COLOR_0 keeps the source component type, the format picks the GBuffer input layout element (GBufferPass::EnumKey).
+		// Joints and weights stay in the draw table until a skinning pass reads them.
+		D3D12_VERTEX_BUFFER_VIEW color;
+		DXGI_FORMAT colorFormat;
 		D3D12_INDEX_BUFFER_VIEW index;
 		uint64_t indexCount;
 		Structures::AABB aabb;
+		uint32_t vertexFormat = VERTEX_FORMAT_FLOAT;
+		DX::XMFLOAT3 positionMin; // dequantization range of VERTEX_POSITION_UNORM16
+		DX::XMFLOAT3 positionExtent;
+		std::array<RenderableLod, MAX_LOD_COUNT> lods; // a mesh LOD past lodCount draws the last one
+		uint32_t lodCount = 0;
+		uint32_t materialIndex = 0; // into the material buffer, 0 is the default material
+	};
+	// One entry of the material buffer, laid out as CPUMaterialCBVData in gbuffers.hlsl.
+	struct GpuMaterial {
+		Scene::Asset::TypePBRMaterialData factors;
+		std::array<uint32_t, 4> textureSlots; // diffuse, emissive, normal, occlusion
+		std::array<uint32_t, 4> mrTextureSlot; // x only
+		std::array<uint32_t, 4> samplerSlots;
+		std::array<uint32_t, 4> mrSamplerSlot;
+	};
+	static_assert(sizeof(GpuMaterial) == 112);
+
+	// A submesh's cooked draw entry with the GPU addresses of the sections its offsets are relative to.
+	struct CookedDraw {
+		const AssetsCreator::Asset::File::DrawEntry* entry;
+		std::array<D3D12_GPU_VIRTUAL_ADDRESS, 3> sectionGpuVirtualAddresses; // by File::Section
 	};
 	struct RenderableMesh {
 		Scene::Asset::MeshId meshId;
 		std::vector<RenderableSubMesh> subMeshes;
+		std::array<float, MAX_LOD_COUNT> lodErrors{}; // worst submesh error per level
+		uint32_t lodCount = 1;
+		DX::XMFLOAT4 boundingSphere; // object space center + radius
 	};
 }
\ No newline at end of file
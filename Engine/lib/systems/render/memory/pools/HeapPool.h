@@ -51,7 +51,12 @@ namespace Engine::Render::Memory {
 			return std::nullopt;
 		}
 		void deallocate(AllocateResult res) {
-
+			std::lock_guard lock(m_allocateMutex);
+			auto itt = m_heaps.find(res.heapId);
+			if (itt == m_heaps.end()) {
+				throw std::runtime_error("[HeapPool] Unknown heap " + std::to_string(res.heapId));
+			}
+			itt->second.removePlacedResource(res.resourceHandle);
 		}
 	private:
 		Manager::ResourceManager* m_resourceManager;
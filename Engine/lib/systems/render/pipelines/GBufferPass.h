@@ -6,6 +6,7 @@
 #include "../memory/Resource.h"
 #include "../managers/CameraManager.h"
 #include "../managers/TransformMatrixManager.h"
+#include "../managers/RenderableManagerStructures.h"
 #include "../descriptors/BindlessHeapDescriptor.h"
 #include "../../../ecs/components/ComponentMesh.h"
 #include "../../../ecs/components/ComponentTransform.h"
@@ -19,18 +20,37 @@ namespace Engine::Render::Pipeline {
 		struct EnumKey {
 			D3D12_CULL_MODE cullMode;
 			D3D12_PRIMITIVE_TOPOLOGY_TYPE topology;
+			uint32_t vertexFormat = Manager::VERTEX_FORMAT_FLOAT;
+			DXGI_FORMAT colorFormat = DXGI_FORMAT_R8G8B8A8_UNORM; // COLOR_0 keeps its source type, the default color is RGBA8
 
 			bool operator==(const EnumKey& other) const {
-				return cullMode == other.cullMode && topology == other.topology;
+				return cullMode == other.cullMode && topology == other.topology && vertexFormat == other.vertexFormat && colorFormat == other.colorFormat;
 			}
 		};
 
 		struct EnumKeyHash {
 			std::size_t operator()(const EnumKey& key) const {
 				return std::hash<int>()(static_cast<int>(key.cullMode)) ^
-					(std::hash<int>()(static_cast<int>(key.topology)) << 1);
+					(std::hash<int>()(static_cast<int>(key.topology)) << 1) ^
+					(std::hash<uint32_t>()(key.vertexFormat) << 2) ^
+					(std::hash<int>()(static_cast<int>(key.colorFormat)) << 3);
 			}
 		};
+
+		// b2 layout in gbuffers.hlsl
+		struct MeshConstants {
+			uint32_t transformIndex;
+			uint32_t materialIndex;
+			uint32_t vertexFormat;
+			uint32_t unused0;
+			DX::XMFLOAT3 positionMin;
+			float unused1;
+			DX::XMFLOAT3 positionExtent;
+		};
+		static constexpr uint32_t MESH_CONSTANTS_COUNT = sizeof(MeshConstants) / sizeof(uint32_t);
+
+		static constexpr float LOD_PIXEL_ERROR = 1.f; // allowed projected error in pixels
+		static constexpr float LOD_HYSTERESIS = 0.25f; // switch coarser below 75%, finer above 125% of LOD_PIXEL_ERROR
 	public:
 		GBufferPass(ID3D12Device* device, UINT width, UINT height,
 			Descriptor::BindlessHeapDescriptor* bindlessHeap, Scene::Scene* scene, Manager::CameraManager* cameraManager, Manager::TransformMatrixManager* transfromMatrixManager
@@ -97,7 +117,8 @@ namespace Engine::Render::Pipeline {
 				rtvHandle.Offset(1, rtvDescriptorSize);
 			}
 			m_commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 0.0f, 0, 0, nullptr);
-			m_commandList->SetPipelineState(getPso({ D3D12_CULL_MODE::D3D12_CULL_MODE_NONE, D3D12_PRIMITIVE_TOPOLOGY_TYPE::D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE }));
+			EnumKey psoKey{ D3D12_CULL_MODE::D3D12_CULL_MODE_NONE, D3D12_PRIMITIVE_TOPOLOGY_TYPE::D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE, Manager::VERTEX_FORMAT_FLOAT };
+			m_commandList->SetPipelineState(getPso(psoKey));
 			m_commandList->IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY::D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 			auto& entityManager = m_scene->entityManager;
@@ -111,16 +132,45 @@ namespace Engine::Render::Pipeline {
 				auto renderableId = renderableManager.getMeshRenderableId(mesh.assetId);
 				if (renderableId && transformPosition) {
 					auto& renderable = meshRenderables[renderableId.value()];
-					uint32_t data[2] = { static_cast<uint32_t>(transformPosition.value()), 0 };
-					m_commandList->SetGraphicsRoot32BitConstants(2, 2, data, 0);
+					auto previousLod = m_entityLods.find(entity);
+					uint32_t meshLod = selectLod(renderable, transform, previousLod != m_entityLods.end() ? previousLod->second : 0);
+					m_nextEntityLods.emplace(entity, meshLod);
+					MeshConstants constants{};
+					constants.transformIndex = static_cast<uint32_t>(transformPosition.value());
 					for (auto& sub : renderable.subMeshes) {
-						D3D12_VERTEX_BUFFER_VIEW vbv[] = { sub.position, sub.normal, sub.texcoord, sub.tangent };
-						m_commandList->IASetVertexBuffers(0, std::size(vbv), vbv);
+						if (sub.vertexFormat != psoKey.vertexFormat || sub.colorFormat != psoKey.colorFormat) {
+							psoKey.vertexFormat = sub.vertexFormat;
+							psoKey.colorFormat = sub.colorFormat;
+							m_commandList->SetPipelineState(getPso(psoKey));
+						}
+						constants.materialIndex = sub.materialIndex;
+						constants.vertexFormat = sub.vertexFormat;
+						constants.positionMin = sub.positionMin;
+						constants.positionExtent = sub.positionExtent;
+						m_commandList->SetGraphicsRoot32BitConstants(2, MESH_CONSTANTS_COUNT, &constants, 0);
+
+						if (sub.vertexFormat & Manager::VERTEX_INTERLEAVED) {
+							D3D12_VERTEX_BUFFER_VIEW vbv[] = { sub.position, sub.surface, sub.color };
+							m_commandList->IASetVertexBuffers(0, std::size(vbv), vbv);
+						}
+						else {
+							D3D12_VERTEX_BUFFER_VIEW vbv[] = { sub.position, sub.normal, sub.texcoord, sub.tangent, sub.color };
+							m_commandList->IASetVertexBuffers(0, std::size(vbv), vbv);
+						}
 						m_commandList->IASetIndexBuffer(&sub.index);
-						m_commandList->DrawIndexedInstanced(static_cast<uint32_t>(sub.indexCount), 1, 0, 0, 0);
+						if (sub.lodCount) {
+							auto& lod = sub.lods[std::min(meshLod, sub.lodCount - 1)];
+							m_commandList->DrawIndexedInstanced(lod.indexCount, 1, lod.firstIndex, 0, 0);
+						}
+						else {
+							m_commandList->DrawIndexedInstanced(static_cast<uint32_t>(sub.indexCount), 1, 0, 0, 0);
+						}
 					}
 				}
 			}
+			// instances that were not drawn this frame drop their level
+			std::swap(m_entityLods, m_nextEntityLods);
+			m_nextEntityLods.clear();
 
 			ThrowIfFailed(m_commandList->Close());
 
@@ -175,6 +225,29 @@ namespace Engine::Render::Pipeline {
 			return N_OF_RTVS;
 		}
 
+		// Projects every level's error to pixels at the bounding sphere's nearest point and moves at most as far as the thresholds allow,
+		// so an instance sitting on a boundary keeps its level instead of alternating every frame.
+		uint32_t selectLod(const Manager::RenderableMesh& renderable, const ECS::Component::ComponentTransform& transform, uint32_t current) const {
+			if (renderable.lodCount <= 1) return 0;
+
+			const auto& camera = m_cameraManager->getMainCamera();
+			const auto& cameraPosition = m_cameraManager->getMainCameraPosition();
+			float scale = std::max({ transform.scale.x, transform.scale.y, transform.scale.z });
+
+			auto localCenter = DX::XMVectorScale(DX::XMLoadFloat4(&renderable.boundingSphere), scale);
+			auto center = DX::XMVectorAdd(DX::XMLoadFloat4(&transform.position), DX::XMVector3Rotate(localCenter, DX::XMLoadFloat4(&transform.rotation)));
+			float distance = DX::XMVectorGetX(DX::XMVector3Length(DX::XMVectorSubtract(center, DX::XMLoadFloat3(&cameraPosition))));
+			distance = std::max(distance - renderable.boundingSphere.w * scale, camera.nearPlane);
+
+			float pixelsPerUnit = static_cast<float>(m_height) / (2.f * std::tan(camera.fov * 0.5f) * distance);
+			auto projected = [&](uint32_t lod) { return renderable.lodErrors[lod] * scale * pixelsPerUnit; };
+
+			uint32_t lod = std::min(current, renderable.lodCount - 1);
+			while (lod + 1 < renderable.lodCount && projected(lod + 1) <= LOD_PIXEL_ERROR * (1.f - LOD_HYSTERESIS)) lod++;
+			while (lod > 0 && projected(lod) > LOD_PIXEL_ERROR * (1.f + LOD_HYSTERESIS)) lod--;
+			return lod;
+		}
+
 		std::span<D3D12_CLEAR_VALUE> getRtvsClearValues() {
 			return std::span<D3D12_CLEAR_VALUE>(m_rtvClearValues);
 		}
@@ -313,8 +386,23 @@ namespace Engine::Render::Pipeline {
 			depthStencilDesc.DepthFunc = D3D12_COMPARISON_FUNC_GREATER;
 			depthStencilDesc.StencilEnable = FALSE;
 
+			D3D12_INPUT_ELEMENT_DESC inputElementDescs[_countof(m_inputElementDescs)];
+			std::copy(std::begin(m_inputElementDescs), std::end(m_inputElementDescs), inputElementDescs);
+			if (key.vertexFormat & Manager::VERTEX_POSITION_UNORM16) inputElementDescs[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+			if (key.vertexFormat & Manager::VERTEX_NORMAL_OCT16) inputElementDescs[1].Format = DXGI_FORMAT_R16G16_SNORM;
+			if (key.vertexFormat & Manager::VERTEX_TEXCOORD_HALF) inputElementDescs[2].Format = DXGI_FORMAT_R16G16_FLOAT;
+			if (key.vertexFormat & Manager::VERTEX_TANGENT_OCT16) inputElementDescs[3].Format = DXGI_FORMAT_R16G16B16A16_SNORM;
+			inputElementDescs[4].Format = key.colorFormat;
+			if (key.vertexFormat & Manager::VERTEX_INTERLEAVED) {
+				for (uint32_t i = 1; i < 4; i++) {
+					inputElementDescs[i].InputSlot = 1;
+					inputElementDescs[i].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+				}
+				inputElementDescs[4].InputSlot = 2;
+			}
+
 			D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
-			psoDesc.InputLayout = { m_inputElementDescs, _countof(m_inputElementDescs) };
+			psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
 
 
 			psoDesc.DepthStencilState = depthStencilDesc;
@@ -342,7 +430,7 @@ namespace Engine::Render::Pipeline {
 		}
 		void createRootSignature() {
 			// SRV ranges for bindless access
-			D3D12_DESCRIPTOR_RANGE srvDescriptorRanges[2] = {};
+			D3D12_DESCRIPTOR_RANGE srvDescriptorRanges[3] = {};
 
 			srvDescriptorRanges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
 			srvDescriptorRanges[0].NumDescriptors = Descriptor::N_SRV_DESCRIPTORS;
@@ -356,6 +444,12 @@ namespace Engine::Render::Pipeline {
 			srvDescriptorRanges[1].RegisterSpace = 1;
 			srvDescriptorRanges[1].OffsetInDescriptorsFromTableStart = 0;
 
+			srvDescriptorRanges[2].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+			srvDescriptorRanges[2].NumDescriptors = Descriptor::N_SRV_DESCRIPTORS;
+			srvDescriptorRanges[2].BaseShaderRegister = 0; // t0, space2: materials
+			srvDescriptorRanges[2].RegisterSpace = 2;
+			srvDescriptorRanges[2].OffsetInDescriptorsFromTableStart = 0;
+
 			// CBV range for bindless access (starts at b3)
 			D3D12_DESCRIPTOR_RANGE cbvDescriptorRange = {};
 			cbvDescriptorRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
@@ -389,13 +483,14 @@ namespace Engine::Render::Pipeline {
 			rootParameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
 			rootParameters[2].Constants.ShaderRegister = 2; // b2
 			rootParameters[2].Constants.RegisterSpace = 0;
-			rootParameters[2].Constants.Num32BitValues = 2;
+			rootParameters[2].Constants.Num32BitValues = MESH_CONSTANTS_COUNT;
 			rootParameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 
-			// Bindless descriptor table: SRVs (space0 + space1) + CBVs (b3+)
-			D3D12_DESCRIPTOR_RANGE allRanges[3] = {
+			// Bindless descriptor table: SRVs (space0 + space1 + space2) + CBVs (b3+)
+			D3D12_DESCRIPTOR_RANGE allRanges[4] = {
 				srvDescriptorRanges[0],
 				srvDescriptorRanges[1],
+				srvDescriptorRanges[2],
 				cbvDescriptorRange
 			};
 
@@ -462,12 +557,13 @@ namespace Engine::Render::Pipeline {
 		WPtr<ID3D12DescriptorHeap> m_rtvHeap;
 		ID3D12Device* m_device;
 		WPtr<ID3D12RootSignature> m_rootSignature;
-		D3D12_INPUT_ELEMENT_DESC m_inputElementDescs[4] =
+		D3D12_INPUT_ELEMENT_DESC m_inputElementDescs[5] =
 		{
 			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 			{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 			{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 2, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 			{ "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 3, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 4, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 		};
 
 		UINT m_width;
@@ -491,5 +587,9 @@ namespace Engine::Render::Pipeline {
 		Scene::Scene* m_scene;
 		Manager::CameraManager* m_cameraManager;
 		Manager::TransformMatrixManager* m_transfromMatrixManager;
+
+		// last selected LOD per instance, kept for the hysteresis; render-side so the pass only reads the ECS
+		std::unordered_map<entt::entity, uint32_t> m_entityLods;
+		std::unordered_map<entt::entity, uint32_t> m_nextEntityLods;
 	};
 }
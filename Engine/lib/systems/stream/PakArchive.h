@@ -0,0 +1,96 @@
+#include "stdafx.h"
+
+#pragma once
+
+#include <AssetReader.h>
+
+namespace Engine::System::Streaming {
+	// A mounted .pak: opened once for DirectStorage and mapped for the header reads, so loading an asset from it is a
+	// binary search of the mapped TOC instead of a file open. Requests address the asset by PakEntry::offset.
+	class PakArchive {
+	public:
+		PakArchive(const std::filesystem::path& path, IDStorageFactory* factory) : m_path(path) {
+			m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (m_file == INVALID_HANDLE_VALUE) {
+				throw std::runtime_error("[PakArchive] Can't open " + path.string());
+			}
+			LARGE_INTEGER size{};
+			GetFileSizeEx(m_file, &size);
+			m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_mapping) {
+				m_view = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			}
+			if (!m_view) {
+				close();
+				throw std::runtime_error("[PakArchive] Can't map " + path.string());
+			}
+			m_size = static_cast<uint64_t>(size.QuadPart);
+			try {
+				m_entries = AssetsCreator::Asset::AssetReader::ReadPakToc(m_view, m_size, path.string());
+				ThrowIfFailed(factory->OpenFile(path.c_str(), IID_PPV_ARGS(&m_storageFile)));
+			}
+			catch (...) {
+				close();
+				throw;
+			}
+		}
+		~PakArchive() {
+			close();
+		}
+		PakArchive(const PakArchive&) = delete;
+		PakArchive& operator=(const PakArchive&) = delete;
+
+		const AssetsCreator::Asset::File::PakEntry& find(const std::filesystem::path& id) const {
+			auto* entry = AssetsCreator::Asset::AssetReader::FindPakEntry(m_entries, id.generic_string());
+			if (!entry) {
+				throw std::runtime_error("[PakArchive] No " + id.generic_string() + " in " + m_path.string());
+			}
+			return *entry;
+		}
+
+		// verify hashes the asset's tables, and with verifySections its sections, straight from the mapping.
+		std::unique_ptr<AssetsCreator::Asset::File::MeshAsset> readMeshHeaders(const std::filesystem::path& id, bool verify = false, bool verifySections = true) const {
+			auto& entry = find(id);
+			AssetsCreator::Asset::MemoryStream stream(m_view + entry.offset, entry.sizeInBytes);
+			return AssetsCreator::Asset::AssetReader::ReadMeshHeaders(stream, id.generic_string(), verify, verifySections);
+		}
+
+		AssetsCreator::Asset::File::MeshBvh readBvh(const std::filesystem::path& id, const AssetsCreator::Asset::File::MeshAsset& meshAsset) const {
+			auto& entry = find(id);
+			AssetsCreator::Asset::MemoryStream stream(m_view + entry.offset, entry.sizeInBytes);
+			return AssetsCreator::Asset::AssetReader::ReadBvh(stream, meshAsset, id.generic_string());
+		}
+
+		std::unique_ptr<AssetsCreator::Asset::File::SceneAsset> readScene(const std::filesystem::path& id) const {
+			auto& entry = find(id);
+			AssetsCreator::Asset::MemoryStream stream(m_view + entry.offset, entry.sizeInBytes);
+			return AssetsCreator::Asset::AssetReader::ReadScene(stream, id.generic_string());
+		}
+
+		IDStorageFile* getStorageFile() const {
+			return m_storageFile.Get();
+		}
+
+		const std::filesystem::path& getPath() const {
+			return m_path;
+		}
+
+	private:
+		void close() {
+			if (m_view) UnmapViewOfFile(m_view);
+			if (m_mapping) CloseHandle(m_mapping);
+			if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+			m_view = nullptr;
+			m_mapping = nullptr;
+			m_file = INVALID_HANDLE_VALUE;
+		}
+
+		std::filesystem::path m_path;
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+		const uint8_t* m_view = nullptr;
+		uint64_t m_size = 0;
+		std::span<const AssetsCreator::Asset::File::PakEntry> m_entries;
+		WPtr<IDStorageFile> m_storageFile;
+	};
+}
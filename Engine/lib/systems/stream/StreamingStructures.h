@@ -23,11 +23,24 @@ namespace Engine::System::Streaming {
 		ID3D12Device* device;
 		ID3D12CommandQueue* commandQueue;
 		uint64_t fenceValue;
+		HANDLE fenceEvent = nullptr;
 		std::function<void()> finalize;
-		virtual ~Args() = default;
+		virtual ~Args() {
+			if (fenceEvent) CloseHandle(fenceEvent);
+		}
+
+		// Blocks until the last signaled fenceValue is reached, the same event wait the render managers use for their uploads.
+		void waitForFence() {
+			if (fence->GetCompletedValue() >= fenceValue) return;
+			ThrowIfFailed(fence->SetEventOnCompletion(fenceValue, fenceEvent));
+			WaitForSingleObject(fenceEvent, INFINITE);
+		}
 	};
 	struct MeshArgs : Args {
 		Scene::Asset::MeshAssetEvent event;
 		MeshGpuUploadPlan uploadPlan;
 	};
+	struct MaterialArgs : Args {
+		Scene::Asset::MaterialAssetEvent event;
+	};
 }
@@ -23,7 +23,17 @@ namespace Engine::System {
 			m_scene->assetManager.subscribeMesh([this](const Scene::Asset::MeshAssetEvent& event) {
 				subscribeMesh(event);
 				});
+			m_scene->assetManager.subscribeMaterial([this](const Scene::Asset::MaterialAssetEvent& event) {
+				subscribeMaterial(event);
+				});
 		};
+		// Assets of the returned pak are registered with FileSourceMesh{ <id inside the pak>, pak }.
+		const Streaming::PakArchive* mountPak(const std::filesystem::path& path) {
+			return m_streamingSystemArgs.mountPak(path);
+		}
+		void setVerifyChecksums(bool verify) {
+			m_streamingSystemArgs.setVerifyChecksums(verify);
+		}
 		void update(float dt) override {
 
 		};
@@ -41,21 +51,60 @@ namespace Engine::System {
 				args->device = m_device;
 				args->commandQueue = m_commandQueue;
 				m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&args->fence));
+				args->fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+				if (!args->fenceEvent) {
+					ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+				}
 				args->finalize = [this, streamingRequestId](){
-					this->m_streamingRequestsMap.erase(streamingRequestId);
+					this->eraseRequest(streamingRequestId);
 					};
 
-				m_streamingRequestsMap.emplace(streamingRequestId, std::move(args));
-
 				ftl::Task task{
 					.Function = Streaming::MetadataLoader::LoadMesh,
-					.ArgData = m_streamingRequestsMap[streamingRequestId].get(),
+					.ArgData = addRequest(streamingRequestId, std::move(args)),
 				};
 				
 				m_taskScheduler->AddTask(task, ftl::TaskPriority::Normal);
 			}
 		}
 
+		void subscribeMaterial(const Scene::Asset::MaterialAssetEvent& event) {
+			if (event.type == Scene::Asset::IAssetEvent::Type::Registered) {
+				auto streamingRequestId = m_nextStreamingRequestId.fetch_add(1, std::memory_order_relaxed);
+				auto args = std::make_unique<Streaming::MaterialArgs>();
+				args->event = event;
+				args->streamingSystemArgs = &m_streamingSystemArgs;
+				args->streamingRequestId = streamingRequestId;
+				args->finalize = [this, streamingRequestId]() {
+					this->eraseRequest(streamingRequestId);
+					};
+
+				ftl::Task task{
+					.Function = Streaming::MetadataLoader::LoadMaterial,
+					.ArgData = addRequest(streamingRequestId, std::move(args)),
+				};
+
+				m_taskScheduler->AddTask(task, ftl::TaskPriority::Normal);
+			}
+		}
+
+		// Requests are added on the registering thread and finalized on task threads.
+		Streaming::Args* addRequest(Streaming::StreamingRequestId id, std::unique_ptr<Streaming::Args> args) {
+			std::lock_guard lock(m_streamingRequestsMutex);
+			return m_streamingRequestsMap.emplace(id, std::move(args)).first->second.get();
+		}
+
+		// The request is destroyed outside the lock.
+		void eraseRequest(Streaming::StreamingRequestId id) {
+			std::unique_ptr<Streaming::Args> args;
+			{
+				std::lock_guard lock(m_streamingRequestsMutex);
+				auto node = m_streamingRequestsMap.extract(id);
+				if (node) args = std::move(node.mapped());
+			}
+		}
+
+		std::mutex m_streamingRequestsMutex;
 		std::unordered_map<Streaming::StreamingRequestId, std::unique_ptr<Streaming::Args>> m_streamingRequestsMap;
 		std::atomic<uint64_t> m_nextStreamingRequestId{ 0 };
 		Scene::Scene* m_scene;
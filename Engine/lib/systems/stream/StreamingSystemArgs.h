@@ -3,6 +3,8 @@
 #pragma once
 
 #include "controllers/BarrierController.h"
+#include "controllers/CustomDecompressionController.h"
+#include "PakArchive.h"
 #include "../../scene/Scene.h"
 
 namespace Engine::System {
@@ -12,6 +14,7 @@ namespace Engine::System {
 			m_scene = scene;
 			createCopyQueue(device);
 			createDirectStorageQueue(device);
+			m_customDecompression.initialize(m_dstorageFactory.Get());
 			createCommandList(device);
 			createFence(device);
 
@@ -63,9 +66,74 @@ namespace Engine::System {
 			return m_dstorageQueue.Get();
 		}
 
+		// DirectStorage only runs requests whose source matches the queue's; verify mode uploads its staged sections here.
+		inline IDStorageQueue2* getDmemoryQueue() {
+			return m_dstorageMemoryQueue.Get();
+		}
+
 		inline Scene::Scene* getScene() {
 			return m_scene;
 		}
+
+		// Checks every mesh against its table and section checksums before it is uploaded. The sections are read once into
+		// memory and hashed there, then uploaded from memory instead of straight from the file.
+		void setVerifyChecksums(bool verify) {
+			m_verifyChecksums.store(verify, std::memory_order_relaxed);
+		}
+
+		inline bool getVerifyChecksums() const {
+			return m_verifyChecksums.load(std::memory_order_relaxed);
+		}
+
+		// Meshes drawing a content store payload finish after it: the continuation runs on the task that finishes the payload
+		// instead of a task waiting for it. Returns false, without registering, when the mesh is already Ready or Error.
+		bool continueAfterMesh(Scene::Asset::MeshId id, Scene::Asset::MeshMapValue* mesh, std::function<void()> continuation) {
+			std::lock_guard lock(m_meshContinuationMutex);
+			auto status = mesh->status.load(std::memory_order_acquire);
+			if (status == Scene::Asset::Status::Ready || status == Scene::Asset::Status::Error) return false;
+			m_meshContinuations[id].push_back(std::move(continuation));
+			return true;
+		}
+
+		// Publishes the final status of a mesh and runs what was waiting for it.
+		void finishMesh(Scene::Asset::MeshId id, Scene::Asset::MeshMapValue* mesh, Scene::Asset::Status status) {
+			std::vector<std::function<void()>> continuations;
+			{
+				std::lock_guard lock(m_meshContinuationMutex);
+				mesh->status.store(status, std::memory_order_release);
+				if (auto node = m_meshContinuations.extract(id)) continuations = std::move(node.mapped());
+			}
+			for (auto& continuation : continuations) {
+				continuation();
+			}
+		}
+
+		// Paks stay mounted, and their file open, for the lifetime of the streaming system.
+		const Streaming::PakArchive* mountPak(const std::filesystem::path& path) {
+			auto pak = std::make_unique<Streaming::PakArchive>(path, m_dstorageFactory.Get());
+			std::lock_guard lock(m_pakMutex);
+			return m_paks.emplace_back(std::move(pak)).get();
+		}
+
+		// The material table of a mesh file, read once for all the materials registered from it and kept, without the other
+		// tables, for the lifetime of the streaming system. Two tasks asking for a new file at once may both read it.
+		std::shared_ptr<const AssetsCreator::Asset::File::MeshAsset> getMaterialTable(const std::filesystem::path& path, const Streaming::PakArchive* pak) {
+			auto key = std::make_pair(pak, path);
+			{
+				std::lock_guard lock(m_materialTableMutex);
+				auto itt = m_materialTables.find(key);
+				if (itt != m_materialTables.end()) return itt->second;
+			}
+
+			auto header = pak ? pak->readMeshHeaders(path) : AssetsCreator::Asset::AssetReader::ReadMeshHeaders(path);
+			auto table = std::make_shared<AssetsCreator::Asset::File::MeshAsset>();
+			table->header = header->header;
+			table->materials = std::move(header->materials);
+			table->textureReferences = std::move(header->textureReferences);
+
+			std::lock_guard lock(m_materialTableMutex);
+			return m_materialTables.emplace(std::move(key), std::move(table)).first->second;
+		}
 	private:
 		void createCopyQueue(ID3D12Device* device) {
 			D3D12_COMMAND_QUEUE_DESC directQueueDesc = {};
@@ -77,7 +145,7 @@ namespace Engine::System {
 			ThrowIfFailed(DStorageGetFactory(IID_PPV_ARGS(&m_dstorageFactory)));
 
 			DSTORAGE_QUEUE_DESC queueDesc = {};
-			queueDesc.Capacity = 512;
+			queueDesc.Capacity = DSTORAGE_MAX_QUEUE_CAPACITY; // compressed sections are one request per chunk
 			queueDesc.Priority = DSTORAGE_PRIORITY_NORMAL;
 			queueDesc.SourceType = DSTORAGE_REQUEST_SOURCE_FILE;
 			queueDesc.Device = device;
@@ -87,6 +155,10 @@ namespace Engine::System {
 			ThrowIfFailed(m_dstorageFactory->CreateQueue(&queueDesc, IID_PPV_ARGS(&tempQeue)));
 			ThrowIfFailed(tempQeue->QueryInterface(IID_PPV_ARGS(&m_dstorageQueue)));
 
+			queueDesc.SourceType = DSTORAGE_REQUEST_SOURCE_MEMORY;
+			ThrowIfFailed(m_dstorageFactory->CreateQueue(&queueDesc, IID_PPV_ARGS(&tempQeue)));
+			ThrowIfFailed(tempQeue->QueryInterface(IID_PPV_ARGS(&m_dstorageMemoryQueue)));
+
 		}
 		void createCommandList(ID3D12Device* device) {
 			WPtr<ID3D12GraphicsCommandList> commandListTemp;
@@ -107,6 +179,8 @@ namespace Engine::System {
 		WPtr<ID3D12CommandQueue> m_copyCommandQueue;
 		WPtr<IDStorageFactory> m_dstorageFactory;
 		WPtr<IDStorageQueue2> m_dstorageQueue;
+		WPtr<IDStorageQueue2> m_dstorageMemoryQueue;
+		Streaming::CustomDecompressionController m_customDecompression;
 
 		WPtr<ID3D12CommandAllocator> m_commandAllocator;
 		WPtr<ID3D12GraphicsCommandList> m_commandList;
@@ -114,6 +188,16 @@ namespace Engine::System {
 
 		WPtr<ID3D12Fence> m_fence;
 		std::atomic<uint64_t> m_fenceValue{ 1 };
+		std::atomic<bool> m_verifyChecksums{ false };
+
+		std::mutex m_meshContinuationMutex;
+		std::unordered_map<Scene::Asset::MeshId, std::vector<std::function<void()>>> m_meshContinuations;
+
+		std::mutex m_pakMutex;
+		std::vector<std::unique_ptr<Streaming::PakArchive>> m_paks;
+
+		std::mutex m_materialTableMutex;
+		std::map<std::pair<const Streaming::PakArchive*, std::filesystem::path>, std::shared_ptr<const AssetsCreator::Asset::File::MeshAsset>> m_materialTables;
 
 		Scene::Scene* m_scene;
 	};
@@ -0,0 +1,87 @@
+#include "stdafx.h"
+
+#pragma once
+
+#include <Lz4.h>
+
+namespace Engine::System::Streaming {
+	// DirectStorage hands formats it can't decode itself to the application through the custom decompression queue.
+	// LZ4 chunks are decoded here by a few worker threads, straight from the staging buffer into the upload destination.
+	class CustomDecompressionController {
+	public:
+		static constexpr DSTORAGE_COMPRESSION_FORMAT LZ4_FORMAT = DSTORAGE_CUSTOM_COMPRESSION_0;
+		static constexpr uint32_t MAX_REQUESTS_PER_BATCH = 64;
+		static constexpr DWORD WAIT_TIMEOUT_MS = 100; // how long a worker may take to notice a stop request
+
+		~CustomDecompressionController() {
+			stop();
+		}
+
+		void initialize(IDStorageFactory* factory, uint32_t threadCount = 0) {
+			ThrowIfFailed(factory->QueryInterface(IID_PPV_ARGS(&m_queue)));
+			// owned by the queue, never closed here; every worker waits on it, so a wake up may find the requests already taken
+			m_event = m_queue->GetEvent();
+
+			if (threadCount == 0)
+				threadCount = std::clamp(std::thread::hardware_concurrency() / 4, 1u, 4u);
+
+			m_workers.reserve(threadCount);
+			for (uint32_t i = 0; i < threadCount; i++) {
+				m_workers.emplace_back([this](std::stop_token stopToken) { workerLoop(stopToken); });
+			}
+		}
+
+		// Joins the workers, within WAIT_TIMEOUT_MS; the queue they use is released after them, with the controller.
+		void stop() {
+			for (auto& worker : m_workers)
+				worker.request_stop();
+			m_workers.clear();
+		}
+	private:
+		// Nothing may throw out of a worker thread: a failed queue call is logged and the worker keeps serving the queue.
+		void workerLoop(std::stop_token stopToken) {
+			DSTORAGE_CUSTOM_DECOMPRESSION_REQUEST requests[MAX_REQUESTS_PER_BATCH];
+			DSTORAGE_CUSTOM_DECOMPRESSION_RESULT results[MAX_REQUESTS_PER_BATCH];
+
+			while (!stopToken.stop_requested()) {
+				if (WaitForSingleObject(m_event, WAIT_TIMEOUT_MS) != WAIT_OBJECT_0)
+					continue;
+
+				uint32_t requestCount = 0;
+				HRESULT hr = m_queue->GetRequests(MAX_REQUESTS_PER_BATCH, requests, &requestCount);
+				if (FAILED(hr)) {
+					logFailure("GetRequests", hr);
+					continue;
+				}
+				if (requestCount == 0)
+					continue;
+
+				for (uint32_t i = 0; i < requestCount; i++) {
+					results[i].Id = requests[i].Id;
+					results[i].Result = decompress(requests[i]) ? S_OK : E_FAIL;
+				}
+				hr = m_queue->SetRequestResults(requestCount, results);
+				if (FAILED(hr)) {
+					logFailure("SetRequestResults", hr);
+				}
+			}
+		}
+
+		static void logFailure(const char* call, HRESULT hr) {
+			std::osyncstream(std::cout) << "[CustomDecompressionController] " << call << " failed with 0x" << std::hex << static_cast<uint32_t>(hr) << std::dec << "\n";
+		}
+
+		static bool decompress(const DSTORAGE_CUSTOM_DECOMPRESSION_REQUEST& request) {
+			if (request.CompressionFormat != LZ4_FORMAT)
+				return false;
+			return AssetsCreator::Asset::Lz4::Decompress(
+				static_cast<const uint8_t*>(request.SrcBuffer), static_cast<size_t>(request.SrcSize),
+				static_cast<uint8_t*>(request.DstBuffer), static_cast<size_t>(request.DstSize));
+		}
+
+		// declared before the workers, so it outlives them
+		WPtr<IDStorageCustomDecompressionQueue> m_queue;
+		HANDLE m_event = nullptr;
+		std::vector<std::jthread> m_workers;
+	};
+}
@@ -9,12 +9,60 @@ namespace Engine::System::Streaming {
 			auto args = reinterpret_cast<MeshArgs*>(arg);
 			args->step = StreamingStep::GpuBufferFinalizer;
 			auto event = args->event;
-			auto scene = args->streamingSystemArgs->getScene();
+			auto* streamingSystemArgs = args->streamingSystemArgs;
+			auto scene = streamingSystemArgs->getScene();
 			auto* asset = event.asset;
-			scene->renderableManager.addMeshAsset(event.id, asset->asset);
-			std::cout << "fin \n";
-			asset->status = Scene::Asset::Status::Ready;
-			args->finalize();
+			if (asset->source != Scene::Asset::SourceMesh::File) {
+				scene->renderableManager.addMeshAsset(event.id, asset->asset);
+				streamingSystemArgs->finishMesh(event.id, asset, Scene::Asset::Status::Ready);
+				args->finalize();
+				return;
+			}
+
+			auto& additionalData = std::get<Scene::Asset::FileMeshAdditionalData>(asset->additionalData);
+			auto pending = std::make_shared<PendingCookedMesh>();
+			pending->draws.resize(asset->asset.subMeshes.size());
+			std::vector<uint32_t> payloadSubmeshes;
+			for (uint32_t i = 0; i < pending->draws.size(); i++) {
+				pending->draws[i] = { &additionalData.file.draws.at(i), additionalData.sectionGpuVirtualAddresses };
+				if (asset->asset.subMeshes[i].payloadMeshId) payloadSubmeshes.push_back(i);
+			}
+			// one count per payload still streaming, plus this task's own
+			pending->remaining.store(static_cast<uint32_t>(payloadSubmeshes.size()) + 1, std::memory_order_relaxed);
+
+			// the last one to count down registers the mesh, on whichever task that happens
+			auto countDown = [streamingSystemArgs, scene, id = event.id, asset, finalize = args->finalize, pending]() {
+				if (pending->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+				scene->renderableManager.addCookedMesh(id, asset->asset, pending->draws);
+				streamingSystemArgs->finishMesh(id, asset, Scene::Asset::Status::Ready);
+				finalize();
+				};
+
+			// submeshes stored in the content store draw the buffers of their payload mesh, streamed by its own tasks;
+			// a failed payload keeps the reference's own entry, which has no indices
+			for (uint32_t i : payloadSubmeshes) {
+				auto payloadId = *asset->asset.subMeshes[i].payloadMeshId;
+				auto* payload = scene->assetManager.getMeshAsset(payloadId);
+				auto usePayload = [asset, payload, pending, countDown, i]() {
+					if (payload->status.load(std::memory_order_acquire) == Scene::Asset::Status::Ready) {
+						auto& payloadData = std::get<Scene::Asset::FileMeshAdditionalData>(payload->additionalData);
+						pending->draws[i] = { &payloadData.file.draws.at(0), payloadData.sectionGpuVirtualAddresses };
+						auto& payloadSubmesh = payload->asset.subMeshes.at(0);
+						auto& submesh = asset->asset.subMeshes[i];
+						submesh.meshlets = payloadSubmesh.meshlets;
+						submesh.lods = payloadSubmesh.lods;
+					}
+					countDown();
+					};
+				if (!streamingSystemArgs->continueAfterMesh(payloadId, payload, usePayload)) usePayload();
+			}
+			countDown();
 		}
+	private:
+		// A cooked mesh waiting on its content store payloads; every payload fills its own draw before counting down.
+		struct PendingCookedMesh {
+			std::vector<Render::Manager::CookedDraw> draws;
+			std::atomic<uint32_t> remaining{ 0 };
+		};
 	};
 }
@@ -16,10 +16,11 @@ namespace Engine::System::Streaming {
 			uint64_t size,
 			ID3D12Resource* destinationResource,
 			uint64_t destinationOffset,
-			uint64_t destinationSize)
+			uint64_t destinationSize,
+			DSTORAGE_COMPRESSION_FORMAT compressionFormat = DSTORAGE_COMPRESSION_FORMAT_NONE)
 		{
 			DSTORAGE_REQUEST request = {};
-			request.Options.CompressionFormat = DSTORAGE_COMPRESSION_FORMAT_NONE;
+			request.Options.CompressionFormat = compressionFormat;
 			request.Options.SourceType = DSTORAGE_REQUEST_SOURCE_FILE;
 			request.Options.DestinationType = DSTORAGE_REQUEST_DESTINATION_BUFFER;
 
@@ -30,21 +31,78 @@ namespace Engine::System::Streaming {
 			request.Destination.Buffer.Resource = destinationResource;
 			request.Destination.Buffer.Offset = destinationOffset;
 			request.Destination.Buffer.Size = static_cast<uint32_t>(destinationSize);
+			request.UncompressedSize = compressionFormat == DSTORAGE_COMPRESSION_FORMAT_NONE ? 0 : static_cast<uint32_t>(destinationSize);
 
 			return request;
 		}
+		// Stored bytes into CPU memory, as they are in the file.
+		static DSTORAGE_REQUEST CreateDStorageStagingRequest(IDStorageFile* storageFile, uint64_t offset, uint64_t size, void* destination) {
+			DSTORAGE_REQUEST request = {};
+			request.Options.CompressionFormat = DSTORAGE_COMPRESSION_FORMAT_NONE;
+			request.Options.SourceType = DSTORAGE_REQUEST_SOURCE_FILE;
+			request.Options.DestinationType = DSTORAGE_REQUEST_DESTINATION_MEMORY;
+
+			request.Source.File.Source = storageFile;
+			request.Source.File.Offset = offset;
+			request.Source.File.Size = static_cast<uint32_t>(size);
+
+			request.Destination.Memory.Buffer = destination;
+			request.Destination.Memory.Size = static_cast<uint32_t>(size);
+
+			return request;
+		}
+		// GDeflate is decompressed by DirectStorage (on the GPU when supported), LZ4 by the CustomDecompressionController.
+		static DSTORAGE_COMPRESSION_FORMAT GetDStorageCompressionFormat(AssetsCreator::Asset::File::CompressionFormat format) {
+			switch (format) {
+			case AssetsCreator::Asset::File::CompressionFormat::GDEFLATE: return DSTORAGE_COMPRESSION_FORMAT_GDEFLATE;
+			case AssetsCreator::Asset::File::CompressionFormat::LZ4: return CustomDecompressionController::LZ4_FORMAT;
+			default: return DSTORAGE_COMPRESSION_FORMAT_NONE;
+			}
+		}
 		static void PopulateMeshUpload(
 			std::optional<Render::Memory::HeapPool::AllocateResult>& alloc,
-			std::optional<DSTORAGE_REQUEST>& requestSlot,
+			std::vector<DSTORAGE_REQUEST>& requests,
 			MeshUploadResource& resourceSlot,
-			const uint64_t offset, const uint64_t size,
-			IDStorageFile* storageFile, Render::Manager::ResourceManager& rm
+			const uint64_t offset, const uint64_t size, const uint64_t storedSize,
+			const AssetsCreator::Asset::File::MeshAsset& file, AssetsCreator::Asset::File::Section section,
+			IDStorageFile* storageFile, uint64_t fileOffset, Render::Manager::ResourceManager& rm,
+			DSMeshUploadTypeData* staging = nullptr
 		) {
 			if (!alloc) return;
 			auto* res = rm.get(alloc->resourceHandle);
 			if (!res) return;
 
-			requestSlot.emplace(CreateDStorageRequest(storageFile, offset, size, res->getResource(), 0, res->getSize()));
+			// verify mode: the stored section is read into memory once, hashed there (UploadExecutor) and uploaded from it
+			const uint8_t* staged = nullptr;
+			if (staging) {
+				auto& stagedSection = staging->staged[static_cast<uint32_t>(section)];
+				stagedSection.resize(storedSize);
+				staging->stagingReq.push_back(CreateDStorageStagingRequest(storageFile, fileOffset + offset, storedSize, stagedSection.data()));
+				staged = stagedSection.data();
+			}
+			// sectionOffset is relative to the stored section; fileOffset places the asset inside its pak
+			auto addRequest = [&](uint64_t sectionOffset, uint64_t requestSize, uint64_t destinationOffset, uint64_t destinationSize,
+				DSTORAGE_COMPRESSION_FORMAT compressionFormat) {
+				auto request = CreateDStorageRequest(storageFile, fileOffset + offset + sectionOffset, requestSize,
+					res->getResource(), destinationOffset, destinationSize, compressionFormat);
+				if (staged) {
+					request.Options.SourceType = DSTORAGE_REQUEST_SOURCE_MEMORY;
+					request.Source.Memory.Source = staged + sectionOffset;
+					request.Source.Memory.Size = static_cast<uint32_t>(requestSize);
+				}
+				requests.push_back(request);
+				};
+
+			if (file.header.compression == AssetsCreator::Asset::File::CompressionFormat::NONE) {
+				addRequest(0, size, 0, res->getSize(), DSTORAGE_COMPRESSION_FORMAT_NONE);
+			}
+			else {
+				for (auto& chunk : file.chunks) {
+					if (chunk.section != section) continue;
+					addRequest(chunk.fileOffset - offset, chunk.compressedSize, chunk.uncompressedOffset, chunk.uncompressedSize,
+						GetDStorageCompressionFormat(chunk.format));
+				}
+			}
 			resourceSlot.resourceHandle = alloc->resourceHandle;
 			resourceSlot.heapId = alloc->heapId;
 		}
@@ -60,8 +118,14 @@ namespace Engine::System::Streaming {
 				auto& sourceData = std::get<Scene::Asset::FileSourceMesh>(asset->sourceData);
 				auto& additionalData = std::get<Scene::Asset::FileMeshAdditionalData>(asset->additionalData);
 
+				// a pak keeps one file open for all of its assets
 				WPtr<IDStorageFile> storageFile;
-				ThrowIfFailed(args->streamingSystemArgs->getDfactory()->OpenFile(sourceData.path.c_str(), IID_PPV_ARGS(&storageFile)));
+				if (sourceData.pak) {
+					storageFile = sourceData.pak->getStorageFile();
+				}
+				else {
+					ThrowIfFailed(args->streamingSystemArgs->getDfactory()->OpenFile(sourceData.path.c_str(), IID_PPV_ARGS(&storageFile)));
+				}
 
 				std::optional<Render::Memory::HeapPool::AllocateResult> ski, att, ind;
 				D3D12_GPU_VIRTUAL_ADDRESS addSki, addAtt, addInt;
@@ -72,13 +136,17 @@ namespace Engine::System::Streaming {
 						ski = scene->skiDefaultHeapPool.allocate(descSki, D3D12_RESOURCE_STATE_COPY_DEST);
 						addSki = scene->resourceManager.get((*ski).resourceHandle)->getResource()->GetGPUVirtualAddress();
 					}
-					D3D12_RESOURCE_DESC descAtt = CD3DX12_RESOURCE_DESC::Buffer(additionalData.file.header.attributeSizeInBytes);
-					att = scene->attDefaultHeapPool.allocate(descAtt, D3D12_RESOURCE_STATE_COPY_DEST);
-					addAtt = scene->resourceManager.get((*att).resourceHandle)->getResource()->GetGPUVirtualAddress();;
-
-					D3D12_RESOURCE_DESC descInd = CD3DX12_RESOURCE_DESC::Buffer(additionalData.file.header.indexSizeInBytes);
-					ind = scene->indDefaultHeapPool.allocate(descInd, D3D12_RESOURCE_STATE_COPY_DEST);
-					addInt = scene->resourceManager.get((*ind).resourceHandle)->getResource()->GetGPUVirtualAddress();;
+					// a mesh whose submeshes all reference content store payloads has no data of its own
+					if (additionalData.file.header.attributeSizeInBytes) {
+						D3D12_RESOURCE_DESC descAtt = CD3DX12_RESOURCE_DESC::Buffer(additionalData.file.header.attributeSizeInBytes);
+						att = scene->attDefaultHeapPool.allocate(descAtt, D3D12_RESOURCE_STATE_COPY_DEST);
+						addAtt = scene->resourceManager.get((*att).resourceHandle)->getResource()->GetGPUVirtualAddress();;
+					}
+					if (additionalData.file.header.indexSizeInBytes) {
+						D3D12_RESOURCE_DESC descInd = CD3DX12_RESOURCE_DESC::Buffer(additionalData.file.header.indexSizeInBytes);
+						ind = scene->indDefaultHeapPool.allocate(descInd, D3D12_RESOURCE_STATE_COPY_DEST);
+						addInt = scene->resourceManager.get((*ind).resourceHandle)->getResource()->GetGPUVirtualAddress();;
+					}
 				}
 
 				MeshGpuUploadPlan meshGpuUploadPlan{};
@@ -87,6 +155,7 @@ namespace Engine::System::Streaming {
 
 				DSMeshUploadTypeData dsMeshUploadTypeData{};
 				dsMeshUploadTypeData.storageFile = storageFile;
+				bool verify = args->streamingSystemArgs->getVerifyChecksums();
 				if (att)
 					PopulateMeshUpload(
 						att,
@@ -94,8 +163,12 @@ namespace Engine::System::Streaming {
 						meshGpuUploadPlan.resourceAtt.emplace(),
 						additionalData.file.header.attributeDataOffset,
 						additionalData.file.header.attributeSizeInBytes,
+						additionalData.file.header.attributeCompressedSizeInBytes,
+						additionalData.file, AssetsCreator::Asset::File::Section::ATTRIBUTE,
 						dsMeshUploadTypeData.storageFile.Get(),
-						scene->resourceManager
+						additionalData.fileOffset,
+						scene->resourceManager,
+						verify ? &dsMeshUploadTypeData : nullptr
 					);
 				if (ind)
 					PopulateMeshUpload(
@@ -104,8 +177,12 @@ namespace Engine::System::Streaming {
 						meshGpuUploadPlan.resourceInd.emplace(),
 						additionalData.file.header.indexDataOffset,
 						additionalData.file.header.indexSizeInBytes,
+						additionalData.file.header.indexCompressedSizeInBytes,
+						additionalData.file, AssetsCreator::Asset::File::Section::INDEX,
 						dsMeshUploadTypeData.storageFile.Get(),
-						scene->resourceManager
+						additionalData.fileOffset,
+						scene->resourceManager,
+						verify ? &dsMeshUploadTypeData : nullptr
 					);
 				if (ski)
 					PopulateMeshUpload(
@@ -114,48 +191,20 @@ namespace Engine::System::Streaming {
 						meshGpuUploadPlan.resourceSki.emplace(),
 						additionalData.file.header.skinnedDataOffset,
 						additionalData.file.header.skinnedSizeInBytes,
+						additionalData.file.header.skinnedCompressedSizeInBytes,
+						additionalData.file, AssetsCreator::Asset::File::Section::SKINNED,
 						dsMeshUploadTypeData.storageFile.Get(),
-						scene->resourceManager
+						additionalData.fileOffset,
+						scene->resourceManager,
+						verify ? &dsMeshUploadTypeData : nullptr
 					);
 				meshGpuUploadPlan.uploadTypeData = std::move(dsMeshUploadTypeData);
 				args->uploadPlan = std::move(meshGpuUploadPlan);
 
-				auto& assetSubmeshes = asset->asset.subMeshes;
-				for (uint32_t i = 0; i < assetSubmeshes.size(); ++i) {
-					auto& assetSubmesh = assetSubmeshes.at(i);
-					auto& fileSubmesh = additionalData.file.submeshes.at(i);
-
-					if (ind) {
-						auto& v = *ind;
-						assetSubmesh.gpuData.indexHeapId = v.heapId;
-						assetSubmesh.gpuData.indexResourceHandle = v.resourceHandle;
-						
-						assetSubmesh.gpuData.indexGpuVirtualAddress = addInt;
-						addInt += assetSubmesh.gpuData.indicesSizeInBytes;
-					}
-					if (att) {
-						auto& v = *att;
-						for (auto& attribute : assetSubmesh.gpuData.attributes) {
-							if (attribute.attribute.type == AssetsCreator::Asset::AttributeType::JOINT || attribute.attribute.type == AssetsCreator::Asset::AttributeType::WEIGHT) continue;
-							attribute.gpuVirtualAddress = addAtt;
-							attribute.heapId = v.heapId;
-							attribute.resourceHandle = v.resourceHandle;
-
-							addAtt += attribute.attribute.sizeInBytes;
-						}
-					}
-					if (ski) {
-						auto& v = *ski;
-						for (auto& attribute : assetSubmesh.gpuData.attributes) {
-							if (attribute.attribute.type != AssetsCreator::Asset::AttributeType::JOINT && attribute.attribute.type != AssetsCreator::Asset::AttributeType::WEIGHT) continue;
-							attribute.gpuVirtualAddress = addSki;
-							attribute.heapId = v.heapId;
-							attribute.resourceHandle = v.resourceHandle;
-
-							addSki += attribute.attribute.sizeInBytes;
-						}
-					}
-				}
+				// the draw table addresses every buffer relative to its section, registration adds these (GpuBufferFinalizer)
+				additionalData.sectionGpuVirtualAddresses[static_cast<uint32_t>(AssetsCreator::Asset::File::Section::ATTRIBUTE)] = att ? addAtt : 0;
+				additionalData.sectionGpuVirtualAddresses[static_cast<uint32_t>(AssetsCreator::Asset::File::Section::INDEX)] = ind ? addInt : 0;
+				additionalData.sectionGpuVirtualAddresses[static_cast<uint32_t>(AssetsCreator::Asset::File::Section::SKINNED)] = ski ? addSki : 0;
 
 				ts->AddTask({ UploadExecutor::ExecuteMesh, arg }, ftl::TaskPriority::Normal);
 				return;
@@ -14,7 +14,10 @@ namespace Engine::System::Streaming {
 		Procedural,
 	};
 	struct DSMeshUploadTypeData {
-		std::optional<DSTORAGE_REQUEST> attReq, indReq, skiReq;
+		std::vector<DSTORAGE_REQUEST> attReq, indReq, skiReq; // one request per chunk when the sections are compressed
+		// verify mode: each stored section is read into staged first and hashed, the requests above then read from there
+		std::vector<DSTORAGE_REQUEST> stagingReq;
+		std::array<std::vector<uint8_t>, 3> staged; // by File::Section
 		WPtr<IDStorageFile> storageFile;
 	};
 	struct CSMeshUploadTypeData {
@@ -5,11 +5,30 @@
 #include <AssetReader.h>
 
 #include "../StreamingStructures.h"
+#include "../PakArchive.h"
 #include "GpuUploadPlanner.h"
 
 namespace Engine::System::Streaming {
 	class MetadataLoader {
 	public:
+		// MaterialEntry starts with the TypePBRMaterialData factors, so they are copied as one block.
+		static Scene::Asset::MeshMaterial ReadMaterial(const AssetsCreator::Asset::File::MeshAsset& file, uint32_t materialIndex) {
+			using AssetsCreator::Asset::File::MaterialEntry;
+			static_assert(sizeof(Scene::Asset::TypePBRMaterialData) == offsetof(MaterialEntry, textureIndices));
+			static_assert(std::tuple_size_v<decltype(Scene::Asset::MeshMaterial::textures)> == std::size(MaterialEntry{}.textureIndices));
+
+			auto& entry = file.materials.at(materialIndex);
+			Scene::Asset::MeshMaterial material{};
+			std::memcpy(&material.data, &entry, sizeof(material.data));
+			for (size_t i = 0; i < material.textures.size(); i++) {
+				if (entry.textureIndices[i] == AssetsCreator::Asset::File::NO_TEXTURE) continue;
+				material.textures[i] = file.textureReferences.at(entry.textureIndices[i]).id;
+			}
+			material.alphaMode = static_cast<Structures::AlphaMode>(entry.alphaMode);
+			material.alphaCutoff = entry.alphaCutoff;
+			material.doubleSided = entry.doubleSided != 0;
+			return material;
+		}
 		static void LoadMesh(ftl::TaskScheduler* ts, void* arg) {
 			auto args = reinterpret_cast<MeshArgs*>(arg);
 			args->step = StreamingStep::MetadataLoader;
@@ -19,91 +38,103 @@ namespace Engine::System::Streaming {
 			auto* asset = event.asset;
 			if (asset->source == Scene::Asset::SourceMesh::File) {
 				auto& sourceData = std::get<Scene::Asset::FileSourceMesh>(asset->sourceData);
-				auto header = AssetsCreator::Asset::AssetReader::ReadMeshHeaders(sourceData.path);
+				bool verify = args->streamingSystemArgs->getVerifyChecksums();
+				std::unique_ptr<AssetsCreator::Asset::File::MeshAsset> header;
+				try {
+					// only the tables here, the sections are hashed from their staging buffers on upload (UploadExecutor)
+					header = sourceData.pak ? sourceData.pak->readMeshHeaders(sourceData.path, verify, false) : AssetsCreator::Asset::AssetReader::ReadMeshHeaders(sourceData.path, verify, false);
+				}
+				catch (const std::exception& e) {
+					// stale, truncated or corrupt: nothing of it reaches the GPU, meshes drawing it as a payload keep their own entries
+					std::osyncstream(std::cout) << e.what() << "\n";
+					args->streamingSystemArgs->finishMesh(event.id, asset, Scene::Asset::Status::Error);
+					args->finalize();
+					return;
+				}
 				Scene::Asset::Mesh mesh{};
 				mesh.name = header->header.id;
 				std::vector<Scene::Asset::SubMesh> submeshes(header->submeshes.size());
 				for (uint32_t i = 0; i < header->submeshes.size(); i++) {
 					auto& headerSubmesh = header->submeshes[i];
 					auto& submesh = submeshes[i];
-					submesh.cpuData.attributes.reserve(static_cast<uint64_t>(headerSubmesh.attributeBufferCount) + headerSubmesh.skinnedBufferCount);
-					submesh.gpuData.attributes.reserve(static_cast<uint64_t>(headerSubmesh.attributeBufferCount) + headerSubmesh.skinnedBufferCount);
-
 					submesh.name = headerSubmesh.id;
 					submesh.aabb.max = DX::XMVectorSet(headerSubmesh.aabbMax[0], headerSubmesh.aabbMax[1], headerSubmesh.aabbMax[2], 0);
 					submesh.aabb.min = DX::XMVectorSet(headerSubmesh.aabbMin[0], headerSubmesh.aabbMin[1], headerSubmesh.aabbMin[2], 0);
 					submesh.topology = headerSubmesh.topology;
+					submesh.materialIndex = headerSubmesh.materialID;
 
-					uint64_t cpuAttrSizeInBytes = 0;
-					uint64_t gpuAttSizeInBytes = 0;
-					uint64_t cpuSkinSizeInBytes = 0;
-					uint64_t gpuSkinSizeInBytes = 0;
-
-					auto& headerIndices = header->indexBuffers[headerSubmesh.indexBufferIndex];
-					submesh.cpuData.indicesFormat = headerIndices.format;
-					submesh.gpuData.indicesFormat = headerIndices.format;
-					submesh.cpuData.indicesSizeInBytes = headerIndices.sizeInBytes;
-					submesh.gpuData.indicesSizeInBytes = headerIndices.sizeInBytes;
-
-					mesh.totalCPUIndicesSizeInBytes += submesh.cpuData.indicesSizeInBytes;
-
-
-					for (uint32_t j = headerSubmesh.attributeBufferIndex; j < headerSubmesh.attributeBufferIndex + headerSubmesh.attributeBufferCount; j++) {
-						auto& headerAttribute = header->attributeBuffers[j];
-						Render::VertexAttribute vertexAttribute{};
-						vertexAttribute.format = headerAttribute.format;
-						vertexAttribute.sizeInBytes = headerAttribute.sizeInBytes;
-						vertexAttribute.type = headerAttribute.type;
-						vertexAttribute.typeIndex = headerAttribute.typeIndex;
-
-						cpuAttrSizeInBytes += headerAttribute.sizeInBytes;
-						gpuAttSizeInBytes += headerAttribute.sizeInBytes;
-
-						Scene::Asset::CpuAttributeData cpuAttributeData;
-						Scene::Asset::GpuAttributeData gpuAttributeData;
-						cpuAttributeData.attribute = vertexAttribute;
-						gpuAttributeData.attribute = vertexAttribute;
-						submesh.cpuData.attributes.push_back(std::move(cpuAttributeData));
-						submesh.gpuData.attributes.push_back(std::move(gpuAttributeData));
+					// data lives in a shared content store payload, streamed as its own mesh (GpuBufferFinalizer picks it up)
+					if (headerSubmesh.payloadHash) {
+						submesh.payloadMeshId = scene->assetManager.registerPayload(headerSubmesh.payloadHash,
+							AssetsCreator::Asset::AssetReader::GetPayloadPath(sourceData.path, *header, headerSubmesh), sourceData.pak);
+						continue;
 					}
-					mesh.totalCPUAttributesSizeInBytes += cpuAttrSizeInBytes;
-
 
-					for (uint32_t j = headerSubmesh.skinnedBufferIndex; j < headerSubmesh.skinnedBufferIndex + headerSubmesh.skinnedBufferCount; j++) {
-						auto& headerAttribute = header->skinnedBuffers[j];
-						Render::VertexAttribute vertexAttribute{};
-						vertexAttribute.format = headerAttribute.format;
-						vertexAttribute.sizeInBytes = headerAttribute.sizeInBytes;
-						vertexAttribute.type = headerAttribute.type;
-						vertexAttribute.typeIndex = headerAttribute.typeIndex;
-
-						cpuSkinSizeInBytes += headerAttribute.sizeInBytes;
-						gpuSkinSizeInBytes += headerAttribute.sizeInBytes;
+					submesh.meshlets.reserve(headerSubmesh.meshletCount);
+					for (uint32_t j = headerSubmesh.meshletIndex; j < headerSubmesh.meshletIndex + headerSubmesh.meshletCount; j++) {
+						auto& headerMeshlet = header->meshlets[j];
+						Scene::Asset::Meshlet meshlet{};
+						meshlet.firstIndex = headerMeshlet.firstIndex;
+						meshlet.indexCount = headerMeshlet.indexCount;
+						meshlet.sphere = DX::XMFLOAT4(headerMeshlet.center[0], headerMeshlet.center[1], headerMeshlet.center[2], headerMeshlet.radius);
+						meshlet.coneApex = DX::XMFLOAT3(headerMeshlet.coneApex);
+						meshlet.coneAxis = DX::XMFLOAT3(headerMeshlet.coneAxis);
+						meshlet.coneCutoff = headerMeshlet.coneCutoff;
+						submesh.meshlets.push_back(meshlet);
+					}
 
-						Scene::Asset::CpuAttributeData cpuAttributeData;
-						Scene::Asset::GpuAttributeData gpuAttributeData;
-						cpuAttributeData.attribute = vertexAttribute;
-						gpuAttributeData.attribute = vertexAttribute;
-						submesh.cpuData.attributes.push_back(std::move(cpuAttributeData));
-						submesh.gpuData.attributes.push_back(std::move(gpuAttributeData));
+					submesh.lods.reserve(headerSubmesh.lodCount);
+					for (uint32_t j = headerSubmesh.lodIndex; j < headerSubmesh.lodIndex + headerSubmesh.lodCount; j++) {
+						auto& headerLod = header->lods[j];
+						submesh.lods.push_back({ headerLod.firstIndex, headerLod.indexCount, headerLod.error });
 					}
-					mesh.totalCPUSkinnedSizeInBytes += cpuSkinSizeInBytes;
 
-					submesh.cpuData.totalCPUSizeInBytes = cpuAttrSizeInBytes + submesh.cpuData.indicesSizeInBytes + cpuSkinSizeInBytes;
-					submesh.gpuData.totalGPUSizeInBytes = gpuAttSizeInBytes + submesh.gpuData.indicesSizeInBytes + gpuSkinSizeInBytes;
+					// streams and index view are not rebuilt here, the renderer registers the file's draw table (GpuBufferFinalizer)
+				}
+				mesh.subMeshes = std::move(submeshes);
+				mesh.materials.reserve(header->materials.size());
+				for (uint32_t i = 0; i < header->materials.size(); i++) {
+					mesh.materials.push_back(ReadMaterial(*header, i));
 				}
-				mesh.subMeshes = submeshes;
 				mesh.totalGPUAttributesSizeInBytes = header->header.attributeSizeInBytes;
 				mesh.totalGPUIndicesSizeInBytes = header->header.indexSizeInBytes;
 				mesh.totalGPUSkinnedSizeInBytes = header->header.skinnedSizeInBytes;
 				asset->asset = std::move(mesh);
-				asset->additionalData = Scene::Asset::FileMeshAdditionalData{ .file = std::move(*header) };
+				asset->additionalData = Scene::Asset::FileMeshAdditionalData{
+					.file = std::move(*header),
+					.fileOffset = sourceData.pak ? sourceData.pak->find(sourceData.path).offset : 0,
+				};
 			}
 			asset->status.store(Scene::Asset::Status::MetadataLoaded, std::memory_order_release);
 			ts->AddTask({ GpuUploadPlanner::CreatePlanForMesh, arg }, ftl::TaskPriority::Normal);
 		}
-		static void LoadMaterial(const Scene::Asset::MaterialAssetEvent event) {
+		// Only the table is read, once per mesh file (StreamingSystemArgs::getMaterialTable); the textures it references are
+		// streamed with their own assets.
+		static void LoadMaterial(ftl::TaskScheduler* ts, void* arg) {
+			auto args = reinterpret_cast<MaterialArgs*>(arg);
+			args->step = StreamingStep::MetadataLoader;
+			auto event = args->event;
 
+			auto* asset = event.asset;
+			if (asset->source == Scene::Asset::SourceMaterial::File) {
+				auto& sourceData = std::get<Scene::Asset::FileSourceMaterial>(asset->sourceData);
+				try {
+					auto table = args->streamingSystemArgs->getMaterialTable(sourceData.path, sourceData.pak);
+					if (sourceData.materialIndex >= table->materials.size()) {
+						throw std::runtime_error("[MetadataLoader] " + sourceData.path.string() + " has no material " + std::to_string(sourceData.materialIndex));
+					}
+					asset->asset.type = Scene::Asset::TypeMaterial::PBR;
+					asset->asset.data = ReadMaterial(*table, sourceData.materialIndex).data;
+				}
+				catch (const std::exception& e) {
+					std::osyncstream(std::cout) << e.what() << "\n";
+					asset->status.store(Scene::Asset::Status::Error, std::memory_order_release);
+					args->finalize();
+					return;
+				}
+			}
+			asset->status.store(Scene::Asset::Status::MetadataLoaded, std::memory_order_release);
+			args->finalize();
 		}
 		static void LoadMaterialInstance(const Scene::Asset::MaterialInstanceAssetEvent event) {
 
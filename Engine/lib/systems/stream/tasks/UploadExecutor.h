@@ -6,6 +6,7 @@
 #include "../../../scene/assets/AssetStructures.h"
 #include "GpuUploadPlannerStructures.h"
 #include "../StreamingStructures.h"
+#include <AssetReader.h>
 
 namespace Engine::System::Streaming {
 	class UploadExecutor {
@@ -22,40 +23,58 @@ namespace Engine::System::Streaming {
 				auto dqueue = args->streamingSystemArgs->getDqueue();
 				auto dfactory = args->streamingSystemArgs->getDfactory();
 				auto& uploadTypeData = std::get<DSMeshUploadTypeData>(args->uploadPlan.uploadTypeData);
-				if (uploadTypeData.attReq)
-					dqueue->EnqueueRequest(&uploadTypeData.attReq.value());
+				// verify mode: the stored sections land in memory first and nothing reaches the GPU unless they hash right;
+				// the uploads then read the staged bytes, which only a memory source queue accepts
+				if (!uploadTypeData.stagingReq.empty()) {
+					for (auto& request : uploadTypeData.stagingReq)
+						dqueue->EnqueueRequest(&request);
+					dqueue->EnqueueSignal(args->fence.Get(), ++args->fenceValue);
+					dqueue->Submit();
+					args->waitForFence();
+					try {
+						VerifyStagedSections(*asset, uploadTypeData);
+					}
+					catch (const std::exception& e) {
+						std::osyncstream(std::cout) << e.what() << "\n";
+						ReleaseUploadResources(*scene, args->uploadPlan);
+						args->streamingSystemArgs->finishMesh(event.id, asset, Scene::Asset::Status::Error);
+						args->finalize();
+						return;
+					}
+					dqueue = args->streamingSystemArgs->getDmemoryQueue();
+				}
+				for (auto& request : uploadTypeData.attReq)
+					dqueue->EnqueueRequest(&request);
 
-				if (uploadTypeData.indReq)
-					dqueue->EnqueueRequest(&uploadTypeData.indReq.value());
+				for (auto& request : uploadTypeData.indReq)
+					dqueue->EnqueueRequest(&request);
 
-				if (uploadTypeData.skiReq)
-					dqueue->EnqueueRequest(&uploadTypeData.skiReq.value());
+				for (auto& request : uploadTypeData.skiReq)
+					dqueue->EnqueueRequest(&request);
 
 
 				dqueue->EnqueueSignal(args->fence.Get(), ++args->fenceValue);
 				dqueue->Submit();
-				while (args->fence->GetCompletedValue() < args->fenceValue) {
-					ftl::YieldThread();
-				}
+				args->waitForFence();
 				auto* device = args->device;
 				WPtr<ID3D12GraphicsCommandList> commandList;
 				WPtr<ID3D12CommandAllocator> commandAllocator;
 				ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator)));
 				ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator.Get(), nullptr, IID_PPV_ARGS(&commandList)));
-				if (uploadTypeData.attReq) {
-					auto* res = uploadTypeData.attReq.value().Destination.Buffer.Resource;
+				if (!uploadTypeData.attReq.empty()) {
+					auto* res = uploadTypeData.attReq.front().Destination.Buffer.Resource;
 					CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
 						res, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
 					commandList->ResourceBarrier(1, &barrier);
 				}
-				if (uploadTypeData.indReq) {
-					auto* res = uploadTypeData.indReq.value().Destination.Buffer.Resource;
+				if (!uploadTypeData.indReq.empty()) {
+					auto* res = uploadTypeData.indReq.front().Destination.Buffer.Resource;
 					CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
 						res, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER);
 					commandList->ResourceBarrier(1, &barrier);
 				}
-				if (uploadTypeData.skiReq) {
-					auto* res = uploadTypeData.skiReq.value().Destination.Buffer.Resource;
+				if (!uploadTypeData.skiReq.empty()) {
+					auto* res = uploadTypeData.skiReq.front().Destination.Buffer.Resource;
 					CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
 						res, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
 					commandList->ResourceBarrier(1, &barrier);
@@ -64,13 +83,35 @@ namespace Engine::System::Streaming {
 				ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
 				args->commandQueue->ExecuteCommandLists(1, ppCommandLists);
 				args->commandQueue->Signal(args->fence.Get(), ++args->fenceValue);
-				while (args->fence->GetCompletedValue() < args->fenceValue) {
-					ftl::YieldThread();
-				}
+				args->waitForFence();
 
 				asset->status.store(Scene::Asset::Status::Loaded, std::memory_order_release);
 				ts->AddTask({ GpuBufferFinalizer::FinalizeMesh, arg }, ftl::TaskPriority::Normal);
 			}
 		}
+	private:
+		// The planner's buffers of a mesh that will not be drawn go back to their pools.
+		static void ReleaseUploadResources(Scene::Scene& scene, MeshGpuUploadPlan& uploadPlan) {
+			auto release = [](Render::Memory::HeapPool& pool, std::optional<MeshUploadResource>& resource) {
+				if (resource && resource->heapId) pool.deallocate({ *resource->heapId, resource->resourceHandle });
+				resource.reset();
+				};
+			release(scene.attDefaultHeapPool, uploadPlan.resourceAtt);
+			release(scene.indDefaultHeapPool, uploadPlan.resourceInd);
+			release(scene.skiDefaultHeapPool, uploadPlan.resourceSki);
+		}
+
+		// Same checks as AssetReader::VerifyMeshSections, on the bytes already read for the upload.
+		static void VerifyStagedSections(const Scene::Asset::MeshMapValue& asset, const DSMeshUploadTypeData& uploadTypeData) {
+			auto& header = std::get<Scene::Asset::FileMeshAdditionalData>(asset.additionalData).file.header;
+			auto name = std::get<Scene::Asset::FileSourceMesh>(asset.sourceData).path.string();
+			const std::array<uint64_t, 3> checksums = { header.attributeChecksum, header.indexChecksum, header.skinnedChecksum };
+			static constexpr std::array<const char*, 3> sectionNames = { "attribute section", "index section", "skinned section" };
+			for (uint32_t i = 0; i < uploadTypeData.staged.size(); i++) {
+				auto& staged = uploadTypeData.staged[i];
+				if (staged.empty()) continue;
+				AssetsCreator::Asset::AssetReader::CheckChecksum(AssetsCreator::Hash::XXH64(staged.data(), staged.size()), checksums[i], sectionNames[i], name);
+			}
+		}
 	};
 }